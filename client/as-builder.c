@@ -55,6 +55,22 @@ as_builder_search_path (GPtrArray *array, const gchar *path, GError **error)
 	return TRUE;
 }
 
+/**
+ * as_builder_progress_cb:
+ **/
+static void
+as_builder_progress_cb (guint current, guint total, gpointer user_data)
+{
+	GTimer *timer = (GTimer *) user_data;
+
+	if (g_timer_elapsed (timer, NULL) < 3.f)
+		return;
+	/* TRANSLATORS: information message */
+	g_print (_("Parsed %i/%i files..."), current, total);
+	g_print ("\n");
+	g_timer_reset (timer);
+}
+
 /**
  * main:
  **/
@@ -64,14 +80,16 @@ main (int argc, char **argv)
 	AsbContext *ctx = NULL;
 	AsbContextProcessFlags flags = AS_CONTEXT_PARSE_FLAG_NONE;
 	GOptionContext *option_context;
-	const gchar *filename;
 	gboolean add_cache_id = FALSE;
 	gboolean embedded_icons = FALSE;
 	gboolean hidpi_enabled = FALSE;
 	gboolean no_net = FALSE;
+	gboolean result_cache = FALSE;
 	gboolean ret;
 	gboolean verbose = FALSE;
 	gdouble api_version = 0.0f;
+	gint cleanup_threads = 0;
+	gint explode_threads = 0;
 	gint max_threads = 4;
 	gint min_icon_size = 32;
 	guint i;
@@ -108,6 +126,9 @@ main (int argc, char **argv)
 		{ "enable-embed", '\0', 0, G_OPTION_ARG_NONE, &embedded_icons,
 			/* TRANSLATORS: command line option */
 			_("Add encoded icons to the XML"), NULL },
+		{ "enable-result-cache", '\0', 0, G_OPTION_ARG_NONE, &result_cache,
+			/* TRANSLATORS: command line option */
+			_("Reuse the results for unchanged packages from the cache directory"), NULL },
 		{ "log-dir", '\0', 0, G_OPTION_ARG_FILENAME, &log_dir,
 			/* TRANSLATORS: command line option */
 			_("Set the logging directory"), "DIR" },
@@ -132,7 +153,7 @@ main (int argc, char **argv)
 		{ "output-dir", '\0', 0, G_OPTION_ARG_FILENAME, &output_dir,
 			/* TRANSLATORS: command line option */
 			_("Set the output directory"), "DIR" },
-		{ "cache-dir", '\0', 0, G_OPTION_ARG_FILENAME, &output_dir,
+		{ "cache-dir", '\0', 0, G_OPTION_ARG_FILENAME, &cache_dir,
 			/* TRANSLATORS: command line option */
 			_("Set the cache directory"), "DIR" },
 		{ "basename", '\0', 0, G_OPTION_ARG_STRING, &basename,
@@ -141,6 +162,12 @@ main (int argc, char **argv)
 		{ "max-threads", '\0', 0, G_OPTION_ARG_INT, &max_threads,
 			/* TRANSLATORS: command line option */
 			_("Set the number of threads"), "THREAD_COUNT" },
+		{ "explode-threads", '\0', 0, G_OPTION_ARG_INT, &explode_threads,
+			/* TRANSLATORS: command line option */
+			_("Set the number of threads used to decompress packages"), "THREAD_COUNT" },
+		{ "cleanup-threads", '\0', 0, G_OPTION_ARG_INT, &cleanup_threads,
+			/* TRANSLATORS: command line option */
+			_("Set the number of threads used to delete temporary files"), "THREAD_COUNT" },
 		{ "min-icon-size", '\0', 0, G_OPTION_ARG_INT, &min_icon_size,
 			/* TRANSLATORS: command line option */
 			_("Set the minimum icon size in pixels"), "ICON_SIZE" },
@@ -181,6 +208,8 @@ main (int argc, char **argv)
 		/* TRANSLATORS: debug message */
 		g_debug ("O_CLOEXEC not available, using 1 core");
 		max_threads = 1;
+		explode_threads = 1;
+		cleanup_threads = 1;
 	}
 #endif
 	/* set defaults */
@@ -216,6 +245,7 @@ main (int argc, char **argv)
 	asb_context_set_add_cache_id (ctx, add_cache_id);
 	asb_context_set_hidpi_enabled (ctx, hidpi_enabled);
 	asb_context_set_embedded_icons (ctx, embedded_icons);
+	asb_context_set_result_cache_enabled (ctx, result_cache);
 	asb_context_set_old_metadata (ctx, old_metadata);
 	asb_context_set_extra_appstream (ctx, extra_appstream);
 	asb_context_set_extra_appdata (ctx, extra_appdata);
@@ -228,6 +258,8 @@ main (int argc, char **argv)
 	asb_context_set_cache_dir (ctx, cache_dir);
 	asb_context_set_basename (ctx, basename);
 	asb_context_set_max_threads (ctx, max_threads);
+	asb_context_set_explode_threads (ctx, explode_threads);
+	asb_context_set_cleanup_threads (ctx, cleanup_threads);
 	asb_context_set_min_icon_size (ctx, min_icon_size);
 	ret = asb_context_setup (ctx, &error);
 	if (!ret) {
@@ -251,24 +283,12 @@ main (int argc, char **argv)
 	/* TRANSLATORS: information message */
 	g_print ("%s\n", _("Scanning packages..."));
 	timer = g_timer_new ();
-	for (i = 0; i < packages->len; i++) {
-		_cleanup_error_free_ GError *error_local = NULL;
-
-		filename = g_ptr_array_index (packages, i);
-
-		/* add to list */
-		if (!asb_context_add_filename (ctx, filename, &error_local)) {
-			/* TRANSLATORS: error message */
-			g_debug ("%s %s: %s", _("Failed to add package"),
-				 filename, error_local->message);
-			continue;
-		}
-		if (g_timer_elapsed (timer, NULL) > 3.f) {
-			/* TRANSLATORS: information message */
-			g_print (_("Parsed %i/%i files..."), i, packages->len);
-			g_print ("\n"),
-			g_timer_reset (timer);
-		}
+	if (!asb_context_add_filenames (ctx, packages,
+					as_builder_progress_cb, timer,
+					&error)) {
+		/* TRANSLATORS: error message */
+		g_warning ("%s: %s", _("Failed to open packages"), error->message);
+		goto out;
 	}
 
 	/* parse the context flags */
@@ -798,9 +798,9 @@ as_util_dump (AsUtilPrivate *priv, gchar **values, GError **error)
 static gboolean
 as_util_search (AsUtilPrivate *priv, gchar **values, GError **error)
 {
-	GPtrArray *apps;
 	guint i;
 	_cleanup_object_unref_ AsStore *store = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *apps = NULL;
 
 	/* check args */
 	if (g_strv_length (values) < 1) {
@@ -816,12 +816,11 @@ as_util_search (AsUtilPrivate *priv, gchar **values, GError **error)
 	store = as_store_new ();
 	if (!as_store_load (store, AS_STORE_LOAD_FLAG_APP_INFO_SYSTEM, NULL, error))
 		return FALSE;
-	apps = as_store_get_apps (store);
+	apps = as_store_search (store, values);
 	for (i = 0; i < apps->len; i++) {
 		AsApp *app;
 		app = g_ptr_array_index (apps, i);
-		if (as_app_search_matches_all (app, values))
-			g_print ("%s\n", as_app_get_id (app));
+		g_print ("%s\n", as_app_get_id (app));
 	}
 	return TRUE;
 }
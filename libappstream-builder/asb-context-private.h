@@ -28,6 +28,19 @@
 GPtrArray	*asb_context_get_file_globs	(AsbContext	*ctx);
 GPtrArray	*asb_context_get_packages	(AsbContext	*ctx);
 AsbPluginLoader	*asb_context_get_plugin_loader	(AsbContext	*ctx);
+gchar		*asb_context_get_result_key	(AsbContext	*ctx,
+						 AsbPackage	*pkg,
+						 GPtrArray	*extra_pkgs,
+						 GError		**error);
+GPtrArray	*asb_context_load_result	(AsbContext	*ctx,
+						 AsbPackage	*pkg,
+						 const gchar	*key,
+						 GError		**error);
+gboolean	 asb_context_save_result	(AsbContext	*ctx,
+						 AsbPackage	*pkg,
+						 const gchar	*key,
+						 GPtrArray	*apps,
+						 GError		**error);
 
 G_END_DECLS
 
@@ -31,15 +31,19 @@
 #include "config.h"
 
 #include <stdlib.h>
+#include <glib/gstdio.h>
 #include <appstream-glib.h>
+#include <as-app-private.h>
 
 #include "as-cleanup.h"
 #include "asb-context.h"
 #include "asb-context-private.h"
+#include "asb-package-private.h"
 #include "asb-panel.h"
 #include "asb-plugin.h"
 #include "asb-plugin-loader.h"
 #include "asb-task.h"
+#include "asb-task-private.h"
 #include "asb-utils.h"
 
 #ifdef HAVE_RPM
@@ -67,7 +71,10 @@ struct _AsbContextPrivate
 	gboolean		 hidpi_enabled;
 	gboolean		 embedded_icons;
 	gboolean		 no_net;
+	gboolean		 result_cache_enabled;
 	guint			 max_threads;
+	guint			 explode_threads;
+	guint			 cleanup_threads;
 	guint			 min_icon_size;
 	gdouble			 api_version;
 	gchar			*old_metadata;
@@ -81,6 +88,20 @@ struct _AsbContextPrivate
 	gchar			*temp_dir;
 	gchar			*output_dir;
 	gchar			*basename;
+	GThreadPool		*pool_examine;
+	GThreadPool		*pool_save;
+	GThreadPool		*pool_cleanup;
+	GMutex			 pipeline_mutex;	/* for ->pipeline_depth */
+	GCond			 pipeline_cond;
+	guint			 pipeline_depth;	/* trees on disk */
+	guint			 pipeline_max;
+	gint64			 busy_explode;		/* us */
+	gint64			 busy_examine;		/* us */
+	gint64			 busy_save;		/* us */
+	gint64			 busy_cleanup;		/* us */
+	GMutex			 result_mutex;		/* for ->result_* */
+	gchar			*result_options;
+	GHashTable		*result_digests;	/* filename:checksum */
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE (AsbContext, asb_context, G_TYPE_OBJECT)
@@ -178,6 +199,25 @@ asb_context_set_hidpi_enabled (AsbContext *ctx, gboolean hidpi_enabled)
 	priv->hidpi_enabled = hidpi_enabled;
 }
 
+/**
+ * asb_context_set_result_cache_enabled:
+ * @ctx: A #AsbContext
+ * @result_cache_enabled: boolean
+ *
+ * Sets if the applications found in each package should be saved in the
+ * cache directory, so that later runs do not have to process any package
+ * with the same contents again. The cache directory can be shared between
+ * several machines.
+ *
+ * Since: 0.3.3
+ **/
+void
+asb_context_set_result_cache_enabled (AsbContext *ctx, gboolean result_cache_enabled)
+{
+	AsbContextPrivate *priv = GET_PRIVATE (ctx);
+	priv->result_cache_enabled = result_cache_enabled;
+}
+
 /**
  * asb_context_set_embedded_icons:
  * @ctx: A #AsbContext
@@ -210,6 +250,41 @@ asb_context_set_max_threads (AsbContext *ctx, guint max_threads)
 	priv->max_threads = max_threads;
 }
 
+/**
+ * asb_context_set_explode_threads:
+ * @ctx: A #AsbContext
+ * @explode_threads: integer, or 0 for the default
+ *
+ * Sets the number of threads to use when decompressing packages. These run
+ * at the same time as the threads set with asb_context_set_max_threads()
+ * which examine the packages that have already been decompressed.
+ *
+ * Since: 0.3.3
+ **/
+void
+asb_context_set_explode_threads (AsbContext *ctx, guint explode_threads)
+{
+	AsbContextPrivate *priv = GET_PRIVATE (ctx);
+	priv->explode_threads = explode_threads;
+}
+
+/**
+ * asb_context_set_cleanup_threads:
+ * @ctx: A #AsbContext
+ * @cleanup_threads: integer, or 0 for the default
+ *
+ * Sets the number of threads to use when deleting the decompressed files
+ * and writing the package logs.
+ *
+ * Since: 0.3.3
+ **/
+void
+asb_context_set_cleanup_threads (AsbContext *ctx, guint cleanup_threads)
+{
+	AsbContextPrivate *priv = GET_PRIVATE (ctx);
+	priv->cleanup_threads = cleanup_threads;
+}
+
 /**
  * asb_context_set_min_icon_size:
  * @ctx: A #AsbContext
@@ -440,6 +515,23 @@ asb_context_get_add_cache_id (AsbContext *ctx)
 	return priv->add_cache_id;
 }
 
+/**
+ * asb_context_get_result_cache_enabled:
+ * @ctx: A #AsbContext
+ *
+ * Gets if the results for each package should be cached.
+ *
+ * Returns: boolean
+ *
+ * Since: 0.3.3
+ **/
+gboolean
+asb_context_get_result_cache_enabled (AsbContext *ctx)
+{
+	AsbContextPrivate *priv = GET_PRIVATE (ctx);
+	return priv->result_cache_enabled;
+}
+
 /**
  * asb_context_get_hidpi_enabled:
  * @ctx: A #AsbContext
@@ -559,29 +651,45 @@ asb_context_get_packages (AsbContext *ctx)
 	return priv->packages;
 }
 
+/* the cost of extracting and examining one file, in compressed bytes */
+#define ASB_CONTEXT_FILE_COST		(64 * 1024)
+
 /**
- * asb_context_add_filename:
- * @ctx: A #AsbContext
- * @filename: package filename
- * @error: A #GError or %NULL
- *
- * Adds a filename to the list of packages to be processed
+ * asb_context_get_package_cost:
  *
- * Returns: %TRUE for success, %FALSE otherwise
- *
- * Since: 0.1.0
+ * Estimates how long the package will take to process, using the size of
+ * the package and the number of files that will be extracted if the file
+ * list has already been read. This is called from the threads that open
+ * the packages, so the scheduling pass does not have to do it serially.
  **/
-gboolean
-asb_context_add_filename (AsbContext *ctx, const gchar *filename, GError **error)
+static guint64
+asb_context_get_package_cost (AsbContext *ctx, AsbPackage *pkg)
 {
 	AsbContextPrivate *priv = GET_PRIVATE (ctx);
-	_cleanup_object_unref_ AsbPackage *pkg = NULL;
+	GStatBuf st;
+	gchar **filelist;
+	guint64 cost = 0;
+	guint i;
 
-	/* can find in existing metadata */
-	if (asb_context_find_in_cache (ctx, filename)) {
-		g_debug ("Found %s in old metadata", filename);
-		return TRUE;
+	if (g_stat (asb_package_get_filename (pkg), &st) == 0)
+		cost = st.st_size;
+	filelist = asb_package_get_filelist (pkg);
+	if (filelist == NULL || priv->file_globs == NULL)
+		return cost;
+	for (i = 0; filelist[i] != NULL; i++) {
+		if (asb_glob_value_search (priv->file_globs, filelist[i]) != NULL)
+			cost += ASB_CONTEXT_FILE_COST;
 	}
+	return cost;
+}
+
+/**
+ * asb_context_package_new:
+ **/
+static AsbPackage *
+asb_context_package_new (AsbContext *ctx, const gchar *filename, GError **error)
+{
+	_cleanup_object_unref_ AsbPackage *pkg = NULL;
 
 	/* open */
 #if HAVE_RPM
@@ -600,16 +708,187 @@ asb_context_add_filename (AsbContext *ctx, const gchar *filename, GError **error
 			     ASB_PLUGIN_ERROR_FAILED,
 			     "No idea how to handle %s",
 			     filename);
-		return FALSE;
+		return NULL;
 	}
 	if (!asb_package_open (pkg, filename, error))
+		return NULL;
+	asb_package_set_cost (pkg, asb_context_get_package_cost (ctx, pkg));
+	return g_object_ref (pkg);
+}
+
+/**
+ * asb_context_add_filename:
+ * @ctx: A #AsbContext
+ * @filename: package filename
+ * @error: A #GError or %NULL
+ *
+ * Adds a filename to the list of packages to be processed
+ *
+ * Returns: %TRUE for success, %FALSE otherwise
+ *
+ * Since: 0.1.0
+ **/
+gboolean
+asb_context_add_filename (AsbContext *ctx, const gchar *filename, GError **error)
+{
+	AsbContextPrivate *priv = GET_PRIVATE (ctx);
+	AsbPackage *pkg;
+
+	/* can find in existing metadata */
+	if (asb_context_find_in_cache (ctx, filename)) {
+		g_debug ("Found %s in old metadata", filename);
+		return TRUE;
+	}
+
+	/* open */
+	pkg = asb_context_package_new (ctx, filename, error);
+	if (pkg == NULL)
 		return FALSE;
 
 	/* add to array */
-	g_ptr_array_add (priv->packages, g_object_ref (pkg));
+	g_ptr_array_add (priv->packages, pkg);
 	return TRUE;
 }
 
+typedef struct {
+	GMutex		 mutex;
+	GCond		 cond;
+	guint		 done;
+} AsbContextOpenBatch;
+
+typedef struct {
+	AsbContext	*ctx;
+	AsbContextOpenBatch *batch;
+	const gchar	*filename;
+	AsbPackage	*pkg;
+	GError		*error;
+} AsbContextOpenItem;
+
+/**
+ * asb_context_open_func:
+ **/
+static void
+asb_context_open_func (gpointer data, gpointer user_data)
+{
+	AsbContextOpenItem *item = (AsbContextOpenItem *) data;
+	AsbContextOpenBatch *batch = item->batch;
+
+	item->pkg = asb_context_package_new (item->ctx,
+					     item->filename,
+					     &item->error);
+
+	/* wake up the caller so it can report progress */
+	g_mutex_lock (&batch->mutex);
+	batch->done++;
+	g_cond_signal (&batch->cond);
+	g_mutex_unlock (&batch->mutex);
+}
+
+/**
+ * asb_context_add_filenames:
+ * @ctx: A #AsbContext
+ * @filenames: (element-type utf8): package filenames
+ * @progress_func: (scope call): a #AsbContextProgressFunc, or %NULL
+ * @user_data: user data to pass to @progress_func
+ * @error: A #GError or %NULL
+ *
+ * Adds several filenames to the list of packages to be processed. This is
+ * the same as calling asb_context_add_filename() on each filename, but the
+ * package headers are read using the threads set with
+ * asb_context_set_max_threads(). The packages are added in the same order
+ * as @filenames, and any packages that cannot be opened are skipped.
+ *
+ * @progress_func is called from the calling thread each time a package
+ * has been opened, and always at least once when they are all done.
+ *
+ * Returns: %TRUE for success, %FALSE otherwise
+ *
+ * Since: 0.3.3
+ **/
+gboolean
+asb_context_add_filenames (AsbContext *ctx,
+			   GPtrArray *filenames,
+			   AsbContextProgressFunc progress_func,
+			   gpointer user_data,
+			   GError **error)
+{
+	AsbContextOpenBatch batch;
+	AsbContextOpenItem *item;
+	AsbContextPrivate *priv = GET_PRIVATE (ctx);
+	GThreadPool *pool;
+	gboolean ret = TRUE;
+	guint done;
+	guint i;
+	guint n_cached = 0;
+	guint n_pushed = 0;
+	guint reported = 0;
+	_cleanup_free_ AsbContextOpenItem *items = NULL;
+
+	pool = g_thread_pool_new (asb_context_open_func,
+				  ctx,
+				  priv->max_threads,
+				  TRUE,
+				  error);
+	if (pool == NULL)
+		return FALSE;
+
+	/* the old metadata is not thread safe, so check it first */
+	g_mutex_init (&batch.mutex);
+	g_cond_init (&batch.cond);
+	batch.done = 0;
+	items = g_new0 (AsbContextOpenItem, filenames->len);
+	for (i = 0; i < filenames->len; i++) {
+		item = &items[i];
+		item->ctx = ctx;
+		item->batch = &batch;
+		item->filename = g_ptr_array_index (filenames, i);
+		if (asb_context_find_in_cache (ctx, item->filename)) {
+			g_debug ("Found %s in old metadata", item->filename);
+			n_cached++;
+			continue;
+		}
+		if (!g_thread_pool_push (pool, item, error)) {
+			ret = FALSE;
+			break;
+		}
+		n_pushed++;
+	}
+
+	/* report progress as each package is opened */
+	do {
+		g_mutex_lock (&batch.mutex);
+		while (batch.done == reported && batch.done < n_pushed)
+			g_cond_wait (&batch.cond, &batch.mutex);
+		done = batch.done;
+		g_mutex_unlock (&batch.mutex);
+		if (progress_func != NULL)
+			progress_func (n_cached + done, filenames->len, user_data);
+		reported = done;
+	} while (done < n_pushed);
+
+	/* wait for the threads to finish */
+	g_thread_pool_free (pool, FALSE, TRUE);
+	g_mutex_clear (&batch.mutex);
+	g_cond_clear (&batch.cond);
+
+	/* add in the original order */
+	for (i = 0; i < filenames->len; i++) {
+		item = &items[i];
+		if (item->error != NULL) {
+			g_debug ("Failed to add package %s: %s",
+				 item->filename, item->error->message);
+			g_error_free (item->error);
+		}
+		if (item->pkg == NULL)
+			continue;
+		if (ret)
+			g_ptr_array_add (priv->packages, item->pkg);
+		else
+			g_object_unref (item->pkg);
+	}
+	return ret;
+}
+
 /**
  * asb_context_get_file_globs:
  * @ctx: A #AsbContext
@@ -893,17 +1172,144 @@ asb_context_setup (AsbContext *ctx, GError **error)
 }
 
 /**
- * asb_task_process_func:
+ * asb_context_add_busy:
+ **/
+static void
+asb_context_add_busy (AsbContext *ctx, gint64 *busy, gint64 start)
+{
+	AsbContextPrivate *priv = GET_PRIVATE (ctx);
+	g_mutex_lock (&priv->pipeline_mutex);
+	*busy += g_get_monotonic_time () - start;
+	g_mutex_unlock (&priv->pipeline_mutex);
+}
+
+/**
+ * asb_context_pipeline_release:
+ *
+ * Called when the tree for a task has been deleted to allow another package
+ * to be decompressed.
+ **/
+static void
+asb_context_pipeline_release (AsbContext *ctx, gint64 start)
+{
+	AsbContextPrivate *priv = GET_PRIVATE (ctx);
+	g_mutex_lock (&priv->pipeline_mutex);
+	priv->busy_cleanup += g_get_monotonic_time () - start;
+	priv->pipeline_depth--;
+	g_cond_signal (&priv->pipeline_cond);
+	g_mutex_unlock (&priv->pipeline_mutex);
+}
+
+/**
+ * asb_context_pipeline_push:
+ *
+ * Hands the task to the next stage, or deletes the tree straight away if
+ * that is not possible so the pipeline does not stall.
+ **/
+static void
+asb_context_pipeline_push (AsbContext *ctx, GThreadPool *pool, AsbTask *task)
+{
+	gint64 start;
+	_cleanup_error_free_ GError *error = NULL;
+
+	if (g_thread_pool_push (pool, task, &error))
+		return;
+	g_warning ("Failed to queue task: %s", error->message);
+	start = g_get_monotonic_time ();
+	asb_task_cleanup (task, NULL);
+	asb_context_pipeline_release (ctx, start);
+}
+
+/**
+ * asb_context_explode_func:
+ **/
+static void
+asb_context_explode_func (gpointer data, gpointer user_data)
+{
+	AsbContext *ctx = ASB_CONTEXT (user_data);
+	AsbContextPrivate *priv = GET_PRIVATE (ctx);
+	AsbTask *task = ASB_TASK (data);
+	gint64 start;
+	_cleanup_error_free_ GError *error = NULL;
+
+	/* do not decompress more packages than can be examined soon */
+	g_mutex_lock (&priv->pipeline_mutex);
+	while (priv->pipeline_depth >= priv->pipeline_max)
+		g_cond_wait (&priv->pipeline_cond, &priv->pipeline_mutex);
+	priv->pipeline_depth++;
+	g_mutex_unlock (&priv->pipeline_mutex);
+
+	start = g_get_monotonic_time ();
+	if (!asb_task_explode (task, &error)) {
+		g_warning ("Failed to run task: %s", error->message);
+		g_clear_error (&error);
+	}
+	asb_context_add_busy (ctx, &priv->busy_explode, start);
+
+	/* hand over to the next stage even on failure to remove the tree */
+	asb_context_pipeline_push (ctx, priv->pool_examine, task);
+}
+
+/**
+ * asb_context_examine_func:
+ **/
+static void
+asb_context_examine_func (gpointer data, gpointer user_data)
+{
+	AsbContext *ctx = ASB_CONTEXT (user_data);
+	AsbContextPrivate *priv = GET_PRIVATE (ctx);
+	AsbTask *task = ASB_TASK (data);
+	gint64 start;
+	_cleanup_error_free_ GError *error = NULL;
+
+	start = g_get_monotonic_time ();
+	if (!asb_task_examine (task, &error)) {
+		g_warning ("Failed to run task: %s", error->message);
+		g_clear_error (&error);
+	}
+	asb_context_add_busy (ctx, &priv->busy_examine, start);
+	asb_context_pipeline_push (ctx, priv->pool_save, task);
+}
+
+/**
+ * asb_context_save_func:
+ **/
+static void
+asb_context_save_func (gpointer data, gpointer user_data)
+{
+	AsbContext *ctx = ASB_CONTEXT (user_data);
+	AsbContextPrivate *priv = GET_PRIVATE (ctx);
+	AsbTask *task = ASB_TASK (data);
+	gint64 start;
+	_cleanup_error_free_ GError *error = NULL;
+
+	start = g_get_monotonic_time ();
+	if (!asb_task_save (task, &error)) {
+		g_warning ("Failed to run task: %s", error->message);
+		g_clear_error (&error);
+	}
+	asb_context_add_busy (ctx, &priv->busy_save, start);
+	asb_context_pipeline_push (ctx, priv->pool_cleanup, task);
+}
+
+/**
+ * asb_context_cleanup_func:
  **/
 static void
-asb_task_process_func (gpointer data, gpointer user_data)
+asb_context_cleanup_func (gpointer data, gpointer user_data)
 {
-	AsbTask *task = (AsbTask *) data;
+	AsbContext *ctx = ASB_CONTEXT (user_data);
+	AsbContextPrivate *priv = GET_PRIVATE (ctx);
+	AsbTask *task = ASB_TASK (data);
+	gint64 start;
 	_cleanup_error_free_ GError *error = NULL;
 
-	/* just run the task */
-	if (!asb_task_process (task, &error))
+	start = g_get_monotonic_time ();
+	if (!asb_task_cleanup (task, &error))
 		g_warning ("Failed to run task: %s", error->message);
+
+	/* allow another package to be decompressed */
+	asb_context_pipeline_release (ctx, start);
 }
 
 /**
@@ -987,7 +1393,8 @@ asb_context_write_xml (AsbContext *ctx,
 				 file,
 				 AS_NODE_TO_XML_FLAG_ADD_HEADER |
 				 AS_NODE_TO_XML_FLAG_FORMAT_INDENT |
-				 AS_NODE_TO_XML_FLAG_FORMAT_MULTILINE,
+				 AS_NODE_TO_XML_FLAG_FORMAT_MULTILINE |
+				 AS_NODE_TO_XML_FLAG_PARALLEL,
 				 NULL, error);
 }
 
@@ -1336,6 +1743,65 @@ asb_context_disable_multiarch_pkgs (AsbContext *ctx)
 	}
 }
 
+typedef struct {
+	AsbTask		*task;
+	guint64		 cost;
+	guint		 idx;
+} AsbContextJob;
+
+/**
+ * asb_context_job_sort_cb:
+ **/
+static gint
+asb_context_job_sort_cb (gconstpointer a, gconstpointer b)
+{
+	const AsbContextJob *job1 = a;
+	const AsbContextJob *job2 = b;
+
+	/* most expensive first, otherwise keep the package order */
+	if (job1->cost != job2->cost)
+		return job1->cost > job2->cost ? -1 : 1;
+	if (job1->idx != job2->idx)
+		return job1->idx < job2->idx ? -1 : 1;
+	return 0;
+}
+
+/**
+ * asb_context_print_efficiency:
+ **/
+static void
+asb_context_print_efficiency (const gchar *name,
+			      gint64 busy,
+			      gint64 elapsed,
+			      guint threads)
+{
+	g_print ("  %-8s %2u threads, %5.1f%% busy\n", name, threads,
+		 elapsed > 0 ? (gdouble) busy * 100.f / (gdouble) (elapsed * threads) : 0.f);
+}
+
+/**
+ * asb_context_pipeline_free:
+ **/
+static void
+asb_context_pipeline_free (AsbContext *ctx)
+{
+	AsbContextPrivate *priv = GET_PRIVATE (ctx);
+
+	/* each stage feeds the next, so drain them in order */
+	if (priv->pool_examine != NULL) {
+		g_thread_pool_free (priv->pool_examine, FALSE, TRUE);
+		priv->pool_examine = NULL;
+	}
+	if (priv->pool_save != NULL) {
+		g_thread_pool_free (priv->pool_save, FALSE, TRUE);
+		priv->pool_save = NULL;
+	}
+	if (priv->pool_cleanup != NULL) {
+		g_thread_pool_free (priv->pool_cleanup, FALSE, TRUE);
+		priv->pool_cleanup = NULL;
+	}
+}
+
 /**
  * asb_context_process:
  * @ctx: A #AsbContext
@@ -1353,28 +1819,83 @@ asb_context_process (AsbContext *ctx, AsbContextProcessFlags flags, GError **err
 {
 	AsbContextPrivate *priv = GET_PRIVATE (ctx);
 	AsbPackage *pkg;
+	AsbContextJob *job;
+	AsbContextJob job_tmp;
 	AsbTask *task;
 	GThreadPool *pool;
 	gboolean ret;
+	gint64 elapsed;
+	gint64 start;
+	guint explode_threads;
+	guint cleanup_threads;
 	guint i;
+	_cleanup_array_unref_ GArray *jobs = NULL;
 	_cleanup_ptrarray_unref_ GPtrArray *tasks = NULL;
 
 	/* only process the newest packages */
 	asb_context_disable_multiarch_pkgs (ctx);
 	asb_context_disable_older_pkgs (ctx);
 
-	/* create thread pool */
-	pool = g_thread_pool_new (asb_task_process_func,
+	/* each package is decompressed, examined, has its screenshots saved
+	 * and then is cleaned up in separate pools so that the disk and CPU
+	 * are both kept busy */
+	explode_threads = priv->explode_threads;
+	if (explode_threads == 0)
+		explode_threads = MAX (priv->max_threads / 2, 1);
+	cleanup_threads = priv->cleanup_threads;
+	if (cleanup_threads == 0)
+		cleanup_threads = 1;
+	priv->pipeline_depth = 0;
+	priv->pipeline_max = explode_threads + priv->max_threads * 3;
+	priv->busy_explode = 0;
+	priv->busy_examine = 0;
+	priv->busy_save = 0;
+	priv->busy_cleanup = 0;
+
+	/* the extra files may have changed since the last run */
+	g_free (priv->result_options);
+	priv->result_options = NULL;
+	g_hash_table_remove_all (priv->result_digests);
+
+	/* create thread pools */
+	priv->pool_cleanup = g_thread_pool_new (asb_context_cleanup_func,
+						ctx,
+						cleanup_threads,
+						TRUE,
+						error);
+	if (priv->pool_cleanup == NULL)
+		return FALSE;
+	priv->pool_save = g_thread_pool_new (asb_context_save_func,
+					     ctx,
+					     priv->max_threads,
+					     TRUE,
+					     error);
+	if (priv->pool_save == NULL) {
+		asb_context_pipeline_free (ctx);
+		return FALSE;
+	}
+	priv->pool_examine = g_thread_pool_new (asb_context_examine_func,
+						ctx,
+						priv->max_threads,
+						TRUE,
+						error);
+	if (priv->pool_examine == NULL) {
+		asb_context_pipeline_free (ctx);
+		return FALSE;
+	}
+	pool = g_thread_pool_new (asb_context_explode_func,
 				  ctx,
-				  priv->max_threads,
+				  explode_threads,
 				  TRUE,
 				  error);
-	if (pool == NULL)
+	if (pool == NULL) {
+		asb_context_pipeline_free (ctx);
 		return FALSE;
+	}
 
 	/* add each package */
 	g_print ("Processing packages...\n");
-	asb_panel_set_job_total (priv->panel, priv->packages->len);
+	jobs = g_array_new (FALSE, FALSE, sizeof (AsbContextJob));
 	tasks = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
 	for (i = 0; i < priv->packages->len; i++) {
 		pkg = g_ptr_array_index (priv->packages, i);
@@ -1400,18 +1921,49 @@ asb_context_process (AsbContext *ctx, AsbContextProcessFlags flags, GError **err
 
 		/* create task */
 		task = asb_task_new (ctx);
-		asb_task_set_id (task, i);
 		asb_task_set_package (task, pkg);
 		asb_task_set_panel (task, priv->panel);
 		g_ptr_array_add (tasks, task);
 
+		/* estimate the cost */
+		job_tmp.task = task;
+		job_tmp.cost = asb_package_get_cost (pkg);
+		job_tmp.idx = i;
+		g_array_append_val (jobs, job_tmp);
+	}
+
+	/* start the longest packages first so they do not hold up the end */
+	g_array_sort (jobs, asb_context_job_sort_cb);
+	asb_panel_set_job_total (priv->panel, jobs->len);
+	start = g_get_monotonic_time ();
+	for (i = 0; i < jobs->len; i++) {
+		job = &g_array_index (jobs, AsbContextJob, i);
+		asb_task_set_id (job->task, i);
+
 		/* add task to pool */
-		if (!g_thread_pool_push (pool, task, error))
+		if (!g_thread_pool_push (pool, job->task, error)) {
+			g_thread_pool_free (pool, FALSE, TRUE);
+			asb_context_pipeline_free (ctx);
 			return FALSE;
+		}
 	}
 
 	/* wait for them to finish */
 	g_thread_pool_free (pool, FALSE, TRUE);
+	asb_context_pipeline_free (ctx);
+
+	/* show how well the threads were used */
+	elapsed = g_get_monotonic_time () - start;
+	g_print ("Processed %u packages in %.1fs, parallel efficiency:\n",
+		 jobs->len, (gdouble) elapsed / G_USEC_PER_SEC);
+	asb_context_print_efficiency ("explode", priv->busy_explode,
+				      elapsed, explode_threads);
+	asb_context_print_efficiency ("examine", priv->busy_examine,
+				      elapsed, priv->max_threads);
+	asb_context_print_efficiency ("save", priv->busy_save,
+				      elapsed, priv->max_threads);
+	asb_context_print_efficiency ("cleanup", priv->busy_cleanup,
+				      elapsed, cleanup_threads);
 
 	/* merge */
 	g_print ("Merging applications...\n");
@@ -1469,6 +2021,523 @@ asb_context_process (AsbContext *ctx, AsbContextProcessFlags flags, GError **err
 	return TRUE;
 }
 
+/**
+ * asb_context_filename_sort_cb:
+ **/
+static gint
+asb_context_filename_sort_cb (gconstpointer a, gconstpointer b)
+{
+	return g_strcmp0 (*((const gchar **) a), *((const gchar **) b));
+}
+
+/**
+ * asb_context_checksum_dir:
+ *
+ * Adds the relative name, size and modification time of every file in
+ * @path to @csum, which is much quicker than reading each file and still
+ * notices any file being edited or replaced.
+ **/
+static gboolean
+asb_context_checksum_dir (GChecksum *csum,
+			  const gchar *path,
+			  const gchar *prefix,
+			  GError **error)
+{
+	const gchar *tmp;
+	guint i;
+	_cleanup_dir_close_ GDir *dir = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *names = NULL;
+
+	if (path == NULL || !g_file_test (path, G_FILE_TEST_IS_DIR)) {
+		g_checksum_update (csum, (const guchar *) "\n", -1);
+		return TRUE;
+	}
+	dir = g_dir_open (path, 0, error);
+	if (dir == NULL)
+		return FALSE;
+
+	/* the order from the filesystem is not stable */
+	names = g_ptr_array_new_with_free_func (g_free);
+	while ((tmp = g_dir_read_name (dir)) != NULL)
+		g_ptr_array_add (names, g_strdup (tmp));
+	g_ptr_array_sort (names, asb_context_filename_sort_cb);
+	for (i = 0; i < names->len; i++) {
+		GStatBuf buf;
+		_cleanup_free_ gchar *fn = NULL;
+		_cleanup_free_ gchar *line = NULL;
+		_cleanup_free_ gchar *name = NULL;
+
+		name = g_build_filename (prefix, g_ptr_array_index (names, i), NULL);
+		fn = g_build_filename (path, g_ptr_array_index (names, i), NULL);
+		if (g_stat (fn, &buf) != 0) {
+			g_set_error (error,
+				     ASB_PLUGIN_ERROR,
+				     ASB_PLUGIN_ERROR_FAILED,
+				     "Failed to get info about %s", fn);
+			return FALSE;
+		}
+		if (S_ISDIR (buf.st_mode)) {
+			if (!asb_context_checksum_dir (csum, fn, name, error))
+				return FALSE;
+			continue;
+		}
+		line = g_strdup_printf ("%s\t%" G_GINT64_FORMAT "\t%" G_GINT64_FORMAT "\n",
+					name, (gint64) buf.st_size, (gint64) buf.st_mtime);
+		g_checksum_update (csum, (const guchar *) line, -1);
+	}
+	return TRUE;
+}
+
+/**
+ * asb_context_get_result_options:
+ *
+ * Gets a checksum of everything apart from the packages that changes the
+ * generated metadata. This is only worked out once for each context.
+ **/
+static const gchar *
+asb_context_get_result_options (AsbContext *ctx, GError **error)
+{
+	AsbContextPrivate *priv = GET_PRIVATE (ctx);
+	AsbPlugin *plugin;
+	GPtrArray *plugins;
+	const gchar *result = NULL;
+	guint i;
+	_cleanup_checksum_free_ GChecksum *csum = NULL;
+	_cleanup_free_ gchar *builder_id = NULL;
+	_cleanup_free_ gchar *options = NULL;
+
+	g_mutex_lock (&priv->result_mutex);
+	if (priv->result_options != NULL) {
+		result = priv->result_options;
+		goto out;
+	}
+
+	/* anything that changes the output */
+	csum = g_checksum_new (G_CHECKSUM_SHA256);
+	builder_id = asb_utils_get_builder_id ();
+	options = g_strdup_printf ("%s\n%s\n%.2f\n%i\n%i\n%i\n%i\n%u\n%s\n%s\n",
+				   builder_id,
+				   PACKAGE_VERSION,
+				   priv->api_version,
+				   priv->add_cache_id,
+				   priv->hidpi_enabled,
+				   priv->embedded_icons,
+				   priv->no_net,
+				   priv->min_icon_size,
+				   priv->screenshot_uri,
+				   priv->screenshot_dir);
+	g_checksum_update (csum, (const guchar *) options, -1);
+	plugins = asb_plugin_loader_get_plugins (priv->plugin_loader);
+	for (i = 0; i < plugins->len; i++) {
+		plugin = g_ptr_array_index (plugins, i);
+		g_checksum_update (csum, (const guchar *) plugin->name, -1);
+		g_checksum_update (csum, (const guchar *) "\n", -1);
+	}
+
+	/* the files merged into the applications, not just where they are */
+	if (!asb_context_checksum_dir (csum, priv->extra_appdata, "", error))
+		goto out;
+	if (!asb_context_checksum_dir (csum, priv->extra_screenshots, "", error))
+		goto out;
+	priv->result_options = g_strdup (g_checksum_get_string (csum));
+	result = priv->result_options;
+out:
+	g_mutex_unlock (&priv->result_mutex);
+	return result;
+}
+
+/**
+ * asb_context_get_result_digest:
+ *
+ * Gets the checksum of the contents of a package, which is remembered as
+ * the same extra packages are used by many other packages.
+ **/
+static gchar *
+asb_context_get_result_digest (AsbContext *ctx,
+			       const gchar *filename,
+			       GError **error)
+{
+	AsbContextPrivate *priv = GET_PRIVATE (ctx);
+	gchar *digest;
+
+	g_mutex_lock (&priv->result_mutex);
+	digest = g_strdup (g_hash_table_lookup (priv->result_digests, filename));
+	g_mutex_unlock (&priv->result_mutex);
+	if (digest != NULL)
+		return digest;
+	digest = asb_utils_get_cache_id_for_file (filename, error);
+	if (digest == NULL)
+		return NULL;
+	g_mutex_lock (&priv->result_mutex);
+	g_hash_table_insert (priv->result_digests,
+			     g_strdup (filename),
+			     g_strdup (digest));
+	g_mutex_unlock (&priv->result_mutex);
+	return digest;
+}
+
+/**
+ * asb_context_get_result_key:
+ * @ctx: A #AsbContext
+ * @pkg: A #AsbPackage
+ * @extra_pkgs: (element-type AsbPackage): packages exploded with @pkg
+ * @error: A #GError or %NULL
+ *
+ * Gets the key used for the cached result of a package. This depends on
+ * the contents of the package and any extra packages, the plugins, the
+ * files in the extra AppData and screenshot directories and the options
+ * that affect the generated metadata.
+ *
+ * Returns: a checksum, or %NULL for error
+ **/
+gchar *
+asb_context_get_result_key (AsbContext *ctx,
+			    AsbPackage *pkg,
+			    GPtrArray *extra_pkgs,
+			    GError **error)
+{
+	AsbPackage *pkg_extra;
+	const gchar *options;
+	guint i;
+	_cleanup_checksum_free_ GChecksum *csum = NULL;
+	_cleanup_free_ gchar *cache_id = NULL;
+
+	cache_id = asb_utils_get_cache_id_for_file (asb_package_get_filename (pkg),
+						    error);
+	if (cache_id == NULL)
+		return NULL;
+	csum = g_checksum_new (G_CHECKSUM_SHA256);
+	g_checksum_update (csum, (const guchar *) cache_id, -1);
+	g_checksum_update (csum, (const guchar *) "\n", -1);
+
+	/* anything that changes the output */
+	options = asb_context_get_result_options (ctx, error);
+	if (options == NULL)
+		return NULL;
+	g_checksum_update (csum, (const guchar *) options, -1);
+	g_checksum_update (csum, (const guchar *) "\n", -1);
+
+	/* files from other packages, e.g. icon themes */
+	for (i = 0; extra_pkgs != NULL && i < extra_pkgs->len; i++) {
+		_cleanup_free_ gchar *digest = NULL;
+		pkg_extra = g_ptr_array_index (extra_pkgs, i);
+		digest = asb_context_get_result_digest (ctx,
+							asb_package_get_filename (pkg_extra),
+							error);
+		if (digest == NULL)
+			return NULL;
+		g_checksum_update (csum, (const guchar *) digest, -1);
+		g_checksum_update (csum, (const guchar *) "\n", -1);
+	}
+	return g_strdup (g_checksum_get_string (csum));
+}
+
+/**
+ * asb_context_get_result_dir:
+ **/
+static gchar *
+asb_context_get_result_dir (AsbContext *ctx, const gchar *key)
+{
+	AsbContextPrivate *priv = GET_PRIVATE (ctx);
+	gchar prefix[3] = { key[0], key[1], '\0' };
+	return g_build_filename (priv->cache_dir, "results", prefix, key, NULL);
+}
+
+/**
+ * asb_context_get_image_size_str:
+ **/
+static gchar *
+asb_context_get_image_size_str (AsImage *im)
+{
+	if (as_image_get_kind (im) == AS_IMAGE_KIND_SOURCE)
+		return g_strdup ("source");
+	return g_strdup_printf ("%ix%i",
+				as_image_get_width (im),
+				as_image_get_height (im));
+}
+
+/**
+ * asb_context_copy_file:
+ **/
+static gboolean
+asb_context_copy_file (const gchar *src, const gchar *dest, GError **error)
+{
+	_cleanup_free_ gchar *dirname = NULL;
+	_cleanup_object_unref_ GFile *file_dest = NULL;
+	_cleanup_object_unref_ GFile *file_src = NULL;
+
+	dirname = g_path_get_dirname (dest);
+	if (!asb_utils_ensure_exists (dirname, error))
+		return FALSE;
+	file_src = g_file_new_for_path (src);
+	file_dest = g_file_new_for_path (dest);
+	return g_file_copy (file_src, file_dest,
+			    G_FILE_COPY_OVERWRITE,
+			    NULL, NULL, NULL, error);
+}
+
+/**
+ * asb_context_copy_screenshots:
+ **/
+static gboolean
+asb_context_copy_screenshots (AsApp *app,
+			      const gchar *src_dir,
+			      const gchar *dest_dir,
+			      GError **error)
+{
+	AsImage *im;
+	AsScreenshot *ss;
+	GPtrArray *images;
+	GPtrArray *screenshots;
+	guint i;
+	guint j;
+
+	screenshots = as_app_get_screenshots (app);
+	for (i = 0; i < screenshots->len; i++) {
+		ss = g_ptr_array_index (screenshots, i);
+		images = as_screenshot_get_images (ss);
+		for (j = 0; j < images->len; j++) {
+			_cleanup_free_ gchar *dest = NULL;
+			_cleanup_free_ gchar *size_str = NULL;
+			_cleanup_free_ gchar *src = NULL;
+			im = g_ptr_array_index (images, j);
+			if (as_image_get_basename (im) == NULL)
+				continue;
+			size_str = asb_context_get_image_size_str (im);
+			src = g_build_filename (src_dir, size_str,
+						as_image_get_basename (im), NULL);
+			dest = g_build_filename (dest_dir, size_str,
+						 as_image_get_basename (im), NULL);
+			if (!g_file_test (src, G_FILE_TEST_EXISTS))
+				continue;
+			if (g_file_test (dest, G_FILE_TEST_EXISTS))
+				continue;
+			if (!asb_context_copy_file (src, dest, error))
+				return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * asb_context_save_result:
+ * @ctx: A #AsbContext
+ * @pkg: A #AsbPackage
+ * @key: a key from asb_context_get_result_key()
+ * @apps: (element-type AsbApp): the applications found in @pkg
+ * @error: A #GError or %NULL
+ *
+ * Saves the applications found in a package, along with their icons,
+ * screenshots and the package log, to the cache directory.
+ *
+ * Returns: %TRUE for success, %FALSE otherwise
+ **/
+gboolean
+asb_context_save_result (AsbContext *ctx,
+			 AsbPackage *pkg,
+			 const gchar *key,
+			 GPtrArray *apps,
+			 GError **error)
+{
+	AsApp *app;
+	AsIcon *icon;
+	AsbContextPrivate *priv = GET_PRIVATE (ctx);
+	GNode *node_apps;
+	GPtrArray *icons;
+	guint i;
+	guint j;
+	_cleanup_free_ gchar *dirname = NULL;
+	_cleanup_free_ gchar *filename = NULL;
+	_cleanup_free_ gchar *log_str = NULL;
+	_cleanup_free_ gchar *parent = NULL;
+	_cleanup_free_ gchar *tmpdir = NULL;
+	_cleanup_node_unref_ GNode *root = NULL;
+	_cleanup_object_unref_ GFile *file = NULL;
+
+	/* write everything to a private directory first */
+	dirname = asb_context_get_result_dir (ctx, key);
+	if (g_file_test (dirname, G_FILE_TEST_EXISTS))
+		return TRUE;
+	parent = g_path_get_dirname (dirname);
+	if (!asb_utils_ensure_exists (parent, error))
+		return FALSE;
+	tmpdir = g_strdup_printf ("%s.XXXXXX", dirname);
+	if (g_mkdtemp (tmpdir) == NULL) {
+		g_set_error (error,
+			     ASB_PLUGIN_ERROR,
+			     ASB_PLUGIN_ERROR_FAILED,
+			     "Failed to create %s", tmpdir);
+		return FALSE;
+	}
+
+	/* the vetos are only written in newer versions */
+	root = as_node_new ();
+	node_apps = as_node_insert (root, "components", NULL,
+				    AS_NODE_INSERT_FLAG_NONE,
+				    "version", "0.8",
+				    NULL);
+	for (i = 0; i < apps->len; i++) {
+		app = g_ptr_array_index (apps, i);
+		as_app_node_insert (app, node_apps, 0.8);
+
+		/* icons are only written to the tarball at the end */
+		icons = as_app_get_icons (app);
+		for (j = 0; j < icons->len; j++) {
+			_cleanup_free_ gchar *fn = NULL;
+			_cleanup_free_ gchar *fn_dir = NULL;
+			icon = g_ptr_array_index (icons, j);
+			if (as_icon_get_kind (icon) != AS_ICON_KIND_CACHED)
+				continue;
+			if (as_icon_get_pixbuf (icon) == NULL)
+				continue;
+			fn = g_build_filename (tmpdir, "icons",
+					       as_icon_get_name (icon), NULL);
+			fn_dir = g_path_get_dirname (fn);
+			if (!asb_utils_ensure_exists (fn_dir, error))
+				goto fail;
+			if (!gdk_pixbuf_save (as_icon_get_pixbuf (icon),
+					      fn, "png", error, NULL))
+				goto fail;
+		}
+
+		/* screenshots are normally shared, but may not be */
+		if (priv->screenshot_dir != NULL) {
+			_cleanup_free_ gchar *ss_dir = NULL;
+			ss_dir = g_build_filename (tmpdir, "screenshots", NULL);
+			if (!asb_context_copy_screenshots (app,
+							   priv->screenshot_dir,
+							   ss_dir,
+							   error))
+				goto fail;
+		}
+	}
+	filename = g_build_filename (tmpdir, "log.txt", NULL);
+	log_str = asb_package_get_log (pkg);
+	if (!g_file_set_contents (filename, log_str, -1, error))
+		goto fail;
+	g_free (filename);
+	filename = g_build_filename (tmpdir, "components.xml", NULL);
+	file = g_file_new_for_path (filename);
+	if (!as_node_to_file (root, file,
+			      AS_NODE_TO_XML_FLAG_ADD_HEADER |
+			      AS_NODE_TO_XML_FLAG_FORMAT_INDENT |
+			      AS_NODE_TO_XML_FLAG_FORMAT_MULTILINE,
+			      NULL, error))
+		goto fail;
+
+	/* another thread or machine may have got there first */
+	if (g_rename (tmpdir, dirname) != 0)
+		return asb_utils_rmtree (tmpdir, error);
+	return TRUE;
+fail:
+	asb_utils_rmtree (tmpdir, NULL);
+	return FALSE;
+}
+
+/**
+ * asb_context_load_result:
+ * @ctx: A #AsbContext
+ * @pkg: A #AsbPackage
+ * @key: a key from asb_context_get_result_key()
+ * @error: A #GError or %NULL
+ *
+ * Loads the applications found in a package from the cache directory,
+ * restoring any screenshots and appending the cached package log.
+ *
+ * Returns: (transfer container) (element-type AsbApp): the applications,
+ * or %NULL with %G_IO_ERROR_NOT_FOUND if the package is not in the cache
+ **/
+GPtrArray *
+asb_context_load_result (AsbContext *ctx,
+			 AsbPackage *pkg,
+			 const gchar *key,
+			 GError **error)
+{
+	AsIcon *icon;
+	AsbContextPrivate *priv = GET_PRIVATE (ctx);
+	GNode *n;
+	GNode *node_apps;
+	GPtrArray *icons;
+	guint i;
+	_cleanup_free_ gchar *cache_id = NULL;
+	_cleanup_free_ gchar *dirname = NULL;
+	_cleanup_free_ gchar *filename = NULL;
+	_cleanup_free_ gchar *icons_dir = NULL;
+	_cleanup_free_ gchar *log = NULL;
+	_cleanup_free_ gchar *ss_dir = NULL;
+	_cleanup_node_unref_ GNode *root = NULL;
+	_cleanup_object_unref_ GFile *file = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *apps = NULL;
+
+	dirname = asb_context_get_result_dir (ctx, key);
+	filename = g_build_filename (dirname, "components.xml", NULL);
+	file = g_file_new_for_path (filename);
+	root = as_node_from_file (file, AS_NODE_FROM_XML_FLAG_NONE, NULL, error);
+	if (root == NULL)
+		return NULL;
+	node_apps = as_node_find (root, "components");
+	if (node_apps == NULL) {
+		g_set_error (error,
+			     ASB_PLUGIN_ERROR,
+			     ASB_PLUGIN_ERROR_FAILED,
+			     "No components in %s", filename);
+		return NULL;
+	}
+
+	/* the filename may be different to last time */
+	if (priv->add_cache_id)
+		cache_id = asb_utils_get_cache_id_for_filename (asb_package_get_filename (pkg));
+
+	apps = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	icons_dir = g_build_filename (dirname, "icons", NULL);
+	ss_dir = g_build_filename (dirname, "screenshots", NULL);
+	for (n = node_apps->children; n != NULL; n = n->next) {
+		_cleanup_object_unref_ AsbApp *app = NULL;
+		if (g_strcmp0 (as_node_get_name (n), "component") != 0)
+			continue;
+		app = asb_app_new (pkg, NULL);
+		asb_app_set_hidpi_enabled (app, priv->hidpi_enabled);
+		if (!as_app_node_parse (AS_APP (app), n, error))
+			return NULL;
+		if (cache_id != NULL)
+			as_app_add_metadata (AS_APP (app), "X-CacheID", cache_id, -1);
+
+		/* the icons are saved to the tarball from the pixbuf */
+		icons = as_app_get_icons (AS_APP (app));
+		for (i = 0; i < icons->len; i++) {
+			icon = g_ptr_array_index (icons, i);
+			if (as_icon_get_kind (icon) != AS_ICON_KIND_CACHED)
+				continue;
+			as_icon_set_prefix (icon, icons_dir);
+			if (!as_icon_load (icon, AS_ICON_LOAD_FLAG_NONE, error))
+				return NULL;
+		}
+
+		/* restore any screenshots not already present */
+		if (priv->screenshot_dir != NULL) {
+			if (!asb_context_copy_screenshots (AS_APP (app),
+							   ss_dir,
+							   priv->screenshot_dir,
+							   error))
+				return NULL;
+		}
+		g_ptr_array_add (apps, g_object_ref (app));
+	}
+
+	/* add the log from last time */
+	g_free (filename);
+	filename = g_build_filename (dirname, "log.txt", NULL);
+	if (g_file_get_contents (filename, &log, NULL, NULL)) {
+		g_strchomp (log);
+		asb_package_log (pkg, ASB_PACKAGE_LOG_LEVEL_INFO,
+				 "Using cached result %s", key);
+		if (log[0] != '\0')
+			asb_package_log (pkg, ASB_PACKAGE_LOG_LEVEL_NONE,
+					 "%s", log);
+	}
+	return g_ptr_array_ref (apps);
+}
+
 /**
  * asb_context_find_in_cache:
  * @ctx: A #AsbContext
@@ -1624,6 +2693,11 @@ asb_context_finalize (GObject *object)
 	if (priv->file_globs != NULL)
 		g_ptr_array_unref (priv->file_globs);
 	g_mutex_clear (&priv->apps_mutex);
+	g_mutex_clear (&priv->pipeline_mutex);
+	g_cond_clear (&priv->pipeline_cond);
+	g_mutex_clear (&priv->result_mutex);
+	g_hash_table_unref (priv->result_digests);
+	g_free (priv->result_options);
 	g_free (priv->old_metadata);
 	g_free (priv->extra_appstream);
 	g_free (priv->extra_appdata);
@@ -1651,6 +2725,11 @@ asb_context_init (AsbContext *ctx)
 	priv->panel = asb_panel_new ();
 	priv->packages = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
 	g_mutex_init (&priv->apps_mutex);
+	g_mutex_init (&priv->pipeline_mutex);
+	g_cond_init (&priv->pipeline_cond);
+	g_mutex_init (&priv->result_mutex);
+	priv->result_digests = g_hash_table_new_full (g_str_hash, g_str_equal,
+						      g_free, g_free);
 	priv->store_failed = as_store_new ();
 	priv->store_ignore = as_store_new ();
 	priv->store_old = as_store_new ();
@@ -74,6 +74,20 @@ typedef enum {
 	AS_CONTEXT_PARSE_FLAG_LAST,
 } AsbContextProcessFlags;
 
+/**
+ * AsbContextProgressFunc:
+ * @current: the number of packages done so far
+ * @total: the total number of packages
+ * @user_data: user data
+ *
+ * Reports progress while adding packages.
+ *
+ * Since: 0.3.3
+ **/
+typedef void	 (*AsbContextProgressFunc)	(guint		 current,
+						 guint		 total,
+						 gpointer	 user_data);
+
 GType		 asb_context_get_type		(void);
 
 AsbContext	*asb_context_new		(void);
@@ -93,8 +107,14 @@ void		 asb_context_set_hidpi_enabled	(AsbContext	*ctx,
 						 gboolean	 hidpi_enabled);
 void		 asb_context_set_embedded_icons	(AsbContext	*ctx,
 						 gboolean	 embedded_icons);
+void		 asb_context_set_result_cache_enabled (AsbContext	*ctx,
+						 gboolean	 result_cache_enabled);
 void		 asb_context_set_max_threads	(AsbContext	*ctx,
 						 guint		 max_threads);
+void		 asb_context_set_explode_threads (AsbContext	*ctx,
+						 guint		 explode_threads);
+void		 asb_context_set_cleanup_threads (AsbContext	*ctx,
+						 guint		 cleanup_threads);
 void		 asb_context_set_min_icon_size	(AsbContext	*ctx,
 						 guint		 min_icon_size);
 void		 asb_context_set_old_metadata	(AsbContext	*ctx,
@@ -123,6 +143,7 @@ const gchar	*asb_context_get_temp_dir	(AsbContext	*ctx);
 gboolean	 asb_context_get_add_cache_id	(AsbContext	*ctx);
 gboolean	 asb_context_get_hidpi_enabled	(AsbContext	*ctx);
 gboolean	 asb_context_get_embedded_icons	(AsbContext	*ctx);
+gboolean	 asb_context_get_result_cache_enabled (AsbContext	*ctx);
 gboolean	 asb_context_get_no_net		(AsbContext	*ctx);
 gdouble		 asb_context_get_api_version	(AsbContext	*ctx);
 guint		 asb_context_get_min_icon_size	(AsbContext	*ctx);
@@ -135,6 +156,11 @@ gboolean	 asb_context_process		(AsbContext	*ctx,
 gboolean	 asb_context_add_filename	(AsbContext	*ctx,
 						 const gchar	*filename,
 						 GError		**error);
+gboolean	 asb_context_add_filenames	(AsbContext	*ctx,
+						 GPtrArray	*filenames,
+						 AsbContextProgressFunc progress_func,
+						 gpointer	 user_data,
+						 GError		**error);
 gboolean	 asb_context_find_in_cache	(AsbContext	*ctx,
 						 const gchar	*filename);
 
@@ -29,10 +29,13 @@
 
 #include "config.h"
 
+#include <archive.h>
+#include <archive_entry.h>
+
 #include "as-cleanup.h"
 #include "asb-package-deb.h"
 #include "asb-plugin.h"
-
+#include "asb-utils-private.h"
 
 G_DEFINE_TYPE (AsbPackageDeb, asb_package_deb, ASB_TYPE_PACKAGE)
 
@@ -45,103 +48,198 @@ asb_package_deb_init (AsbPackageDeb *pkg)
 }
 
 /**
- * asb_package_deb_ensure_simple:
+ * asb_package_deb_set_field:
  **/
-static gboolean
-asb_package_deb_ensure_simple (AsbPackage *pkg, GError **error)
+static void
+asb_package_deb_set_field (AsbPackage *pkg,
+			   const gchar *key,
+			   gchar *value,
+			   GPtrArray *deps)
 {
-	const gchar *argv[4] = { "dpkg", "--field", "fn", NULL };
 	gchar *tmp;
-	gchar **vr;
-	guint i;
 	guint j;
-	_cleanup_free_ gchar *output = NULL;
+	_cleanup_strv_free_ gchar **vr = NULL;
+
+	if (g_strcmp0 (key, "Package") == 0) {
+		asb_package_set_name (pkg, value);
+		return;
+	}
+	if (g_strcmp0 (key, "Source") == 0) {
+		asb_package_set_source (pkg, value);
+		return;
+	}
+	if (g_strcmp0 (key, "Version") == 0) {
+		vr = g_strsplit (value, "-", 2);
+		tmp = g_strstr_len (vr[0], -1, ":");
+		if (tmp == NULL) {
+			asb_package_set_version (pkg, vr[0]);
+		} else {
+			*tmp = '\0';
+			j = g_ascii_strtoll (vr[0], NULL, 10);
+			asb_package_set_epoch (pkg, j);
+			asb_package_set_version (pkg, tmp + 1);
+		}
+		asb_package_set_release (pkg, vr[1]);
+		return;
+	}
+	if (g_strcmp0 (key, "Depends") == 0) {
+		vr = g_strsplit (value, ", ", -1);
+		for (j = 0; vr[j] != NULL; j++) {
+			tmp = g_strstr_len (vr[j], -1, " ");
+			if (tmp != NULL)
+				*tmp = '\0';
+			g_ptr_array_add (deps, g_strdup (vr[j]));
+		}
+		return;
+	}
+}
+
+/**
+ * asb_package_deb_parse_control:
+ *
+ * Parses the control file, where each field is "Key: value" and any line
+ * starting with whitespace continues the previous field.
+ **/
+static void
+asb_package_deb_parse_control (AsbPackage *pkg, const gchar *data)
+{
+	gchar *tmp;
+	guint i;
+	_cleanup_free_ gchar *key = NULL;
 	_cleanup_ptrarray_unref_ GPtrArray *deps = NULL;
 	_cleanup_strv_free_ gchar **lines = NULL;
+	_cleanup_string_free_ GString *value = NULL;
 
-	/* spawn sync */
-	argv[2] = asb_package_get_filename (pkg);
-	if (!g_spawn_sync (NULL, (gchar **) argv, NULL,
-			   G_SPAWN_SEARCH_PATH,
-			   NULL, NULL,
-			   &output, NULL, NULL, error))
-		return FALSE;
-
-	/* parse output */
 	deps = g_ptr_array_new_with_free_func (g_free);
-	lines = g_strsplit (output, "\n", -1);
+	value = g_string_new ("");
+	lines = g_strsplit (data, "\n", -1);
 	for (i = 0; lines[i] != NULL; i++) {
-		if (g_str_has_prefix (lines[i], "Package: ")) {
-			asb_package_set_name (pkg, lines[i] + 9);
+
+		/* continuation of the previous field */
+		if (lines[i][0] == ' ' || lines[i][0] == '\t') {
+			if (key != NULL)
+				g_string_append (value, lines[i]);
 			continue;
 		}
-		if (g_str_has_prefix (lines[i], "Source: ")) {
-			asb_package_set_source (pkg, lines[i] + 8);
-			continue;
+
+		/* new field, so the previous one is complete */
+		if (key != NULL) {
+			asb_package_deb_set_field (pkg, key, value->str, deps);
+			g_free (key);
+			key = NULL;
 		}
-		if (g_str_has_prefix (lines[i], "Version: ")) {
-			vr = g_strsplit (lines[i] + 9, "-", 2);
-			tmp = g_strstr_len (vr[0], -1, ":");
-			if (tmp == NULL) {
-				asb_package_set_version (pkg, vr[0]);
-			} else {
-				*tmp = '\0';
-				j = g_ascii_strtoll (vr[0], NULL, 10);
-				asb_package_set_epoch (pkg, j);
-				asb_package_set_version (pkg, tmp + 1);
-			}
-			asb_package_set_release (pkg, vr[1]);
-			g_strfreev (vr);
+		tmp = g_strstr_len (lines[i], -1, ":");
+		if (tmp == NULL)
 			continue;
+		key = g_strndup (lines[i], tmp - lines[i]);
+		for (tmp++; *tmp == ' ' || *tmp == '\t'; tmp++);
+		g_string_assign (value, tmp);
+	}
+	if (key != NULL)
+		asb_package_deb_set_field (pkg, key, value->str, deps);
+
+	g_ptr_array_add (deps, NULL);
+	asb_package_set_deps (pkg, (gchar **) deps->pdata);
+}
+
+/**
+ * asb_package_deb_read_control:
+ **/
+static gboolean
+asb_package_deb_read_control (AsbPackage *pkg,
+			      struct archive *arch,
+			      GError **error)
+{
+	int r;
+	struct archive_entry *entry;
+
+	for (;;) {
+		const gchar *tmp;
+		gchar buf[4096];
+		gssize len;
+		_cleanup_string_free_ GString *data = NULL;
+
+		r = archive_read_next_header (arch, &entry);
+		if (r == ARCHIVE_EOF)
+			break;
+		if (r != ARCHIVE_OK) {
+			g_set_error (error,
+				     ASB_PLUGIN_ERROR,
+				     ASB_PLUGIN_ERROR_FAILED,
+				     "Cannot read control header: %s",
+				     archive_error_string (arch));
+			return FALSE;
 		}
-		if (g_str_has_prefix (lines[i], "Depends: ")) {
-			vr = g_strsplit (lines[i] + 9, ", ", -1);
-			for (j = 0; vr[j] != NULL; j++) {
-				tmp = g_strstr_len (vr[j], -1, " ");
-				if (tmp != NULL)
-					*tmp = '\0';
-				g_ptr_array_add (deps, vr[j]);
-			}
+		tmp = archive_entry_pathname (entry);
+		if (g_strcmp0 (tmp, "./control") != 0 &&
+		    g_strcmp0 (tmp, "control") != 0)
 			continue;
+
+		/* read the whole file, it is only a few kilobytes */
+		data = g_string_new ("");
+		while ((len = archive_read_data (arch, buf, sizeof (buf))) > 0)
+			g_string_append_len (data, buf, len);
+		if (len < 0) {
+			g_set_error (error,
+				     ASB_PLUGIN_ERROR,
+				     ASB_PLUGIN_ERROR_FAILED,
+				     "Cannot read control: %s",
+				     archive_error_string (arch));
+			return FALSE;
 		}
+		asb_package_deb_parse_control (pkg, data->str);
+		return TRUE;
 	}
-	g_ptr_array_add (deps, NULL);
-	asb_package_set_deps (pkg, (gchar **) deps->pdata);
-	return TRUE;
+	g_set_error (error,
+		     ASB_PLUGIN_ERROR,
+		     ASB_PLUGIN_ERROR_FAILED,
+		     "No control file in %s",
+		     asb_package_get_filename (pkg));
+	return FALSE;
 }
 
 /**
- * asb_package_deb_ensure_filelists:
+ * asb_package_deb_read_filelist:
  **/
 static gboolean
-asb_package_deb_ensure_filelists (AsbPackage *pkg, GError **error)
+asb_package_deb_read_filelist (AsbPackage *pkg,
+			       struct archive *arch,
+			       GError **error)
 {
-	const gchar *argv[4] = { "dpkg", "--contents", "fn", NULL };
-	const gchar *fn;
-	guint i;
-	_cleanup_free_ gchar *output = NULL;
+	int r;
+	struct archive_entry *entry;
 	_cleanup_ptrarray_unref_ GPtrArray *files = NULL;
-	_cleanup_strv_free_ gchar **lines = NULL;
-
-	/* spawn sync */
-	argv[2] = asb_package_get_filename (pkg);
-	if (!g_spawn_sync (NULL, (gchar **) argv, NULL,
-			   G_SPAWN_SEARCH_PATH,
-			   NULL, NULL,
-			   &output, NULL, NULL, error))
-		return FALSE;
 
-	/* parse output */
+	/* only the headers are needed, so the data is skipped */
 	files = g_ptr_array_new_with_free_func (g_free);
-	lines = g_strsplit (output, "\n", -1);
-	for (i = 0; lines[i] != NULL; i++) {
-		fn = g_strrstr (lines[i], " ");
-		if (fn == NULL)
-			continue;
+	for (;;) {
+		const gchar *tmp;
+		r = archive_read_next_header (arch, &entry);
+		if (r == ARCHIVE_EOF)
+			break;
+		if (r != ARCHIVE_OK) {
+			g_set_error (error,
+				     ASB_PLUGIN_ERROR,
+				     ASB_PLUGIN_ERROR_FAILED,
+				     "Cannot read data header: %s",
+				     archive_error_string (arch));
+			return FALSE;
+		}
+
 		/* ignore directories */
-		if (g_str_has_suffix (fn, "/"))
+		if (archive_entry_filetype (entry) == AE_IFDIR)
+			continue;
+		tmp = archive_entry_pathname (entry);
+		if (tmp == NULL)
 			continue;
-		g_ptr_array_add (files, g_strdup (fn + 2));
+
+		/* ./usr/share/README -> /usr/share/README */
+		if (tmp[0] == '.')
+			tmp++;
+		if (tmp[0] == '/')
+			g_ptr_array_add (files, g_strdup (tmp));
+		else
+			g_ptr_array_add (files, g_strconcat ("/", tmp, NULL));
 	}
 
 	/* save */
@@ -152,16 +250,88 @@ asb_package_deb_ensure_filelists (AsbPackage *pkg, GError **error)
 
 /**
  * asb_package_deb_open:
+ *
+ * Reads the control fields and the file list in one pass over the .deb,
+ * which is an ar container of control.tar.* and data.tar.* members.
  **/
 static gboolean
 asb_package_deb_open (AsbPackage *pkg, const gchar *filename, GError **error)
 {
-	/* read package stuff */
-	if (!asb_package_deb_ensure_simple (pkg, error))
-		return FALSE;
-	if (!asb_package_deb_ensure_filelists (pkg, error))
+	gboolean got_control = FALSE;
+	gboolean got_data = FALSE;
+	gboolean ret = TRUE;
+	int r;
+	struct archive *arch;
+	struct archive_entry *entry;
+
+	arch = archive_read_new ();
+	archive_read_support_format_ar (arch);
+	r = archive_read_open_filename (arch, filename, 16384);
+	if (r) {
+		g_set_error (error,
+			     ASB_PLUGIN_ERROR,
+			     ASB_PLUGIN_ERROR_FAILED,
+			     "Cannot open: %s",
+			     archive_error_string (arch));
+		archive_read_free (arch);
 		return FALSE;
-	return TRUE;
+	}
+	while (!got_control || !got_data) {
+		const gchar *tmp;
+		struct archive *member;
+
+		r = archive_read_next_header (arch, &entry);
+		if (r == ARCHIVE_EOF)
+			break;
+		if (r != ARCHIVE_OK) {
+			ret = FALSE;
+			g_set_error (error,
+				     ASB_PLUGIN_ERROR,
+				     ASB_PLUGIN_ERROR_FAILED,
+				     "Cannot read header: %s",
+				     archive_error_string (arch));
+			goto out;
+		}
+		tmp = archive_entry_pathname (entry);
+		if (tmp == NULL)
+			continue;
+		if (g_str_has_prefix (tmp, "control.tar")) {
+			member = asb_utils_archive_read_nested (arch, FALSE, error);
+			if (member == NULL) {
+				ret = FALSE;
+				goto out;
+			}
+			ret = asb_package_deb_read_control (pkg, member, error);
+			archive_read_free (member);
+			if (!ret)
+				goto out;
+			got_control = TRUE;
+		} else if (g_str_has_prefix (tmp, "data.tar")) {
+			member = asb_utils_archive_read_nested (arch, FALSE, error);
+			if (member == NULL) {
+				ret = FALSE;
+				goto out;
+			}
+			ret = asb_package_deb_read_filelist (pkg, member, error);
+			archive_read_free (member);
+			if (!ret)
+				goto out;
+			got_data = TRUE;
+		}
+	}
+	if (!got_control || !got_data) {
+		ret = FALSE;
+		g_set_error (error,
+			     ASB_PLUGIN_ERROR,
+			     ASB_PLUGIN_ERROR_FAILED,
+			     "No %s in %s",
+			     got_control ? "data.tar" : "control.tar",
+			     filename);
+	}
+out:
+	archive_read_close (arch);
+	archive_read_free (arch);
+	return ret;
 }
 
 /**
@@ -173,29 +343,24 @@ asb_package_deb_explode (AsbPackage *pkg,
 			 GPtrArray *glob,
 			 GError **error)
 {
-	guint i;
-	const gchar *data_names[] = { "data.tar.xz",
-				      "data.tar.bz2",
-				      "data.tar.gz",
-				      "data.tar.lzma",
-				      "data.tar",
-				      NULL };
-
-	/* first decompress the main deb */
-	if (!asb_utils_explode (asb_package_get_filename (pkg),
-				dir, NULL, error))
-		return FALSE;
+	/* only the data member has anything we want */
+	return asb_utils_explode_member (asb_package_get_filename (pkg),
+					 "data.tar", dir, NULL, glob, error);
+}
 
-	/* then decompress the data file */
-	for (i = 0; data_names[i] != NULL; i++) {
-		_cleanup_free_ gchar *data_fn = NULL;
-		data_fn = g_build_filename (dir, data_names[i], NULL);
-		if (g_file_test (data_fn, G_FILE_TEST_EXISTS)) {
-			if (!asb_utils_explode (data_fn, dir, glob, error))
-				return FALSE;
-		}
-	}
-	return TRUE;
+/**
+ * asb_package_deb_explode_tree:
+ **/
+static gboolean
+asb_package_deb_explode_tree (AsbPackage *pkg,
+			      AsbPackageTree *tree,
+			      GPtrArray *glob,
+			      GError **error)
+{
+	return asb_utils_explode_member (asb_package_get_filename (pkg),
+					 "data.tar",
+					 asb_package_tree_get_dir (tree),
+					 tree, glob, error);
 }
 
 /**
@@ -207,6 +372,7 @@ asb_package_deb_class_init (AsbPackageDebClass *klass)
 	AsbPackageClass *package_class = ASB_PACKAGE_CLASS (klass);
 	package_class->open = asb_package_deb_open;
 	package_class->explode = asb_package_deb_explode;
+	package_class->explode_tree = asb_package_deb_explode_tree;
 }
 
 /**
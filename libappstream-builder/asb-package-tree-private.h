@@ -0,0 +1,41 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2014 Richard Hughes <richard@hughsie.com>
+ *
+ * Licensed under the GNU Lesser General Public License Version 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef ASB_PACKAGE_TREE_PRIVATE_H
+#define ASB_PACKAGE_TREE_PRIVATE_H
+
+#include <archive.h>
+#include <archive_entry.h>
+
+#include "asb-package-tree.h"
+
+G_BEGIN_DECLS
+
+gboolean	 asb_package_tree_can_add_entry	(AsbPackageTree	*tree,
+						 struct archive_entry *entry);
+gboolean	 asb_package_tree_add_entry	(AsbPackageTree	*tree,
+						 struct archive	*arch,
+						 struct archive_entry *entry,
+						 GError		**error);
+
+G_END_DECLS
+
+#endif /* ASB_PACKAGE_TREE_PRIVATE_H */
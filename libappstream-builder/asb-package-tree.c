@@ -0,0 +1,729 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2014 Richard Hughes <richard@hughsie.com>
+ *
+ * Licensed under the GNU Lesser General Public License Version 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * SECTION:asb-package-tree
+ * @short_description: The files decompressed from a package.
+ * @stability: Unstable
+ *
+ * This object holds the files decompressed from a package and any extra
+ * packages it needs. Small files are kept in memory and only written to
+ * the temporary directory when a caller needs a real filename; large
+ * files are decompressed straight to disk.
+ *
+ * All paths are absolute, e.g. "/usr/share/applications/foo.desktop",
+ * and symbolic links inside the package are followed.
+ */
+
+#include "config.h"
+
+#include <glib/gstdio.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "as-cleanup.h"
+#include "asb-package-tree-private.h"
+#include "asb-plugin.h"
+#include "asb-utils-private.h"
+
+#define ASB_PACKAGE_TREE_MAX_SIZE	(1024 * 1024)	/* bytes */
+#define ASB_PACKAGE_TREE_MAX_TOTAL_SIZE	(32 * 1024 * 1024)	/* bytes */
+#define ASB_PACKAGE_TREE_MAX_LINKS	16
+
+typedef struct {
+	GBytes		*bytes;		/* for files */
+	gchar		*target;	/* for symlinks */
+	gboolean	 on_disk;
+} AsbPackageTreeEntry;
+
+typedef struct _AsbPackageTreePrivate	AsbPackageTreePrivate;
+struct _AsbPackageTreePrivate
+{
+	gchar			*dir;
+	gsize			 max_size;
+	gsize			 max_total_size;
+	gsize			 bytes_used;
+	GHashTable		*entries;	/* path : AsbPackageTreeEntry */
+	GHashTable		*dirs;		/* path : GHashTable of names */
+};
+
+G_DEFINE_TYPE_WITH_PRIVATE (AsbPackageTree, asb_package_tree, G_TYPE_OBJECT)
+
+#define GET_PRIVATE(o) (asb_package_tree_get_instance_private (o))
+
+/**
+ * asb_package_tree_entry_free:
+ **/
+static void
+asb_package_tree_entry_free (AsbPackageTreeEntry *entry)
+{
+	if (entry->bytes != NULL)
+		g_bytes_unref (entry->bytes);
+	g_free (entry->target);
+	g_free (entry);
+}
+
+/**
+ * asb_package_tree_resolve:
+ *
+ * Converts @path into a canonical absolute path, optionally following any
+ * symlinks in the tree, which may also point at parent directories.
+ **/
+static gchar *
+asb_package_tree_resolve (AsbPackageTree *tree,
+			  const gchar *path,
+			  gboolean follow,
+			  guint depth)
+{
+	AsbPackageTreeEntry *entry;
+	AsbPackageTreePrivate *priv = GET_PRIVATE (tree);
+	GString *str;
+	gchar *sep;
+	gchar *tmp;
+	guint i;
+	_cleanup_strv_free_ gchar **split = NULL;
+
+	str = g_string_new ("");
+	split = g_strsplit (path, "/", -1);
+	for (i = 0; split[i] != NULL; i++) {
+		if (split[i][0] == '\0' || g_strcmp0 (split[i], ".") == 0)
+			continue;
+		if (g_strcmp0 (split[i], "..") == 0) {
+			sep = g_strrstr (str->str, "/");
+			if (sep != NULL)
+				g_string_truncate (str, sep - str->str);
+			continue;
+		}
+		g_string_append_printf (str, "/%s", split[i]);
+		if (!follow)
+			continue;
+		entry = g_hash_table_lookup (priv->entries, str->str);
+		if (entry == NULL || entry->target == NULL)
+			continue;
+
+		/* symlink loop */
+		if (depth >= ASB_PACKAGE_TREE_MAX_LINKS) {
+			g_string_free (str, TRUE);
+			return NULL;
+		}
+
+		/* start again from the target with what is left */
+		sep = g_strrstr (str->str, "/");
+		g_string_truncate (str, sep - str->str);
+		if (entry->target[0] == '/')
+			g_string_assign (str, entry->target);
+		else
+			g_string_append_printf (str, "/%s", entry->target);
+		for (i++; split[i] != NULL; i++)
+			g_string_append_printf (str, "/%s", split[i]);
+		tmp = asb_package_tree_resolve (tree, str->str, TRUE, depth + 1);
+		g_string_free (str, TRUE);
+		return tmp;
+	}
+	if (str->len == 0)
+		g_string_assign (str, "/");
+	return g_string_free (str, FALSE);
+}
+
+/**
+ * asb_package_tree_lookup:
+ **/
+static gchar *
+asb_package_tree_lookup (AsbPackageTree *tree, const gchar *path, GError **error)
+{
+	gchar *resolved;
+
+	resolved = asb_package_tree_resolve (tree, path, TRUE, 0);
+	if (resolved == NULL) {
+		g_set_error (error,
+			     ASB_PLUGIN_ERROR,
+			     ASB_PLUGIN_ERROR_FAILED,
+			     "Too many levels of symbolic links in %s",
+			     path);
+		return NULL;
+	}
+	return resolved;
+}
+
+/**
+ * asb_package_tree_add_to_parents:
+ **/
+static void
+asb_package_tree_add_to_parents (AsbPackageTree *tree, const gchar *path)
+{
+	AsbPackageTreePrivate *priv = GET_PRIVATE (tree);
+	GHashTable *names;
+	const gchar *dirname;
+	gchar *sep;
+	_cleanup_free_ gchar *tmp = NULL;
+
+	tmp = g_strdup (path);
+	while ((sep = g_strrstr (tmp, "/")) != NULL && sep[1] != '\0') {
+		*sep = '\0';
+		dirname = tmp[0] == '\0' ? "/" : tmp;
+		names = g_hash_table_lookup (priv->dirs, dirname);
+		if (names == NULL) {
+			names = g_hash_table_new_full (g_str_hash, g_str_equal,
+						       g_free, NULL);
+			g_hash_table_insert (priv->dirs, g_strdup (dirname), names);
+		} else if (g_hash_table_contains (names, sep + 1)) {
+			/* so all the parents are known too */
+			break;
+		}
+		g_hash_table_add (names, g_strdup (sep + 1));
+	}
+}
+
+/**
+ * asb_package_tree_can_add_entry:
+ * @tree: A #AsbPackageTree
+ * @entry: an archive entry
+ *
+ * Gets if @entry can be kept in memory, rather than being decompressed
+ * to disk. Files are written to disk if they are too large on their own,
+ * or once the tree holds its total budget of file data.
+ *
+ * Returns: %TRUE if asb_package_tree_add_entry() should be used
+ **/
+gboolean
+asb_package_tree_can_add_entry (AsbPackageTree *tree,
+				struct archive_entry *entry)
+{
+	AsbPackageTreeEntry *item;
+	AsbPackageTreePrivate *priv = GET_PRIVATE (tree);
+	const gchar *tmp;
+
+	if (priv->max_size == 0)
+		return FALSE;
+
+	/* hardlinks share the data of a file already in memory */
+	tmp = archive_entry_hardlink (entry);
+	if (tmp != NULL) {
+		_cleanup_free_ gchar *path = NULL;
+		_cleanup_free_ gchar *path_link = NULL;
+		path_link = asb_utils_sanitise_path (tmp);
+		path = asb_package_tree_resolve (tree, path_link, FALSE, 0);
+		item = g_hash_table_lookup (priv->entries, path);
+		return item != NULL && item->bytes != NULL;
+	}
+
+	switch (archive_entry_filetype (entry)) {
+	case AE_IFDIR:
+	case AE_IFLNK:
+		return TRUE;
+	case AE_IFREG:
+		if (!archive_entry_size_is_set (entry))
+			return FALSE;
+		if (archive_entry_size (entry) > (gint64) priv->max_size)
+			return FALSE;
+		return priv->bytes_used + archive_entry_size (entry) <=
+			priv->max_total_size;
+	default:
+		break;
+	}
+	return FALSE;
+}
+
+/**
+ * asb_package_tree_read_data:
+ **/
+static GBytes *
+asb_package_tree_read_data (struct archive *arch, gsize size, GError **error)
+{
+	gchar *data;
+	gsize offset = 0;
+	gssize len;
+
+	data = g_malloc (size);
+	while (offset < size) {
+		len = archive_read_data (arch, data + offset, size - offset);
+		if (len < 0) {
+			g_set_error (error,
+				     ASB_PLUGIN_ERROR,
+				     ASB_PLUGIN_ERROR_FAILED,
+				     "Cannot read: %s",
+				     archive_error_string (arch));
+			g_free (data);
+			return NULL;
+		}
+		if (len == 0)
+			break;
+		offset += len;
+	}
+	return g_bytes_new_take (data, offset);
+}
+
+/**
+ * asb_package_tree_add_entry:
+ * @tree: A #AsbPackageTree
+ * @arch: an archive
+ * @entry: the current entry of @arch
+ * @error: A #GError or %NULL
+ *
+ * Reads the current entry of the archive into memory.
+ *
+ * Returns: %TRUE for success, %FALSE otherwise
+ **/
+gboolean
+asb_package_tree_add_entry (AsbPackageTree *tree,
+			    struct archive *arch,
+			    struct archive_entry *entry,
+			    GError **error)
+{
+	AsbPackageTreeEntry *item;
+	AsbPackageTreeEntry *item_link;
+	AsbPackageTreePrivate *priv = GET_PRIVATE (tree);
+	GBytes *bytes;
+	const gchar *tmp;
+	_cleanup_free_ gchar *path = NULL;
+	_cleanup_free_ gchar *path_tmp = NULL;
+
+	tmp = archive_entry_pathname (entry);
+	if (tmp == NULL)
+		return TRUE;
+	path_tmp = asb_utils_sanitise_path (tmp);
+	path = asb_package_tree_resolve (tree, path_tmp, FALSE, 0);
+
+	/* directories are implied by the files in them */
+	asb_package_tree_add_to_parents (tree, path);
+	if (archive_entry_filetype (entry) == AE_IFDIR)
+		return TRUE;
+
+	/* hardlink */
+	tmp = archive_entry_hardlink (entry);
+	if (tmp != NULL) {
+		_cleanup_free_ gchar *path_link = NULL;
+		g_free (path_tmp);
+		path_tmp = asb_utils_sanitise_path (tmp);
+		path_link = asb_package_tree_resolve (tree, path_tmp, FALSE, 0);
+		item_link = g_hash_table_lookup (priv->entries, path_link);
+		if (item_link == NULL || item_link->bytes == NULL) {
+			g_set_error (error,
+				     ASB_PLUGIN_ERROR,
+				     ASB_PLUGIN_ERROR_FAILED,
+				     "%s does not exist, cannot hardlink",
+				     path_link);
+			return FALSE;
+		}
+		item = g_new0 (AsbPackageTreeEntry, 1);
+		item->bytes = g_bytes_ref (item_link->bytes);
+		g_hash_table_insert (priv->entries, g_strdup (path), item);
+		return TRUE;
+	}
+
+	/* symlink */
+	if (archive_entry_filetype (entry) == AE_IFLNK) {
+		tmp = archive_entry_symlink (entry);
+		if (tmp == NULL)
+			return TRUE;
+		item = g_new0 (AsbPackageTreeEntry, 1);
+		item->target = g_strdup (tmp);
+		g_hash_table_insert (priv->entries, g_strdup (path), item);
+		return TRUE;
+	}
+
+	/* file */
+	bytes = asb_package_tree_read_data (arch, archive_entry_size (entry), error);
+	if (bytes == NULL)
+		return FALSE;
+	priv->bytes_used += g_bytes_get_size (bytes);
+	item = g_new0 (AsbPackageTreeEntry, 1);
+	item->bytes = bytes;
+	g_hash_table_insert (priv->entries, g_strdup (path), item);
+	return TRUE;
+}
+
+/**
+ * asb_package_tree_write_entry:
+ **/
+static gboolean
+asb_package_tree_write_entry (AsbPackageTree *tree,
+			      const gchar *path,
+			      AsbPackageTreeEntry *entry,
+			      GError **error)
+{
+	AsbPackageTreePrivate *priv = GET_PRIVATE (tree);
+	const gchar *data;
+	gsize len;
+	guint i;
+	_cleanup_free_ gchar *dirname = NULL;
+	_cleanup_free_ gchar *filename = NULL;
+
+	filename = g_build_filename (priv->dir, path, NULL);
+	dirname = g_path_get_dirname (filename);
+	if (g_mkdir_with_parents (dirname, 0700) != 0) {
+		g_set_error (error,
+			     ASB_PLUGIN_ERROR,
+			     ASB_PLUGIN_ERROR_FAILED,
+			     "Failed to create %s", dirname);
+		return FALSE;
+	}
+
+	/* absolute symlinks point inside the tree, not the host */
+	if (entry->target != NULL) {
+		_cleanup_string_free_ GString *target = NULL;
+		target = g_string_new ("");
+		if (entry->target[0] == '/') {
+			for (i = 1; path[i] != '\0'; i++) {
+				if (path[i] == '/')
+					g_string_append (target, "../");
+			}
+			g_string_append (target, entry->target + 1);
+		} else {
+			g_string_append (target, entry->target);
+		}
+		if (symlink (target->str, filename) != 0 && errno != EEXIST) {
+			g_set_error (error,
+				     ASB_PLUGIN_ERROR,
+				     ASB_PLUGIN_ERROR_FAILED,
+				     "Failed to create symlink %s", filename);
+			return FALSE;
+		}
+		entry->on_disk = TRUE;
+		return TRUE;
+	}
+
+	data = g_bytes_get_data (entry->bytes, &len);
+	if (!g_file_set_contents (filename, data, len, error))
+		return FALSE;
+	entry->on_disk = TRUE;
+	return TRUE;
+}
+
+/**
+ * asb_package_tree_get_dir:
+ * @tree: A #AsbPackageTree
+ *
+ * Gets the directory the tree is written into when required.
+ *
+ * Returns: a directory
+ *
+ * Since: 0.3.3
+ **/
+const gchar *
+asb_package_tree_get_dir (AsbPackageTree *tree)
+{
+	AsbPackageTreePrivate *priv = GET_PRIVATE (tree);
+	return priv->dir;
+}
+
+/**
+ * asb_package_tree_set_max_size:
+ * @tree: A #AsbPackageTree
+ * @max_size: size in bytes
+ *
+ * Sets the largest file that will be kept in memory. Larger files are
+ * decompressed straight to disk. Use 0 to write all files to disk.
+ *
+ * Since: 0.3.3
+ **/
+void
+asb_package_tree_set_max_size (AsbPackageTree *tree, gsize max_size)
+{
+	AsbPackageTreePrivate *priv = GET_PRIVATE (tree);
+	priv->max_size = max_size;
+}
+
+/**
+ * asb_package_tree_set_max_total_size:
+ * @tree: A #AsbPackageTree
+ * @max_total_size: size in bytes
+ *
+ * Sets the most file data that will be kept in memory for the whole tree.
+ * Once this is used up, further files are decompressed straight to disk.
+ *
+ * Since: 0.3.3
+ **/
+void
+asb_package_tree_set_max_total_size (AsbPackageTree *tree, gsize max_total_size)
+{
+	AsbPackageTreePrivate *priv = GET_PRIVATE (tree);
+	priv->max_total_size = max_total_size;
+}
+
+/**
+ * asb_package_tree_exists:
+ * @tree: A #AsbPackageTree
+ * @path: an absolute path, e.g. "/usr/bin/foo"
+ *
+ * Finds out if a file or directory exists in the tree.
+ *
+ * Returns: %TRUE if @path exists
+ *
+ * Since: 0.3.3
+ **/
+gboolean
+asb_package_tree_exists (AsbPackageTree *tree, const gchar *path)
+{
+	AsbPackageTreePrivate *priv = GET_PRIVATE (tree);
+	_cleanup_free_ gchar *filename = NULL;
+	_cleanup_free_ gchar *resolved = NULL;
+
+	resolved = asb_package_tree_resolve (tree, path, TRUE, 0);
+	if (resolved == NULL)
+		return FALSE;
+	if (g_hash_table_contains (priv->entries, resolved))
+		return TRUE;
+	if (g_hash_table_contains (priv->dirs, resolved))
+		return TRUE;
+	filename = g_build_filename (priv->dir, resolved, NULL);
+	return g_file_test (filename, G_FILE_TEST_EXISTS);
+}
+
+/**
+ * asb_package_tree_get_bytes:
+ * @tree: A #AsbPackageTree
+ * @path: an absolute path, e.g. "/usr/bin/foo"
+ * @error: A #GError or %NULL
+ *
+ * Gets the contents of a file in the tree.
+ *
+ * Returns: (transfer full): the file data, or %NULL for error
+ *
+ * Since: 0.3.3
+ **/
+GBytes *
+asb_package_tree_get_bytes (AsbPackageTree *tree,
+			    const gchar *path,
+			    GError **error)
+{
+	AsbPackageTreeEntry *entry;
+	AsbPackageTreePrivate *priv = GET_PRIVATE (tree);
+	gchar *data;
+	gsize len;
+	_cleanup_free_ gchar *filename = NULL;
+	_cleanup_free_ gchar *resolved = NULL;
+
+	resolved = asb_package_tree_lookup (tree, path, error);
+	if (resolved == NULL)
+		return NULL;
+	entry = g_hash_table_lookup (priv->entries, resolved);
+	if (entry != NULL && entry->bytes != NULL)
+		return g_bytes_ref (entry->bytes);
+
+	/* too large to be kept in memory */
+	filename = g_build_filename (priv->dir, resolved, NULL);
+	if (!g_file_get_contents (filename, &data, &len, error))
+		return NULL;
+	return g_bytes_new_take (data, len);
+}
+
+/**
+ * asb_package_tree_sort_cb:
+ **/
+static gint
+asb_package_tree_sort_cb (gconstpointer a, gconstpointer b)
+{
+	return g_strcmp0 (*((const gchar **) a), *((const gchar **) b));
+}
+
+/**
+ * asb_package_tree_list_dir:
+ * @tree: A #AsbPackageTree
+ * @path: an absolute path, e.g. "/usr/share/locale"
+ * @error: A #GError or %NULL
+ *
+ * Lists the names of the files and directories in a directory of the tree.
+ *
+ * Returns: (transfer container) (element-type utf8): sorted names, or %NULL
+ *
+ * Since: 0.3.3
+ **/
+GPtrArray *
+asb_package_tree_list_dir (AsbPackageTree *tree,
+			   const gchar *path,
+			   GError **error)
+{
+	AsbPackageTreePrivate *priv = GET_PRIVATE (tree);
+	GHashTable *names;
+	GList *l;
+	GPtrArray *array;
+	const gchar *tmp;
+	_cleanup_free_ gchar *filename = NULL;
+	_cleanup_free_ gchar *resolved = NULL;
+	_cleanup_list_free_ GList *keys = NULL;
+
+	resolved = asb_package_tree_lookup (tree, path, error);
+	if (resolved == NULL)
+		return NULL;
+	names = g_hash_table_lookup (priv->dirs, resolved);
+	filename = g_build_filename (priv->dir, resolved, NULL);
+	if (names == NULL && !g_file_test (filename, G_FILE_TEST_IS_DIR)) {
+		g_set_error (error,
+			     ASB_PLUGIN_ERROR,
+			     ASB_PLUGIN_ERROR_FAILED,
+			     "No directory %s", path);
+		return NULL;
+	}
+
+	/* files in memory */
+	array = g_ptr_array_new_with_free_func (g_free);
+	if (names != NULL) {
+		keys = g_hash_table_get_keys (names);
+		for (l = keys; l != NULL; l = l->next)
+			g_ptr_array_add (array, g_strdup (l->data));
+	}
+
+	/* files decompressed to disk */
+	if (g_file_test (filename, G_FILE_TEST_IS_DIR)) {
+		_cleanup_dir_close_ GDir *dir = NULL;
+		dir = g_dir_open (filename, 0, error);
+		if (dir == NULL) {
+			g_ptr_array_unref (array);
+			return NULL;
+		}
+		while ((tmp = g_dir_read_name (dir)) != NULL) {
+			if (names != NULL && g_hash_table_contains (names, tmp))
+				continue;
+			g_ptr_array_add (array, g_strdup (tmp));
+		}
+	}
+	g_ptr_array_sort (array, asb_package_tree_sort_cb);
+	return array;
+}
+
+/**
+ * asb_package_tree_get_filename:
+ * @tree: A #AsbPackageTree
+ * @path: an absolute path, e.g. "/usr/bin/foo"
+ * @error: A #GError or %NULL
+ *
+ * Gets a real filename for a file in the tree, writing the file to disk if
+ * it was only held in memory. This should only be used when the consumer
+ * of the file cannot read it from memory.
+ *
+ * Returns: a filename, or %NULL for error
+ *
+ * Since: 0.3.3
+ **/
+gchar *
+asb_package_tree_get_filename (AsbPackageTree *tree,
+			       const gchar *path,
+			       GError **error)
+{
+	AsbPackageTreeEntry *entry;
+	AsbPackageTreePrivate *priv = GET_PRIVATE (tree);
+	_cleanup_free_ gchar *resolved = NULL;
+
+	resolved = asb_package_tree_lookup (tree, path, error);
+	if (resolved == NULL)
+		return NULL;
+	entry = g_hash_table_lookup (priv->entries, resolved);
+	if (entry != NULL && !entry->on_disk) {
+		if (!asb_package_tree_write_entry (tree, resolved, entry, error))
+			return NULL;
+	}
+	return g_build_filename (priv->dir, resolved, NULL);
+}
+
+/**
+ * asb_package_tree_write_all:
+ * @tree: A #AsbPackageTree
+ * @error: A #GError or %NULL
+ *
+ * Writes every file held in memory to disk, for consumers that need to
+ * scan the directory returned by asb_package_tree_get_dir().
+ *
+ * Returns: %TRUE for success, %FALSE otherwise
+ *
+ * Since: 0.3.3
+ **/
+gboolean
+asb_package_tree_write_all (AsbPackageTree *tree, GError **error)
+{
+	AsbPackageTreeEntry *entry;
+	AsbPackageTreePrivate *priv = GET_PRIVATE (tree);
+	GList *l;
+	_cleanup_list_free_ GList *keys = NULL;
+
+	keys = g_hash_table_get_keys (priv->entries);
+	for (l = keys; l != NULL; l = l->next) {
+		entry = g_hash_table_lookup (priv->entries, l->data);
+		if (entry->on_disk)
+			continue;
+		if (!asb_package_tree_write_entry (tree, l->data, entry, error))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * asb_package_tree_finalize:
+ **/
+static void
+asb_package_tree_finalize (GObject *object)
+{
+	AsbPackageTree *tree = ASB_PACKAGE_TREE (object);
+	AsbPackageTreePrivate *priv = GET_PRIVATE (tree);
+
+	g_free (priv->dir);
+	g_hash_table_unref (priv->entries);
+	g_hash_table_unref (priv->dirs);
+
+	G_OBJECT_CLASS (asb_package_tree_parent_class)->finalize (object);
+}
+
+/**
+ * asb_package_tree_init:
+ **/
+static void
+asb_package_tree_init (AsbPackageTree *tree)
+{
+	AsbPackageTreePrivate *priv = GET_PRIVATE (tree);
+	priv->max_size = ASB_PACKAGE_TREE_MAX_SIZE;
+	priv->max_total_size = ASB_PACKAGE_TREE_MAX_TOTAL_SIZE;
+	priv->entries = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+					       (GDestroyNotify) asb_package_tree_entry_free);
+	priv->dirs = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+					    (GDestroyNotify) g_hash_table_unref);
+}
+
+/**
+ * asb_package_tree_class_init:
+ **/
+static void
+asb_package_tree_class_init (AsbPackageTreeClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	object_class->finalize = asb_package_tree_finalize;
+}
+
+/**
+ * asb_package_tree_new:
+ * @dir: the directory to use for files that are written to disk
+ *
+ * Creates a new, empty, package tree. The directory is only created if
+ * files have to be written to disk.
+ *
+ * Returns: A #AsbPackageTree
+ *
+ * Since: 0.3.3
+ **/
+AsbPackageTree *
+asb_package_tree_new (const gchar *dir)
+{
+	AsbPackageTree *tree;
+	AsbPackageTreePrivate *priv;
+	tree = g_object_new (ASB_TYPE_PACKAGE_TREE, NULL);
+	priv = GET_PRIVATE (tree);
+	priv->dir = g_strdup (dir);
+	return ASB_PACKAGE_TREE (tree);
+}
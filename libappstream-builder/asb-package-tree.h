@@ -0,0 +1,82 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2014 Richard Hughes <richard@hughsie.com>
+ *
+ * Licensed under the GNU Lesser General Public License Version 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef ASB_PACKAGE_TREE_H
+#define ASB_PACKAGE_TREE_H
+
+#include <glib-object.h>
+
+#define ASB_TYPE_PACKAGE_TREE		(asb_package_tree_get_type())
+#define ASB_PACKAGE_TREE(obj)		(G_TYPE_CHECK_INSTANCE_CAST((obj), ASB_TYPE_PACKAGE_TREE, AsbPackageTree))
+#define ASB_PACKAGE_TREE_CLASS(cls)	(G_TYPE_CHECK_CLASS_CAST((cls), ASB_TYPE_PACKAGE_TREE, AsbPackageTreeClass))
+#define ASB_IS_PACKAGE_TREE(obj)	(G_TYPE_CHECK_INSTANCE_TYPE((obj), ASB_TYPE_PACKAGE_TREE))
+#define ASB_IS_PACKAGE_TREE_CLASS(cls)	(G_TYPE_CHECK_CLASS_TYPE((cls), ASB_TYPE_PACKAGE_TREE))
+#define ASB_PACKAGE_TREE_GET_CLASS(obj)	(G_TYPE_INSTANCE_GET_CLASS((obj), ASB_TYPE_PACKAGE_TREE, AsbPackageTreeClass))
+
+G_BEGIN_DECLS
+
+typedef struct _AsbPackageTree		AsbPackageTree;
+typedef struct _AsbPackageTreeClass	AsbPackageTreeClass;
+
+struct _AsbPackageTree
+{
+	GObject				 parent;
+};
+
+struct _AsbPackageTreeClass
+{
+	GObjectClass			 parent_class;
+	/*< private >*/
+	void (*_asb_reserved1)	(void);
+	void (*_asb_reserved2)	(void);
+	void (*_asb_reserved3)	(void);
+	void (*_asb_reserved4)	(void);
+	void (*_asb_reserved5)	(void);
+	void (*_asb_reserved6)	(void);
+	void (*_asb_reserved7)	(void);
+	void (*_asb_reserved8)	(void);
+};
+
+GType		 asb_package_tree_get_type	(void);
+
+AsbPackageTree	*asb_package_tree_new		(const gchar	*dir);
+const gchar	*asb_package_tree_get_dir	(AsbPackageTree	*tree);
+void		 asb_package_tree_set_max_size	(AsbPackageTree	*tree,
+						 gsize		 max_size);
+void		 asb_package_tree_set_max_total_size (AsbPackageTree *tree,
+						 gsize		 max_total_size);
+gboolean	 asb_package_tree_exists	(AsbPackageTree	*tree,
+						 const gchar	*path);
+GBytes		*asb_package_tree_get_bytes	(AsbPackageTree	*tree,
+						 const gchar	*path,
+						 GError		**error);
+GPtrArray	*asb_package_tree_list_dir	(AsbPackageTree	*tree,
+						 const gchar	*path,
+						 GError		**error);
+gchar		*asb_package_tree_get_filename	(AsbPackageTree	*tree,
+						 const gchar	*path,
+						 GError		**error);
+gboolean	 asb_package_tree_write_all	(AsbPackageTree	*tree,
+						 GError		**error);
+
+G_END_DECLS
+
+#endif /* ASB_PACKAGE_TREE_H */
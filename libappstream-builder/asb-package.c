@@ -33,7 +33,9 @@
 
 #include "as-cleanup.h"
 #include "asb-package.h"
+#include "asb-package-private.h"
 #include "asb-plugin.h"
+#include "asb-utils-private.h"
 
 typedef struct _AsbPackagePrivate	AsbPackagePrivate;
 struct _AsbPackagePrivate
@@ -63,6 +65,8 @@ struct _AsbPackagePrivate
 	GPtrArray	*releases;
 	GHashTable	*releases_hash;
 	GMutex		 mutex_log;
+	AsbPackageTree	*tree;
+	guint64		 cost;
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE (AsbPackage, asb_package, G_TYPE_OBJECT)
@@ -99,6 +103,8 @@ asb_package_finalize (GObject *object)
 	g_hash_table_unref (priv->configs);
 	g_ptr_array_unref (priv->releases);
 	g_hash_table_unref (priv->releases_hash);
+	if (priv->tree != NULL)
+		g_object_unref (priv->tree);
 
 	G_OBJECT_CLASS (asb_package_parent_class)->finalize (object);
 }
@@ -138,6 +144,36 @@ asb_package_get_enabled (AsbPackage *pkg)
 	return priv->enabled;
 }
 
+/**
+ * asb_package_get_cost:
+ * @pkg: A #AsbPackage
+ *
+ * Gets the estimated cost of processing the package.
+ *
+ * Returns: a cost in compressed bytes, or 0 if unknown
+ **/
+guint64
+asb_package_get_cost (AsbPackage *pkg)
+{
+	AsbPackagePrivate *priv = GET_PRIVATE (pkg);
+	return priv->cost;
+}
+
+/**
+ * asb_package_set_cost:
+ * @pkg: A #AsbPackage
+ * @cost: a cost in compressed bytes
+ *
+ * Sets the estimated cost of processing the package, which is used to
+ * start the most expensive packages first.
+ **/
+void
+asb_package_set_cost (AsbPackage *pkg, guint64 cost)
+{
+	AsbPackagePrivate *priv = GET_PRIVATE (pkg);
+	priv->cost = cost;
+}
+
 /**
  * asb_package_set_enabled:
  * @pkg: A #AsbPackage
@@ -224,6 +260,29 @@ asb_package_log (AsbPackage *pkg,
 	g_mutex_unlock (&priv->mutex_log);
 }
 
+/**
+ * asb_package_get_log:
+ * @pkg: A #AsbPackage
+ *
+ * Gets a copy of the messages logged for the package so far. Other
+ * threads may still be adding to the log.
+ *
+ * Returns: (transfer full): a newly allocated string
+ *
+ * Since: 0.3.3
+ **/
+gchar *
+asb_package_get_log (AsbPackage *pkg)
+{
+	AsbPackagePrivate *priv = GET_PRIVATE (pkg);
+	gchar *tmp;
+
+	g_mutex_lock (&priv->mutex_log);
+	tmp = g_strdup (priv->log->str);
+	g_mutex_unlock (&priv->mutex_log);
+	return tmp;
+}
+
 /**
  * asb_package_log_flush:
  * @pkg: A #AsbPackage
@@ -261,6 +320,42 @@ asb_package_log_flush (AsbPackage *pkg, GError **error)
 	return g_file_set_contents (logfile, priv->log->str, -1, error);
 }
 
+/**
+ * asb_package_get_tree:
+ * @pkg: A #AsbPackage
+ *
+ * Gets the files decompressed from the package.
+ *
+ * Returns: (transfer none): a #AsbPackageTree, or %NULL if not exploded
+ *
+ * Since: 0.3.3
+ **/
+AsbPackageTree *
+asb_package_get_tree (AsbPackage *pkg)
+{
+	AsbPackagePrivate *priv = GET_PRIVATE (pkg);
+	return priv->tree;
+}
+
+/**
+ * asb_package_set_tree:
+ * @pkg: A #AsbPackage
+ * @tree: (allow-none): a #AsbPackageTree, or %NULL
+ *
+ * Sets the files decompressed from the package, which may also include
+ * the files from any extra packages.
+ *
+ * Since: 0.3.3
+ **/
+void
+asb_package_set_tree (AsbPackage *pkg, AsbPackageTree *tree)
+{
+	AsbPackagePrivate *priv = GET_PRIVATE (pkg);
+	if (priv->tree != NULL)
+		g_object_unref (priv->tree);
+	priv->tree = tree != NULL ? g_object_ref (tree) : NULL;
+}
+
 /**
  * asb_package_get_filename:
  * @pkg: A #AsbPackage
@@ -820,6 +915,41 @@ asb_package_explode (AsbPackage *pkg,
 	return asb_utils_explode (priv->filename, dir, glob, error);
 }
 
+/**
+ * asb_package_explode_tree:
+ * @pkg: A #AsbPackage
+ * @tree: a #AsbPackageTree
+ * @glob: (element-type utf8): the glob list, or %NULL
+ * @error: A #GError or %NULL
+ *
+ * Decompresses a package into a tree, optionally using a glob list. Small
+ * files are held in memory rather than being written to disk.
+ *
+ * Returns: %TRUE for success, %FALSE otherwise
+ *
+ * Since: 0.3.3
+ **/
+gboolean
+asb_package_explode_tree (AsbPackage *pkg,
+			  AsbPackageTree *tree,
+			  GPtrArray *glob,
+			  GError **error)
+{
+	AsbPackageClass *klass = ASB_PACKAGE_GET_CLASS (pkg);
+	AsbPackagePrivate *priv = GET_PRIVATE (pkg);
+	if (klass->explode_tree != NULL)
+		return klass->explode_tree (pkg, tree, glob, error);
+
+	/* this package type can only write to disk */
+	if (klass->explode != NULL) {
+		return klass->explode (pkg, asb_package_tree_get_dir (tree),
+				       glob, error);
+	}
+	return asb_utils_explode_member (priv->filename, NULL,
+					 asb_package_tree_get_dir (tree),
+					 tree, glob, error);
+}
+
 /**
  * asb_package_set_config:
  * @pkg: A #AsbPackage
@@ -27,6 +27,8 @@
 #include <stdarg.h>
 #include <appstream-glib.h>
 
+#include "asb-package-tree.h"
+
 #define ASB_TYPE_PACKAGE		(asb_package_get_type())
 #define ASB_PACKAGE(obj)		(G_TYPE_CHECK_INSTANCE_CAST((obj), ASB_TYPE_PACKAGE, AsbPackage))
 #define ASB_PACKAGE_CLASS(cls)		(G_TYPE_CHECK_CLASS_CAST((cls), ASB_TYPE_PACKAGE, AsbPackageClass))
@@ -71,8 +73,11 @@ struct _AsbPackageClass
 						 GError		**error);
 	gint			 (*compare)	(AsbPackage	*pkg1,
 						 AsbPackage	*pkg2);
+	gboolean		 (*explode_tree) (AsbPackage	*pkg,
+						 AsbPackageTree	*tree,
+						 GPtrArray	*glob,
+						 GError		**error);
 	/*< private >*/
-	void (*_asb_reserved1)	(void);
 	void (*_asb_reserved2)	(void);
 	void (*_asb_reserved3)	(void);
 	void (*_asb_reserved4)	(void);
@@ -100,6 +105,7 @@ void		 asb_package_log		(AsbPackage	*pkg,
 						 G_GNUC_PRINTF (3, 4);
 gboolean	 asb_package_log_flush		(AsbPackage	*pkg,
 						 GError		**error);
+gchar		*asb_package_get_log		(AsbPackage	*pkg);
 gboolean	 asb_package_open		(AsbPackage	*pkg,
 						 const gchar	*filename,
 						 GError		**error);
@@ -110,6 +116,13 @@ gboolean	 asb_package_explode		(AsbPackage	*pkg,
 						 const gchar	*dir,
 						 GPtrArray	*glob,
 						 GError		**error);
+gboolean	 asb_package_explode_tree	(AsbPackage	*pkg,
+						 AsbPackageTree	*tree,
+						 GPtrArray	*glob,
+						 GError		**error);
+AsbPackageTree	*asb_package_get_tree		(AsbPackage	*pkg);
+void		 asb_package_set_tree		(AsbPackage	*pkg,
+						 AsbPackageTree	*tree);
 const gchar	*asb_package_get_filename	(AsbPackage	*pkg);
 const gchar	*asb_package_get_basename	(AsbPackage	*pkg);
 const gchar	*asb_package_get_arch		(AsbPackage	*pkg);
@@ -38,9 +38,15 @@ typedef struct _AsbPluginLoaderPrivate	AsbPluginLoaderPrivate;
 struct _AsbPluginLoaderPrivate
 {
 	GPtrArray		*plugins;
+	GArray			*check_fns;	/* of AsbPluginLoaderCheck */
 	AsbContext		*ctx;
 };
 
+typedef struct {
+	AsbPlugin			*plugin;
+	AsbPluginCheckFilenameFunc	 func;
+} AsbPluginLoaderCheck;
+
 G_DEFINE_TYPE_WITH_PRIVATE (AsbPluginLoader, asb_plugin_loader, G_TYPE_OBJECT)
 
 #define GET_PRIVATE(o) (asb_plugin_loader_get_instance_private (o))
@@ -85,6 +91,7 @@ asb_plugin_loader_finalize (GObject *object)
 					      (gpointer*) &priv->ctx);
 	}
 	g_ptr_array_unref (priv->plugins);
+	g_array_unref (priv->check_fns);
 
 	G_OBJECT_CLASS (asb_plugin_loader_parent_class)->finalize (object);
 }
@@ -109,6 +116,7 @@ asb_plugin_loader_init (AsbPluginLoader *plugin_loader)
 {
 	AsbPluginLoaderPrivate *priv = GET_PRIVATE (plugin_loader);
 	priv->plugins = g_ptr_array_new_with_free_func ((GDestroyNotify) asb_plugin_loader_plugin_free);
+	priv->check_fns = g_array_new (FALSE, FALSE, sizeof (AsbPluginLoaderCheck));
 }
 
 /**
@@ -125,22 +133,15 @@ asb_plugin_loader_init (AsbPluginLoader *plugin_loader)
 AsbPlugin *
 asb_plugin_loader_match_fn (AsbPluginLoader *plugin_loader, const gchar *filename)
 {
-	AsbPluginCheckFilenameFunc plugin_func = NULL;
+	AsbPluginLoaderCheck *check;
 	AsbPluginLoaderPrivate *priv = GET_PRIVATE (plugin_loader);
-	AsbPlugin *plugin;
-	gboolean ret;
 	guint i;
 
-	/* run each plugin */
-	for (i = 0; i < priv->plugins->len; i++) {
-		plugin = g_ptr_array_index (priv->plugins, i);
-		ret = g_module_symbol (plugin->module,
-				       "asb_plugin_check_filename",
-				       (gpointer *) &plugin_func);
-		if (!ret)
-			continue;
-		if (plugin_func (plugin, filename))
-			return plugin;
+	/* run each plugin that can check filenames */
+	for (i = 0; i < priv->check_fns->len; i++) {
+		check = &g_array_index (priv->check_fns, AsbPluginLoaderCheck, i);
+		if (check->func (check->plugin, filename))
+			return check->plugin;
 	}
 	return NULL;
 }
@@ -386,6 +387,7 @@ asb_plugin_loader_setup (AsbPluginLoader *plugin_loader, GError **error)
 	AsbPluginLoaderPrivate *priv = GET_PRIVATE (plugin_loader);
 	const gchar *filename_tmp;
 	const gchar *location = "./plugins/.libs/";
+	guint i;
 	_cleanup_dir_close_ GDir *dir = NULL;
 
 	/* search system-wide if not found locally */
@@ -415,6 +417,18 @@ asb_plugin_loader_setup (AsbPluginLoader *plugin_loader, GError **error)
 	/* run the plugins */
 	asb_plugin_loader_run (plugin_loader, "asb_plugin_initialize");
 	g_ptr_array_sort (priv->plugins, asb_plugin_loader_sort_cb);
+
+	/* resolve the filename checks once rather than for every file */
+	g_array_set_size (priv->check_fns, 0);
+	for (i = 0; i < priv->plugins->len; i++) {
+		AsbPluginLoaderCheck check;
+		check.plugin = g_ptr_array_index (priv->plugins, i);
+		if (!g_module_symbol (check.plugin->module,
+				      "asb_plugin_check_filename",
+				      (gpointer *) &check.func))
+			continue;
+		g_array_append_val (priv->check_fns, check);
+	}
 	return TRUE;
 }
 
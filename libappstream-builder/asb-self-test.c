@@ -22,12 +22,15 @@
 #include "config.h"
 
 #include <glib.h>
+#include <glib/gstdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <locale.h>
 
 #include "as-cleanup.h"
 
 #include "asb-context-private.h"
+#include "asb-package-deb.h"
 #include "asb-plugin.h"
 #include "asb-plugin-loader.h"
 #include "asb-task.h"
@@ -175,8 +178,170 @@ asb_test_package_rpm_func (void)
 	g_assert (ret);
 	g_assert (g_file_test ("/tmp/asb-test/usr/share/test-0.1/README", G_FILE_TEST_EXISTS));
 }
+
+static void
+asb_test_package_tree_func (void)
+{
+	GError *error = NULL;
+	gboolean ret;
+	_cleanup_bytes_unref_ GBytes *bytes = NULL;
+	_cleanup_free_ gchar *filename = NULL;
+	_cleanup_free_ gchar *fn = NULL;
+	_cleanup_object_unref_ AsbPackage *pkg = NULL;
+	_cleanup_object_unref_ AsbPackageTree *tree = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *array = NULL;
+
+	/* open file */
+	filename = asb_test_get_filename ("test-0.1-1.fc21.noarch.rpm");
+	g_assert (filename != NULL);
+	pkg = asb_package_rpm_new ();
+	ret = asb_package_open (pkg, filename, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* explode into memory */
+	ret = asb_utils_rmtree ("/tmp/asb-test-tree", &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	tree = asb_package_tree_new ("/tmp/asb-test-tree");
+	ret = asb_package_explode_tree (pkg, tree, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert (!g_file_test ("/tmp/asb-test-tree", G_FILE_TEST_EXISTS));
+	g_assert (asb_package_tree_exists (tree, "/usr/share/test-0.1/README"));
+	g_assert (asb_package_tree_exists (tree, "/usr/share/test-0.1"));
+	g_assert (!asb_package_tree_exists (tree, "/usr/share/test-0.1/NEWS"));
+	bytes = asb_package_tree_get_bytes (tree, "/usr/share/./test-0.1/../test-0.1/README", &error);
+	g_assert_no_error (error);
+	g_assert (bytes != NULL);
+	array = asb_package_tree_list_dir (tree, "/usr/share", &error);
+	g_assert_no_error (error);
+	g_assert (array != NULL);
+	g_assert_cmpint (array->len, ==, 1);
+	g_assert_cmpstr (g_ptr_array_index (array, 0), ==, "test-0.1");
+
+	/* only written when a real file is needed */
+	fn = asb_package_tree_get_filename (tree, "/usr/share/test-0.1/README", &error);
+	g_assert_no_error (error);
+	g_assert_cmpstr (fn, ==, "/tmp/asb-test-tree/usr/share/test-0.1/README");
+	g_assert (g_file_test (fn, G_FILE_TEST_EXISTS));
+
+	/* clean up */
+	ret = asb_utils_rmtree ("/tmp/asb-test-tree", &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert (!g_file_test ("/tmp/asb-test-tree", G_FILE_TEST_EXISTS));
+}
 #endif
 
+static void
+asb_test_package_deb_func (void)
+{
+	GError *error = NULL;
+	gboolean ret;
+	gchar **deps;
+	gchar **filelist;
+	gsize len;
+	const gchar *fn_truncated = "/tmp/asb-test-truncated.deb";
+	_cleanup_bytes_unref_ GBytes *bytes = NULL;
+	_cleanup_bytes_unref_ GBytes *bytes_budget = NULL;
+	_cleanup_free_ gchar *data = NULL;
+	_cleanup_free_ gchar *filename = NULL;
+	_cleanup_object_unref_ AsbPackage *pkg = NULL;
+	_cleanup_object_unref_ AsbPackage *pkg_truncated = NULL;
+	_cleanup_object_unref_ AsbPackageTree *tree = NULL;
+	_cleanup_object_unref_ AsbPackageTree *tree_budget = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *glob = NULL;
+
+	/* open file */
+	filename = asb_test_get_filename ("test_0.1-2_all.deb");
+	g_assert (filename != NULL);
+	pkg = asb_package_deb_new ();
+	ret = asb_package_open (pkg, filename, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* check the control fields */
+	g_assert_cmpstr (asb_package_get_name (pkg), ==, "test");
+	g_assert_cmpstr (asb_package_get_source (pkg), ==, "test-src");
+	g_assert_cmpstr (asb_package_get_evr (pkg), ==, "1:0.1-2");
+	g_assert_cmpstr (asb_package_get_nevr (pkg), ==, "test-1:0.1-2");
+	deps = asb_package_get_deps (pkg);
+	g_assert (deps != NULL);
+	g_assert_cmpstr (deps[0], ==, "libc6");
+	g_assert_cmpstr (deps[1], ==, "pkg-config");
+	g_assert_cmpstr (deps[2], ==, NULL);
+
+	/* check the file list, which does not include directories */
+	filelist = asb_package_get_filelist (pkg);
+	g_assert (filelist != NULL);
+	g_assert_cmpstr (filelist[0], ==, "/usr/share/test-0.1/README");
+	g_assert_cmpstr (filelist[1], ==, "/usr/share/test-0.1/test.desktop");
+	g_assert_cmpstr (filelist[2], ==, NULL);
+
+	/* only extract the files matching the glob */
+	ret = asb_utils_rmtree ("/tmp/asb-test-deb", &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	glob = asb_glob_value_array_new ();
+	g_ptr_array_add (glob, asb_glob_value_new ("/usr/share/test-0.1/README", ""));
+	tree = asb_package_tree_new ("/tmp/asb-test-deb");
+	ret = asb_package_explode_tree (pkg, tree, glob, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert (asb_package_tree_exists (tree, "/usr/share/test-0.1/README"));
+	g_assert (!asb_package_tree_exists (tree, "/usr/share/test-0.1/test.desktop"));
+	bytes = asb_package_tree_get_bytes (tree, "/usr/share/test-0.1/README", &error);
+	g_assert_no_error (error);
+	g_assert (bytes != NULL);
+	g_assert_cmpint (g_bytes_get_size (bytes), ==, 20);
+	g_assert (memcmp (g_bytes_get_data (bytes, NULL), "This is a test file\n", 20) == 0);
+
+	/* files past the total budget of the tree go to disk */
+	ret = asb_utils_rmtree ("/tmp/asb-test-budget", &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	tree_budget = asb_package_tree_new ("/tmp/asb-test-budget");
+	asb_package_tree_set_max_total_size (tree_budget, 100);
+	ret = asb_package_explode_tree (pkg, tree_budget, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert (!g_file_test ("/tmp/asb-test-budget/usr/share/test-0.1/README", G_FILE_TEST_EXISTS));
+	g_assert (g_file_test ("/tmp/asb-test-budget/usr/share/test-0.1/test.desktop", G_FILE_TEST_EXISTS));
+	bytes_budget = asb_package_tree_get_bytes (tree_budget, "/usr/share/test-0.1/test.desktop", &error);
+	g_assert_no_error (error);
+	g_assert (bytes_budget != NULL);
+	g_assert_cmpint (g_bytes_get_size (bytes_budget), ==, 213);
+	ret = asb_utils_rmtree ("/tmp/asb-test-budget", &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* extract everything to disk */
+	ret = asb_package_explode (pkg, "/tmp/asb-test-deb", NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert (g_file_test ("/tmp/asb-test-deb/usr/share/test-0.1/README", G_FILE_TEST_EXISTS));
+	g_assert (g_file_test ("/tmp/asb-test-deb/usr/share/test-0.1/test.desktop", G_FILE_TEST_EXISTS));
+	ret = asb_utils_rmtree ("/tmp/asb-test-deb", &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert (!g_file_test ("/tmp/asb-test-deb", G_FILE_TEST_EXISTS));
+
+	/* a package with the end of data.tar missing is an error */
+	ret = g_file_get_contents (filename, &data, &len, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	ret = g_file_set_contents (fn_truncated, data, len - 64, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	pkg_truncated = asb_package_deb_new ();
+	ret = asb_package_open (pkg_truncated, fn_truncated, &error);
+	g_assert_error (error, ASB_PLUGIN_ERROR, ASB_PLUGIN_ERROR_FAILED);
+	g_assert (!ret);
+	g_clear_error (&error);
+	g_unlink (fn_truncated);
+}
+
 static void
 asb_test_utils_glob_func (void)
 {
@@ -189,6 +354,17 @@ asb_test_utils_glob_func (void)
 	g_assert_cmpstr (asb_glob_value_search (array, "moo"), ==, NULL);
 	g_assert_cmpstr (asb_glob_value_search (array, "gimp.desktop"), ==, "DESKTOP");
 	g_assert_cmpstr (asb_glob_value_search (array, "gimp.appdata.xml"), ==, "APPDATA");
+
+	/* literal prefixes and suffixes, and globs needing fnmatch() */
+	g_ptr_array_add (array, asb_glob_value_new ("/usr/share/help", "HELP"));
+	g_ptr_array_add (array, asb_glob_value_new ("/usr/lib/*/*.so", "LIB"));
+	g_ptr_array_add (array, asb_glob_value_new ("/usr/bin/gimp-?.[0-9]", "GIMP"));
+	g_assert_cmpstr (asb_glob_value_search (array, "/usr/share/help"), ==, "HELP");
+	g_assert_cmpstr (asb_glob_value_search (array, "/usr/share/help/C"), ==, NULL);
+	g_assert_cmpstr (asb_glob_value_search (array, "/usr/lib/gimp/foo.so"), ==, "LIB");
+	g_assert_cmpstr (asb_glob_value_search (array, "/usr/lib/foo.so"), ==, NULL);
+	g_assert_cmpstr (asb_glob_value_search (array, "/usr/bin/gimp-2.8"), ==, "GIMP");
+	g_assert_cmpstr (asb_glob_value_search (array, "/usr/bin/gimp-2.x"), ==, NULL);
 }
 
 static void
@@ -249,9 +425,19 @@ typedef enum {
 	ASB_TEST_CONTEXT_MODE_NO_CACHE,
 	ASB_TEST_CONTEXT_MODE_WITH_CACHE,
 	ASB_TEST_CONTEXT_MODE_WITH_OLD_CACHE,
+	ASB_TEST_CONTEXT_MODE_WITH_RESULT_CACHE,
 	ASB_TEST_CONTEXT_MODE_LAST
 } AsbTestContextMode;
 
+static void
+asb_test_context_progress_cb (guint current, guint total, gpointer user_data)
+{
+	guint *progress = (guint *) user_data;
+	g_assert_cmpint (current, >=, *progress);
+	g_assert_cmpint (current, <=, total);
+	*progress = current;
+}
+
 static void
 asb_test_context_test_func (AsbTestContextMode mode)
 {
@@ -260,6 +446,7 @@ asb_test_context_test_func (AsbTestContextMode mode)
 	const gchar *expected_xml;
 	gboolean ret;
 	guint i;
+	guint progress = 0;
 	_cleanup_object_unref_ AsbContext *ctx = NULL;
 	_cleanup_object_unref_ AsStore *store_failed = NULL;
 	_cleanup_object_unref_ AsStore *store_ignore = NULL;
@@ -267,6 +454,7 @@ asb_test_context_test_func (AsbTestContextMode mode)
 	_cleanup_object_unref_ GFile *file_failed = NULL;
 	_cleanup_object_unref_ GFile *file_ignore = NULL;
 	_cleanup_object_unref_ GFile *file = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *array = NULL;
 	_cleanup_string_free_ GString *xml = NULL;
 	_cleanup_string_free_ GString *xml_failed = NULL;
 	_cleanup_string_free_ GString *xml_ignore = NULL;
@@ -304,6 +492,9 @@ asb_test_context_test_func (AsbTestContextMode mode)
 			asb_context_set_old_metadata (ctx, old_cache_dir);
 		}
 		break;
+	case ASB_TEST_CONTEXT_MODE_WITH_RESULT_CACHE:
+		asb_context_set_result_cache_enabled (ctx, TRUE);
+		break;
 	default:
 		break;
 	}
@@ -314,21 +505,27 @@ asb_test_context_test_func (AsbTestContextMode mode)
 	g_assert (ret);
 
 	/* add packages */
+	array = g_ptr_array_new_with_free_func (g_free);
 	for (i = 0; filenames[i] != NULL; i++) {
-		_cleanup_free_ gchar *filename = NULL;
+		gchar *filename;
 		filename = asb_test_get_filename (filenames[i]);
 		if (filename == NULL)
 			g_warning ("%s not found", filenames[i]);
 		g_assert (filename != NULL);
-		ret = asb_context_add_filename (ctx, filename, &error);
-		g_assert_no_error (error);
-		g_assert (ret);
+		g_ptr_array_add (array, filename);
 	}
+	ret = asb_context_add_filenames (ctx, array,
+					 asb_test_context_progress_cb,
+					 &progress, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (progress, ==, array->len);
 
 	/* verify queue size */
 	switch (mode) {
 	case ASB_TEST_CONTEXT_MODE_NO_CACHE:
 	case ASB_TEST_CONTEXT_MODE_WITH_OLD_CACHE:
+	case ASB_TEST_CONTEXT_MODE_WITH_RESULT_CACHE:
 		g_assert_cmpint (asb_context_get_packages(ctx)->len, ==, 8);
 		break;
 	default:
@@ -749,6 +946,104 @@ asb_test_context_oldcache_func (void)
 #endif
 }
 
+static void
+asb_test_context_resultcache_func (void)
+{
+#ifdef HAVE_RPM
+	GError *error = NULL;
+	gboolean ret;
+
+	/* the first run fills the cache */
+	asb_test_context_test_func (ASB_TEST_CONTEXT_MODE_WITH_RESULT_CACHE);
+	g_assert (g_file_test ("/tmp/asbuilder/cache/results", G_FILE_TEST_IS_DIR));
+
+	/* remove everything apart from the cache */
+	ret = asb_utils_rmtree ("/tmp/asbuilder/temp", &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	ret = asb_utils_rmtree ("/tmp/asbuilder/output", &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* the second run should produce the same results from the cache */
+	asb_test_context_test_func (ASB_TEST_CONTEXT_MODE_WITH_RESULT_CACHE);
+
+	/* remove temp space */
+	ret = asb_utils_rmtree ("/tmp/asbuilder", &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+#endif
+}
+
+/**
+ * asb_test_get_result_key:
+ **/
+static gchar *
+asb_test_get_result_key (AsbPackage *pkg, GPtrArray *extra_pkgs)
+{
+	GError *error = NULL;
+	gchar *key;
+	_cleanup_object_unref_ AsbContext *ctx = NULL;
+
+	ctx = asb_context_new ();
+	asb_context_set_extra_appdata (ctx, "/tmp/asb-test-result-key/appdata");
+	key = asb_context_get_result_key (ctx, pkg, extra_pkgs, &error);
+	g_assert_no_error (error);
+	g_assert (key != NULL);
+	return key;
+}
+
+static void
+asb_test_context_result_key_func (void)
+{
+	GError *error = NULL;
+	gboolean ret;
+	const gchar *fn = "/tmp/asb-test-result-key/appdata/test.appdata.xml";
+	_cleanup_free_ gchar *filename = NULL;
+	_cleanup_free_ gchar *key1 = NULL;
+	_cleanup_free_ gchar *key2 = NULL;
+	_cleanup_free_ gchar *key3 = NULL;
+	_cleanup_free_ gchar *key4 = NULL;
+	_cleanup_object_unref_ AsbPackage *pkg = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *extra_pkgs = NULL;
+
+	filename = asb_test_get_filename ("test-0.1-1.fc21.noarch.rpm");
+	g_assert (filename != NULL);
+	pkg = asb_package_new ();
+	ret = asb_package_open (pkg, filename, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* the same inputs give the same key */
+	ret = asb_utils_rmtree ("/tmp/asb-test-result-key", &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (g_mkdir_with_parents ("/tmp/asb-test-result-key/appdata", 0700), ==, 0);
+	ret = g_file_set_contents (fn, "<application/>", -1, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	key1 = asb_test_get_result_key (pkg, NULL);
+	key2 = asb_test_get_result_key (pkg, NULL);
+	g_assert_cmpstr (key1, ==, key2);
+
+	/* editing an extra AppData file changes the key */
+	ret = g_file_set_contents (fn, "<component/>", -1, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	key3 = asb_test_get_result_key (pkg, NULL);
+	g_assert_cmpstr (key3, !=, key1);
+
+	/* so does exploding another package with it */
+	extra_pkgs = g_ptr_array_new ();
+	g_ptr_array_add (extra_pkgs, pkg);
+	key4 = asb_test_get_result_key (pkg, extra_pkgs);
+	g_assert_cmpstr (key4, !=, key3);
+
+	ret = asb_utils_rmtree ("/tmp/asb-test-result-key", &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -763,11 +1058,15 @@ main (int argc, char **argv)
 	g_test_add_func ("/AppStreamBuilder/utils{replace}", asb_test_utils_replace_func);
 	g_test_add_func ("/AppStreamBuilder/utils{glob}", asb_test_utils_glob_func);
 	g_test_add_func ("/AppStreamBuilder/plugin-loader", asb_test_plugin_loader_func);
+	g_test_add_func ("/AppStreamBuilder/package{deb}", asb_test_package_deb_func);
 	g_test_add_func ("/AppStreamBuilder/context{no-cache}", asb_test_context_nocache_func);
 	g_test_add_func ("/AppStreamBuilder/context{cache}", asb_test_context_cache_func);
 	g_test_add_func ("/AppStreamBuilder/context{old-cache}", asb_test_context_oldcache_func);
+	g_test_add_func ("/AppStreamBuilder/context{result-cache}", asb_test_context_resultcache_func);
+	g_test_add_func ("/AppStreamBuilder/context{result-key}", asb_test_context_result_key_func);
 #ifdef HAVE_RPM
 	g_test_add_func ("/AppStreamBuilder/package{rpm}", asb_test_package_rpm_func);
+	g_test_add_func ("/AppStreamBuilder/package-tree", asb_test_package_tree_func);
 #endif
 	return g_test_run ();
 }
@@ -0,0 +1,40 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2014 Richard Hughes <richard@hughsie.com>
+ *
+ * Licensed under the GNU Lesser General Public License Version 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef ASB_TASK_PRIVATE_H
+#define ASB_TASK_PRIVATE_H
+
+#include "asb-task.h"
+
+G_BEGIN_DECLS
+
+gboolean	 asb_task_explode		(AsbTask	*task,
+						 GError		**error_not_used);
+gboolean	 asb_task_examine		(AsbTask	*task,
+						 GError		**error_not_used);
+gboolean	 asb_task_save			(AsbTask	*task,
+						 GError		**error_not_used);
+gboolean	 asb_task_cleanup		(AsbTask	*task,
+						 GError		**error_not_used);
+
+G_END_DECLS
+
+#endif /* ASB_TASK_PRIVATE_H */
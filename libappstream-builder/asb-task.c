@@ -33,6 +33,7 @@
 #include "as-cleanup.h"
 #include "asb-context-private.h"
 #include "asb-task.h"
+#include "asb-task-private.h"
 #include "asb-package.h"
 #include "asb-utils.h"
 #include "asb-plugin.h"
@@ -48,6 +49,14 @@ struct _AsbTaskPrivate
 	gchar			*filename;
 	gchar			*tmpdir;
 	guint			 id;
+	gchar			*result_key;
+	GPtrArray		*extra_pkgs;		/* of AsbPackage */
+	GPtrArray		*apps_to_save;		/* of AsbApp */
+	guint			 nr_added;
+	gboolean		 has_tree;
+	gboolean		 exploded;
+	gboolean		 examined;
+	gboolean		 cached;
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE (AsbTask, asb_task, G_TYPE_OBJECT)
@@ -89,17 +98,16 @@ asb_task_add_suitable_plugins (AsbTask *task)
 }
 
 /**
- * asb_task_explode_extra_package:
+ * asb_task_add_extra_package:
  **/
 static gboolean
-asb_task_explode_extra_package (AsbTask *task,
-				const gchar *pkg_name,
-				gboolean require_same_srpm,
-				GError **error)
+asb_task_add_extra_package (AsbTask *task,
+			    const gchar *pkg_name,
+			    gboolean require_same_srpm,
+			    GError **error)
 {
 	AsbTaskPrivate *priv = GET_PRIVATE (task);
 	AsbPackage *pkg_extra;
-	gboolean ret = TRUE;
 
 	/* if not found, that's fine */
 	pkg_extra = asb_context_find_by_pkgname (priv->ctx, pkg_name);
@@ -116,25 +124,15 @@ asb_task_explode_extra_package (AsbTask *task,
 	    (g_strcmp0 (asb_package_get_source (pkg_extra),
 		        asb_package_get_source (priv->pkg)) != 0))
 		return TRUE;
-
-	asb_panel_set_status (priv->panel, "Decompressing extra pkg %s",
-			      asb_package_get_name (pkg_extra));
-	asb_package_log (priv->pkg,
-			 ASB_PACKAGE_LOG_LEVEL_DEBUG,
-			 "Adding extra package %s for %s",
-			 asb_package_get_name (pkg_extra),
-			 asb_package_get_name (priv->pkg));
-	ret = asb_package_explode (pkg_extra, priv->tmpdir,
-				   asb_context_get_file_globs (priv->ctx),
-				   error);
-	return ret;
+	g_ptr_array_add (priv->extra_pkgs, g_object_ref (pkg_extra));
+	return TRUE;
 }
 
 /**
- * asb_task_explode_extra_packages:
+ * asb_task_ensure_extra_packages:
  **/
 static gboolean
-asb_task_explode_extra_packages (AsbTask *task, GError **error)
+asb_task_ensure_extra_packages (AsbTask *task, GError **error)
 {
 	AsbTaskPrivate *priv = GET_PRIVATE (task);
 	const gchar *ignore[] = { "rtld", NULL };
@@ -145,6 +143,10 @@ asb_task_explode_extra_packages (AsbTask *task, GError **error)
 	_cleanup_ptrarray_unref_ GPtrArray *array = NULL;
 	_cleanup_ptrarray_unref_ GPtrArray *icon_themes = NULL;
 
+	/* already done */
+	if (priv->extra_pkgs != NULL)
+		return TRUE;
+
 	/* anything the package requires */
 	hash = g_hash_table_new (g_str_hash, g_str_equal);
 	for (i = 0; ignore[i] != NULL; i++) {
@@ -178,50 +180,128 @@ asb_task_explode_extra_packages (AsbTask *task, GError **error)
 		g_hash_table_insert (hash, deps[i], GINT_TO_POINTER (1));
 	}
 
-	/* explode any potential packages */
+	/* any potential packages */
+	priv->extra_pkgs = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
 	for (i = 0; i < array->len; i++) {
 		tmp = g_ptr_array_index (array, i);
-		if (!asb_task_explode_extra_package (task, tmp, TRUE, error))
+		if (!asb_task_add_extra_package (task, tmp, TRUE, error))
 			return FALSE;
 	}
 
-	/* explode any icon themes */
+	/* any icon themes */
 	for (i = 0; i < icon_themes->len; i++) {
 		tmp = g_ptr_array_index (icon_themes, i);
-		if (!asb_task_explode_extra_package (task, tmp, FALSE, error))
+		if (!asb_task_add_extra_package (task, tmp, FALSE, error))
 			return FALSE;
 	}
 	return TRUE;
 }
 
 /**
- * asb_task_process:
+ * asb_task_explode_extra_packages:
+ **/
+static gboolean
+asb_task_explode_extra_packages (AsbTask *task, GError **error)
+{
+	AsbTaskPrivate *priv = GET_PRIVATE (task);
+	AsbPackage *pkg_extra;
+	guint i;
+
+	if (!asb_task_ensure_extra_packages (task, error))
+		return FALSE;
+	for (i = 0; i < priv->extra_pkgs->len; i++) {
+		pkg_extra = g_ptr_array_index (priv->extra_pkgs, i);
+		asb_panel_set_status (priv->panel, "Decompressing extra pkg %s",
+				      asb_package_get_name (pkg_extra));
+		asb_package_log (priv->pkg,
+				 ASB_PACKAGE_LOG_LEVEL_DEBUG,
+				 "Adding extra package %s for %s",
+				 asb_package_get_name (pkg_extra),
+				 asb_package_get_name (priv->pkg));
+		if (!asb_package_explode_tree (pkg_extra,
+					       asb_package_get_tree (priv->pkg),
+					       asb_context_get_file_globs (priv->ctx),
+					       error))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * asb_task_load_result:
+ **/
+static gboolean
+asb_task_load_result (AsbTask *task)
+{
+	AsbApp *app;
+	AsbTaskPrivate *priv = GET_PRIVATE (task);
+	guint i;
+	_cleanup_error_free_ GError *error = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *apps = NULL;
+
+	/* the key depends on any extra packages too */
+	if (!asb_task_ensure_extra_packages (task, &error)) {
+		asb_package_log (priv->pkg,
+				 ASB_PACKAGE_LOG_LEVEL_WARNING,
+				 "Failed to find extra packages: %s",
+				 error->message);
+		return FALSE;
+	}
+	priv->result_key = asb_context_get_result_key (priv->ctx,
+						       priv->pkg,
+						       priv->extra_pkgs,
+						       &error);
+	if (priv->result_key == NULL) {
+		asb_package_log (priv->pkg,
+				 ASB_PACKAGE_LOG_LEVEL_WARNING,
+				 "Failed to get cache key: %s",
+				 error->message);
+		return FALSE;
+	}
+
+	/* not processed before */
+	apps = asb_context_load_result (priv->ctx,
+					priv->pkg,
+					priv->result_key,
+					&error);
+	if (apps == NULL) {
+		if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND)) {
+			asb_package_log (priv->pkg,
+					 ASB_PACKAGE_LOG_LEVEL_WARNING,
+					 "Failed to load cached result: %s",
+					 error->message);
+		}
+		return FALSE;
+	}
+	for (i = 0; i < apps->len; i++) {
+		app = g_ptr_array_index (apps, i);
+		asb_context_add_app (priv->ctx, app);
+		priv->nr_added++;
+	}
+	priv->cached = TRUE;
+	return TRUE;
+}
+
+/**
+ * asb_task_explode:
  * @task: A #AsbTask
  * @error_not_used: A #GError or %NULL
  *
- * Processes the task.
+ * Decompresses the package and any extra packages it needs into a
+ * #AsbPackageTree, which keeps small files in memory. This is the first
+ * stage of processing the task and is typically limited by the speed of
+ * the disk rather than the CPU.
  *
  * Returns: %TRUE for success, %FALSE otherwise
- *
- * Since: 0.1.0
  **/
 gboolean
-asb_task_process (AsbTask *task, GError **error_not_used)
+asb_task_explode (AsbTask *task, GError **error_not_used)
 {
-	AsRelease *release;
-	AsbApp *app;
-	AsbPlugin *plugin = NULL;
 	AsbTaskPrivate *priv = GET_PRIVATE (task);
-	GList *apps = NULL;
-	GList *l;
-	GPtrArray *array;
 	gboolean ret;
-	gchar *cache_id;
-	gchar *tmp;
-	guint i;
-	guint nr_added = 0;
 	_cleanup_error_free_ GError *error = NULL;
 	_cleanup_free_ gchar *basename = NULL;
+	_cleanup_object_unref_ AsbPackageTree *tree = NULL;
 
 	/* reset the profile timer */
 	asb_package_log_start (priv->pkg);
@@ -254,14 +334,34 @@ asb_task_process (AsbTask *task, GError **error_not_used)
 		goto out;
 	}
 
-	/* delete old tree if it exists */
-	ret = asb_utils_ensure_exists_and_empty (priv->tmpdir, &error);
-	if (!ret) {
-		asb_package_log (priv->pkg,
-				 ASB_PACKAGE_LOG_LEVEL_WARNING,
-				 "Failed to clear: %s", error->message);
-		goto out;
+	/* was this processed before, perhaps with a different filename */
+	if (asb_context_get_result_cache_enabled (priv->ctx)) {
+		if (!asb_package_ensure (priv->pkg,
+					 ASB_PACKAGE_ENSURE_DEPS |
+					 ASB_PACKAGE_ENSURE_SOURCE,
+					 error_not_used)) {
+			asb_panel_remove (priv->panel);
+			return FALSE;
+		}
+		asb_panel_set_status (priv->panel, "Checking cache");
+		if (asb_task_load_result (task))
+			goto out;
+	}
+
+	/* delete old tree if it exists; the directory is only created again
+	 * if any files have to be written to disk */
+	if (g_file_test (priv->tmpdir, G_FILE_TEST_EXISTS)) {
+		ret = asb_utils_rmtree (priv->tmpdir, &error);
+		if (!ret) {
+			asb_package_log (priv->pkg,
+					 ASB_PACKAGE_LOG_LEVEL_WARNING,
+					 "Failed to clear: %s", error->message);
+			goto out;
+		}
 	}
+	tree = asb_package_tree_new (priv->tmpdir);
+	asb_package_set_tree (priv->pkg, tree);
+	priv->has_tree = TRUE;
 
 	/* explode tree */
 	asb_panel_set_status (priv->panel, "Decompressing files");
@@ -269,35 +369,78 @@ asb_task_process (AsbTask *task, GError **error_not_used)
 			 ASB_PACKAGE_LOG_LEVEL_DEBUG,
 			 "Exploding tree for %s",
 			 asb_package_get_name (priv->pkg));
-	ret = asb_package_explode (priv->pkg,
-				   priv->tmpdir,
-				   asb_context_get_file_globs (priv->ctx),
-				   &error);
+	ret = asb_package_explode_tree (priv->pkg,
+					tree,
+					asb_context_get_file_globs (priv->ctx),
+					&error);
 	if (!ret) {
 		asb_package_log (priv->pkg,
 				 ASB_PACKAGE_LOG_LEVEL_WARNING,
 				 "Failed to explode: %s", error->message);
-		g_clear_error (&error);
-		goto skip;
+		goto out;
 	}
 
 	/* add extra packages */
 	if (!asb_package_ensure (priv->pkg,
 				 ASB_PACKAGE_ENSURE_DEPS |
 				 ASB_PACKAGE_ENSURE_SOURCE,
-				 error_not_used))
+				 error_not_used)) {
+		asb_panel_remove (priv->panel);
 		return FALSE;
+	}
 	ret = asb_task_explode_extra_packages (task, &error);
 	if (!ret) {
 		asb_package_log (priv->pkg,
 				 ASB_PACKAGE_LOG_LEVEL_WARNING,
 				 "Failed to explode extra file: %s",
 				 error->message);
-		goto skip;
+		goto out;
 	}
+	priv->exploded = TRUE;
+out:
+	asb_panel_remove (priv->panel);
+	return TRUE;
+}
+
+/**
+ * asb_task_examine:
+ * @task: A #AsbTask
+ * @error_not_used: A #GError or %NULL
+ *
+ * Runs the plugins on the files decompressed by asb_task_explode() and
+ * refines any applications found, which are then added to the context by
+ * asb_task_save(). This stage does nothing if the package could not be
+ * decompressed.
+ *
+ * Returns: %TRUE for success, %FALSE otherwise
+ **/
+gboolean
+asb_task_examine (AsbTask *task, GError **error_not_used)
+{
+	AsRelease *release;
+	AsbApp *app;
+	AsbPlugin *plugin = NULL;
+	AsbTaskPrivate *priv = GET_PRIVATE (task);
+	GList *apps = NULL;
+	GList *l;
+	GPtrArray *array;
+	gboolean ret = TRUE;
+	gchar *cache_id;
+	gchar *tmp;
+	guint i;
+	_cleanup_error_free_ GError *error = NULL;
+	_cleanup_free_ gchar *basename = NULL;
+
+	/* nothing to do */
+	if (!priv->exploded)
+		return TRUE;
+
+	asb_panel_set_job_number (priv->panel, priv->id + 1);
+	asb_panel_set_title (priv->panel, asb_package_get_name (priv->pkg));
 
 	/* run plugins */
 	asb_panel_set_status (priv->panel, "Examining");
+	basename = g_path_get_basename (priv->filename);
 	for (i = 0; i < priv->plugins_to_run->len; i++) {
 		GList *apps_tmp = NULL;
 		plugin = g_ptr_array_index (priv->plugins_to_run, i);
@@ -321,7 +464,7 @@ asb_task_process (AsbTask *task, GError **error_not_used)
 		g_list_free_full (apps_tmp, g_object_unref);
 	}
 	if (apps == NULL)
-		goto skip;
+		goto done;
 
 	/* print */
 	asb_panel_set_status (priv->panel, "Processing");
@@ -342,8 +485,10 @@ asb_task_process (AsbTask *task, GError **error_not_used)
 					 ASB_PACKAGE_ENSURE_LICENSE |
 					 ASB_PACKAGE_ENSURE_RELEASES |
 					 ASB_PACKAGE_ENSURE_URL,
-					 error_not_used))
-			return FALSE;
+					 error_not_used)) {
+			ret = FALSE;
+			goto out;
+		}
 		if (asb_package_get_url (priv->pkg) != NULL) {
 			as_app_add_url (AS_APP (app),
 					AS_URL_KIND_HOMEPAGE,
@@ -382,8 +527,8 @@ asb_task_process (AsbTask *task, GError **error_not_used)
 					 "Failed to run process on %s: %s",
 					 as_app_get_id (AS_APP (app)),
 					 error->message);
-			g_clear_error (&error);
-			goto skip;
+			ret = TRUE;
+			goto out;
 		}
 
 		/* veto apps that *still* require appdata */
@@ -406,32 +551,130 @@ asb_task_process (AsbTask *task, GError **error_not_used)
 			g_free (cache_id);
 		}
 
+		/* all okay */
+		g_ptr_array_add (priv->apps_to_save, g_object_ref (app));
+	}
+done:
+	priv->examined = TRUE;
+out:
+	asb_panel_remove (priv->panel);
+	g_list_free_full (apps, (GDestroyNotify) g_object_unref);
+	return ret;
+}
+
+/**
+ * asb_task_save:
+ * @task: A #AsbTask
+ * @error_not_used: A #GError or %NULL
+ *
+ * Saves the screenshots of the applications found by asb_task_examine(),
+ * adds them to the context and stores the result in the cache. This is
+ * kept apart from examining the package as it is mostly spent waiting for
+ * the disk. This stage does nothing if the package could not be
+ * decompressed.
+ *
+ * Returns: %TRUE for success, %FALSE otherwise
+ **/
+gboolean
+asb_task_save (AsbTask *task, GError **error_not_used)
+{
+	AsbApp *app;
+	AsbTaskPrivate *priv = GET_PRIVATE (task);
+	gboolean ret = TRUE;
+	guint i;
+	_cleanup_error_free_ GError *error = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *added = NULL;
+
+	/* nothing to do */
+	if (!priv->exploded)
+		return TRUE;
+	added = g_ptr_array_new ();
+
+	asb_panel_set_job_number (priv->panel, priv->id + 1);
+	asb_panel_set_title (priv->panel, asb_package_get_name (priv->pkg));
+	asb_panel_set_status (priv->panel, "Saving screenshots");
+	for (i = 0; i < priv->apps_to_save->len; i++) {
+		app = g_ptr_array_index (priv->apps_to_save, i);
+
 		/* save any screenshots early */
-		if (array->len == 0) {
-			if (!asb_app_save_resources (ASB_APP (app),
+		if (asb_app_get_requires_appdata (app)->len == 0) {
+			if (!asb_app_save_resources (app,
 						     ASB_APP_SAVE_FLAG_SCREENSHOTS,
-						     error_not_used))
-				return FALSE;
+						     error_not_used)) {
+				ret = FALSE;
+				goto out;
+			}
 		}
 
 		/* all okay */
 		asb_context_add_app (priv->ctx, app);
-		nr_added++;
+		g_ptr_array_add (added, app);
+		priv->nr_added++;
 	}
-skip:
+
+	/* save for next time, unless examining stopped early */
+	if (priv->examined && priv->result_key != NULL) {
+		asb_panel_set_status (priv->panel, "Saving to cache");
+		if (!asb_context_save_result (priv->ctx,
+					      priv->pkg,
+					      priv->result_key,
+					      added,
+					      &error)) {
+			asb_package_log (priv->pkg,
+					 ASB_PACKAGE_LOG_LEVEL_WARNING,
+					 "Failed to save cached result: %s",
+					 error->message);
+		}
+	}
+out:
+	asb_panel_remove (priv->panel);
+	g_ptr_array_set_size (priv->apps_to_save, 0);
+	return ret;
+}
+
+/**
+ * asb_task_cleanup:
+ * @task: A #AsbTask
+ * @error_not_used: A #GError or %NULL
+ *
+ * Deletes the temporary files created by asb_task_explode() and writes the
+ * package log. This stage does nothing if no files were decompressed and
+ * no cached result was used.
+ *
+ * Returns: %TRUE for success, %FALSE otherwise
+ **/
+gboolean
+asb_task_cleanup (AsbTask *task, GError **error_not_used)
+{
+	AsbTaskPrivate *priv = GET_PRIVATE (task);
+	_cleanup_error_free_ GError *error = NULL;
+
+	/* nothing to do */
+	if (!priv->has_tree && !priv->cached)
+		return TRUE;
+
 	/* add a dummy element to the AppStream metadata so that we don't keep
 	 * parsing this every time */
-	if (asb_context_get_add_cache_id (priv->ctx) && nr_added == 0)
+	if (asb_context_get_add_cache_id (priv->ctx) && priv->nr_added == 0)
 		asb_context_add_app_ignore (priv->ctx, priv->pkg);
 
-	/* delete tree */
-	asb_panel_set_status (priv->panel, "Deleting temp files");
-	if (!asb_utils_rmtree (priv->tmpdir, &error)) {
-		asb_package_log (priv->pkg,
-				 ASB_PACKAGE_LOG_LEVEL_WARNING,
-				 "Failed to delete tree: %s",
-				 error->message);
-		goto out;
+	asb_panel_set_job_number (priv->panel, priv->id + 1);
+	asb_panel_set_title (priv->panel, asb_package_get_name (priv->pkg));
+
+	/* delete tree, which may never have been written to disk */
+	if (priv->has_tree) {
+		asb_package_set_tree (priv->pkg, NULL);
+		priv->has_tree = FALSE;
+	}
+	if (g_file_test (priv->tmpdir, G_FILE_TEST_EXISTS)) {
+		asb_panel_set_status (priv->panel, "Deleting temp files");
+		if (!asb_utils_rmtree (priv->tmpdir, &error)) {
+			asb_package_log (priv->pkg,
+					 ASB_PACKAGE_LOG_LEVEL_WARNING,
+					 "Failed to delete tree: %s",
+					 error->message);
+			goto out;
+		}
 	}
 
 	/* write log */
@@ -443,14 +686,39 @@ skip:
 				 error->message);
 		goto out;
 	}
-
-	/* update UI */
-	asb_panel_remove (priv->panel);
 out:
-	g_list_free_full (apps, (GDestroyNotify) g_object_unref);
+	asb_panel_remove (priv->panel);
 	return TRUE;
 }
 
+/**
+ * asb_task_process:
+ * @task: A #AsbTask
+ * @error_not_used: A #GError or %NULL
+ *
+ * Processes the task by running each of the stages in turn.
+ *
+ * Returns: %TRUE for success, %FALSE otherwise
+ *
+ * Since: 0.1.0
+ **/
+gboolean
+asb_task_process (AsbTask *task, GError **error_not_used)
+{
+	gboolean ret;
+
+	if (!asb_task_explode (task, error_not_used)) {
+		asb_task_cleanup (task, NULL);
+		return FALSE;
+	}
+	ret = asb_task_examine (task, error_not_used);
+	if (!asb_task_save (task, ret ? error_not_used : NULL))
+		ret = FALSE;
+	if (!asb_task_cleanup (task, ret ? error_not_used : NULL))
+		return FALSE;
+	return ret;
+}
+
 /**
  * asb_task_finalize:
  **/
@@ -466,8 +734,12 @@ asb_task_finalize (GObject *object)
 		g_object_unref (priv->pkg);
 	if (priv->panel != NULL)
 		g_object_unref (priv->panel);
+	if (priv->extra_pkgs != NULL)
+		g_ptr_array_unref (priv->extra_pkgs);
+	g_ptr_array_unref (priv->apps_to_save);
 	g_free (priv->filename);
 	g_free (priv->tmpdir);
+	g_free (priv->result_key);
 
 	G_OBJECT_CLASS (asb_task_parent_class)->finalize (object);
 }
@@ -531,6 +803,7 @@ asb_task_init (AsbTask *task)
 {
 	AsbTaskPrivate *priv = GET_PRIVATE (task);
 	priv->plugins_to_run = g_ptr_array_new ();
+	priv->apps_to_save = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
 }
 
 /**
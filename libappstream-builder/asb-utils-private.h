@@ -0,0 +1,45 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2014 Richard Hughes <richard@hughsie.com>
+ *
+ * Licensed under the GNU Lesser General Public License Version 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef ASB_UTILS_PRIVATE_H
+#define ASB_UTILS_PRIVATE_H
+
+#include <archive.h>
+
+#include "asb-package-tree.h"
+#include "asb-utils.h"
+
+G_BEGIN_DECLS
+
+gchar		*asb_utils_sanitise_path		(const gchar	*path);
+struct archive	*asb_utils_archive_read_nested		(struct archive	*outer,
+							 gboolean	 close_outer,
+							 GError		**error);
+gboolean	 asb_utils_explode_member		(const gchar	*filename,
+							 const gchar	*member,
+							 const gchar	*dir,
+							 AsbPackageTree	*tree,
+							 GPtrArray	*glob,
+							 GError		**error);
+
+G_END_DECLS
+
+#endif /* ASB_UTILS_PRIVATE_H */
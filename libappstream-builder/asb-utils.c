@@ -34,7 +34,8 @@
 #include <string.h>
 
 #include "as-cleanup.h"
-#include "asb-utils.h"
+#include "asb-package-tree-private.h"
+#include "asb-utils-private.h"
 #include "asb-plugin.h"
 
 #define ASB_METADATA_CACHE_VERSION	4
@@ -72,6 +73,41 @@ asb_utils_get_cache_id_for_filename (const gchar *filename)
 	return g_path_get_basename (filename);
 }
 
+/**
+ * asb_utils_get_cache_id_for_file:
+ * @filename: utf8 filename
+ * @error: A #GError or %NULL
+ *
+ * Gets a cache-id from the contents of a file, so that a rebuilt package with
+ * the same filename gets a different ID and a renamed package keeps the
+ * same ID.
+ *
+ * Returns: utf8 string, or %NULL for error
+ *
+ * Since: 0.3.3
+ **/
+gchar *
+asb_utils_get_cache_id_for_file (const gchar *filename, GError **error)
+{
+	gssize len;
+	_cleanup_checksum_free_ GChecksum *csum = NULL;
+	_cleanup_free_ guchar *buf = NULL;
+	_cleanup_object_unref_ GFile *file = NULL;
+	_cleanup_object_unref_ GInputStream *stream = NULL;
+
+	file = g_file_new_for_path (filename);
+	stream = G_INPUT_STREAM (g_file_read (file, NULL, error));
+	if (stream == NULL)
+		return NULL;
+	csum = g_checksum_new (G_CHECKSUM_SHA256);
+	buf = g_malloc (0x10000);
+	while ((len = g_input_stream_read (stream, buf, 0x10000, NULL, error)) > 0)
+		g_checksum_update (csum, buf, len);
+	if (len < 0)
+		return NULL;
+	return g_strdup (g_checksum_get_string (csum));
+}
+
 /**
  * asb_utils_rmtree:
  * @directory: utf8 directory name
@@ -209,10 +245,13 @@ asb_utils_get_back_to_root (guint levels)
 
 /**
  * asb_utils_sanitise_path:
+ * @path: a path from an archive
  *
  * Converts various formats into an absolute path.
+ *
+ * Returns: a new absolute path
  **/
-static gchar *
+gchar *
 asb_utils_sanitise_path (const gchar *path)
 {
 	/* /usr/share/README -> /usr/share/README */
@@ -279,60 +318,263 @@ asb_utils_explode_file (struct archive_entry *entry, const gchar *dir)
 	return TRUE;
 }
 
+typedef struct {
+	struct archive	*outer;
+	gboolean	 close_outer;
+} AsbUtilsNested;
+
 /**
- * asb_utils_explode:
+ * asb_utils_archive_nested_read_cb:
+ **/
+static ssize_t
+asb_utils_archive_nested_read_cb (struct archive *arch,
+				  void *user_data,
+				  const void **buf)
+{
+	AsbUtilsNested *nested = (AsbUtilsNested *) user_data;
+	int r;
+	int64_t offset;
+	size_t size;
+
+	r = archive_read_data_block (nested->outer, buf, &size, &offset);
+	if (r == ARCHIVE_EOF)
+		return 0;
+	if (r != ARCHIVE_OK) {
+		archive_set_error (arch,
+				   archive_errno (nested->outer),
+				   "%s",
+				   archive_error_string (nested->outer));
+		return -1;
+	}
+	return size;
+}
+
+/**
+ * asb_utils_archive_nested_close_cb:
+ **/
+static int
+asb_utils_archive_nested_close_cb (struct archive *arch, void *user_data)
+{
+	AsbUtilsNested *nested = (AsbUtilsNested *) user_data;
+
+	if (nested->close_outer) {
+		archive_read_close (nested->outer);
+		archive_read_free (nested->outer);
+	}
+	g_free (nested);
+	return ARCHIVE_OK;
+}
+
+/**
+ * asb_utils_archive_read_nested:
+ * @outer: an archive positioned on the member to read
+ * @close_outer: if @outer should be freed when the result is freed
+ * @error: A #GError or %NULL
+ *
+ * Opens the data of the current member of @outer as an archive in its own
+ * right, decompressing it as it is streamed rather than copying it to disk.
+ *
+ * Returns: a new archive, or %NULL for error
+ **/
+struct archive *
+asb_utils_archive_read_nested (struct archive *outer,
+			       gboolean close_outer,
+			       GError **error)
+{
+	AsbUtilsNested *nested;
+	int r;
+	struct archive *arch;
+
+	nested = g_new0 (AsbUtilsNested, 1);
+	nested->outer = outer;
+	nested->close_outer = close_outer;
+
+	/* the close callback frees @nested, even on failure */
+	arch = archive_read_new ();
+	archive_read_support_format_all (arch);
+	archive_read_support_filter_all (arch);
+	r = archive_read_open (arch, nested, NULL,
+			       asb_utils_archive_nested_read_cb,
+			       asb_utils_archive_nested_close_cb);
+	if (r) {
+		g_set_error (error,
+			     ASB_PLUGIN_ERROR,
+			     ASB_PLUGIN_ERROR_FAILED,
+			     "Cannot open: %s",
+			     archive_error_string (arch));
+		archive_read_free (arch);
+		return NULL;
+	}
+	return arch;
+}
+
+/**
+ * asb_utils_explode_open:
+ *
+ * Opens @filename, or the first member of it with a name starting with
+ * @member if that is not %NULL.
+ **/
+static struct archive *
+asb_utils_explode_open (const gchar *filename,
+			const gchar *member,
+			GError **error)
+{
+	int r;
+	struct archive *arch;
+	struct archive_entry *entry;
+
+	arch = archive_read_new ();
+	archive_read_support_format_all (arch);
+	archive_read_support_filter_all (arch);
+	r = archive_read_open_filename (arch, filename, 16384);
+	if (r) {
+		g_set_error (error,
+			     ASB_PLUGIN_ERROR,
+			     ASB_PLUGIN_ERROR_FAILED,
+			     "Cannot open: %s",
+			     archive_error_string (arch));
+		archive_read_free (arch);
+		return NULL;
+	}
+	if (member == NULL)
+		return arch;
+
+	/* find the member and read it in place */
+	for (;;) {
+		const gchar *tmp;
+		r = archive_read_next_header (arch, &entry);
+		if (r == ARCHIVE_EOF) {
+			g_set_error (error,
+				     ASB_PLUGIN_ERROR,
+				     ASB_PLUGIN_ERROR_FAILED,
+				     "No %s in %s", member, filename);
+			break;
+		}
+		if (r != ARCHIVE_OK) {
+			g_set_error (error,
+				     ASB_PLUGIN_ERROR,
+				     ASB_PLUGIN_ERROR_FAILED,
+				     "Cannot read header: %s",
+				     archive_error_string (arch));
+			break;
+		}
+		tmp = archive_entry_pathname (entry);
+		if (tmp != NULL && g_str_has_prefix (tmp, member))
+			return asb_utils_archive_read_nested (arch, TRUE, error);
+	}
+	archive_read_close (arch);
+	archive_read_free (arch);
+	return NULL;
+}
+
+/**
+ * asb_utils_explode_entry:
+ **/
+static gboolean
+asb_utils_explode_entry (struct archive *arch,
+			 struct archive_entry *entry,
+			 const gchar *dir,
+			 AsbPackageTree *tree,
+			 GError **error)
+{
+	int r;
+
+	/* small files do not need to touch the disk at all */
+	if (tree != NULL && asb_package_tree_can_add_entry (tree, entry))
+		return asb_package_tree_add_entry (tree, arch, entry, error);
+
+	if (!asb_utils_explode_file (entry, dir))
+		return TRUE;
+	r = archive_read_extract (arch, entry, 0);
+	if (r != ARCHIVE_OK) {
+		g_set_error (error,
+			     ASB_PLUGIN_ERROR,
+			     ASB_PLUGIN_ERROR_FAILED,
+			     "Cannot extract: %s",
+			     archive_error_string (arch));
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * asb_utils_explode_add_target:
+ *
+ * Records that the link target @path has to be extracted. If the entry has
+ * already been streamed past it can only be picked up by a second pass.
+ **/
+static gboolean
+asb_utils_explode_add_target (GHashTable *seen,
+			      GHashTable *wanted,
+			      GHashTable *deferred,
+			      const gchar *path)
+{
+	gpointer value;
+
+	if (!g_hash_table_lookup_extended (seen, path, NULL, &value)) {
+		g_hash_table_add (wanted, g_strdup (path));
+		return FALSE;
+	}
+	if (GPOINTER_TO_INT (value) == 0) {
+		g_hash_table_add (deferred, g_strdup (path));
+		return TRUE;
+	}
+	return FALSE;
+}
+
+/**
+ * asb_utils_explode_member:
  * @filename: package filename
+ * @member: prefix of the archive member to decompress, or %NULL
  * @dir: directory to decompress into
+ * @tree: (allow-none): a #AsbPackageTree to keep small files in, or %NULL
  * @glob: (element-type utf8): filename globs, or %NULL
  * @error: A #GError or %NULL
  *
- * Decompresses the package into a given directory.
+ * Decompresses the package into a given directory. If @member is set then
+ * the package is a container, and only the contents of the first member
+ * with that prefix are decompressed, without writing the member to disk.
+ * If @tree is set then any file it can hold is read into memory instead.
  *
- * Returns: %TRUE for success, %FALSE otherwise
+ * The archive is streamed from disk and entries are extracted as they are
+ * read. Only link targets that were skipped before the link referencing
+ * them was found need a second pass over the archive.
  *
- * Since: 0.1.0
+ * Returns: %TRUE for success, %FALSE otherwise
  **/
 gboolean
-asb_utils_explode (const gchar *filename,
-		   const gchar *dir,
-		   GPtrArray *glob,
-		   GError **error)
+asb_utils_explode_member (const gchar *filename,
+			  const gchar *member,
+			  const gchar *dir,
+			  AsbPackageTree *tree,
+			  GPtrArray *glob,
+			  GError **error)
 {
 	const gchar *tmp;
 	gboolean ret = TRUE;
-	gboolean valid;
-	gsize len;
 	int r;
 	struct archive *arch = NULL;
-	struct archive *arch_preview = NULL;
 	struct archive_entry *entry;
-	_cleanup_free_ gchar *data = NULL;
-	_cleanup_hashtable_unref_ GHashTable *matches = NULL;
+	_cleanup_hashtable_unref_ GHashTable *deferred = NULL;
+	_cleanup_hashtable_unref_ GHashTable *seen = NULL;
+	_cleanup_hashtable_unref_ GHashTable *wanted = NULL;
 
-	/* load file at once to avoid seeking */
-	ret = g_file_get_contents (filename, &data, &len, error);
-	if (!ret)
-		goto out;
+	/* path -> extracted? for everything already streamed past */
+	seen = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	wanted = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	deferred = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 
-	/* populate a hash with all the files, symlinks and hardlinks that
-	 * actually need decompressing */
-	arch_preview = archive_read_new ();
-	archive_read_support_format_all (arch_preview);
-	archive_read_support_filter_all (arch_preview);
-	r = archive_read_open_memory (arch_preview, data, len);
-	if (r) {
+	/* decompress anything matching the glob, or any link target */
+	arch = asb_utils_explode_open (filename, member, error);
+	if (arch == NULL) {
 		ret = FALSE;
-		g_set_error (error,
-			     ASB_PLUGIN_ERROR,
-			     ASB_PLUGIN_ERROR_FAILED,
-			     "Cannot open: %s",
-			     archive_error_string (arch_preview));
 		goto out;
 	}
-	matches = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 	for (;;) {
+		gboolean extract = TRUE;
+		gboolean late_target = FALSE;
 		_cleanup_free_ gchar *path = NULL;
-		r = archive_read_next_header (arch_preview, &entry);
+		r = archive_read_next_header (arch, &entry);
 		if (r == ARCHIVE_EOF)
 			break;
 		if (r != ARCHIVE_OK) {
@@ -341,7 +583,7 @@ asb_utils_explode (const gchar *filename,
 				     ASB_PLUGIN_ERROR,
 				     ASB_PLUGIN_ERROR_FAILED,
 				     "Cannot read header: %s",
-				     archive_error_string (arch_preview));
+				     archive_error_string (arch));
 			goto out;
 		}
 
@@ -350,41 +592,57 @@ asb_utils_explode (const gchar *filename,
 		if (tmp == NULL)
 			continue;
 		path = asb_utils_sanitise_path (tmp);
-		if (glob != NULL) {
-			if (asb_glob_value_search (glob, path) == NULL)
-				continue;
-		}
-		g_hash_table_insert (matches, g_strdup (path), GINT_TO_POINTER (1));
-
-		/* add hardlink */
-		tmp = archive_entry_hardlink (entry);
-		if (tmp != NULL) {
-			g_hash_table_insert (matches,
-					     asb_utils_sanitise_path (tmp),
-					     GINT_TO_POINTER (1));
+		if (glob != NULL && asb_glob_value_search (glob, path) == NULL) {
+			if (!g_hash_table_remove (wanted, path))
+				extract = FALSE;
+		} else {
+			/* add hardlink; the target has to exist on disk
+			 * before the link itself can be extracted */
+			tmp = archive_entry_hardlink (entry);
+			if (tmp != NULL) {
+				_cleanup_free_ gchar *path_link = NULL;
+				path_link = asb_utils_sanitise_path (tmp);
+				late_target = asb_utils_explode_add_target (seen,
+									    wanted,
+									    deferred,
+									    path_link);
+			}
+
+			/* add symlink */
+			tmp = archive_entry_symlink (entry);
+			if (tmp != NULL) {
+				_cleanup_free_ gchar *path_link = NULL;
+				path_link = asb_utils_sanitise_path (tmp);
+				asb_utils_explode_add_target (seen,
+							      wanted,
+							      deferred,
+							      path_link);
+			}
 		}
 
-		/* add symlink */
-		tmp = archive_entry_symlink (entry);
-		if (tmp != NULL) {
-			g_hash_table_insert (matches,
-					     asb_utils_sanitise_path (tmp),
-					     GINT_TO_POINTER (1));
+		/* extract now, or leave for the second pass */
+		if (late_target) {
+			g_hash_table_add (deferred, g_strdup (path));
+			extract = FALSE;
 		}
+		if (extract) {
+			if (!asb_utils_explode_entry (arch, entry, dir, tree, error)) {
+				ret = FALSE;
+				goto out;
+			}
+		}
+		g_hash_table_insert (seen, g_strdup (path), GINT_TO_POINTER (extract));
 	}
+	archive_read_close (arch);
+	archive_read_free (arch);
+	arch = NULL;
 
-	/* decompress anything matching either glob */
-	arch = archive_read_new ();
-	archive_read_support_format_all (arch);
-	archive_read_support_filter_all (arch);
-	r = archive_read_open_memory (arch, data, len);
-	if (r) {
+	/* link targets that were skipped before the link was found */
+	if (g_hash_table_size (deferred) == 0)
+		goto out;
+	arch = asb_utils_explode_open (filename, member, error);
+	if (arch == NULL) {
 		ret = FALSE;
-		g_set_error (error,
-			     ASB_PLUGIN_ERROR,
-			     ASB_PLUGIN_ERROR_FAILED,
-			     "Cannot open: %s",
-			     archive_error_string (arch));
 		goto out;
 	}
 	for (;;) {
@@ -401,31 +659,20 @@ asb_utils_explode (const gchar *filename,
 				     archive_error_string (arch));
 			goto out;
 		}
-
-		/* only extract if valid */
 		tmp = archive_entry_pathname (entry);
-		path = asb_utils_sanitise_path (tmp);
-		if (g_hash_table_lookup (matches, path) == NULL)
+		if (tmp == NULL)
 			continue;
-		valid = asb_utils_explode_file (entry, dir);
-		if (!valid)
+		path = asb_utils_sanitise_path (tmp);
+		if (!g_hash_table_remove (deferred, path))
 			continue;
-		r = archive_read_extract (arch, entry, 0);
-		if (r != ARCHIVE_OK) {
+		if (!asb_utils_explode_entry (arch, entry, dir, tree, error)) {
 			ret = FALSE;
-			g_set_error (error,
-				     ASB_PLUGIN_ERROR,
-				     ASB_PLUGIN_ERROR_FAILED,
-				     "Cannot extract: %s",
-				     archive_error_string (arch));
 			goto out;
 		}
+		if (g_hash_table_size (deferred) == 0)
+			break;
 	}
 out:
-	if (arch_preview != NULL) {
-		archive_read_close (arch_preview);
-		archive_read_free (arch_preview);
-	}
 	if (arch != NULL) {
 		archive_read_close (arch);
 		archive_read_free (arch);
@@ -433,6 +680,28 @@ out:
 	return ret;
 }
 
+/**
+ * asb_utils_explode:
+ * @filename: package filename
+ * @dir: directory to decompress into
+ * @glob: (element-type utf8): filename globs, or %NULL
+ * @error: A #GError or %NULL
+ *
+ * Decompresses the package into a given directory.
+ *
+ * Returns: %TRUE for success, %FALSE otherwise
+ *
+ * Since: 0.1.0
+ **/
+gboolean
+asb_utils_explode (const gchar *filename,
+		   const gchar *dir,
+		   GPtrArray *glob,
+		   GError **error)
+{
+	return asb_utils_explode_member (filename, NULL, dir, NULL, glob, error);
+}
+
 /**
  * asb_utils_write_archive:
  **/
@@ -642,6 +911,10 @@ asb_string_replace (GString *string, const gchar *search, const gchar *replace)
 struct AsbGlobValue {
 	gchar		*glob;
 	gchar		*value;
+	gsize		 glob_len;
+	gsize		 prefix_len;	/* literal text before any wildcard */
+	gsize		 suffix_len;	/* literal text after the last wildcard */
+	gboolean	 need_fnmatch;
 };
 
 /**
@@ -675,6 +948,76 @@ asb_glob_value_array_new (void)
 	return g_ptr_array_new_with_free_func ((GDestroyNotify) asb_glob_value_free);
 }
 
+/**
+ * asb_glob_value_compile:
+ *
+ * Splits the glob into a literal prefix and suffix so that most filenames can
+ * be rejected with a couple of memcmp()s. Globs of the form "prefix*suffix"
+ * are matched completely without needing fnmatch().
+ **/
+static void
+asb_glob_value_compile (AsbGlobValue *kv)
+{
+	const gchar *last;
+	guint n_stars = 0;
+	guint i;
+
+	kv->glob_len = strlen (kv->glob);
+	kv->prefix_len = strcspn (kv->glob, "*?[\\");
+	kv->suffix_len = 0;
+	kv->need_fnmatch = FALSE;
+
+	/* no wildcards at all */
+	if (kv->prefix_len == kv->glob_len)
+		return;
+
+	/* bracket expressions and escapes make the suffix hard to find */
+	if (strpbrk (kv->glob, "[\\") != NULL) {
+		kv->need_fnmatch = TRUE;
+		return;
+	}
+	for (i = kv->prefix_len; i < kv->glob_len; i++) {
+		if (kv->glob[i] == '?')
+			kv->need_fnmatch = TRUE;
+		else if (kv->glob[i] == '*')
+			n_stars++;
+	}
+	if (n_stars != 1)
+		kv->need_fnmatch = TRUE;
+	last = kv->glob + kv->glob_len;
+	while (last > kv->glob && last[-1] != '*' && last[-1] != '?')
+		last--;
+	kv->suffix_len = kv->glob_len - (gsize) (last - kv->glob);
+}
+
+/**
+ * asb_glob_value_match:
+ **/
+static gboolean
+asb_glob_value_match (const AsbGlobValue *kv, const gchar *search, gsize len)
+{
+	/* exact match */
+	if (kv->prefix_len == kv->glob_len) {
+		return len == kv->glob_len &&
+			memcmp (kv->glob, search, len) == 0;
+	}
+
+	/* check the literal parts first */
+	if (len < kv->prefix_len + kv->suffix_len)
+		return FALSE;
+	if (memcmp (kv->glob, search, kv->prefix_len) != 0)
+		return FALSE;
+	if (memcmp (kv->glob + kv->glob_len - kv->suffix_len,
+		    search + len - kv->suffix_len,
+		    kv->suffix_len) != 0)
+		return FALSE;
+
+	/* "prefix*suffix" needs nothing more */
+	if (!kv->need_fnmatch)
+		return TRUE;
+	return fnmatch (kv->glob, search, 0) == 0;
+}
+
 /**
  * asb_glob_value_new: (skip)
  * @glob: utf8 string
@@ -693,6 +1036,7 @@ asb_glob_value_new (const gchar *glob, const gchar *value)
 	kv = g_slice_new0 (AsbGlobValue);
 	kv->glob = g_strdup (glob);
 	kv->value = g_strdup (value);
+	asb_glob_value_compile (kv);
 	return kv;
 }
 
@@ -711,6 +1055,7 @@ const gchar *
 asb_glob_value_search (GPtrArray *array, const gchar *search)
 {
 	const AsbGlobValue *tmp;
+	gsize len;
 	guint i;
 
 	g_return_val_if_fail (array != NULL, NULL);
@@ -720,9 +1065,10 @@ asb_glob_value_search (GPtrArray *array, const gchar *search)
 	if (search == NULL)
 		return NULL;
 
+	len = strlen (search);
 	for (i = 0; i < array->len; i++) {
 		tmp = g_ptr_array_index (array, i);
-		if (fnmatch (tmp->glob, search, 0) == 0)
+		if (asb_glob_value_match (tmp, search, len))
 			return tmp->value;
 	}
 	return NULL;
@@ -43,6 +43,8 @@ gboolean	 asb_utils_explode			(const gchar	*filename,
 							 GPtrArray	*glob,
 							 GError		**error);
 gchar		*asb_utils_get_cache_id_for_filename	(const gchar	*filename);
+gchar		*asb_utils_get_cache_id_for_file	(const gchar	*filename,
+							 GError		**error);
 
 gchar		*asb_utils_get_builder_id		(void);
 
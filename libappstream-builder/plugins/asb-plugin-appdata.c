@@ -502,16 +502,19 @@ asb_plugin_process_app (AsbPlugin *plugin,
 			const gchar *tmpdir,
 			GError **error)
 {
+	AsbPackageTree *tree;
 	const gchar *kind_str;
 	const gchar *tmp;
 	_cleanup_free_ gchar *appdata_basename = NULL;
 	_cleanup_free_ gchar *appdata_filename = NULL;
 	_cleanup_free_ gchar *appdata_filename_extra = NULL;
+	_cleanup_free_ gchar *appdata_path = NULL;
 
 	/* get possible sources */
+	tree = asb_package_get_tree (pkg);
 	appdata_basename = asb_plugin_appdata_get_fn_for_app (AS_APP (app));
-	appdata_filename = g_strdup_printf ("%s/usr/share/appdata/%s.appdata.xml",
-					    tmpdir, appdata_basename);
+	appdata_path = g_strdup_printf ("/usr/share/appdata/%s.appdata.xml",
+					appdata_basename);
 	tmp = asb_package_get_config (pkg, "AppDataExtra");
 	if (tmp != NULL && g_file_test (tmp, G_FILE_TEST_EXISTS)) {
 		if (!asb_plugin_appdata_add_files (plugin, tmp, error))
@@ -521,7 +524,7 @@ asb_plugin_process_app (AsbPlugin *plugin,
 							  tmp,
 							  kind_str,
 							  appdata_basename);
-		if (g_file_test (appdata_filename, G_FILE_TEST_EXISTS) &&
+		if (asb_package_tree_exists (tree, appdata_path) &&
 		    g_file_test (appdata_filename_extra, G_FILE_TEST_EXISTS)) {
 			asb_package_log (pkg,
 					 ASB_PACKAGE_LOG_LEVEL_WARNING,
@@ -544,7 +547,12 @@ asb_plugin_process_app (AsbPlugin *plugin,
 	}
 
 	/* any installed appdata file */
-	if (g_file_test (appdata_filename, G_FILE_TEST_EXISTS)) {
+	if (asb_package_tree_exists (tree, appdata_path)) {
+		appdata_filename = asb_package_tree_get_filename (tree,
+								  appdata_path,
+								  error);
+		if (appdata_filename == NULL)
+			return FALSE;
 		return asb_plugin_process_filename (plugin,
 						    app,
 						    appdata_filename,
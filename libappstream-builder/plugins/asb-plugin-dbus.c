@@ -70,20 +70,25 @@ _asb_plugin_check_filename_session (const gchar *filename)
  */
 static gboolean
 asb_plugin_process_dbus (AsbApp *app,
-			 const gchar *tmpdir,
+			 AsbPackageTree *tree,
 			 const gchar *filename,
 			 gboolean is_system,
 			 GError **error)
 {
-	_cleanup_free_ gchar *filename_full = NULL;
+	const gchar *data;
+	gsize len;
+	_cleanup_bytes_unref_ GBytes *bytes = NULL;
 	_cleanup_free_ gchar *name = NULL;
 	_cleanup_keyfile_unref_ GKeyFile *kf = NULL;
 	_cleanup_object_unref_ AsProvide *provide = NULL;
 
 	/* load file */
-	filename_full = g_build_filename (tmpdir, filename, NULL);
+	bytes = asb_package_tree_get_bytes (tree, filename, error);
+	if (bytes == NULL)
+		return FALSE;
+	data = g_bytes_get_data (bytes, &len);
 	kf = g_key_file_new ();
-	if (!g_key_file_load_from_file (kf, filename_full, G_KEY_FILE_NONE, error))
+	if (!g_key_file_load_from_data (kf, data, len, G_KEY_FILE_NONE, error))
 		return FALSE;
 	name = g_key_file_get_string (kf, "D-BUS Service", "Name", error);
 	if (name == NULL)
@@ -108,18 +113,20 @@ asb_plugin_process_app (AsbPlugin *plugin,
 			const gchar *tmpdir,
 			GError **error)
 {
+	AsbPackageTree *tree;
 	gchar **filelist;
 	guint i;
 
-	/* look for any GIR files */
+	/* look for any D-Bus service files */
+	tree = asb_package_get_tree (pkg);
 	filelist = asb_package_get_filelist (pkg);
 	for (i = 0; filelist[i] != NULL; i++) {
 		if (_asb_plugin_check_filename_system (filelist[i])) {
-			if (!asb_plugin_process_dbus (app, tmpdir, filelist[i],
+			if (!asb_plugin_process_dbus (app, tree, filelist[i],
 						      TRUE, error))
 				return FALSE;
 		} else if (_asb_plugin_check_filename_session (filelist[i])) {
-			if (!asb_plugin_process_dbus (app, tmpdir, filelist[i],
+			if (!asb_plugin_process_dbus (app, tree, filelist[i],
 						      FALSE, error))
 				return FALSE;
 		}
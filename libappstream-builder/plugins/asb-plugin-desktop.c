@@ -74,6 +74,26 @@ asb_plugin_check_filename (AsbPlugin *plugin, const gchar *filename)
 	return _asb_plugin_check_filename (filename);
 }
 
+/**
+ * asb_plugin_desktop_list_dir_cb:
+ */
+static GPtrArray *
+asb_plugin_desktop_list_dir_cb (const gchar *path, gpointer user_data)
+{
+	AsbPackageTree *tree = ASB_PACKAGE_TREE (user_data);
+	return asb_package_tree_list_dir (tree, path, NULL);
+}
+
+/**
+ * asb_plugin_desktop_exists_cb:
+ */
+static gboolean
+asb_plugin_desktop_exists_cb (const gchar *path, gpointer user_data)
+{
+	AsbPackageTree *tree = ASB_PACKAGE_TREE (user_data);
+	return asb_package_tree_exists (tree, path);
+}
+
 /**
  * asb_app_load_icon:
  */
@@ -85,22 +105,34 @@ asb_app_load_icon (AsbApp *app,
 		   guint min_icon_size,
 		   GError **error)
 {
+	AsbPackageTree *tree;
 	GdkPixbuf *pixbuf = NULL;
 	guint pixbuf_height;
 	guint pixbuf_width;
 	guint tmp_height;
 	guint tmp_width;
+	_cleanup_bytes_unref_ GBytes *bytes = NULL;
 	_cleanup_object_unref_ GdkPixbuf *pixbuf_src = NULL;
 	_cleanup_object_unref_ GdkPixbuf *pixbuf_tmp = NULL;
+	_cleanup_object_unref_ GInputStream *stream = NULL;
+
+	/* read the file from the package */
+	tree = asb_package_get_tree (asb_app_get_package (app));
+	bytes = asb_package_tree_get_bytes (tree, logfn, error);
+	if (bytes == NULL)
+		return NULL;
+	stream = g_memory_input_stream_new_from_bytes (bytes);
 
 	/* open file in native size */
 	if (g_str_has_suffix (filename, ".svg")) {
-		pixbuf_src = gdk_pixbuf_new_from_file_at_scale (filename,
-								icon_size,
-								icon_size,
-								TRUE, error);
+		pixbuf_src = gdk_pixbuf_new_from_stream_at_scale (stream,
+								  icon_size,
+								  icon_size,
+								  TRUE,
+								  NULL,
+								  error);
 	} else {
-		pixbuf_src = gdk_pixbuf_new_from_file (filename, error);
+		pixbuf_src = gdk_pixbuf_new_from_stream (stream, NULL, error);
 	}
 	if (pixbuf_src == NULL)
 		return NULL;
@@ -194,6 +226,7 @@ asb_app_load_icon (AsbApp *app,
 static gboolean
 asb_plugin_desktop_add_icons (AsbPlugin *plugin,
 			      AsbApp *app,
+			      AsUtilsIconIndex *idx,
 			      const gchar *tmpdir,
 			      const gchar *key,
 			      GError **error)
@@ -209,9 +242,9 @@ asb_plugin_desktop_add_icons (AsbPlugin *plugin,
 	_cleanup_object_unref_ GdkPixbuf *pixbuf = NULL;
 
 	/* find 64x64 icon */
-	fn = as_utils_find_icon_filename_full (tmpdir, key,
-					       AS_UTILS_FIND_ICON_NONE,
-					       error);
+	fn = as_utils_find_icon_filename_index (idx, key,
+						AS_UTILS_FIND_ICON_NONE,
+						error);
 	if (fn == NULL) {
 		g_prefix_error (error, "Failed to find icon: ");
 		return FALSE;
@@ -270,9 +303,9 @@ asb_plugin_desktop_add_icons (AsbPlugin *plugin,
 		return TRUE;
 
 	/* try to get a HiDPI icon */
-	fn_hidpi = as_utils_find_icon_filename_full (tmpdir, key,
-						     AS_UTILS_FIND_ICON_HI_DPI,
-						     NULL);
+	fn_hidpi = as_utils_find_icon_filename_index (idx, key,
+						      AS_UTILS_FIND_ICON_HI_DPI,
+						      NULL);
 	if (fn_hidpi == NULL)
 		return TRUE;
 
@@ -308,11 +341,13 @@ asb_plugin_process_filename (AsbPlugin *plugin,
 			     AsbPackage *pkg,
 			     const gchar *filename,
 			     GList **apps,
+			     AsUtilsIconIndex *idx,
 			     const gchar *tmpdir,
 			     GError **error)
 {
 	AsIcon *icon;
 	gboolean ret;
+	_cleanup_bytes_unref_ GBytes *bytes = NULL;
 	_cleanup_free_ gchar *app_id = NULL;
 	_cleanup_free_ gchar *full_filename = NULL;
 	_cleanup_object_unref_ AsbApp *app = NULL;
@@ -322,9 +357,14 @@ asb_plugin_process_filename (AsbPlugin *plugin,
 	app_id = g_path_get_basename (filename);
 	app = asb_app_new (pkg, app_id);
 	asb_app_set_hidpi_enabled (app, asb_context_get_hidpi_enabled (plugin->ctx));
+	bytes = asb_package_tree_get_bytes (asb_package_get_tree (pkg),
+					    filename, error);
+	if (bytes == NULL)
+		return FALSE;
 	full_filename = g_build_filename (tmpdir, filename, NULL);
-	ret = as_app_parse_file (AS_APP (app),
+	ret = as_app_parse_data (AS_APP (app),
 				 full_filename,
+				 bytes,
 				 AS_APP_PARSE_FLAG_USE_HEURISTICS,
 				 error);
 	if (!ret)
@@ -354,6 +394,7 @@ asb_plugin_process_filename (AsbPlugin *plugin,
 			g_ptr_array_set_size (as_app_get_icons (AS_APP (app)), 0);
 			ret = asb_plugin_desktop_add_icons (plugin,
 							    app,
+							    idx,
 							    tmpdir,
 							    key,
 							    &error_local);
@@ -378,12 +419,20 @@ asb_plugin_process (AsbPlugin *plugin,
 		    const gchar *tmpdir,
 		    GError **error)
 {
+	AsUtilsIconIndex *idx;
+	AsbPackageTree *tree;
 	gboolean ret;
 	GError *error_local = NULL;
 	GList *apps = NULL;
 	guint i;
 	gchar **filelist;
 
+	/* share the icon lookups between all the apps in the package */
+	tree = asb_package_get_tree (pkg);
+	idx = as_utils_icon_index_new_full (tmpdir,
+					    asb_plugin_desktop_list_dir_cb,
+					    asb_plugin_desktop_exists_cb,
+					    tree);
 	filelist = asb_package_get_filelist (pkg);
 	for (i = 0; filelist[i] != NULL; i++) {
 		if (!_asb_plugin_check_filename (filelist[i]))
@@ -392,6 +441,7 @@ asb_plugin_process (AsbPlugin *plugin,
 						   pkg,
 						   filelist[i],
 						   &apps,
+						   idx,
 						   tmpdir,
 						   &error_local);
 		if (!ret) {
@@ -403,6 +453,7 @@ asb_plugin_process (AsbPlugin *plugin,
 			g_clear_error (&error_local);
 		}
 	}
+	as_utils_icon_index_free (idx);
 
 	/* no desktop files we care about */
 	if (apps == NULL) {
@@ -676,9 +676,11 @@ asb_plugin_process_app (AsbPlugin *plugin,
 			const gchar *tmpdir,
 			GError **error)
 {
+	AsbPackageTree *tree;
 	gchar **filelist;
 	guint i;
 
+	tree = asb_package_get_tree (pkg);
 	filelist = asb_package_get_filelist (pkg);
 	for (i = 0; filelist[i] != NULL; i++) {
 		GError *error_local = NULL;
@@ -686,12 +688,16 @@ asb_plugin_process_app (AsbPlugin *plugin,
 
 		if (!_asb_plugin_check_filename (filelist[i]))
 			continue;
-		filename = g_build_filename (tmpdir, filelist[i], NULL);
-		if (!asb_plugin_font_app (plugin, app, filename, &error_local)) {
+
+		/* fontconfig needs a real file */
+		filename = asb_package_tree_get_filename (tree, filelist[i],
+							  &error_local);
+		if (filename == NULL ||
+		    !asb_plugin_font_app (plugin, app, filename, &error_local)) {
 			asb_package_log (pkg,
 					 ASB_PACKAGE_LOG_LEVEL_WARNING,
 					 "Failed to get font from %s: %s",
-					 filename,
+					 filelist[i],
 					 error_local->message);
 			g_clear_error (&error_local);
 		}
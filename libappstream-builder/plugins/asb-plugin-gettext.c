@@ -117,19 +117,28 @@ asb_gettext_ctx_free (AsbGettextContext *ctx)
  **/
 static gboolean
 asb_gettext_parse_file (AsbGettextContext *ctx,
+			AsbPackageTree *tree,
 			const gchar *locale,
 			const gchar *filename,
 			GError **error)
 {
 	AsbGettextEntry *entry;
 	AsbGettextHeader *h;
-	_cleanup_free_ gchar *data = NULL;
+	_cleanup_bytes_unref_ GBytes *bytes = NULL;
 
 	/* read data, although we only strictly need the header */
-	if (!g_file_get_contents (filename, &data, NULL, error))
+	bytes = asb_package_tree_get_bytes (tree, filename, error);
+	if (bytes == NULL)
 		return FALSE;
+	if (g_bytes_get_size (bytes) < G_STRUCT_OFFSET (AsbGettextHeader, orig_tab_offset)) {
+		g_set_error (error,
+			     ASB_PLUGIN_ERROR,
+			     ASB_PLUGIN_ERROR_FAILED,
+			     "%s is too small", filename);
+		return FALSE;
+	}
 
-	h = (AsbGettextHeader *) data;
+	h = (AsbGettextHeader *) g_bytes_get_data (bytes, NULL);
 	entry = asb_gettext_entry_new ();
 	entry->locale = g_strdup (locale);
 	entry->nstrings = h->nstrings;
@@ -144,28 +153,30 @@ asb_gettext_parse_file (AsbGettextContext *ctx,
  **/
 static gboolean
 asb_gettext_ctx_search_locale (AsbGettextContext *ctx,
+			       AsbPackageTree *tree,
 			       const gchar *locale,
 			       const gchar *messages_path,
 			       GError **error)
 {
 	const gchar *filename;
 	guint i;
-	_cleanup_dir_close_ GDir *dir = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *files = NULL;
 	_cleanup_ptrarray_unref_ GPtrArray *mo_paths = NULL;
 
-	dir = g_dir_open (messages_path, 0, error);
-	if (dir == NULL)
+	files = asb_package_tree_list_dir (tree, messages_path, error);
+	if (files == NULL)
 		return FALSE;
 
 	/* do a first pass at this, trying to find the prefered .mo */
 	mo_paths = g_ptr_array_new_with_free_func (g_free);
-	while ((filename = g_dir_read_name (dir)) != NULL) {
+	for (i = 0; i < files->len; i++) {
 		_cleanup_free_ gchar *path = NULL;
+		filename = g_ptr_array_index (files, i);
 		path = g_build_filename (messages_path, filename, NULL);
-		if (!g_file_test (path, G_FILE_TEST_EXISTS))
+		if (!asb_package_tree_exists (tree, path))
 			continue;
 		if (g_strcmp0 (filename, ctx->prefered_mo_filename) == 0) {
-			if (!asb_gettext_parse_file (ctx, locale, path, error))
+			if (!asb_gettext_parse_file (ctx, tree, locale, path, error))
 				return FALSE;
 			return TRUE;
 		}
@@ -176,7 +187,7 @@ asb_gettext_ctx_search_locale (AsbGettextContext *ctx,
 	 * language results than is actually true */
 	for (i = 0; i < mo_paths->len; i++) {
 		filename = g_ptr_array_index (mo_paths, i);
-		if (!asb_gettext_parse_file (ctx, locale, filename, error))
+		if (!asb_gettext_parse_file (ctx, tree, locale, filename, error))
 			return FALSE;
 	}
 
@@ -194,27 +205,29 @@ asb_gettext_entry_sort_cb (gconstpointer a, gconstpointer b)
  **/
 static gboolean
 asb_gettext_ctx_search_path (AsbGettextContext *ctx,
-			     const gchar *prefix,
+			     AsbPackageTree *tree,
 			     GError **error)
 {
 	const gchar *filename;
+	const gchar *root = "/usr/share/locale";
 	AsbGettextEntry *e;
 	GList *l;
-	_cleanup_dir_close_ GDir *dir = NULL;
-	_cleanup_free_ gchar *root = NULL;
+	guint i;
+	_cleanup_ptrarray_unref_ GPtrArray *locales = NULL;
 
-	/* search for .mo files in the prefix */
-	root = g_build_filename (prefix, "/usr/share/locale", NULL);
-	if (!g_file_test (root, G_FILE_TEST_EXISTS))
+	/* search for .mo files in the tree */
+	if (!asb_package_tree_exists (tree, root))
 		return TRUE;
-	dir = g_dir_open (root, 0, error);
-	if (dir == NULL)
+	locales = asb_package_tree_list_dir (tree, root, error);
+	if (locales == NULL)
 		return FALSE;
-	while ((filename = g_dir_read_name (dir)) != NULL) {
+	for (i = 0; i < locales->len; i++) {
 		_cleanup_free_ gchar *path = NULL;
+		filename = g_ptr_array_index (locales, i);
 		path = g_build_filename (root, filename, "LC_MESSAGES", NULL);
-		if (g_file_test (path, G_FILE_TEST_EXISTS)) {
-			if (!asb_gettext_ctx_search_locale (ctx, filename, path, error))
+		if (asb_package_tree_exists (tree, path)) {
+			if (!asb_gettext_ctx_search_locale (ctx, tree, filename,
+							    path, error))
 				return FALSE;
 		}
 	}
@@ -248,7 +261,7 @@ asb_plugin_process_app (AsbPlugin *plugin,
 	/* search */
 	ctx = asb_gettext_ctx_new ();
 	ctx->prefered_mo_filename = g_strdup_printf ("%s.mo", asb_package_get_name (pkg));
-	ret = asb_gettext_ctx_search_path (ctx, tmpdir, error);
+	ret = asb_gettext_ctx_search_path (ctx, asb_package_get_tree (pkg), error);
 	if (!ret)
 		goto out;
 
@@ -58,22 +58,25 @@ _asb_plugin_check_filename (const gchar *filename)
  */
 static gboolean
 asb_plugin_process_gir (AsbApp *app,
-			const gchar *tmpdir,
+			AsbPackageTree *tree,
 			const gchar *filename,
 			GError **error)
 {
 	GNode *l;
 	GNode *node = NULL;
+	const gchar *data;
 	const gchar *name;
 	const gchar *version;
 	gboolean ret = TRUE;
-	_cleanup_free_ gchar *filename_full = NULL;
-	_cleanup_object_unref_ GFile *file = NULL;
+	gsize len;
+	_cleanup_bytes_unref_ GBytes *bytes = NULL;
 
 	/* load file */
-	filename_full = g_build_filename (tmpdir, filename, NULL);
-	file = g_file_new_for_path (filename_full);
-	node = as_node_from_file (file, AS_NODE_FROM_XML_FLAG_NONE, NULL, error);
+	bytes = asb_package_tree_get_bytes (tree, filename, error);
+	if (bytes == NULL)
+		return FALSE;
+	data = g_bytes_get_data (bytes, &len);
+	node = as_node_from_xml (data, len, AS_NODE_FROM_XML_FLAG_ARENA, error);
 	if (node == NULL) {
 		ret = FALSE;
 		goto out;
@@ -110,15 +113,17 @@ asb_plugin_process_app (AsbPlugin *plugin,
 			const gchar *tmpdir,
 			GError **error)
 {
+	AsbPackageTree *tree;
 	gchar **filelist;
 	guint i;
 
 	/* look for any GIR files */
+	tree = asb_package_get_tree (pkg);
 	filelist = asb_package_get_filelist (pkg);
 	for (i = 0; filelist[i] != NULL; i++) {
 		if (!_asb_plugin_check_filename (filelist[i]))
 			continue;
-		if (!asb_plugin_process_gir (app, tmpdir, filelist[i], error))
+		if (!asb_plugin_process_gir (app, tree, filelist[i], error))
 			return FALSE;
 	}
 	return TRUE;
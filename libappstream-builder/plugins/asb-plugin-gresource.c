@@ -79,9 +79,11 @@ asb_plugin_process_app (AsbPlugin *plugin,
 			const gchar *tmpdir,
 			GError **error)
 {
+	AsbPackageTree *tree;
 	gchar **filelist;
 	guint i;
 
+	tree = asb_package_get_tree (pkg);
 	filelist = asb_package_get_filelist (pkg);
 	for (i = 0; filelist[i] != NULL; i++) {
 		GError *error_local = NULL;
@@ -91,12 +93,16 @@ asb_plugin_process_app (AsbPlugin *plugin,
 			continue;
 		if (as_app_has_kudo_kind (AS_APP (app), AS_KUDO_KIND_APP_MENU))
 			break;
-		filename = g_build_filename (tmpdir, filelist[i], NULL);
-		if (!asb_plugin_gresource_app (app, filename, &error_local)) {
+
+		/* the tool needs a real file */
+		filename = asb_package_tree_get_filename (tree, filelist[i],
+							  &error_local);
+		if (filename == NULL ||
+		    !asb_plugin_gresource_app (app, filename, &error_local)) {
 			asb_package_log (pkg,
 					 ASB_PACKAGE_LOG_LEVEL_WARNING,
 					 "Failed to get resources from %s: %s",
-					 filename,
+					 filelist[i],
 					 error_local->message);
 			g_clear_error (&error_local);
 		}
@@ -105,17 +105,6 @@ static const AsbGstreamerDescData data[] = {
 	{ NULL,		NULL }
 };
 
-/**
- * asb_utils_is_file_in_tmpdir:
- */
-static gboolean
-asb_utils_is_file_in_tmpdir (const gchar *tmpdir, const gchar *filename)
-{
-	_cleanup_free_ gchar *tmp = NULL;
-	tmp = g_build_filename (tmpdir, filename, NULL);
-	return g_file_test (tmp, G_FILE_TEST_EXISTS);
-}
-
 /**
  * asb_utils_string_sort_cb:
  */
@@ -171,7 +160,8 @@ asb_plugin_process (AsbPlugin *plugin,
 	as_app_add_icon (AS_APP (app), icon);
 
 	for (i = 0; data[i].path != NULL; i++) {
-		if (!asb_utils_is_file_in_tmpdir (tmpdir, data[i].path))
+		if (!asb_package_tree_exists (asb_package_get_tree (pkg),
+					      data[i].path))
 			continue;
 		split = g_strsplit (data[i].text, "|", -1);
 		for (j = 0; split[j] != NULL; j++)
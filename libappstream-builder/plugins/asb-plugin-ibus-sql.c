@@ -82,17 +82,17 @@ asb_plugin_process_filename (AsbPlugin *plugin,
 			     AsbPackage *pkg,
 			     const gchar *filename,
 			     GList **apps,
-			     const gchar *tmpdir,
+			     AsbPackageTree *tree,
 			     GError **error)
 {
 	gboolean ret = TRUE;
 	gchar *error_msg = 0;
-	gchar *filename_tmp;
 	gint rc;
 	guint i;
 	sqlite3 *db = NULL;
 	_cleanup_free_ gchar *basename = NULL;
 	_cleanup_free_ gchar *description = NULL;
+	_cleanup_free_ gchar *filename_tmp = NULL;
 	_cleanup_free_ gchar *language_string = NULL;
 	_cleanup_free_ gchar *name = NULL;
 	_cleanup_free_ gchar *symbol = NULL;
@@ -100,8 +100,12 @@ asb_plugin_process_filename (AsbPlugin *plugin,
 	_cleanup_object_unref_ AsIcon *icon = NULL;
 	_cleanup_strv_free_ gchar **languages = NULL;
 
-	/* open IME database */
-	filename_tmp = g_build_filename (tmpdir, filename, NULL);
+	/* open IME database, which has to be a real file */
+	filename_tmp = asb_package_tree_get_filename (tree, filename, error);
+	if (filename_tmp == NULL) {
+		ret = FALSE;
+		goto out;
+	}
 	rc = sqlite3_open (filename_tmp, &db);
 	if (rc) {
 		ret = FALSE;
@@ -241,7 +245,7 @@ asb_plugin_process (AsbPlugin *plugin,
 						   pkg,
 						   filelist[i],
 						   &apps,
-						   tmpdir,
+						   asb_package_get_tree (pkg),
 						   error);
 		if (!ret) {
 			g_list_free_full (apps, (GDestroyNotify) g_object_unref);
@@ -72,7 +72,7 @@ asb_plugin_process_filename (AsbPlugin *plugin,
 			     AsbPackage *pkg,
 			     const gchar *filename,
 			     GList **apps,
-			     const gchar *tmpdir,
+			     AsbPackageTree *tree,
 			     GError **error)
 {
 	GNode *root = NULL;
@@ -83,18 +83,21 @@ asb_plugin_process_filename (AsbPlugin *plugin,
 	gboolean ret;
 	guint i;
 	_cleanup_free_ gchar *basename = NULL;
+	_cleanup_bytes_unref_ GBytes *bytes = NULL;
 	_cleanup_free_ gchar *data = NULL;
-	_cleanup_free_ gchar *filename_tmp = NULL;
 	_cleanup_object_unref_ AsbApp *app = NULL;
 	_cleanup_object_unref_ AsIcon *icon = NULL;
 	_cleanup_strv_free_ gchar **languages = NULL;
 	_cleanup_strv_free_ gchar **lines = NULL;
 
 	/* open file */
-	filename_tmp = g_build_filename (tmpdir, filename, NULL);
-	ret = g_file_get_contents (filename_tmp, &data, NULL, error);
-	if (!ret)
+	bytes = asb_package_tree_get_bytes (tree, filename, error);
+	if (bytes == NULL) {
+		ret = FALSE;
 		goto out;
+	}
+	data = g_strndup (g_bytes_get_data (bytes, NULL),
+			  g_bytes_get_size (bytes));
 
 	/* some components start with a comment (invalid XML) and some
 	 * don't even have '<?xml' -- try to fix up best we can */
@@ -110,7 +113,7 @@ asb_plugin_process_filename (AsbPlugin *plugin,
 
 	/* parse contents */
 	root = as_node_from_xml (valid_xml->str, -1,
-				 AS_NODE_FROM_XML_FLAG_NONE,
+				 AS_NODE_FROM_XML_FLAG_ARENA,
 				 error);
 	if (!ret)
 		goto out;
@@ -203,7 +206,7 @@ asb_plugin_process (AsbPlugin *plugin,
 						   pkg,
 						   filelist[i],
 						   &apps,
-						   tmpdir,
+						   asb_package_get_tree (pkg),
 						   error);
 		if (!ret) {
 			g_list_free_full (apps, (GDestroyNotify) g_object_unref);
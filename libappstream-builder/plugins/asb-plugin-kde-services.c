@@ -48,13 +48,20 @@ asb_plugin_add_globs (AsbPlugin *plugin, GPtrArray *globs)
 static gboolean
 asb_plugin_process_filename (const gchar *filename,
 			     AsbApp *app,
-			     const gchar *tmpdir,
+			     AsbPackageTree *tree,
 			     GError **error)
 {
+	const gchar *data;
+	gsize len;
+	_cleanup_bytes_unref_ GBytes *bytes = NULL;
 	_cleanup_free_ gchar *types = NULL;
 	_cleanup_keyfile_unref_ GKeyFile *kf = NULL;
+	bytes = asb_package_tree_get_bytes (tree, filename, error);
+	if (bytes == NULL)
+		return FALSE;
+	data = g_bytes_get_data (bytes, &len);
 	kf = g_key_file_new ();
-	if (!g_key_file_load_from_file (kf, filename, G_KEY_FILE_NONE, error))
+	if (!g_key_file_load_from_data (kf, data, len, G_KEY_FILE_NONE, error))
 		return FALSE;
 	types = g_key_file_get_string (kf, G_KEY_FILE_DESKTOP_GROUP,
 				       "X-KDE-ServiceTypes", NULL);
@@ -76,20 +83,20 @@ asb_plugin_process_app (AsbPlugin *plugin,
 			const gchar *tmpdir,
 			GError **error)
 {
+	AsbPackageTree *tree;
 	gchar **filelist;
 	guint i;
 
 	/* look for a krunner provider */
+	tree = asb_package_get_tree (pkg);
 	filelist = asb_package_get_filelist (pkg);
 	for (i = 0; filelist[i] != NULL; i++) {
 		_cleanup_error_free_ GError *error_local = NULL;
-		_cleanup_free_ gchar *filename = NULL;
 		if (fnmatch ("/usr/share/kde4/services/*.desktop", filelist[i], 0) != 0)
 			continue;
-		filename = g_build_filename (tmpdir, filelist[i], NULL);
-		if (!asb_plugin_process_filename (filename,
+		if (!asb_plugin_process_filename (filelist[i],
 						  app,
-						  tmpdir,
+						  tree,
 						  &error_local)) {
 			asb_package_log (pkg,
 					 ASB_PACKAGE_LOG_LEVEL_INFO,
@@ -103,17 +103,24 @@ asb_plugin_process (AsbPlugin *plugin,
 		    const gchar *tmpdir,
 		    GError **error)
 {
+	AsbPackageTree *tree;
 	gboolean ret;
 	GList *apps = NULL;
 	guint i;
 	gchar **filelist;
 
+	tree = asb_package_get_tree (pkg);
 	filelist = asb_package_get_filelist (pkg);
 	for (i = 0; filelist[i] != NULL; i++) {
 		_cleanup_free_ gchar *filename_tmp = NULL;
 		if (!_asb_plugin_check_filename (filelist[i]))
 			continue;
-		filename_tmp = g_build_filename (tmpdir, filelist[i], NULL);
+		filename_tmp = asb_package_tree_get_filename (tree, filelist[i],
+							      error);
+		if (filename_tmp == NULL) {
+			g_list_free_full (apps, (GDestroyNotify) g_object_unref);
+			return NULL;
+		}
 		ret = asb_plugin_process_filename (plugin,
 						   pkg,
 						   filename_tmp,
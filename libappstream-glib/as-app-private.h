@@ -29,6 +29,10 @@
 #include <glib-object.h>
 
 #include "as-app.h"
+#include "as-icon-private.h"
+#include "as-provide-private.h"
+#include "as-release-private.h"
+#include "as-screenshot-private.h"
 
 G_BEGIN_DECLS
 
@@ -68,6 +72,18 @@ typedef enum {
 	AS_APP_PROBLEM_LAST
 } AsAppProblems;
 
+typedef struct {
+	gchar		**values_ascii;
+	gchar		**values_utf8;
+	guint		  score;
+} AsAppTokenItem;
+
+typedef void (*AsAppMetadataChangedFunc)	(AsApp		*app,
+						 const gchar	*key,
+						 const gchar	*old_value,
+						 const gchar	*new_value,
+						 gpointer	 user_data);
+
 /* some useful constants */
 #define AS_APP_ICON_MIN_HEIGHT			32
 #define AS_APP_ICON_MIN_WIDTH			32
@@ -76,6 +92,15 @@ AsAppProblems	 as_app_get_problems		(AsApp		*app);
 guint		 as_app_get_name_size		(AsApp		*app);
 guint		 as_app_get_comment_size	(AsApp		*app);
 guint		 as_app_get_description_size	(AsApp		*app);
+GPtrArray	*as_app_get_search_tokens	(AsApp		*app);
+void		 as_app_add_metadata_watch	(AsApp		*app,
+						 AsAppMetadataChangedFunc func,
+						 gpointer	 user_data);
+void		 as_app_remove_metadata_watch	(AsApp		*app,
+						 AsAppMetadataChangedFunc func,
+						 gpointer	 user_data);
+void		 as_app_set_locale_filter	(AsApp		*app,
+						 GHashTable	*locale_filter);
 
 GNode		*as_app_node_insert		(AsApp		*app,
 						 GNode		*parent,
@@ -87,6 +112,21 @@ gboolean	 as_app_node_parse_dep11	(AsApp		*app,
 						 GNode		*node,
 						 GError		**error);
 
+#define AS_APP_VARIANT_TYPE	"(uuiuusssssssss"			\
+				"a{ss}a{ss}a{ss}a{ss}a{sas}a{si}a{ss}a{ss}" \
+				"asasasasasasasas"			\
+				"a" AS_ICON_VARIANT_TYPE			\
+				"a" AS_PROVIDE_VARIANT_TYPE		\
+				"a" AS_RELEASE_VARIANT_TYPE		\
+				"a" AS_SCREENSHOT_VARIANT_TYPE ")"
+
+GVariant	*as_app_to_variant		(AsApp		*app);
+gboolean	 as_app_variant_parse		(AsApp		*app,
+						 GVariant	*value,
+						 GError		**error);
+void		 as_app_intern_get_stats	(guint		*strings,
+						 guint		*refs);
+
 G_END_DECLS
 
 #endif /* __AS_APP_PRIVATE_H */
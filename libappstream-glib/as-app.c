@@ -92,17 +92,19 @@ struct _AsAppPrivate
 	gint		 priority;
 	gsize		 token_cache_valid;
 	GPtrArray	*token_cache;			/* of AsAppTokenItem */
+	GArray		*metadata_watches;		/* of AsAppMetadataWatch */
+	GHashTable	*locale_filter;			/* of locale */
 };
 
+typedef struct {
+	AsAppMetadataChangedFunc	 func;
+	gpointer			 user_data;
+} AsAppMetadataWatch;
+
 G_DEFINE_TYPE_WITH_PRIVATE (AsApp, as_app, G_TYPE_OBJECT)
 
 #define GET_PRIVATE(o) (as_app_get_instance_private (o))
 
-typedef struct {
-	gchar		**values_ascii;
-	gchar		**values_utf8;
-	guint		  score;
-} AsAppTokenItem;
 
 /**
  * as_app_error_quark:
@@ -238,6 +240,139 @@ as_app_guess_source_kind (const gchar *filename)
 	return AS_APP_SOURCE_KIND_UNKNOWN;
 }
 
+typedef struct {
+	gchar		*str;
+	guint		 refcount;
+} AsAppInternItem;
+
+/* the pool is split by hash so that parsing threads rarely wait for
+ * each other, as every string that is added or freed needs a lock */
+#define AS_APP_INTERN_SHARDS	16
+
+typedef struct {
+	GMutex		 mutex;
+	GHashTable	*hash;		/* of AsAppInternItem{str} */
+} AsAppInternShard;
+
+static AsAppInternShard as_app_intern_shards[AS_APP_INTERN_SHARDS];
+
+/**
+ * as_app_intern_get_shard:
+ **/
+static AsAppInternShard *
+as_app_intern_get_shard (const gchar *text)
+{
+	return &as_app_intern_shards[g_str_hash (text) % AS_APP_INTERN_SHARDS];
+}
+
+/**
+ * as_app_intern:
+ *
+ * Returns a reference to a canonical copy of @text that is shared by all
+ * applications, as the same few hundred strings are used for locales,
+ * categories, mimetypes and metadata keys by thousands of applications.
+ *
+ * The string is freed when the last reference is dropped using
+ * as_app_intern_release(), so the pool only holds strings still in use.
+ **/
+static const gchar *
+as_app_intern (const gchar *text, gssize text_len)
+{
+	AsAppInternItem *item;
+	AsAppInternShard *shard;
+	gchar *tmp = NULL;
+
+	if (text_len >= 0) {
+		tmp = g_strndup (text, text_len);
+		text = tmp;
+	}
+	shard = as_app_intern_get_shard (text);
+	g_mutex_lock (&shard->mutex);
+	if (shard->hash == NULL)
+		shard->hash = g_hash_table_new (g_str_hash, g_str_equal);
+	item = g_hash_table_lookup (shard->hash, text);
+	if (item == NULL) {
+		item = g_slice_new (AsAppInternItem);
+		item->str = tmp != NULL ? tmp : g_strdup (text);
+		item->refcount = 0;
+		tmp = NULL;
+		g_hash_table_insert (shard->hash, item->str, item);
+	}
+	item->refcount++;
+	g_mutex_unlock (&shard->mutex);
+	g_free (tmp);
+	return item->str;
+}
+
+/**
+ * as_app_intern_release:
+ *
+ * Drops a reference to a string returned by as_app_intern(). Any string
+ * that did not come from the pool is freed with g_free(), so callers can
+ * still add their own allocated strings to the public arrays.
+ **/
+static void
+as_app_intern_release (gpointer data)
+{
+	AsAppInternItem *item = NULL;
+	AsAppInternShard *shard;
+
+	if (data == NULL)
+		return;
+	shard = as_app_intern_get_shard (data);
+	g_mutex_lock (&shard->mutex);
+	if (shard->hash != NULL)
+		item = g_hash_table_lookup (shard->hash, data);
+	if (item == NULL || item->str != data) {
+		g_mutex_unlock (&shard->mutex);
+		g_free (data);
+		return;
+	}
+	if (--item->refcount == 0) {
+		g_hash_table_remove (shard->hash, item->str);
+		g_free (item->str);
+		g_slice_free (AsAppInternItem, item);
+	}
+	g_mutex_unlock (&shard->mutex);
+}
+
+/**
+ * as_app_intern_get_stats:
+ * @strings: (out): number of strings in the pool, or %NULL
+ * @refs: (out): number of references to them, or %NULL
+ *
+ * Gets how much the shared strings are being used, which is only
+ * useful for testing.
+ *
+ * Since: 0.3.3
+ **/
+void
+as_app_intern_get_stats (guint *strings, guint *refs)
+{
+	AsAppInternItem *item;
+	AsAppInternShard *shard;
+	GHashTableIter iter;
+	guint i;
+	guint n_strings = 0;
+	guint n_refs = 0;
+
+	for (i = 0; i < AS_APP_INTERN_SHARDS; i++) {
+		shard = &as_app_intern_shards[i];
+		g_mutex_lock (&shard->mutex);
+		if (shard->hash != NULL) {
+			n_strings += g_hash_table_size (shard->hash);
+			g_hash_table_iter_init (&iter, shard->hash);
+			while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &item))
+				n_refs += item->refcount;
+		}
+		g_mutex_unlock (&shard->mutex);
+	}
+	if (strings != NULL)
+		*strings = n_strings;
+	if (refs != NULL)
+		*refs = n_refs;
+}
+
 /**
  * as_app_finalize:
  **/
@@ -279,6 +414,10 @@ as_app_finalize (GObject *object)
 	g_ptr_array_unref (priv->icons);
 	g_ptr_array_unref (priv->token_cache);
 	g_ptr_array_unref (priv->vetos);
+	if (priv->metadata_watches != NULL)
+		g_array_unref (priv->metadata_watches);
+	if (priv->locale_filter != NULL)
+		g_hash_table_unref (priv->locale_filter);
 
 	G_OBJECT_CLASS (as_app_parent_class)->finalize (object);
 }
@@ -301,15 +440,16 @@ static void
 as_app_init (AsApp *app)
 {
 	AsAppPrivate *priv = GET_PRIVATE (app);
-	priv->categories = g_ptr_array_new_with_free_func (g_free);
-	priv->compulsory_for_desktops = g_ptr_array_new_with_free_func (g_free);
+	priv->categories = g_ptr_array_new_with_free_func (as_app_intern_release);
+	priv->compulsory_for_desktops = g_ptr_array_new_with_free_func (as_app_intern_release);
 	priv->extends = g_ptr_array_new_with_free_func (g_free);
 	priv->keywords = g_hash_table_new_full (g_str_hash, g_str_equal,
-						g_free, (GDestroyNotify) g_ptr_array_unref);
-	priv->kudos = g_ptr_array_new_with_free_func (g_free);
-	priv->mimetypes = g_ptr_array_new_with_free_func (g_free);
+						as_app_intern_release,
+						(GDestroyNotify) g_ptr_array_unref);
+	priv->kudos = g_ptr_array_new_with_free_func (as_app_intern_release);
+	priv->mimetypes = g_ptr_array_new_with_free_func (as_app_intern_release);
 	priv->pkgnames = g_ptr_array_new_with_free_func (g_free);
-	priv->architectures = g_ptr_array_new_with_free_func (g_free);
+	priv->architectures = g_ptr_array_new_with_free_func (as_app_intern_release);
 	priv->addons = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
 	priv->releases = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
 	priv->provides = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
@@ -318,13 +458,14 @@ as_app_init (AsApp *app)
 	priv->token_cache = g_ptr_array_new_with_free_func ((GDestroyNotify) as_app_token_item_free);
 	priv->vetos = g_ptr_array_new_with_free_func (g_free);
 
-	priv->comments = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
-	priv->developer_names = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
-	priv->descriptions = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
-	priv->languages = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
-	priv->metadata = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
-	priv->names = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
-	priv->urls = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+	/* the keys are all interned as they are shared between applications */
+	priv->comments = g_hash_table_new_full (g_str_hash, g_str_equal, as_app_intern_release, g_free);
+	priv->developer_names = g_hash_table_new_full (g_str_hash, g_str_equal, as_app_intern_release, g_free);
+	priv->descriptions = g_hash_table_new_full (g_str_hash, g_str_equal, as_app_intern_release, g_free);
+	priv->languages = g_hash_table_new_full (g_str_hash, g_str_equal, as_app_intern_release, NULL);
+	priv->metadata = g_hash_table_new_full (g_str_hash, g_str_equal, as_app_intern_release, g_free);
+	priv->names = g_hash_table_new_full (g_str_hash, g_str_equal, as_app_intern_release, g_free);
+	priv->urls = g_hash_table_new_full (g_str_hash, g_str_equal, as_app_intern_release, g_free);
 }
 
 /**
@@ -1618,21 +1759,81 @@ as_app_set_icon_path (AsApp *app, const gchar *icon_path, gssize icon_path_len)
 
 /**
  * as_app_parse_locale:
+ *
+ * Returns a reference to the interned locale to store a translation under,
+ * or %NULL if the translation should be ignored. The reference has to be
+ * transferred to a hash table or dropped using as_app_intern_release().
  **/
-static gchar *
-as_app_parse_locale (const gchar *locale)
+static const gchar *
+as_app_parse_locale (AsApp *app, const gchar *locale)
 {
-	gchar *tmp;
+	AsAppPrivate *priv = GET_PRIVATE (app);
+	_cleanup_free_ gchar *tmp = NULL;
 
 	if (locale == NULL)
-		return g_strdup ("C");
+		return as_app_intern ("C", -1);
 	if (g_strcmp0 (locale, "xx") == 0)
 		return NULL;
 	if (g_strcmp0 (locale, "x-test") == 0)
 		return NULL;
-	tmp = g_strdup (locale);
-	g_strdelimit (tmp, "-", '_');
-	return tmp;
+	if (strchr (locale, '-') != NULL) {
+		tmp = g_strdup (locale);
+		g_strdelimit (tmp, "-", '_');
+		locale = tmp;
+	}
+
+	/* only keep the locales the caller is interested in */
+	if (priv->locale_filter != NULL &&
+	    !g_hash_table_contains (priv->locale_filter, locale))
+		return NULL;
+	return as_app_intern (locale, -1);
+}
+
+/**
+ * as_app_locale_is_wanted:
+ **/
+static gboolean
+as_app_locale_is_wanted (AsApp *app, const gchar *locale)
+{
+	const gchar *tmp;
+
+	tmp = as_app_parse_locale (app, locale);
+	if (tmp == NULL)
+		return FALSE;
+	as_app_intern_release ((gpointer) tmp);
+	return TRUE;
+}
+
+/**
+ * as_app_locale_filter_cb:
+ **/
+static gboolean
+as_app_locale_filter_cb (gpointer key, gpointer value, gpointer user_data)
+{
+	AsApp *app = AS_APP (user_data);
+	return !as_app_locale_is_wanted (app, key);
+}
+
+/**
+ * as_app_set_locale_filter: (skip)
+ * @app: a #AsApp instance.
+ * @locale_filter: (allow-none): a set of locale strings, or %NULL
+ *
+ * Sets the locales to keep when translations are added. Any translation
+ * for a locale not in @locale_filter is silently dropped. This is designed
+ * to be set only while the application is being parsed.
+ *
+ * Since: 0.3.3
+ **/
+void
+as_app_set_locale_filter (AsApp *app, GHashTable *locale_filter)
+{
+	AsAppPrivate *priv = GET_PRIVATE (app);
+	if (priv->locale_filter != NULL)
+		g_hash_table_unref (priv->locale_filter);
+	priv->locale_filter = NULL;
+	if (locale_filter != NULL)
+		priv->locale_filter = g_hash_table_ref (locale_filter);
 }
 
 /**
@@ -1653,7 +1854,7 @@ as_app_set_name (AsApp *app,
 		 gssize name_len)
 {
 	AsAppPrivate *priv = GET_PRIVATE (app);
-	gchar *tmp_locale;
+	const gchar *tmp_locale;
 
 	/* handle untrusted */
 	if ((priv->trust_flags & AS_APP_TRUST_FLAG_CHECK_VALID_UTF8) > 0 &&
@@ -1663,11 +1864,11 @@ as_app_set_name (AsApp *app,
 	}
 
 	/* get fixed locale */
-	tmp_locale = as_app_parse_locale (locale);
+	tmp_locale = as_app_parse_locale (app, locale);
 	if (tmp_locale == NULL)
 		return;
 	g_hash_table_insert (priv->names,
-			     tmp_locale,
+			     (gpointer) tmp_locale,
 			     as_strndup (name, name_len));
 }
 
@@ -1689,7 +1890,7 @@ as_app_set_comment (AsApp *app,
 		    gssize comment_len)
 {
 	AsAppPrivate *priv = GET_PRIVATE (app);
-	gchar *tmp_locale;
+	const gchar *tmp_locale;
 
 	g_return_if_fail (comment != NULL);
 
@@ -1701,11 +1902,11 @@ as_app_set_comment (AsApp *app,
 	}
 
 	/* get fixed locale */
-	tmp_locale = as_app_parse_locale (locale);
+	tmp_locale = as_app_parse_locale (app, locale);
 	if (tmp_locale == NULL)
 		return;
 	g_hash_table_insert (priv->comments,
-			     tmp_locale,
+			     (gpointer) tmp_locale,
 			     as_strndup (comment, comment_len));
 }
 
@@ -1727,7 +1928,7 @@ as_app_set_developer_name (AsApp *app,
 			   gssize developer_name_len)
 {
 	AsAppPrivate *priv = GET_PRIVATE (app);
-	gchar *tmp_locale;
+	const gchar *tmp_locale;
 
 	g_return_if_fail (developer_name != NULL);
 
@@ -1739,11 +1940,11 @@ as_app_set_developer_name (AsApp *app,
 	}
 
 	/* get fixed locale */
-	tmp_locale = as_app_parse_locale (locale);
+	tmp_locale = as_app_parse_locale (app, locale);
 	if (tmp_locale == NULL)
 		return;
 	g_hash_table_insert (priv->developer_names,
-			     tmp_locale,
+			     (gpointer) tmp_locale,
 			     as_strndup (developer_name, developer_name_len));
 }
 
@@ -1765,7 +1966,7 @@ as_app_set_description (AsApp *app,
 			gssize description_len)
 {
 	AsAppPrivate *priv = GET_PRIVATE (app);
-	gchar *tmp_locale;
+	const gchar *tmp_locale;
 
 	g_return_if_fail (description != NULL);
 
@@ -1777,11 +1978,11 @@ as_app_set_description (AsApp *app,
 	}
 
 	/* get fixed locale */
-	tmp_locale = as_app_parse_locale (locale);
+	tmp_locale = as_app_parse_locale (app, locale);
 	if (tmp_locale == NULL)
 		return;
 	g_hash_table_insert (priv->descriptions,
-			     tmp_locale,
+			     (gpointer) tmp_locale,
 			     as_strndup (description, description_len));
 }
 
@@ -1849,7 +2050,8 @@ as_app_add_category (AsApp *app, const gchar *category, gssize category_len)
 	if (g_strcmp0 (category, "Feed") == 0)
 		category = "News";
 
-	g_ptr_array_add (priv->categories, as_strndup (category, category_len));
+	g_ptr_array_add (priv->categories,
+			 (gpointer) as_app_intern (category, category_len));
 }
 
 
@@ -1884,8 +2086,8 @@ as_app_add_compulsory_for_desktop (AsApp *app,
 	}
 
 	g_ptr_array_add (priv->compulsory_for_desktops,
-			 as_strndup (compulsory_for_desktop,
-				     compulsory_for_desktop_len));
+			 (gpointer) as_app_intern (compulsory_for_desktop,
+						   compulsory_for_desktop_len));
 }
 
 /**
@@ -1907,7 +2109,7 @@ as_app_add_keyword (AsApp *app,
 {
 	AsAppPrivate *priv = GET_PRIVATE (app);
 	GPtrArray *tmp;
-	_cleanup_free_ gchar *tmp_locale = NULL;
+	const gchar *tmp_locale;
 
 	/* handle untrusted */
 	if ((priv->trust_flags & AS_APP_TRUST_FLAG_CHECK_VALID_UTF8) > 0 &&
@@ -1916,7 +2118,7 @@ as_app_add_keyword (AsApp *app,
 	}
 
 	/* get fixed locale */
-	tmp_locale = as_app_parse_locale (locale);
+	tmp_locale = as_app_parse_locale (app, locale);
 	if (tmp_locale == NULL)
 		return;
 
@@ -1924,9 +2126,11 @@ as_app_add_keyword (AsApp *app,
 	tmp = g_hash_table_lookup (priv->keywords, tmp_locale);
 	if (tmp == NULL) {
 		tmp = g_ptr_array_new_with_free_func (g_free);
-		g_hash_table_insert (priv->keywords, g_strdup (tmp_locale), tmp);
-	} else if ((priv->trust_flags & AS_APP_TRUST_FLAG_CHECK_DUPLICATES) > 0) {
-		if (as_app_array_find_string (tmp, keyword, keyword_len))
+		g_hash_table_insert (priv->keywords, (gpointer) tmp_locale, tmp);
+	} else {
+		as_app_intern_release ((gpointer) tmp_locale);
+		if ((priv->trust_flags & AS_APP_TRUST_FLAG_CHECK_DUPLICATES) > 0 &&
+		    as_app_array_find_string (tmp, keyword, keyword_len))
 			return;
 	}
 	g_ptr_array_add (tmp, as_strndup (keyword, keyword_len));
@@ -1956,7 +2160,7 @@ as_app_add_kudo (AsApp *app, const gchar *kudo, gssize kudo_len)
 	    as_app_array_find_string (priv->kudos, kudo, kudo_len)) {
 		return;
 	}
-	g_ptr_array_add (priv->kudos, as_strndup (kudo, kudo_len));
+	g_ptr_array_add (priv->kudos, (gpointer) as_app_intern (kudo, kudo_len));
 }
 
 /**
@@ -2000,7 +2204,8 @@ as_app_add_mimetype (AsApp *app, const gchar *mimetype, gssize mimetype_len)
 		return;
 	}
 
-	g_ptr_array_add (priv->mimetypes, as_strndup (mimetype, mimetype_len));
+	g_ptr_array_add (priv->mimetypes,
+			 (gpointer) as_app_intern (mimetype, mimetype_len));
 }
 
 /**
@@ -2186,7 +2391,8 @@ as_app_add_arch (AsApp *app, const gchar *arch, gssize arch_len)
 		return;
 	}
 
-	g_ptr_array_add (priv->architectures, as_strndup (arch, arch_len));
+	g_ptr_array_add (priv->architectures,
+			 (gpointer) as_app_intern (arch, arch_len));
 }
 
 /**
@@ -2218,7 +2424,7 @@ as_app_add_language (AsApp *app,
 	if (locale == NULL)
 		locale = "C";
 	g_hash_table_insert (priv->languages,
-			     as_strndup (locale, locale_len),
+			     (gpointer) as_app_intern (locale, locale_len),
 			     GINT_TO_POINTER (percentage));
 }
 
@@ -2249,10 +2455,30 @@ as_app_add_url (AsApp *app,
 	}
 
 	g_hash_table_insert (priv->urls,
-			     g_strdup (as_url_kind_to_string (url_kind)),
+			     (gpointer) as_app_intern (as_url_kind_to_string (url_kind), -1),
 			     as_strndup (url, url_len));
 }
 
+/**
+ * as_app_metadata_changed:
+ **/
+static void
+as_app_metadata_changed (AsApp *app, const gchar *key, const gchar *old_value)
+{
+	AsAppMetadataWatch *watch;
+	AsAppPrivate *priv = GET_PRIVATE (app);
+	const gchar *new_value;
+	guint i;
+
+	new_value = g_hash_table_lookup (priv->metadata, key);
+	if (g_strcmp0 (old_value, new_value) == 0)
+		return;
+	for (i = 0; i < priv->metadata_watches->len; i++) {
+		watch = &g_array_index (priv->metadata_watches, AsAppMetadataWatch, i);
+		watch->func (app, key, old_value, new_value, watch->user_data);
+	}
+}
+
 /**
  * as_app_add_metadata:
  * @app: a #AsApp instance.
@@ -2281,8 +2507,20 @@ as_app_add_metadata (AsApp *app,
 
 	if (value == NULL)
 		value = "";
+	key = as_app_intern (key, -1);
+
+	/* only copy the old value if something is watching */
+	if (priv->metadata_watches != NULL) {
+		_cleanup_free_ gchar *old_value = NULL;
+		old_value = g_strdup (g_hash_table_lookup (priv->metadata, key));
+		g_hash_table_insert (priv->metadata,
+				     (gpointer) key,
+				     as_strndup (value, value_len));
+		as_app_metadata_changed (app, key, old_value);
+		return;
+	}
 	g_hash_table_insert (priv->metadata,
-			     g_strdup (key),
+			     (gpointer) key,
 			     as_strndup (value, value_len));
 }
 
@@ -2299,7 +2537,82 @@ void
 as_app_remove_metadata (AsApp *app, const gchar *key)
 {
 	AsAppPrivate *priv = GET_PRIVATE (app);
+	_cleanup_free_ gchar *old_value = NULL;
+
+	if (priv->metadata_watches == NULL) {
+		g_hash_table_remove (priv->metadata, key);
+		return;
+	}
+	old_value = g_strdup (g_hash_table_lookup (priv->metadata, key));
 	g_hash_table_remove (priv->metadata, key);
+	as_app_metadata_changed (app, key, old_value);
+}
+
+/**
+ * as_app_add_metadata_watch: (skip)
+ * @app: a #AsApp instance.
+ * @func: the function to call when the metadata changes.
+ * @user_data: user data for @func.
+ *
+ * Calls @func each time a metadata item is added, changed or removed.
+ * Adding the same @func and @user_data twice has no effect.
+ *
+ * Since: 0.3.3
+ **/
+void
+as_app_add_metadata_watch (AsApp *app,
+			   AsAppMetadataChangedFunc func,
+			   gpointer user_data)
+{
+	AsAppMetadataWatch *watch;
+	AsAppMetadataWatch watch_new;
+	AsAppPrivate *priv = GET_PRIVATE (app);
+	guint i;
+
+	if (priv->metadata_watches == NULL)
+		priv->metadata_watches = g_array_new (FALSE, FALSE, sizeof (AsAppMetadataWatch));
+	for (i = 0; i < priv->metadata_watches->len; i++) {
+		watch = &g_array_index (priv->metadata_watches, AsAppMetadataWatch, i);
+		if (watch->func == func && watch->user_data == user_data)
+			return;
+	}
+	watch_new.func = func;
+	watch_new.user_data = user_data;
+	g_array_append_val (priv->metadata_watches, watch_new);
+}
+
+/**
+ * as_app_remove_metadata_watch: (skip)
+ * @app: a #AsApp instance.
+ * @func: the function passed to as_app_add_metadata_watch().
+ * @user_data: user data for @func.
+ *
+ * Stops calling @func when the metadata changes.
+ *
+ * Since: 0.3.3
+ **/
+void
+as_app_remove_metadata_watch (AsApp *app,
+			      AsAppMetadataChangedFunc func,
+			      gpointer user_data)
+{
+	AsAppMetadataWatch *watch;
+	AsAppPrivate *priv = GET_PRIVATE (app);
+	guint i;
+
+	if (priv->metadata_watches == NULL)
+		return;
+	for (i = 0; i < priv->metadata_watches->len; i++) {
+		watch = &g_array_index (priv->metadata_watches, AsAppMetadataWatch, i);
+		if (watch->func != func || watch->user_data != user_data)
+			continue;
+		g_array_remove_index (priv->metadata_watches, i);
+		break;
+	}
+	if (priv->metadata_watches->len == 0) {
+		g_array_unref (priv->metadata_watches);
+		priv->metadata_watches = NULL;
+	}
 }
 
 /**
@@ -2375,7 +2688,9 @@ as_app_subsume_dict (GHashTable *dest, GHashTable *src, gboolean overwrite)
 				continue;
 		}
 		value = g_hash_table_lookup (src, key);
-		g_hash_table_insert (dest, g_strdup (key), g_strdup (value));
+		g_hash_table_insert (dest,
+				     (gpointer) as_app_intern (key, -1),
+				     g_strdup (value));
 	}
 }
 
@@ -3051,6 +3366,7 @@ as_app_node_parse_child (AsApp *app, GNode *n, AsAppParseFlags flags, GError **e
 	AsAppPrivate *priv = GET_PRIVATE (app);
 	GNode *c;
 	const gchar *tmp;
+	const gchar *tmp_locale;
 	gchar *taken;
 
 	switch (as_node_get_tag (n)) {
@@ -3080,31 +3396,31 @@ as_app_node_parse_child (AsApp *app, GNode *n, AsAppParseFlags flags, GError **e
 
 	/* <name> */
 	case AS_TAG_NAME:
-		taken = as_app_parse_locale (as_node_get_attribute (n, "xml:lang"));
-		if (taken == NULL)
+		tmp_locale = as_app_parse_locale (app, as_node_get_attribute (n, "xml:lang"));
+		if (tmp_locale == NULL)
 			break;
 		g_hash_table_insert (priv->names,
-				     taken,
+				     (gpointer) tmp_locale,
 				     as_node_take_data (n));
 		break;
 
 	/* <summary> */
 	case AS_TAG_SUMMARY:
-		taken = as_app_parse_locale (as_node_get_attribute (n, "xml:lang"));
-		if (taken == NULL)
+		tmp_locale = as_app_parse_locale (app, as_node_get_attribute (n, "xml:lang"));
+		if (tmp_locale == NULL)
 			break;
 		g_hash_table_insert (priv->comments,
-				     taken,
+				     (gpointer) tmp_locale,
 				     as_node_take_data (n));
 		break;
 
 	/* <developer_name> */
 	case AS_TAG_DEVELOPER_NAME:
-		taken = as_app_parse_locale (as_node_get_attribute (n, "xml:lang"));
-		if (taken == NULL)
+		tmp_locale = as_app_parse_locale (app, as_node_get_attribute (n, "xml:lang"));
+		if (tmp_locale == NULL)
 			break;
 		g_hash_table_insert (priv->developer_names,
-				     taken,
+				     (gpointer) tmp_locale,
 				     as_node_take_data (n));
 		break;
 
@@ -3132,10 +3448,18 @@ as_app_node_parse_child (AsApp *app, GNode *n, AsAppParseFlags flags, GError **e
 				g_propagate_error (error, error_local);
 				return FALSE;
 			}
+			if (priv->locale_filter != NULL) {
+				g_hash_table_foreach_remove (unwrapped,
+							     as_app_locale_filter_cb,
+							     app);
+			}
 			as_app_subsume_dict (priv->descriptions, unwrapped, FALSE);
 			break;
 		}
 
+		/* avoid converting the markup for ignored locales */
+		if (!as_app_locale_is_wanted (app, as_node_get_attribute (n, "xml:lang")))
+			break;
 		if (n->children == NULL) {
 			/* pre-formatted */
 			priv->problems |= AS_APP_PROBLEM_PREFORMATTED_DESCRIPTION;
@@ -3172,10 +3496,10 @@ as_app_node_parse_child (AsApp *app, GNode *n, AsAppParseFlags flags, GError **e
 		for (c = n->children; c != NULL; c = c->next) {
 			if (as_node_get_tag (c) != AS_TAG_CATEGORY)
 				continue;
-			taken = as_node_take_data (c);
-			if (taken == NULL)
+			tmp = as_node_get_data (c);
+			if (tmp == NULL)
 				continue;
-			g_ptr_array_add (priv->categories, taken);
+			g_ptr_array_add (priv->categories, (gpointer) as_app_intern (tmp, -1));
 		}
 		break;
 
@@ -3186,10 +3510,10 @@ as_app_node_parse_child (AsApp *app, GNode *n, AsAppParseFlags flags, GError **e
 		for (c = n->children; c != NULL; c = c->next) {
 			if (as_node_get_tag (c) != AS_TAG_ARCH)
 				continue;
-			taken = as_node_take_data (c);
-			if (taken == NULL)
+			tmp = as_node_get_data (c);
+			if (tmp == NULL)
 				continue;
-			g_ptr_array_add (priv->architectures, taken);
+			g_ptr_array_add (priv->architectures, (gpointer) as_app_intern (tmp, -1));
 		}
 		break;
 
@@ -3203,11 +3527,9 @@ as_app_node_parse_child (AsApp *app, GNode *n, AsAppParseFlags flags, GError **e
 			tmp = as_node_get_data (c);
 			if (tmp == NULL)
 				continue;
-			taken = as_app_parse_locale (as_node_get_attribute (c, "xml:lang"));
-			if (taken == NULL)
-				continue;
-			as_app_add_keyword (app, taken, tmp, -1);
-			g_free (taken);
+			as_app_add_keyword (app,
+					    as_node_get_attribute (c, "xml:lang"),
+					    tmp, -1);
 		}
 		break;
 
@@ -3218,10 +3540,10 @@ as_app_node_parse_child (AsApp *app, GNode *n, AsAppParseFlags flags, GError **e
 		for (c = n->children; c != NULL; c = c->next) {
 			if (as_node_get_tag (c) != AS_TAG_KUDO)
 				continue;
-			taken = as_node_take_data (c);
-			if (taken == NULL)
+			tmp = as_node_get_data (c);
+			if (tmp == NULL)
 				continue;
-			g_ptr_array_add (priv->kudos, taken);
+			g_ptr_array_add (priv->kudos, (gpointer) as_app_intern (tmp, -1));
 		}
 		break;
 
@@ -3246,10 +3568,10 @@ as_app_node_parse_child (AsApp *app, GNode *n, AsAppParseFlags flags, GError **e
 		for (c = n->children; c != NULL; c = c->next) {
 			if (as_node_get_tag (c) != AS_TAG_MIMETYPE)
 				continue;
-			taken = as_node_take_data (c);
-			if (taken == NULL)
+			tmp = as_node_get_data (c);
+			if (tmp == NULL)
 				continue;
-			g_ptr_array_add (priv->mimetypes, taken);
+			g_ptr_array_add (priv->mimetypes, (gpointer) as_app_intern (tmp, -1));
 		}
 		break;
 
@@ -3302,8 +3624,11 @@ as_app_node_parse_child (AsApp *app, GNode *n, AsAppParseFlags flags, GError **e
 
 	/* <compulsory_for_desktop> */
 	case AS_TAG_COMPULSORY_FOR_DESKTOP:
+		tmp = as_node_get_data (n);
+		if (tmp == NULL)
+			break;
 		g_ptr_array_add (priv->compulsory_for_desktops,
-				 as_node_take_data (n));
+				 (gpointer) as_app_intern (tmp, -1));
 		break;
 
 	/* <extends> */
@@ -3379,11 +3704,11 @@ as_app_node_parse_child (AsApp *app, GNode *n, AsAppParseFlags flags, GError **e
 			g_hash_table_remove_all (priv->metadata);
 		for (c = n->children; c != NULL; c = c->next) {
 			AsKudoKind kudo;
-			gchar *key;
+			const gchar *key;
 
 			if (as_node_get_tag (c) != AS_TAG_VALUE)
 				continue;
-			key = as_node_take_attribute (c, "key");
+			key = as_node_get_attribute (c, "key");
 
 			/* check if it's not an old-style metadata kudo */
 			kudo = as_app_kudo_kind_from_legacy_string (key);
@@ -3391,12 +3716,13 @@ as_app_node_parse_child (AsApp *app, GNode *n, AsAppParseFlags flags, GError **e
 				taken = as_node_take_data (c);
 				if (taken == NULL)
 					taken = g_strdup ("");
-				g_hash_table_insert (priv->metadata, key, taken);
+				g_hash_table_insert (priv->metadata,
+						     (gpointer) as_app_intern (key, -1),
+						     taken);
 			} else {
 				/* storing a a string is inelegant, but allows
 				 * us to show kudos not (yet) supported */
 				as_app_add_kudo_kind (app, kudo);
-				g_free (key);
 			}
 		}
 		break;
@@ -3495,6 +3821,388 @@ as_app_node_parse (AsApp *app, GNode *node, GError **error)
 	return as_app_node_parse_full (app, node, AS_APP_PARSE_FLAG_NONE, error);
 }
 
+/* the members of AS_APP_VARIANT_TYPE */
+typedef enum {
+	AS_APP_VARIANT_SOURCE_KIND,
+	AS_APP_VARIANT_STATE,
+	AS_APP_VARIANT_PRIORITY,
+	AS_APP_VARIANT_ID_KIND,
+	AS_APP_VARIANT_PROBLEMS,
+	AS_APP_VARIANT_ID,
+	AS_APP_VARIANT_ICON_PATH,
+	AS_APP_VARIANT_ORIGIN,
+	AS_APP_VARIANT_SOURCE_FILE,
+	AS_APP_VARIANT_PROJECT_GROUP,
+	AS_APP_VARIANT_PROJECT_LICENSE,
+	AS_APP_VARIANT_METADATA_LICENSE,
+	AS_APP_VARIANT_SOURCE_PKGNAME,
+	AS_APP_VARIANT_UPDATE_CONTACT,
+	AS_APP_VARIANT_NAMES,
+	AS_APP_VARIANT_COMMENTS,
+	AS_APP_VARIANT_DEVELOPER_NAMES,
+	AS_APP_VARIANT_DESCRIPTIONS,
+	AS_APP_VARIANT_KEYWORDS,
+	AS_APP_VARIANT_LANGUAGES,
+	AS_APP_VARIANT_URLS,
+	AS_APP_VARIANT_METADATA,
+	AS_APP_VARIANT_CATEGORIES,
+	AS_APP_VARIANT_COMPULSORY_FOR_DESKTOPS,
+	AS_APP_VARIANT_EXTENDS,
+	AS_APP_VARIANT_KUDOS,
+	AS_APP_VARIANT_MIMETYPES,
+	AS_APP_VARIANT_PKGNAMES,
+	AS_APP_VARIANT_ARCHITECTURES,
+	AS_APP_VARIANT_VETOS,
+	AS_APP_VARIANT_ICONS,
+	AS_APP_VARIANT_PROVIDES,
+	AS_APP_VARIANT_RELEASES,
+	AS_APP_VARIANT_SCREENSHOTS,
+	AS_APP_VARIANT_LAST
+} AsAppVariant;
+
+/**
+ * as_app_variant_new_string:
+ **/
+static GVariant *
+as_app_variant_new_string (const gchar *value)
+{
+	return g_variant_new_string (value != NULL ? value : "");
+}
+
+/**
+ * as_app_variant_new_strv:
+ **/
+static GVariant *
+as_app_variant_new_strv (GPtrArray *array)
+{
+	return g_variant_new_strv ((const gchar * const *) array->pdata,
+				   (gssize) array->len);
+}
+
+/**
+ * as_app_to_variant: (skip)
+ * @app: a #AsApp instance.
+ *
+ * Converts the application to a binary form used in caches. Addons are
+ * not included, as they are separate applications.
+ *
+ * Returns: a floating #GVariant of type %AS_APP_VARIANT_TYPE
+ *
+ * Since: 0.3.3
+ **/
+GVariant *
+as_app_to_variant (AsApp *app)
+{
+	AsAppPrivate *priv = GET_PRIVATE (app);
+	GHashTableIter iter;
+	GVariant *children[AS_APP_VARIANT_LAST];
+	GVariantBuilder builder;
+	gpointer key;
+	gpointer value;
+	guint i;
+
+	children[AS_APP_VARIANT_SOURCE_KIND] = g_variant_new_uint32 (priv->source_kind);
+	children[AS_APP_VARIANT_STATE] = g_variant_new_uint32 (priv->state);
+	children[AS_APP_VARIANT_PRIORITY] = g_variant_new_int32 (priv->priority);
+	children[AS_APP_VARIANT_ID_KIND] = g_variant_new_uint32 (priv->id_kind);
+	children[AS_APP_VARIANT_PROBLEMS] = g_variant_new_uint32 (priv->problems);
+	children[AS_APP_VARIANT_ID] = as_app_variant_new_string (priv->id);
+	children[AS_APP_VARIANT_ICON_PATH] = as_app_variant_new_string (priv->icon_path);
+	children[AS_APP_VARIANT_ORIGIN] = as_app_variant_new_string (priv->origin);
+	children[AS_APP_VARIANT_SOURCE_FILE] = as_app_variant_new_string (priv->source_file);
+	children[AS_APP_VARIANT_PROJECT_GROUP] = as_app_variant_new_string (priv->project_group);
+	children[AS_APP_VARIANT_PROJECT_LICENSE] = as_app_variant_new_string (priv->project_license);
+	children[AS_APP_VARIANT_METADATA_LICENSE] = as_app_variant_new_string (priv->metadata_license);
+	children[AS_APP_VARIANT_SOURCE_PKGNAME] = as_app_variant_new_string (priv->source_pkgname);
+	children[AS_APP_VARIANT_UPDATE_CONTACT] = as_app_variant_new_string (priv->update_contact);
+	children[AS_APP_VARIANT_NAMES] = as_hash_to_variant (priv->names);
+	children[AS_APP_VARIANT_COMMENTS] = as_hash_to_variant (priv->comments);
+	children[AS_APP_VARIANT_DEVELOPER_NAMES] = as_hash_to_variant (priv->developer_names);
+	children[AS_APP_VARIANT_DESCRIPTIONS] = as_hash_to_variant (priv->descriptions);
+	children[AS_APP_VARIANT_URLS] = as_hash_to_variant (priv->urls);
+	children[AS_APP_VARIANT_METADATA] = as_hash_to_variant (priv->metadata);
+	children[AS_APP_VARIANT_CATEGORIES] = as_app_variant_new_strv (priv->categories);
+	children[AS_APP_VARIANT_COMPULSORY_FOR_DESKTOPS] = as_app_variant_new_strv (priv->compulsory_for_desktops);
+	children[AS_APP_VARIANT_EXTENDS] = as_app_variant_new_strv (priv->extends);
+	children[AS_APP_VARIANT_KUDOS] = as_app_variant_new_strv (priv->kudos);
+	children[AS_APP_VARIANT_MIMETYPES] = as_app_variant_new_strv (priv->mimetypes);
+	children[AS_APP_VARIANT_PKGNAMES] = as_app_variant_new_strv (priv->pkgnames);
+	children[AS_APP_VARIANT_ARCHITECTURES] = as_app_variant_new_strv (priv->architectures);
+	children[AS_APP_VARIANT_VETOS] = as_app_variant_new_strv (priv->vetos);
+
+	/* keywords are a list for each locale */
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sas}"));
+	g_hash_table_iter_init (&iter, priv->keywords);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		g_variant_builder_add (&builder, "{s@as}",
+				       (const gchar *) key,
+				       as_app_variant_new_strv (value));
+	}
+	children[AS_APP_VARIANT_KEYWORDS] = g_variant_builder_end (&builder);
+
+	/* languages are stored with the percentage */
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{si}"));
+	g_hash_table_iter_init (&iter, priv->languages);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		g_variant_builder_add (&builder, "{si}",
+				       (const gchar *) key,
+				       GPOINTER_TO_INT (value));
+	}
+	children[AS_APP_VARIANT_LANGUAGES] = g_variant_builder_end (&builder);
+
+	/* objects */
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a" AS_ICON_VARIANT_TYPE));
+	for (i = 0; i < priv->icons->len; i++) {
+		AsIcon *icon = g_ptr_array_index (priv->icons, i);
+		g_variant_builder_add_value (&builder, as_icon_to_variant (icon));
+	}
+	children[AS_APP_VARIANT_ICONS] = g_variant_builder_end (&builder);
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a" AS_PROVIDE_VARIANT_TYPE));
+	for (i = 0; i < priv->provides->len; i++) {
+		AsProvide *provide = g_ptr_array_index (priv->provides, i);
+		g_variant_builder_add_value (&builder, as_provide_to_variant (provide));
+	}
+	children[AS_APP_VARIANT_PROVIDES] = g_variant_builder_end (&builder);
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a" AS_RELEASE_VARIANT_TYPE));
+	for (i = 0; i < priv->releases->len; i++) {
+		AsRelease *release = g_ptr_array_index (priv->releases, i);
+		g_variant_builder_add_value (&builder, as_release_to_variant (release));
+	}
+	children[AS_APP_VARIANT_RELEASES] = g_variant_builder_end (&builder);
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a" AS_SCREENSHOT_VARIANT_TYPE));
+	for (i = 0; i < priv->screenshots->len; i++) {
+		AsScreenshot *ss = g_ptr_array_index (priv->screenshots, i);
+		g_variant_builder_add_value (&builder, as_screenshot_to_variant (ss));
+	}
+	children[AS_APP_VARIANT_SCREENSHOTS] = g_variant_builder_end (&builder);
+
+	return g_variant_new_tuple (children, AS_APP_VARIANT_LAST);
+}
+
+/**
+ * as_app_variant_get_string:
+ *
+ * Returns a copy of the string member, or %NULL if it is empty.
+ **/
+static gchar *
+as_app_variant_get_string (GVariant *value, AsAppVariant idx)
+{
+	const gchar *tmp;
+	g_variant_get_child (value, idx, "&s", &tmp);
+	if (tmp[0] == '\0')
+		return NULL;
+	return g_strdup (tmp);
+}
+
+/**
+ * as_app_variant_parse_localized:
+ **/
+static void
+as_app_variant_parse_localized (AsApp *app,
+				GHashTable *hash,
+				GVariant *value,
+				AsAppVariant idx)
+{
+	GVariantIter iter;
+	const gchar *locale;
+	const gchar *tmp;
+	const gchar *tmp_locale;
+	_cleanup_variant_unref_ GVariant *child = NULL;
+
+	child = g_variant_get_child_value (value, idx);
+	g_variant_iter_init (&iter, child);
+	while (g_variant_iter_next (&iter, "{&s&s}", &locale, &tmp)) {
+		tmp_locale = as_app_parse_locale (app, locale);
+		if (tmp_locale == NULL)
+			continue;
+		g_hash_table_insert (hash, (gpointer) tmp_locale, g_strdup (tmp));
+	}
+}
+
+/**
+ * as_app_variant_parse_strv:
+ **/
+static void
+as_app_variant_parse_strv (GPtrArray *array,
+			   GVariant *value,
+			   AsAppVariant idx,
+			   gboolean intern)
+{
+	GVariantIter iter;
+	const gchar *tmp;
+	_cleanup_variant_unref_ GVariant *child = NULL;
+
+	child = g_variant_get_child_value (value, idx);
+	g_variant_iter_init (&iter, child);
+	while (g_variant_iter_next (&iter, "&s", &tmp)) {
+		if (intern)
+			g_ptr_array_add (array, (gpointer) as_app_intern (tmp, -1));
+		else
+			g_ptr_array_add (array, g_strdup (tmp));
+	}
+}
+
+/**
+ * as_app_variant_parse: (skip)
+ * @app: a #AsApp instance.
+ * @value: a #GVariant of type %AS_APP_VARIANT_TYPE
+ * @error: A #GError or %NULL.
+ *
+ * Populates the object from a value created by as_app_to_variant(). This is
+ * much faster than parsing XML as no text has to be tokenized, unescaped or
+ * validated.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 0.3.3
+ **/
+gboolean
+as_app_variant_parse (AsApp *app, GVariant *value, GError **error)
+{
+	AsAppPrivate *priv = GET_PRIVATE (app);
+	GVariantIter iter;
+	GVariantIter *iter_keywords;
+	const gchar *key;
+	const gchar *tmp;
+	gint32 percentage;
+	gint32 priority;
+	guint32 tmp_u32;
+	guint i;
+	_cleanup_free_ gchar *id = NULL;
+	_cleanup_variant_unref_ GVariant *child = NULL;
+
+	g_variant_get_child (value, AS_APP_VARIANT_SOURCE_KIND, "u", &tmp_u32);
+	priv->source_kind = tmp_u32;
+	g_variant_get_child (value, AS_APP_VARIANT_STATE, "u", &tmp_u32);
+	priv->state = tmp_u32;
+	g_variant_get_child (value, AS_APP_VARIANT_PRIORITY, "i", &priority);
+	priv->priority = priority;
+	g_variant_get_child (value, AS_APP_VARIANT_ID_KIND, "u", &tmp_u32);
+	priv->id_kind = tmp_u32;
+	g_variant_get_child (value, AS_APP_VARIANT_PROBLEMS, "u", &tmp_u32);
+	priv->problems = tmp_u32;
+
+	/* strings */
+	id = as_app_variant_get_string (value, AS_APP_VARIANT_ID);
+	if (id != NULL)
+		as_app_set_id (app, id, -1);
+	g_free (priv->icon_path);
+	priv->icon_path = as_app_variant_get_string (value, AS_APP_VARIANT_ICON_PATH);
+	g_free (priv->origin);
+	priv->origin = as_app_variant_get_string (value, AS_APP_VARIANT_ORIGIN);
+	g_free (priv->source_file);
+	priv->source_file = as_app_variant_get_string (value, AS_APP_VARIANT_SOURCE_FILE);
+	g_free (priv->project_group);
+	priv->project_group = as_app_variant_get_string (value, AS_APP_VARIANT_PROJECT_GROUP);
+	g_free (priv->project_license);
+	priv->project_license = as_app_variant_get_string (value, AS_APP_VARIANT_PROJECT_LICENSE);
+	g_free (priv->metadata_license);
+	priv->metadata_license = as_app_variant_get_string (value, AS_APP_VARIANT_METADATA_LICENSE);
+	g_free (priv->source_pkgname);
+	priv->source_pkgname = as_app_variant_get_string (value, AS_APP_VARIANT_SOURCE_PKGNAME);
+	g_free (priv->update_contact);
+	priv->update_contact = as_app_variant_get_string (value, AS_APP_VARIANT_UPDATE_CONTACT);
+
+	/* translations, which honour any locale filter */
+	as_app_variant_parse_localized (app, priv->names, value, AS_APP_VARIANT_NAMES);
+	as_app_variant_parse_localized (app, priv->comments, value, AS_APP_VARIANT_COMMENTS);
+	as_app_variant_parse_localized (app, priv->developer_names, value, AS_APP_VARIANT_DEVELOPER_NAMES);
+	as_app_variant_parse_localized (app, priv->descriptions, value, AS_APP_VARIANT_DESCRIPTIONS);
+	g_variant_get_child (value, AS_APP_VARIANT_KEYWORDS, "a{sas}", &iter_keywords);
+	while (g_variant_iter_next (iter_keywords, "{&s@as}", &key, &child)) {
+		_cleanup_free_ const gchar **keywords = NULL;
+		keywords = g_variant_get_strv (child, NULL);
+		for (i = 0; keywords[i] != NULL; i++)
+			as_app_add_keyword (app, key, keywords[i], -1);
+		g_variant_unref (child);
+		child = NULL;
+	}
+	g_variant_iter_free (iter_keywords);
+
+	/* hashes of plain strings */
+	child = g_variant_get_child_value (value, AS_APP_VARIANT_LANGUAGES);
+	g_variant_iter_init (&iter, child);
+	while (g_variant_iter_next (&iter, "{&si}", &key, &percentage)) {
+		g_hash_table_insert (priv->languages,
+				     (gpointer) as_app_intern (key, -1),
+				     GINT_TO_POINTER (percentage));
+	}
+	g_variant_unref (child);
+	child = g_variant_get_child_value (value, AS_APP_VARIANT_URLS);
+	g_variant_iter_init (&iter, child);
+	while (g_variant_iter_next (&iter, "{&s&s}", &key, &tmp)) {
+		g_hash_table_insert (priv->urls,
+				     (gpointer) as_app_intern (key, -1),
+				     g_strdup (tmp));
+	}
+	g_variant_unref (child);
+	child = g_variant_get_child_value (value, AS_APP_VARIANT_METADATA);
+	g_variant_iter_init (&iter, child);
+	while (g_variant_iter_next (&iter, "{&s&s}", &key, &tmp)) {
+		g_hash_table_insert (priv->metadata,
+				     (gpointer) as_app_intern (key, -1),
+				     g_strdup (tmp));
+	}
+	g_variant_unref (child);
+	child = NULL;
+
+	/* arrays of strings */
+	as_app_variant_parse_strv (priv->categories, value, AS_APP_VARIANT_CATEGORIES, TRUE);
+	as_app_variant_parse_strv (priv->compulsory_for_desktops, value, AS_APP_VARIANT_COMPULSORY_FOR_DESKTOPS, TRUE);
+	as_app_variant_parse_strv (priv->extends, value, AS_APP_VARIANT_EXTENDS, FALSE);
+	as_app_variant_parse_strv (priv->kudos, value, AS_APP_VARIANT_KUDOS, TRUE);
+	as_app_variant_parse_strv (priv->mimetypes, value, AS_APP_VARIANT_MIMETYPES, TRUE);
+	as_app_variant_parse_strv (priv->pkgnames, value, AS_APP_VARIANT_PKGNAMES, FALSE);
+	as_app_variant_parse_strv (priv->architectures, value, AS_APP_VARIANT_ARCHITECTURES, TRUE);
+	as_app_variant_parse_strv (priv->vetos, value, AS_APP_VARIANT_VETOS, FALSE);
+
+	/* objects */
+	child = g_variant_get_child_value (value, AS_APP_VARIANT_ICONS);
+	for (i = 0; i < g_variant_n_children (child); i++) {
+		_cleanup_object_unref_ AsIcon *icon = NULL;
+		_cleanup_variant_unref_ GVariant *tmp_value = NULL;
+		tmp_value = g_variant_get_child_value (child, i);
+		icon = as_icon_new ();
+		if (!as_icon_variant_parse (icon, tmp_value, error))
+			return FALSE;
+		g_ptr_array_add (priv->icons, g_object_ref (icon));
+	}
+	g_variant_unref (child);
+	child = g_variant_get_child_value (value, AS_APP_VARIANT_PROVIDES);
+	for (i = 0; i < g_variant_n_children (child); i++) {
+		_cleanup_object_unref_ AsProvide *provide = NULL;
+		_cleanup_variant_unref_ GVariant *tmp_value = NULL;
+		tmp_value = g_variant_get_child_value (child, i);
+		provide = as_provide_new ();
+		if (!as_provide_variant_parse (provide, tmp_value, error))
+			return FALSE;
+		g_ptr_array_add (priv->provides, g_object_ref (provide));
+	}
+	g_variant_unref (child);
+	child = g_variant_get_child_value (value, AS_APP_VARIANT_RELEASES);
+	for (i = 0; i < g_variant_n_children (child); i++) {
+		_cleanup_object_unref_ AsRelease *release = NULL;
+		_cleanup_variant_unref_ GVariant *tmp_value = NULL;
+		tmp_value = g_variant_get_child_value (child, i);
+		release = as_release_new ();
+		if (!as_release_variant_parse (release, tmp_value, error))
+			return FALSE;
+		g_ptr_array_add (priv->releases, g_object_ref (release));
+	}
+	g_variant_unref (child);
+	child = g_variant_get_child_value (value, AS_APP_VARIANT_SCREENSHOTS);
+	for (i = 0; i < g_variant_n_children (child); i++) {
+		_cleanup_object_unref_ AsScreenshot *ss = NULL;
+		_cleanup_variant_unref_ GVariant *tmp_value = NULL;
+		tmp_value = g_variant_get_child_value (child, i);
+		ss = as_screenshot_new ();
+		if (!as_screenshot_variant_parse (ss, tmp_value, error))
+			return FALSE;
+		g_ptr_array_add (priv->screenshots, g_object_ref (ss));
+	}
+	return TRUE;
+}
+
 /**
  * as_app_node_parse_dep11_icons:
  **/
@@ -3786,6 +4494,30 @@ as_app_create_token_cache (AsApp *app)
 	}
 }
 
+/**
+ * as_app_get_search_tokens: (skip)
+ * @app: a #AsApp instance.
+ *
+ * Gets the search tokens for the application, creating them if required.
+ * The items are in the order that as_app_search_matches() checks them.
+ *
+ * Returns: (transfer none) (element-type AsAppTokenItem): the token items
+ *
+ * Since: 0.3.3
+ **/
+GPtrArray *
+as_app_get_search_tokens (AsApp *app)
+{
+	AsAppPrivate *priv = GET_PRIVATE (app);
+
+	/* ensure the token cache is created */
+	if (g_once_init_enter (&priv->token_cache_valid)) {
+		as_app_create_token_cache (app);
+		g_once_init_leave (&priv->token_cache_valid, TRUE);
+	}
+	return priv->token_cache;
+}
+
 /**
  * as_app_search_matches:
  * @app: a #AsApp instance.
@@ -3800,23 +4532,18 @@ as_app_create_token_cache (AsApp *app)
 guint
 as_app_search_matches (AsApp *app, const gchar *search)
 {
-	AsAppPrivate *priv = GET_PRIVATE (app);
 	AsAppTokenItem *item;
+	GPtrArray *token_cache;
 	guint i, j;
 
 	/* nothing to do */
 	if (search == NULL)
 		return 0;
 
-	/* ensure the token cache is created */
-	if (g_once_init_enter (&priv->token_cache_valid)) {
-		as_app_create_token_cache (app);
-		g_once_init_leave (&priv->token_cache_valid, TRUE);
-	}
-
 	/* find the search term */
-	for (i = 0; i < priv->token_cache->len; i++) {
-		item = g_ptr_array_index (priv->token_cache, i);
+	token_cache = as_app_get_search_tokens (app);
+	for (i = 0; i < token_cache->len; i++) {
+		item = g_ptr_array_index (token_cache, i);
 
 		/* prefer UTF-8 matches */
 		if (item->values_utf8 != NULL) {
@@ -4160,6 +4887,8 @@ as_app_parse_file_key (AsApp *app,
 static gboolean
 as_app_parse_desktop_file (AsApp *app,
 			   const gchar *desktop_file,
+			   const gchar *data,
+			   gsize len,
 			   AsAppParseFlags flags,
 			   GError **error)
 {
@@ -4175,7 +4904,7 @@ as_app_parse_desktop_file (AsApp *app,
 	kf = g_key_file_new ();
 	if (flags & AS_APP_PARSE_FLAG_KEEP_COMMENTS)
 		kf_flags |= G_KEY_FILE_KEEP_COMMENTS;
-	if (!g_key_file_load_from_file (kf, desktop_file, kf_flags, &error_local)) {
+	if (!g_key_file_load_from_data (kf, data, len, kf_flags, &error_local)) {
 		g_set_error (error,
 			     AS_APP_ERROR,
 			     AS_APP_ERROR_INVALID_TYPE,
@@ -4272,23 +5001,19 @@ as_app_parse_appdata_unintltoolize_cb (GNode *node, gpointer data)
 static gboolean
 as_app_parse_appdata_file (AsApp *app,
 			   const gchar *filename,
+			   const gchar *data,
+			   gsize len,
 			   AsAppParseFlags flags,
 			   GError **error)
 {
 	AsAppPrivate *priv = GET_PRIVATE (app);
-	AsNodeFromXmlFlags from_xml_flags = AS_NODE_FROM_XML_FLAG_NONE;
+	AsNodeFromXmlFlags from_xml_flags = AS_NODE_FROM_XML_FLAG_ARENA;
 	GNode *l;
 	GNode *node;
 	gboolean seen_application = FALSE;
 	gchar *tmp;
-	gsize len;
-	_cleanup_free_ gchar *data = NULL;
 	_cleanup_node_unref_ GNode *root = NULL;
 
-	/* open file */
-	if (!g_file_get_contents (filename, &data, &len, error))
-		return FALSE;
-
 	/* validate */
 	tmp = g_strstr_len (data, len, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>");
 	if (tmp == NULL)
@@ -4354,41 +5079,41 @@ as_app_parse_appdata_file (AsApp *app,
 }
 
 /**
- * as_app_parse_file:
- * @app: a #AsApp instance.
- * @filename: file to load.
- * @flags: #AsAppParseFlags, e.g. %AS_APP_PARSE_FLAG_USE_HEURISTICS
- * @error: A #GError or %NULL.
- *
- * Parses a desktop or AppData file and populates the application state.
- *
- * Applications that are not suitable for the store will have vetos added.
- *
- * Returns: %TRUE for success
- *
- * Since: 0.1.2
+ * as_app_parse_source_kind:
  **/
-gboolean
-as_app_parse_file (AsApp *app,
-		   const gchar *filename,
-		   AsAppParseFlags flags,
-		   GError **error)
+static gboolean
+as_app_parse_source_kind (AsApp *app, const gchar *filename, GError **error)
 {
 	AsAppPrivate *priv = GET_PRIVATE (app);
-	GPtrArray *vetos;
 
 	/* autodetect */
+	if (priv->source_kind != AS_APP_SOURCE_KIND_UNKNOWN)
+		return TRUE;
+	priv->source_kind = as_app_guess_source_kind (filename);
 	if (priv->source_kind == AS_APP_SOURCE_KIND_UNKNOWN) {
-		priv->source_kind = as_app_guess_source_kind (filename);
-		if (priv->source_kind == AS_APP_SOURCE_KIND_UNKNOWN) {
-			g_set_error (error,
-				     AS_APP_ERROR,
-				     AS_APP_ERROR_INVALID_TYPE,
-				     "%s has an unrecognised extension",
-				     filename);
-			return FALSE;
-		}
+		g_set_error (error,
+			     AS_APP_ERROR,
+			     AS_APP_ERROR_INVALID_TYPE,
+			     "%s has an unrecognised extension",
+			     filename);
+		return FALSE;
 	}
+	return TRUE;
+}
+
+/**
+ * as_app_parse_contents:
+ **/
+static gboolean
+as_app_parse_contents (AsApp *app,
+		       const gchar *filename,
+		       const gchar *data,
+		       gsize len,
+		       AsAppParseFlags flags,
+		       GError **error)
+{
+	AsAppPrivate *priv = GET_PRIVATE (app);
+	GPtrArray *vetos;
 
 	/* convert <_p> into <p> for easy validation */
 	if (g_str_has_suffix (filename, ".appdata.xml.in") ||
@@ -4406,12 +5131,14 @@ as_app_parse_file (AsApp *app,
 	/* parse */
 	switch (priv->source_kind) {
 	case AS_APP_SOURCE_KIND_DESKTOP:
-		if (!as_app_parse_desktop_file (app, filename, flags, error))
+		if (!as_app_parse_desktop_file (app, filename, data, len,
+						flags, error))
 			return FALSE;
 		break;
 	case AS_APP_SOURCE_KIND_APPDATA:
 	case AS_APP_SOURCE_KIND_METAINFO:
-		if (!as_app_parse_appdata_file (app, filename, flags, error))
+		if (!as_app_parse_appdata_file (app, filename, data, len,
+						flags, error))
 			return FALSE;
 		break;
 	default:
@@ -4438,6 +5165,83 @@ as_app_parse_file (AsApp *app,
 	return TRUE;
 }
 
+/**
+ * as_app_parse_file:
+ * @app: a #AsApp instance.
+ * @filename: file to load.
+ * @flags: #AsAppParseFlags, e.g. %AS_APP_PARSE_FLAG_USE_HEURISTICS
+ * @error: A #GError or %NULL.
+ *
+ * Parses a desktop or AppData file and populates the application state.
+ *
+ * Applications that are not suitable for the store will have vetos added.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 0.1.2
+ **/
+gboolean
+as_app_parse_file (AsApp *app,
+		   const gchar *filename,
+		   AsAppParseFlags flags,
+		   GError **error)
+{
+	AsAppPrivate *priv = GET_PRIVATE (app);
+	gsize len;
+	_cleanup_error_free_ GError *error_local = NULL;
+	_cleanup_free_ gchar *data = NULL;
+
+	if (!as_app_parse_source_kind (app, filename, error))
+		return FALSE;
+
+	/* open file */
+	if (!g_file_get_contents (filename, &data, &len, &error_local)) {
+		if (priv->source_kind == AS_APP_SOURCE_KIND_DESKTOP) {
+			g_set_error (error,
+				     AS_APP_ERROR,
+				     AS_APP_ERROR_INVALID_TYPE,
+				     "Failed to parse %s: %s",
+				     filename, error_local->message);
+			return FALSE;
+		}
+		g_propagate_error (error, error_local);
+		error_local = NULL;
+		return FALSE;
+	}
+	return as_app_parse_contents (app, filename, data, len, flags, error);
+}
+
+/**
+ * as_app_parse_data:
+ * @app: a #AsApp instance.
+ * @filename: the name of the file, used to detect the type and the ID
+ * @data: the file contents
+ * @flags: #AsAppParseFlags, e.g. %AS_APP_PARSE_FLAG_USE_HEURISTICS
+ * @error: A #GError or %NULL.
+ *
+ * Parses the contents of a desktop or AppData file that is already in
+ * memory, for instance when it has been read from a package.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 0.3.3
+ **/
+gboolean
+as_app_parse_data (AsApp *app,
+		   const gchar *filename,
+		   GBytes *data,
+		   AsAppParseFlags flags,
+		   GError **error)
+{
+	gsize len;
+	const gchar *tmp;
+
+	if (!as_app_parse_source_kind (app, filename, error))
+		return FALSE;
+	tmp = g_bytes_get_data (data, &len);
+	return as_app_parse_contents (app, filename, tmp, len, flags, error);
+}
+
 /**
  * as_app_to_file:
  * @app: a #AsApp instance.
@@ -398,6 +398,11 @@ gboolean	 as_app_parse_file		(AsApp		*app,
 						 const gchar	*filename,
 						 AsAppParseFlags flags,
 						 GError		**error);
+gboolean	 as_app_parse_data		(AsApp		*app,
+						 const gchar	*filename,
+						 GBytes		*data,
+						 AsAppParseFlags flags,
+						 GError		**error);
 gboolean	 as_app_to_file			(AsApp		*app,
 						 GFile		*file,
 						 GCancellable	*cancellable,
@@ -44,6 +44,13 @@ gboolean	 as_icon_node_parse_dep11	(AsIcon		*icon,
 						 GNode		*node,
 						 GError		**error);
 
+#define AS_ICON_VARIANT_TYPE		"(usssuuay)"
+
+GVariant	*as_icon_to_variant		(AsIcon		*icon);
+gboolean	 as_icon_variant_parse		(AsIcon		*icon,
+						 GVariant	*value,
+						 GError		**error);
+
 G_END_DECLS
 
 #endif /* __AS_ICON_PRIVATE_H */
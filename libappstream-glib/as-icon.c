@@ -592,6 +592,96 @@ as_icon_node_parse (AsIcon *icon, GNode *node, GError **error)
 	return TRUE;
 }
 
+/**
+ * as_icon_to_variant: (skip)
+ * @icon: a #AsIcon instance.
+ *
+ * Converts the icon to a binary form used in caches. Embedded icons keep
+ * their raw data, but the pixbuf is not included.
+ *
+ * Returns: a floating #GVariant of type %AS_ICON_VARIANT_TYPE
+ *
+ * Since: 0.3.3
+ **/
+GVariant *
+as_icon_to_variant (AsIcon *icon)
+{
+	AsIconPrivate *priv = GET_PRIVATE (icon);
+	gconstpointer data = NULL;
+	gsize size = 0;
+
+	if (priv->data != NULL)
+		data = g_bytes_get_data (priv->data, &size);
+	return g_variant_new ("(usssuu@ay)",
+			      priv->kind,
+			      priv->name != NULL ? priv->name : "",
+			      priv->prefix != NULL ? priv->prefix : "",
+			      priv->prefix_private != NULL ? priv->prefix_private : "",
+			      priv->width,
+			      priv->height,
+			      g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE,
+							 data, size,
+							 sizeof (guint8)));
+}
+
+/**
+ * as_icon_variant_parse: (skip)
+ * @icon: a #AsIcon instance.
+ * @value: a #GVariant of type %AS_ICON_VARIANT_TYPE
+ * @error: A #GError or %NULL.
+ *
+ * Populates the object from a value created by as_icon_to_variant().
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 0.3.3
+ **/
+gboolean
+as_icon_variant_parse (AsIcon *icon, GVariant *value, GError **error)
+{
+	AsIconPrivate *priv = GET_PRIVATE (icon);
+	const gchar *name;
+	const gchar *prefix;
+	const gchar *prefix_private;
+	gconstpointer data;
+	gsize size;
+	guint32 height;
+	guint32 kind;
+	guint32 width;
+	_cleanup_object_unref_ GdkPixbuf *pixbuf = NULL;
+	_cleanup_object_unref_ GInputStream *stream = NULL;
+	_cleanup_variant_unref_ GVariant *data_value = NULL;
+
+	g_variant_get (value, "(u&s&s&suu@ay)",
+		       &kind, &name, &prefix, &prefix_private,
+		       &width, &height, &data_value);
+	priv->kind = kind;
+	priv->width = width;
+	priv->height = height;
+	g_free (priv->name);
+	priv->name = name[0] != '\0' ? g_strdup (name) : NULL;
+	g_free (priv->prefix);
+	priv->prefix = prefix[0] != '\0' ? g_strdup (prefix) : NULL;
+	g_free (priv->prefix_private);
+	priv->prefix_private = prefix_private[0] != '\0' ? g_strdup (prefix_private) : NULL;
+
+	/* only embedded icons have data */
+	data = g_variant_get_fixed_array (data_value, &size, sizeof (guint8));
+	if (size == 0)
+		return TRUE;
+	if (priv->data != NULL)
+		g_bytes_unref (priv->data);
+	priv->data = g_bytes_new (data, size);
+
+	/* load the image */
+	stream = g_memory_input_stream_new_from_bytes (priv->data);
+	pixbuf = gdk_pixbuf_new_from_stream (stream, NULL, error);
+	if (pixbuf == NULL)
+		return FALSE;
+	as_icon_set_pixbuf (icon, pixbuf);
+	return TRUE;
+}
+
 /**
  * as_icon_node_parse_dep11:
  * @icon: a #AsIcon instance.
@@ -0,0 +1,27 @@
+#!/bin/sh
+#
+# Generates sorted static tables from the as-*.txt ID lists so that they can
+# be searched with bsearch() rather than scanning the text at runtime.
+#
+# Usage: as-ids-private.sh srcdir > as-ids-private.h
+
+srcdir="$1"
+set -f
+
+# table name, filename, grep arguments used to select the lines
+as_ids_table () {
+	echo "static const gchar *$1[] = {"
+	grep -v -e '^#' -e '^$' "$srcdir/$2" | grep $3 | \
+		LC_ALL=C sort -u | sed -e 's/\\/\\\\/g' -e 's/"/\\"/g' -e 's/.*/\t"&",/'
+	echo "};"
+	echo
+}
+
+echo "/* generated by as-ids-private.sh, do not edit */"
+echo
+as_ids_table as_ids_stock_icons as-stock-icons.txt "-e ."
+as_ids_table as_ids_licenses as-license-ids.txt "-e ."
+as_ids_table as_ids_categories as-category-ids.txt "-e ."
+as_ids_table as_ids_environments as-environment-ids.txt "-e ."
+as_ids_table as_ids_blacklist as-blacklist-ids.txt "-v -e [*?[]"
+as_ids_table as_ids_blacklist_globs as-blacklist-ids.txt "-e [*?[]"
@@ -40,6 +40,13 @@ gboolean	 as_image_node_parse_dep11	(AsImage	*image,
 						 GNode		*node,
 						 GError		**error);
 
+#define AS_IMAGE_VARIANT_TYPE		"(usssuu)"
+
+GVariant	*as_image_to_variant		(AsImage	*image);
+gboolean	 as_image_variant_parse		(AsImage	*image,
+						 GVariant	*value,
+						 GError		**error);
+
 G_END_DECLS
 
 #endif /* __AS_IMAGE_PRIVATE_H */
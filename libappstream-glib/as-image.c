@@ -442,6 +442,67 @@ as_image_node_parse (AsImage *image, GNode *node, GError **error)
 	return TRUE;
 }
 
+/**
+ * as_image_to_variant: (skip)
+ * @image: a #AsImage instance.
+ *
+ * Converts the image to a binary form used in caches. The pixbuf is not
+ * included.
+ *
+ * Returns: a floating #GVariant of type %AS_IMAGE_VARIANT_TYPE
+ *
+ * Since: 0.3.3
+ **/
+GVariant *
+as_image_to_variant (AsImage *image)
+{
+	AsImagePrivate *priv = GET_PRIVATE (image);
+	return g_variant_new (AS_IMAGE_VARIANT_TYPE,
+			      priv->kind,
+			      priv->url != NULL ? priv->url : "",
+			      priv->md5 != NULL ? priv->md5 : "",
+			      priv->basename != NULL ? priv->basename : "",
+			      priv->width,
+			      priv->height);
+}
+
+/**
+ * as_image_variant_parse: (skip)
+ * @image: a #AsImage instance.
+ * @value: a #GVariant of type %AS_IMAGE_VARIANT_TYPE
+ * @error: A #GError or %NULL.
+ *
+ * Populates the object from a value created by as_image_to_variant().
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 0.3.3
+ **/
+gboolean
+as_image_variant_parse (AsImage *image, GVariant *value, GError **error)
+{
+	AsImagePrivate *priv = GET_PRIVATE (image);
+	const gchar *basename;
+	const gchar *md5;
+	const gchar *url;
+	guint32 height;
+	guint32 kind;
+	guint32 width;
+
+	g_variant_get (value, "(u&s&s&suu)",
+		       &kind, &url, &md5, &basename, &width, &height);
+	priv->kind = kind;
+	priv->width = width;
+	priv->height = height;
+	g_free (priv->url);
+	priv->url = url[0] != '\0' ? g_strdup (url) : NULL;
+	g_free (priv->md5);
+	priv->md5 = md5[0] != '\0' ? g_strdup (md5) : NULL;
+	g_free (priv->basename);
+	priv->basename = basename[0] != '\0' ? g_strdup (basename) : NULL;
+	return TRUE;
+}
+
 /**
  * as_image_node_parse_dep11:
  * @image: a #AsImage instance.
@@ -30,11 +30,48 @@
 
 G_BEGIN_DECLS
 
+/**
+ * AsNodeSplitFunc:
+ * @node: a complete #GNode subtree, which is freed after the function returns
+ * @user_data: user data
+ * @error: A #GError or %NULL
+ *
+ * Called for each subtree at the split depth when parsing.
+ *
+ * Returns: %FALSE to abort the parse, with @error set
+ **/
+typedef gboolean (*AsNodeSplitFunc)		(GNode		*node,
+						 gpointer	 user_data,
+						 GError		**error);
+
 gchar		*as_node_take_data		(const GNode	*node);
 gchar		*as_node_take_attribute		(const GNode	*node,
 						 const gchar	*key);
 gchar		*as_node_reflow_text		(const gchar	*text,
 						 gssize		 text_len);
+GNode		*as_node_from_xml_full		(const gchar	*data,
+						 gssize		 data_len,
+						 AsNodeFromXmlFlags flags,
+						 guint		 split_depth,
+						 AsNodeSplitFunc split_func,
+						 gpointer	 split_data,
+						 GError		**error);
+GNode		*as_node_from_file_full		(GFile		*file,
+						 AsNodeFromXmlFlags flags,
+						 guint		 split_depth,
+						 AsNodeSplitFunc split_func,
+						 gpointer	 split_data,
+						 GCancellable	*cancellable,
+						 GError		**error);
+void		 as_node_to_xml_start		(GString	*xml,
+						 const GNode	*node,
+						 AsNodeToXmlFlags flags);
+void		 as_node_to_xml_child		(GString	*xml,
+						 const GNode	*node,
+						 AsNodeToXmlFlags flags);
+void		 as_node_to_xml_end		(GString	*xml,
+						 const GNode	*node,
+						 AsNodeToXmlFlags flags);
 
 G_END_DECLS
 
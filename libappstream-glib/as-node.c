@@ -41,19 +41,149 @@
 #include "as-node-private.h"
 #include "as-utils-private.h"
 
+#define AS_NODE_ARENA_CHUNK_SIZE	(64 * 1024)
+
+typedef struct {
+	GSList		*chunks;	/* of gchar[] */
+	gchar		*ptr;
+	gsize		 left;
+	GNode		*root;
+	gboolean	 dirty;		/* nodes or strings on the heap */
+} AsNodeArena;
+
+typedef struct {
+	const gchar	*key;		/* interned */
+	gchar		*value;
+} AsNodeAttr;
+
 typedef struct
 {
-	GList		*attrs;
+	AsNodeAttr	*attrs;		/* in the order they were added */
+	guint		 attrs_len;
+	guint		 attrs_size;
+	gboolean	 cdata_escaped;
+	gboolean	 heap_strings;	/* only used if arena != NULL */
+	gboolean	 heap_data;	/* only used if arena != NULL */
 	gchar		*name;		/* only used if tag == AS_TAG_UNKNOWN */
 	gchar		*cdata;
-	gboolean	 cdata_escaped;
+	AsNodeArena	*arena;		/* if allocated with the tree */
 	AsTag		 tag;
 } AsNodeData;
 
-typedef struct {
-	const gchar	*key;
-	gchar		*value;
-} AsNodeAttr;
+/**
+ * as_node_arena_alloc:
+ *
+ * Allocates zeroed memory that is only freed when the whole tree is freed.
+ **/
+static gpointer
+as_node_arena_alloc (AsNodeArena *arena, gsize size)
+{
+	gpointer mem;
+
+	size = (size + 7) & ~((gsize) 7);
+	if (size > arena->left) {
+		gsize chunk_size = MAX (AS_NODE_ARENA_CHUNK_SIZE, size);
+		arena->ptr = g_malloc (chunk_size);
+		arena->left = chunk_size;
+		arena->chunks = g_slist_prepend (arena->chunks, arena->ptr);
+	}
+	mem = arena->ptr;
+	arena->ptr += size;
+	arena->left -= size;
+	memset (mem, 0, size);
+	return mem;
+}
+
+/**
+ * as_node_arena_trim:
+ *
+ * Gives back the unused end of the most recent allocation.
+ **/
+static void
+as_node_arena_trim (AsNodeArena *arena, gpointer mem, gsize size, gsize used)
+{
+	size = (size + 7) & ~((gsize) 7);
+	used = (used + 7) & ~((gsize) 7);
+	if ((gchar *) mem + size != (gchar *) arena->ptr)
+		return;
+	arena->ptr -= size - used;
+	arena->left += size - used;
+}
+
+/**
+ * as_node_arena_strndup:
+ **/
+static gchar *
+as_node_arena_strndup (AsNodeArena *arena, const gchar *text, gsize text_len)
+{
+	gchar *tmp = as_node_arena_alloc (arena, text_len + 1);
+	memcpy (tmp, text, text_len);
+	return tmp;
+}
+
+/**
+ * as_node_arena_free:
+ **/
+static void
+as_node_arena_free (AsNodeArena *arena)
+{
+	g_slist_free_full (arena->chunks, g_free);
+	g_free (arena);
+}
+
+/**
+ * as_node_arena_node_new:
+ **/
+static GNode *
+as_node_arena_node_new (AsNodeArena *arena, AsNodeData *data)
+{
+	GNode *node = as_node_arena_alloc (arena, sizeof (GNode));
+	node->data = data;
+	return node;
+}
+
+/**
+ * as_node_new_arena:
+ **/
+static GNode *
+as_node_new_arena (void)
+{
+	AsNodeArena *arena;
+	AsNodeData *data;
+
+	arena = g_new0 (AsNodeArena, 1);
+	data = as_node_arena_alloc (arena, sizeof (AsNodeData));
+	data->tag = AS_TAG_LAST;
+	data->arena = arena;
+	arena->root = as_node_arena_node_new (arena, data);
+	return arena->root;
+}
+
+/**
+ * as_node_data_detach:
+ *
+ * Copies the strings of a node allocated from an arena onto the heap so they
+ * can be modified and freed in the usual way.
+ **/
+static void
+as_node_data_detach (AsNodeData *data)
+{
+	AsNodeAttr *attrs;
+	guint i;
+
+	if (data->arena == NULL || data->heap_strings)
+		return;
+	data->name = g_strdup (data->name);
+	data->cdata = g_strdup (data->cdata);
+	attrs = data->attrs;
+	data->attrs = g_new (AsNodeAttr, data->attrs_size);
+	for (i = 0; i < data->attrs_len; i++) {
+		data->attrs[i].key = attrs[i].key;
+		data->attrs[i].value = g_strdup (attrs[i].value);
+	}
+	data->heap_strings = TRUE;
+	data->arena->dirty = TRUE;
+}
 
 /**
  * as_node_new: (skip)
@@ -73,47 +203,62 @@ as_node_new (void)
 	return g_node_new (data);
 }
 
-/**
- * as_node_attr_free:
- **/
-static void
-as_node_attr_free (AsNodeAttr *attr)
-{
-	g_free (attr->value);
-	g_slice_free (AsNodeAttr, attr);
-}
-
 /**
  * as_node_attr_insert:
+ *
+ * The attributes are stored inline in a small array rather than as a list,
+ * as most elements have zero, one or two attributes.
+ *
+ * The returned pointer is only valid until the next attribute is added.
  **/
 static AsNodeAttr *
 as_node_attr_insert (AsNodeData *data, const gchar *key, const gchar *value)
 {
 	AsNodeAttr *attr;
-	attr = g_slice_new0 (AsNodeAttr);
+
+	if (data->attrs_len == data->attrs_size) {
+		data->attrs_size = data->attrs_size > 0 ? data->attrs_size * 2 : 2;
+		data->attrs = g_renew (AsNodeAttr, data->attrs, data->attrs_size);
+	}
+	attr = &data->attrs[data->attrs_len++];
 	attr->key = g_intern_string (key);
 	attr->value = g_strdup (value);
-	data->attrs = g_list_prepend (data->attrs, attr);
 	return attr;
 }
 
 /**
  * as_node_attr_find:
+ *
+ * The most recently added attribute with the key is returned.
  **/
 static AsNodeAttr *
 as_node_attr_find (AsNodeData *data, const gchar *key)
 {
 	AsNodeAttr *attr;
-	GList *l;
+	guint i;
 
-	for (l = data->attrs; l != NULL; l = l->next) {
-		attr = l->data;
-		if (g_strcmp0 (attr->key, key) == 0)
+	for (i = data->attrs_len; i > 0; i--) {
+		attr = &data->attrs[i - 1];
+		if (attr->key == key || strcmp (attr->key, key) == 0)
 			return attr;
 	}
 	return NULL;
 }
 
+/**
+ * as_node_attr_remove:
+ **/
+static void
+as_node_attr_remove (AsNodeData *data, AsNodeAttr *attr)
+{
+	guint idx = attr - data->attrs;
+
+	g_free (attr->value);
+	data->attrs_len--;
+	memmove (&data->attrs[idx], &data->attrs[idx + 1],
+		 (data->attrs_len - idx) * sizeof (AsNodeAttr));
+}
+
 /**
  * as_node_attr_lookup:
  **/
@@ -134,15 +279,47 @@ static gboolean
 as_node_destroy_node_cb (GNode *node, gpointer user_data)
 {
 	AsNodeData *data = node->data;
+	guint i;
+
 	if (data == NULL)
 		return FALSE;
+	if (data->arena != NULL && !data->heap_strings)
+		return FALSE;
 	g_free (data->name);
 	g_free (data->cdata);
-	g_list_free_full (data->attrs, (GDestroyNotify) as_node_attr_free);
-	g_slice_free (AsNodeData, data);
+	for (i = 0; i < data->attrs_len; i++)
+		g_free (data->attrs[i].value);
+	g_free (data->attrs);
+	if (data->arena == NULL || data->heap_data)
+		g_slice_free (AsNodeData, data);
 	return FALSE;
 }
 
+/**
+ * as_node_insert_data:
+ **/
+static GNode *
+as_node_insert_data (GNode *parent, AsNodeData *data)
+{
+	AsNodeArena *arena;
+	AsNodeData *data_parent = parent->data;
+	GNode *node;
+
+	if (data_parent == NULL || data_parent->arena == NULL)
+		return g_node_insert_data (parent, -1, data);
+
+	/* every GNode in the tree belongs to the arena, but the new strings
+	 * have to be freed separately */
+	arena = data_parent->arena;
+	arena->dirty = TRUE;
+	data->arena = arena;
+	data->heap_strings = TRUE;
+	data->heap_data = TRUE;
+	node = as_node_arena_node_new (arena, data);
+	g_node_insert (parent, -1, node);
+	return node;
+}
+
 /**
  * as_node_unref:
  * @node: a #GNode.
@@ -154,6 +331,26 @@ as_node_destroy_node_cb (GNode *node, gpointer user_data)
 void
 as_node_unref (GNode *node)
 {
+	AsNodeData *data = node->data;
+
+	/* the tree is freed in one go unless it has been modified */
+	if (data != NULL && data->arena != NULL) {
+		AsNodeArena *arena = data->arena;
+		if (arena->dirty || node != arena->root) {
+			g_node_traverse (node,
+					 G_PRE_ORDER,
+					 G_TRAVERSE_ALL,
+					 -1,
+					 as_node_destroy_node_cb,
+					 NULL);
+		}
+		if (node == arena->root)
+			as_node_arena_free (arena);
+		else
+			g_node_unlink (node);
+		return;
+	}
+
 	g_node_traverse (node,
 			 G_PRE_ORDER,
 			 G_TRAVERSE_ALL,
@@ -180,79 +377,84 @@ as_node_error_quark (void)
 }
 
 /**
- * as_node_string_replace:
+ * as_node_cdata_to_raw:
+ *
+ * Unescapes the entities in one pass, in place.
  **/
 static void
-as_node_string_replace (GString *string, const gchar *search, const gchar *replace)
+as_node_cdata_to_raw (AsNodeData *data)
 {
-	_cleanup_free_ gchar *tmp = NULL;
-	_cleanup_strv_free_ gchar **split = NULL;
+	gchar *dest;
+	gchar *src;
 
-	/* quick search */
-	if (g_strstr_len (string->str, -1, search) == NULL)
+	if (!data->cdata_escaped)
 		return;
-
-	/* replace */
-	split = g_strsplit (string->str, search, -1);
-	tmp = g_strjoinv (replace, split);
-	g_string_assign (string, tmp);
+	if (data->cdata != NULL &&
+	    (src = strchr (data->cdata, '&')) != NULL) {
+		for (dest = src; *src != '\0'; ) {
+			if (strncmp (src, "&amp;", 5) == 0) {
+				*dest++ = '&';
+				src += 5;
+			} else if (strncmp (src, "&lt;", 4) == 0) {
+				*dest++ = '<';
+				src += 4;
+			} else if (strncmp (src, "&gt;", 4) == 0) {
+				*dest++ = '>';
+				src += 4;
+			} else {
+				*dest++ = *src++;
+			}
+		}
+		*dest = '\0';
+	}
+	data->cdata_escaped = FALSE;
 }
 
 /**
- * as_node_string_replace_inplace:
+ * as_node_string_append_escaped:
+ *
+ * Appends @text escaping any entities in one pass.
  **/
 static void
-as_node_string_replace_inplace (gchar *text,
-				const gchar *search,
-				gchar replace)
+as_node_string_append_escaped (GString *str, const gchar *text)
 {
+	const gchar *entity;
+	const gchar *p;
 	const gchar *start = text;
-	gchar *tmp;
-	gsize len;
-	gsize len_escaped = 0;
-
-	while ((tmp = g_strstr_len (start, -1, search)) != NULL) {
-		*tmp = replace;
-		len = strlen (tmp);
-		if (len_escaped == 0)
-			len_escaped = strlen (search);
-		memcpy (tmp + 1,
-			tmp + len_escaped,
-			(len - len_escaped) + 1);
-		start = tmp + 1;
+
+	for (p = text; *p != '\0'; p++) {
+		switch (*p) {
+		case '&':
+			entity = "&amp;";
+			break;
+		case '<':
+			entity = "&lt;";
+			break;
+		case '>':
+			entity = "&gt;";
+			break;
+		default:
+			continue;
+		}
+		g_string_append_len (str, start, p - start);
+		g_string_append (str, entity);
+		start = p + 1;
 	}
+	g_string_append_len (str, start, p - start);
 }
 
 /**
- * as_node_cdata_to_raw:
+ * as_node_string_append_cdata:
  **/
 static void
-as_node_cdata_to_raw (AsNodeData *data)
+as_node_string_append_cdata (GString *str, const AsNodeData *data)
 {
-	if (!data->cdata_escaped)
+	if (data->cdata == NULL)
 		return;
-	as_node_string_replace_inplace (data->cdata, "&amp;", '&');
-	as_node_string_replace_inplace (data->cdata, "&lt;", '<');
-	as_node_string_replace_inplace (data->cdata, "&gt;", '>');
-	data->cdata_escaped = FALSE;
-}
-
-/**
- * as_node_cdata_to_escaped:
- **/
-static void
-as_node_cdata_to_escaped (AsNodeData *data)
-{
-	GString *str;
 	if (data->cdata_escaped)
-		return;
-	str = g_string_new (data->cdata);
-	g_free (data->cdata);
-	as_node_string_replace (str, "&", "&amp;");
-	as_node_string_replace (str, "<", "&lt;");
-	as_node_string_replace (str, ">", "&gt;");
-	data->cdata = g_string_free (str, FALSE);
-	data->cdata_escaped = TRUE;
+		g_string_append (str, data->cdata);
+	else
+		as_node_string_append_escaped (str, data->cdata);
 }
 
 /**
@@ -273,12 +475,13 @@ static gchar *
 as_node_get_attr_string (AsNodeData *data)
 {
 	AsNodeAttr *attr;
-	GList *l;
 	GString *str;
+	guint i;
 
+	/* newest first */
 	str = g_string_new ("");
-	for (l = data->attrs; l != NULL; l = l->next) {
-		attr = l->data;
+	for (i = data->attrs_len; i > 0; i--) {
+		attr = &data->attrs[i - 1];
 		if (g_strcmp0 (attr->key, "@comment") == 0 ||
 		    g_strcmp0 (attr->key, "@comment-tmp") == 0)
 			continue;
@@ -345,6 +548,45 @@ as_node_sort_children (GNode *first)
 		as_node_sort_children (first->next);
 }
 
+/**
+ * as_node_to_xml_start_tag:
+ **/
+static void
+as_node_to_xml_start_tag (GString *xml,
+			  guint depth_offset,
+			  const GNode *n,
+			  AsNodeToXmlFlags flags)
+{
+	AsNodeData *data = n->data;
+	guint depth = g_node_depth ((GNode *) n);
+	_cleanup_free_ gchar *attrs = NULL;
+
+	if ((flags & AS_NODE_TO_XML_FLAG_FORMAT_INDENT) > 0)
+		as_node_add_padding (xml, depth - depth_offset);
+	attrs = as_node_get_attr_string (data);
+	g_string_append_printf (xml, "<%s%s>", as_tag_data_get_name (data), attrs);
+	if ((flags & AS_NODE_TO_XML_FLAG_FORMAT_MULTILINE) > 0)
+		g_string_append (xml, "\n");
+}
+
+/**
+ * as_node_to_xml_end_tag:
+ **/
+static void
+as_node_to_xml_end_tag (GString *xml,
+			guint depth_offset,
+			const GNode *n,
+			AsNodeToXmlFlags flags)
+{
+	guint depth = g_node_depth ((GNode *) n);
+
+	if ((flags & AS_NODE_TO_XML_FLAG_FORMAT_INDENT) > 0)
+		as_node_add_padding (xml, depth - depth_offset);
+	g_string_append_printf (xml, "</%s>", as_tag_data_get_name (n->data));
+	if ((flags & AS_NODE_TO_XML_FLAG_FORMAT_MULTILINE) > 0)
+		g_string_append (xml, "\n");
+}
+
 /**
  * as_node_to_xml_string:
  **/
@@ -400,12 +642,9 @@ as_node_to_xml_string (GString *xml,
 			g_string_append_printf (xml, "<%s%s/>",
 						tag_str, attrs);
 		} else {
-			as_node_cdata_to_escaped (data);
-			g_string_append_printf (xml, "<%s%s>%s</%s>",
-						tag_str,
-						attrs,
-						data->cdata,
-						tag_str);
+			g_string_append_printf (xml, "<%s%s>", tag_str, attrs);
+			as_node_string_append_cdata (xml, data);
+			g_string_append_printf (xml, "</%s>", tag_str);
 		}
 		if ((flags & AS_NODE_TO_XML_FLAG_FORMAT_MULTILINE) > 0)
 			g_string_append (xml, "\n");
@@ -413,86 +652,169 @@ as_node_to_xml_string (GString *xml,
 
 	/* node with children */
 	} else {
-		if ((flags & AS_NODE_TO_XML_FLAG_FORMAT_INDENT) > 0)
-			as_node_add_padding (xml, depth - depth_offset);
-		attrs = as_node_get_attr_string (data);
-		tag_str = as_tag_data_get_name (data);
-		g_string_append_printf (xml, "<%s%s>", tag_str, attrs);
-		if ((flags & AS_NODE_TO_XML_FLAG_FORMAT_MULTILINE) > 0)
-			g_string_append (xml, "\n");
-		g_free (attrs);
+		as_node_to_xml_start_tag (xml, depth_offset, n, flags);
 		if ((flags & AS_NODE_TO_XML_FLAG_SORT_CHILDREN) > 0)
 			as_node_sort_children (n->children);
 		for (c = n->children; c != NULL; c = c->next)
 			as_node_to_xml_string (xml, depth_offset, c, flags);
-
-		if ((flags & AS_NODE_TO_XML_FLAG_FORMAT_INDENT) > 0)
-			as_node_add_padding (xml, depth - depth_offset);
-		g_string_append_printf (xml, "</%s>", tag_str);
-		if ((flags & AS_NODE_TO_XML_FLAG_FORMAT_MULTILINE) > 0)
-			g_string_append (xml, "\n");
+		as_node_to_xml_end_tag (xml, depth_offset, n, flags);
 	}
 }
 
 /**
- * as_node_reflow_text:
- * @text: XML text data
- * @text_len: length of @text
+ * as_node_to_xml_depth_offset:
+ **/
+static guint
+as_node_to_xml_depth_offset (const GNode *node)
+{
+	return g_node_depth (g_node_get_root ((GNode *) node)) + 1;
+}
+
+/**
+ * as_node_to_xml_start: (skip)
+ * @xml: a #GString
+ * @node: a #GNode with a parent
+ * @flags: the AsNodeToXmlFlags, e.g. %AS_NODE_TO_XML_FLAG_FORMAT_INDENT
  *
- * Converts pretty-formatted source text into a format suitable for AppStream.
- * This might include joining paragraphs, supressing newlines or doing other
- * sanity checks to the text.
+ * Appends just the opening tag of @node, formatted exactly as
+ * as_node_to_xml() would format it when called on the root node.
  *
- * Returns: (transfer full): a new string
+ * Together with as_node_to_xml_child() and as_node_to_xml_end() this allows
+ * very large documents to be written one child at a time.
+ **/
+void
+as_node_to_xml_start (GString *xml, const GNode *node, AsNodeToXmlFlags flags)
+{
+	as_node_to_xml_start_tag (xml, as_node_to_xml_depth_offset (node),
+				  node, flags);
+}
+
+/**
+ * as_node_to_xml_child: (skip)
+ * @xml: a #GString
+ * @node: a #GNode with a parent
+ * @flags: the AsNodeToXmlFlags, e.g. %AS_NODE_TO_XML_FLAG_FORMAT_INDENT
  *
- * Since: 0.1.4
+ * Appends @node and all its children, formatted exactly as as_node_to_xml()
+ * would format it when called on the root node.
  **/
-gchar *
-as_node_reflow_text (const gchar *text, gssize text_len)
+void
+as_node_to_xml_child (GString *xml, const GNode *node, AsNodeToXmlFlags flags)
 {
-	GString *tmp;
-	guint i;
+	as_node_to_xml_string (xml, as_node_to_xml_depth_offset (node),
+			       node, flags);
+}
+
+/**
+ * as_node_to_xml_end: (skip)
+ * @xml: a #GString
+ * @node: a #GNode with a parent
+ * @flags: the AsNodeToXmlFlags, e.g. %AS_NODE_TO_XML_FLAG_FORMAT_INDENT
+ *
+ * Appends just the closing tag of @node.
+ **/
+void
+as_node_to_xml_end (GString *xml, const GNode *node, AsNodeToXmlFlags flags)
+{
+	as_node_to_xml_end_tag (xml, as_node_to_xml_depth_offset (node),
+				node, flags);
+}
+
+/**
+ * as_node_reflow_text_to:
+ *
+ * Reflows the text in one pass without splitting it up into lines first.
+ * The output is never longer than the input, so @dest must have space for
+ * @text_len plus a NUL byte.
+ *
+ * Returns: the length of the text written to @dest
+ **/
+static gsize
+as_node_reflow_text_to (gchar *dest, const gchar *text, gsize text_len)
+{
+	const gchar *end = text + text_len;
+	const gchar *eol;
+	const gchar *line;
+	const gchar *start;
+	const gchar *stop;
+	gsize len = 0;
 	guint newline_count = 0;
-	_cleanup_strv_free_ gchar **split = NULL;
 
-	/* split the text into lines */
-	tmp = g_string_sized_new (text_len + 1);
-	split = g_strsplit (text, "\n", -1);
-	for (i = 0; split[i] != NULL; i++) {
+	for (line = text; line <= end; line = eol + 1) {
+		eol = memchr (line, '\n', (gsize) (end - line));
+		if (eol == NULL)
+			eol = end;
 
 		/* remove leading and trailing whitespace */
-		g_strstrip (split[i]);
+		start = line;
+		stop = eol;
+		while (start < stop && g_ascii_isspace (*start))
+			start++;
+		while (stop > start && g_ascii_isspace (stop[-1]))
+			stop--;
 
 		/* if this is a blank line we end the paragraph mode
 		 * and swallow the newline. If we see exactly two
 		 * newlines in sequence then do a paragraph break */
-		if (split[i][0] == '\0') {
+		if (start == stop) {
 			newline_count++;
 			continue;
 		}
 
 		/* if the line just before this one was not a newline
 		 * then seporate the words with a space */
-		if (newline_count == 1 && tmp->len > 0)
-			g_string_append (tmp, " ");
+		if (newline_count == 1 && len > 0)
+			dest[len++] = ' ';
 
 		/* if we had more than one newline in sequence add a paragraph
 		 * break */
-		if (newline_count > 1)
-			g_string_append (tmp, "\n\n");
+		if (newline_count > 1) {
+			dest[len++] = '\n';
+			dest[len++] = '\n';
+		}
 
 		/* add the actual stripped text */
-		g_string_append (tmp, split[i]);
+		memcpy (dest + len, start, (gsize) (stop - start));
+		len += (gsize) (stop - start);
 
 		/* this last section was paragraph */
 		newline_count = 1;
 	}
-	return g_string_free (tmp, FALSE);
+	dest[len] = '\0';
+	return len;
+}
+
+/**
+ * as_node_reflow_text:
+ * @text: XML text data
+ * @text_len: length of @text
+ *
+ * Converts pretty-formatted source text into a format suitable for AppStream.
+ * This might include joining paragraphs, supressing newlines or doing other
+ * sanity checks to the text.
+ *
+ * Returns: (transfer full): a new string
+ *
+ * Since: 0.1.4
+ **/
+gchar *
+as_node_reflow_text (const gchar *text, gssize text_len)
+{
+	gchar *tmp;
+	if (text_len < 0)
+		text_len = (gssize) strlen (text);
+	tmp = g_malloc (text_len + 1);
+	as_node_reflow_text_to (tmp, text, text_len);
+	return tmp;
 }
 
 typedef struct {
 	GNode			*current;
 	AsNodeFromXmlFlags	 flags;
+	guint			 depth;
+	guint			 split_depth;
+	AsNodeSplitFunc		 split_func;
+	gpointer		 split_data;
 } AsNodeToXmlHelper;
 
 /**
@@ -536,22 +858,50 @@ as_node_start_element_cb (GMarkupParseContext *context,
 			  GError **error)
 {
 	AsNodeToXmlHelper *helper = (AsNodeToXmlHelper *) user_data;
+	AsNodeArena *arena = ((AsNodeData *) helper->current->data)->arena;
 	AsNodeData *data;
 	GNode *current;
 	gchar *tmp;
 	guint i;
 
 	/* create the new node data */
-	data = g_slice_new0 (AsNodeData);
-	as_node_data_set_name (data, element_name, AS_NODE_INSERT_FLAG_NONE);
-	for (i = 0; attribute_names[i] != NULL; i++) {
-		as_node_attr_insert (data,
-				     attribute_names[i],
-				     attribute_values[i]);
+	if (arena != NULL) {
+		data = as_node_arena_alloc (arena, sizeof (AsNodeData));
+		data->arena = arena;
+		data->tag = as_tag_from_string (element_name);
+		if (data->tag == AS_TAG_UNKNOWN) {
+			data->name = as_node_arena_strndup (arena,
+							    element_name,
+							    strlen (element_name));
+		}
+		data->attrs_len = g_strv_length ((gchar **) attribute_names);
+		data->attrs_size = data->attrs_len;
+		data->attrs = as_node_arena_alloc (arena,
+						   data->attrs_len * sizeof (AsNodeAttr));
+		for (i = 0; i < data->attrs_len; i++) {
+			data->attrs[i].key = g_intern_string (attribute_names[i]);
+			data->attrs[i].value =
+				as_node_arena_strndup (arena,
+						       attribute_values[i],
+						       strlen (attribute_values[i]));
+		}
+	} else {
+		data = g_slice_new0 (AsNodeData);
+		as_node_data_set_name (data, element_name, AS_NODE_INSERT_FLAG_NONE);
+		for (i = 0; attribute_names[i] != NULL; i++) {
+			as_node_attr_insert (data,
+					     attribute_names[i],
+					     attribute_values[i]);
+		}
 	}
 
 	/* add the node to the DOM */
-	current = g_node_append_data (helper->current, data);
+	if (arena != NULL) {
+		current = as_node_arena_node_new (arena, data);
+		g_node_append (helper->current, current);
+	} else {
+		current = g_node_append_data (helper->current, data);
+	}
 
 	/* transfer the ownership of the comment to the new child */
 	tmp = as_node_take_attribute (helper->current, "@comment-tmp");
@@ -562,6 +912,7 @@ as_node_start_element_cb (GMarkupParseContext *context,
 
 	/* the child is now the node to be processed */
 	helper->current = current;
+	helper->depth++;
 }
 
 /**
@@ -574,7 +925,25 @@ as_node_end_element_cb (GMarkupParseContext *context,
 			GError             **error)
 {
 	AsNodeToXmlHelper *helper = (AsNodeToXmlHelper *) user_data;
-	helper->current = helper->current->parent;
+	GNode *node = helper->current;
+	gboolean split = FALSE;
+
+	helper->current = node->parent;
+
+	/* hand off the complete subtree and free it straight away; setting
+	 * the error stops the parser before any more elements are read */
+	if (helper->split_func != NULL && helper->depth == helper->split_depth) {
+		split = !helper->split_func (node, helper->split_data, error);
+		g_node_unlink (node);
+		as_node_unref (node);
+	}
+	helper->depth--;
+	if (split && *error == NULL) {
+		g_set_error_literal (error,
+				     AS_NODE_ERROR,
+				     AS_NODE_ERROR_FAILED,
+				     "Failed to process element");
+	}
 }
 
 /**
@@ -603,12 +972,26 @@ as_node_text_cb (GMarkupParseContext *context,
 	if (i >= text_len)
 		return;
 
-	/* split up into lines and add each with spaces stripped */
+	/* split up into lines and add each with spaces stripped, writing
+	 * straight into the final storage */
 	data = helper->current->data;
 	if ((helper->flags & AS_NODE_FROM_XML_FLAG_LITERAL_TEXT) > 0) {
-		data->cdata = g_strndup (text, text_len);
+		if (data->arena != NULL && !data->heap_strings) {
+			data->cdata = as_node_arena_strndup (data->arena,
+							     text, text_len);
+		} else {
+			data->cdata = g_strndup (text, text_len);
+		}
+		return;
+	}
+	if (data->arena != NULL && !data->heap_strings) {
+		gsize len;
+		data->cdata = as_node_arena_alloc (data->arena, text_len + 1);
+		len = as_node_reflow_text_to (data->cdata, text, text_len);
+		as_node_arena_trim (data->arena, data->cdata, text_len + 1, len + 1);
 	} else {
-		data->cdata = as_node_reflow_text (text, text_len);
+		data->cdata = g_malloc (text_len + 1);
+		as_node_reflow_text_to (data->cdata, text, text_len);
 	}
 }
 
@@ -663,23 +1046,29 @@ as_node_passthrough_cb (GMarkupParseContext *context,
 }
 
 /**
- * as_node_from_xml: (skip)
+ * as_node_from_xml_full:
  * @data: XML data
  * @data_len: Length of @data, or -1 if NULL terminated
  * @flags: #AsNodeFromXmlFlags, e.g. %AS_NODE_FROM_XML_FLAG_NONE
+ * @split_depth: the depth of the nodes to pass to @split_func, where 1 is the root
+ * @split_func: a #AsNodeSplitFunc, or %NULL
+ * @split_data: user data for @split_func
  * @error: A #GError or %NULL
  *
- * Parses XML data into a DOM tree.
+ * Parses XML data into a DOM tree, optionally handing each complete subtree
+ * at @split_depth to @split_func and then freeing it as soon as the closing
+ * tag has been parsed. This means the complete tree is never held in memory.
  *
  * Returns: (transfer none): A populated #GNode tree
- *
- * Since: 0.1.0
  **/
 GNode *
-as_node_from_xml (const gchar *data,
-		  gssize data_len,
-		  AsNodeFromXmlFlags flags,
-		  GError **error)
+as_node_from_xml_full (const gchar *data,
+		       gssize data_len,
+		       AsNodeFromXmlFlags flags,
+		       guint split_depth,
+		       AsNodeSplitFunc split_func,
+		       gpointer split_data,
+		       GError **error)
 {
 	AsNodeToXmlHelper helper;
 	GNode *root = NULL;
@@ -695,9 +1084,16 @@ as_node_from_xml (const gchar *data,
 
 	g_return_val_if_fail (data != NULL, FALSE);
 
-	root = as_node_new ();
+	if ((flags & AS_NODE_FROM_XML_FLAG_ARENA) > 0)
+		root = as_node_new_arena ();
+	else
+		root = as_node_new ();
 	helper.flags = flags;
 	helper.current = root;
+	helper.depth = 1;
+	helper.split_depth = split_depth;
+	helper.split_func = split_func;
+	helper.split_data = split_data;
 	ctx = g_markup_parse_context_new (&parser,
 					  G_MARKUP_PREFIX_ERROR_POSITION,
 					  &helper,
@@ -727,6 +1123,29 @@ as_node_from_xml (const gchar *data,
 	return root;
 }
 
+/**
+ * as_node_from_xml: (skip)
+ * @data: XML data
+ * @data_len: Length of @data, or -1 if NULL terminated
+ * @flags: #AsNodeFromXmlFlags, e.g. %AS_NODE_FROM_XML_FLAG_NONE
+ * @error: A #GError or %NULL
+ *
+ * Parses XML data into a DOM tree.
+ *
+ * Returns: (transfer none): A populated #GNode tree
+ *
+ * Since: 0.1.0
+ **/
+GNode *
+as_node_from_xml (const gchar *data,
+		  gssize data_len,
+		  AsNodeFromXmlFlags flags,
+		  GError **error)
+{
+	return as_node_from_xml_full (data, data_len, flags,
+				      0, NULL, NULL, error);
+}
+
 /**
  * as_node_to_file: (skip)
  * @root: A populated #GNode tree
@@ -762,23 +1181,29 @@ as_node_to_file (const GNode *root,
 }
 
 /**
- * as_node_from_file: (skip)
+ * as_node_from_file_full:
  * @file: file
  * @flags: #AsNodeFromXmlFlags, e.g. %AS_NODE_FROM_XML_FLAG_NONE
+ * @split_depth: the depth of the nodes to pass to @split_func, where 1 is the root
+ * @split_func: a #AsNodeSplitFunc, or %NULL
+ * @split_data: user data for @split_func
  * @cancellable: A #GCancellable, or %NULL
  * @error: A #GError or %NULL
  *
- * Parses an XML file into a DOM tree.
+ * Parses an XML file into a DOM tree, optionally handing each complete
+ * subtree at @split_depth to @split_func as described in
+ * as_node_from_xml_full().
  *
  * Returns: (transfer none): A populated #GNode tree
- *
- * Since: 0.1.0
  **/
 GNode *
-as_node_from_file (GFile *file,
-		   AsNodeFromXmlFlags flags,
-		   GCancellable *cancellable,
-		   GError **error)
+as_node_from_file_full (GFile *file,
+			AsNodeFromXmlFlags flags,
+			guint split_depth,
+			AsNodeSplitFunc split_func,
+			gpointer split_data,
+			GCancellable *cancellable,
+			GError **error)
 {
 	AsNodeToXmlHelper helper;
 	GError *error_local = NULL;
@@ -830,9 +1255,16 @@ as_node_from_file (GFile *file,
 	}
 
 	/* parse */
-	root = as_node_new ();
+	if ((flags & AS_NODE_FROM_XML_FLAG_ARENA) > 0)
+		root = as_node_new_arena ();
+	else
+		root = as_node_new ();
 	helper.flags = flags;
 	helper.current = root;
+	helper.depth = 1;
+	helper.split_depth = split_depth;
+	helper.split_func = split_func;
+	helper.split_data = split_data;
 	ctx = g_markup_parse_context_new (&parser,
 					  G_MARKUP_PREFIX_ERROR_POSITION,
 					  &helper,
@@ -875,6 +1307,29 @@ as_node_from_file (GFile *file,
 	return root;
 }
 
+/**
+ * as_node_from_file: (skip)
+ * @file: file
+ * @flags: #AsNodeFromXmlFlags, e.g. %AS_NODE_FROM_XML_FLAG_NONE
+ * @cancellable: A #GCancellable, or %NULL
+ * @error: A #GError or %NULL
+ *
+ * Parses an XML file into a DOM tree.
+ *
+ * Returns: (transfer none): A populated #GNode tree
+ *
+ * Since: 0.1.0
+ **/
+GNode *
+as_node_from_file (GFile *file,
+		   AsNodeFromXmlFlags flags,
+		   GCancellable *cancellable,
+		   GError **error)
+{
+	return as_node_from_file_full (file, flags, 0, NULL, NULL,
+				       cancellable, error);
+}
+
 /**
  * as_node_get_child_node:
  **/
@@ -949,6 +1404,7 @@ as_node_set_name (GNode *node, const gchar *name)
 		return;
 
 	/* overwrite */
+	as_node_data_detach (data);
 	g_free (data->name);
 	data->name = NULL;
 	as_node_data_set_name (data, name, AS_NODE_INSERT_FLAG_NONE);
@@ -1050,6 +1506,7 @@ as_node_set_data (GNode *node,
 		return;
 
 	data = (AsNodeData *) node->data;
+	as_node_data_detach (data);
 	g_free (data->cdata);
 	data->cdata = as_strndup (cdata, cdata_len);
 	data->cdata_escaped = insert_flags & AS_NODE_INSERT_FLAG_PRE_ESCAPED;
@@ -1095,6 +1552,10 @@ as_node_take_data (const GNode *node)
 	as_node_cdata_to_raw (data);
 	tmp = data->cdata;
 	data->cdata = NULL;
+
+	/* the arena still owns the memory */
+	if (data->arena != NULL && !data->heap_strings)
+		return g_strdup (tmp);
 	return tmp;
 }
 
@@ -1181,6 +1642,10 @@ as_node_take_attribute (const GNode *node, const gchar *key)
 		return NULL;
 	tmp = attr->value;
 	attr->value = NULL;
+
+	/* the arena still owns the memory */
+	if (data->arena != NULL && !data->heap_strings)
+		return g_strdup (tmp);
 	return tmp;
 }
 
@@ -1205,11 +1670,11 @@ as_node_remove_attribute (GNode *node, const gchar *key)
 	if (node->data == NULL)
 		return;
 	data = (AsNodeData *) node->data;
+	as_node_data_detach (data);
 	attr = as_node_attr_find (data, key);
 	if (attr == NULL)
 		return;
-	data->attrs = g_list_remove_all (data->attrs, attr);
-	as_node_attr_free (attr);
+	as_node_attr_remove (data, attr);
 }
 
 /**
@@ -1238,6 +1703,7 @@ as_node_add_attribute (GNode *node,
 	if (node->data == NULL)
 		return;
 	data = (AsNodeData *) node->data;
+	as_node_data_detach (data);
 	attr = as_node_attr_insert (data, key, NULL);
 	attr->value = as_strndup (value, value_len);
 }
@@ -1403,7 +1869,7 @@ as_node_insert (GNode *parent,
 	}
 	va_end (args);
 
-	return g_node_insert_data (parent, -1, data);
+	return as_node_insert_data (parent, data);
 }
 
 /**
@@ -1454,7 +1920,7 @@ as_node_insert_localized (GNode *parent,
 		data->cdata = g_strdup (value_c);
 		data->cdata_escaped = insert_flags & AS_NODE_INSERT_FLAG_PRE_ESCAPED;
 	}
-	g_node_insert_data (parent, -1, data);
+	as_node_insert_data (parent, data);
 
 	/* add the other localized values */
 	list = g_hash_table_get_keys (localized);
@@ -1477,7 +1943,7 @@ as_node_insert_localized (GNode *parent,
 			data->cdata = g_strdup (value);
 			data->cdata_escaped = insert_flags & AS_NODE_INSERT_FLAG_PRE_ESCAPED;
 		}
-		g_node_insert_data (parent, -1, data);
+		as_node_insert_data (parent, data);
 	}
 }
 
@@ -1525,7 +1991,7 @@ as_node_insert_hash (GNode *parent,
 			if (value != NULL && value[0] != '\0')
 				as_node_attr_insert (data, attr_key, value);
 		}
-		g_node_insert_data (parent, -1, data);
+		as_node_insert_data (parent, data);
 	}
 	g_list_free (list);
 }
@@ -1691,9 +2157,9 @@ as_node_get_localized_unwrap_type_li (const GNode *node,
 		 * already present */
 		if (g_strcmp0 (data->name, "p") == 0) {
 			str = as_node_denorm_get_str_for_lang (hash, data, TRUE);
-			as_node_cdata_to_escaped (data);
-			g_string_append_printf (str, "<p>%s</p>",
-						data->cdata);
+			g_string_append (str, "<p>");
+			as_node_string_append_cdata (str, data);
+			g_string_append (str, "</p>");
 
 		/* loop on the children */
 		} else if (g_strcmp0 (data->name, "ul") == 0 ||
@@ -1715,10 +2181,9 @@ as_node_get_localized_unwrap_type_li (const GNode *node,
 								data->name);
 				}
 				if (g_strcmp0 (data_c->name, "li") == 0) {
-					as_node_cdata_to_escaped (data_c);
-					g_string_append_printf (str,
-								"<li>%s</li>",
-								data_c->cdata);
+					g_string_append (str, "<li>");
+					as_node_string_append_cdata (str, data_c);
+					g_string_append (str, "</li>");
 				} else {
 					/* only <li> is valid in lists */
 					g_set_error (error,
@@ -1779,9 +2244,9 @@ as_node_get_localized_unwrap_type_ul (const GNode *node,
 		 * already present */
 		if (g_strcmp0 (data->name, "p") == 0) {
 			str = as_node_denorm_get_str_for_lang (hash, data, TRUE);
-			as_node_cdata_to_escaped (data);
-			g_string_append_printf (str, "<p>%s</p>",
-						data->cdata);
+			g_string_append (str, "<p>");
+			as_node_string_append_cdata (str, data);
+			g_string_append (str, "</p>");
 
 		/* loop on the children */
 		} else if (g_strcmp0 (data->name, "ul") == 0 ||
@@ -1791,10 +2256,9 @@ as_node_get_localized_unwrap_type_ul (const GNode *node,
 			for (tmp_c = tmp->children; tmp_c != NULL; tmp_c = tmp_c->next) {
 				data_c = tmp_c->data;
 				if (g_strcmp0 (data_c->name, "li") == 0) {
-					as_node_cdata_to_escaped (data_c);
-					g_string_append_printf (str,
-								"<li>%s</li>",
-								data_c->cdata);
+					g_string_append (str, "<li>");
+					as_node_string_append_cdata (str, data_c);
+					g_string_append (str, "</li>");
 				} else {
 					/* only <li> is valid in lists */
 					g_set_error (error,
@@ -42,6 +42,7 @@ G_BEGIN_DECLS
  * @AS_NODE_TO_XML_FLAG_FORMAT_INDENT:		Indent the XML by child depth
  * @AS_NODE_TO_XML_FLAG_INCLUDE_SIBLINGS:	Include the siblings when converting
  * @AS_NODE_TO_XML_FLAG_SORT_CHILDREN:		Sort the tags by alphabetical order
+ * @AS_NODE_TO_XML_FLAG_PARALLEL:		Generate independent children using threads
  *
  * The flags for converting to XML.
  **/
@@ -52,6 +53,7 @@ typedef enum {
 	AS_NODE_TO_XML_FLAG_FORMAT_INDENT	= 4,	/* Since: 0.1.0 */
 	AS_NODE_TO_XML_FLAG_INCLUDE_SIBLINGS	= 8,	/* Since: 0.1.4 */
 	AS_NODE_TO_XML_FLAG_SORT_CHILDREN	= 16,	/* Since: 0.2.1 */
+	AS_NODE_TO_XML_FLAG_PARALLEL		= 32,	/* Since: 0.3.3 */
 	/*< private >*/
 	AS_NODE_TO_XML_FLAG_LAST
 } AsNodeToXmlFlags;
@@ -61,6 +63,7 @@ typedef enum {
  * @AS_NODE_FROM_XML_FLAG_NONE:			No extra flags to use
  * @AS_NODE_FROM_XML_FLAG_LITERAL_TEXT:		Treat the text as an exact string
  * @AS_NODE_FROM_XML_FLAG_KEEP_COMMENTS:	Retain comments in the XML file
+ * @AS_NODE_FROM_XML_FLAG_ARENA:		Allocate the tree in one block, freeing it in one go
  *
  * The flags for converting from XML.
  **/
@@ -68,6 +71,7 @@ typedef enum {
 	AS_NODE_FROM_XML_FLAG_NONE		= 0,	/* Since: 0.1.0 */
 	AS_NODE_FROM_XML_FLAG_LITERAL_TEXT	= 1,	/* Since: 0.1.3 */
 	AS_NODE_FROM_XML_FLAG_KEEP_COMMENTS	= 2,	/* Since: 0.1.6 */
+	AS_NODE_FROM_XML_FLAG_ARENA		= 4,	/* Since: 0.3.3 */
 	/*< private >*/
 	AS_NODE_FROM_XML_FLAG_LAST
 } AsNodeFromXmlFlags;
@@ -40,6 +40,13 @@ gboolean	 as_provide_node_parse_dep11	(AsProvide	*provide,
 						 GNode		*node,
 						 GError		**error);
 
+#define AS_PROVIDE_VARIANT_TYPE		"(us)"
+
+GVariant	*as_provide_to_variant		(AsProvide	*provide);
+gboolean	 as_provide_variant_parse	(AsProvide	*provide,
+						 GVariant	*value,
+						 GError		**error);
+
 G_END_DECLS
 
 #endif /* __AS_PROVIDE_PRIVATE_H */
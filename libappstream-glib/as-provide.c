@@ -306,6 +306,51 @@ as_provide_node_parse (AsProvide *provide, GNode *node, GError **error)
 	return TRUE;
 }
 
+/**
+ * as_provide_to_variant: (skip)
+ * @provide: a #AsProvide instance.
+ *
+ * Converts the provide to a binary form used in caches.
+ *
+ * Returns: a floating #GVariant of type %AS_PROVIDE_VARIANT_TYPE
+ *
+ * Since: 0.3.3
+ **/
+GVariant *
+as_provide_to_variant (AsProvide *provide)
+{
+	AsProvidePrivate *priv = GET_PRIVATE (provide);
+	return g_variant_new (AS_PROVIDE_VARIANT_TYPE,
+			      priv->kind,
+			      priv->value != NULL ? priv->value : "");
+}
+
+/**
+ * as_provide_variant_parse: (skip)
+ * @provide: a #AsProvide instance.
+ * @value: a #GVariant of type %AS_PROVIDE_VARIANT_TYPE
+ * @error: A #GError or %NULL.
+ *
+ * Populates the object from a value created by as_provide_to_variant().
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 0.3.3
+ **/
+gboolean
+as_provide_variant_parse (AsProvide *provide, GVariant *value, GError **error)
+{
+	AsProvidePrivate *priv = GET_PRIVATE (provide);
+	const gchar *tmp;
+	guint32 kind;
+
+	g_variant_get (value, "(u&s)", &kind, &tmp);
+	priv->kind = kind;
+	g_free (priv->value);
+	priv->value = tmp[0] != '\0' ? g_strdup (tmp) : NULL;
+	return TRUE;
+}
+
 /**
  * as_provide_new:
  *
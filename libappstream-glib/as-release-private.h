@@ -37,6 +37,13 @@ gboolean	 as_release_node_parse		(AsRelease	*release,
 						 GNode		*node,
 						 GError		**error);
 
+#define AS_RELEASE_VARIANT_TYPE		"(sta{ss})"
+
+GVariant	*as_release_to_variant		(AsRelease	*release);
+gboolean	 as_release_variant_parse	(AsRelease	*release,
+						 GVariant	*value,
+						 GError		**error);
+
 G_END_DECLS
 
 #endif /* __AS_RELEASE_PRIVATE_H */
@@ -287,6 +287,57 @@ as_release_node_parse (AsRelease *release, GNode *node, GError **error)
 	return TRUE;
 }
 
+/**
+ * as_release_to_variant: (skip)
+ * @release: a #AsRelease instance.
+ *
+ * Converts the release to a binary form used in caches.
+ *
+ * Returns: a floating #GVariant of type %AS_RELEASE_VARIANT_TYPE
+ *
+ * Since: 0.3.3
+ **/
+GVariant *
+as_release_to_variant (AsRelease *release)
+{
+	AsReleasePrivate *priv = GET_PRIVATE (release);
+	return g_variant_new ("(st@a{ss})",
+			      priv->version != NULL ? priv->version : "",
+			      priv->timestamp,
+			      as_hash_to_variant (priv->descriptions));
+}
+
+/**
+ * as_release_variant_parse: (skip)
+ * @release: a #AsRelease instance.
+ * @value: a #GVariant of type %AS_RELEASE_VARIANT_TYPE
+ * @error: A #GError or %NULL.
+ *
+ * Populates the object from a value created by as_release_to_variant().
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 0.3.3
+ **/
+gboolean
+as_release_variant_parse (AsRelease *release, GVariant *value, GError **error)
+{
+	AsReleasePrivate *priv = GET_PRIVATE (release);
+	GVariantIter *iter;
+	const gchar *locale;
+	const gchar *tmp;
+	guint64 timestamp;
+
+	g_variant_get (value, "(&sta{ss})", &tmp, &timestamp, &iter);
+	g_free (priv->version);
+	priv->version = tmp[0] != '\0' ? g_strdup (tmp) : NULL;
+	priv->timestamp = timestamp;
+	while (g_variant_iter_next (iter, "{&s&s}", &locale, &tmp))
+		as_release_set_description (release, locale, tmp, -1);
+	g_variant_iter_free (iter);
+	return TRUE;
+}
+
 /**
  * as_release_new:
  *
@@ -28,6 +28,7 @@
 
 #include <glib-object.h>
 
+#include "as-image-private.h"
 #include "as-screenshot.h"
 
 G_BEGIN_DECLS
@@ -42,6 +43,13 @@ gboolean	 as_screenshot_node_parse_dep11	(AsScreenshot	*screenshot,
 						 GNode		*node,
 						 GError		**error);
 
+#define AS_SCREENSHOT_VARIANT_TYPE	"(uia{ss}a" AS_IMAGE_VARIANT_TYPE ")"
+
+GVariant	*as_screenshot_to_variant	(AsScreenshot	*screenshot);
+gboolean	 as_screenshot_variant_parse	(AsScreenshot	*screenshot,
+						 GVariant	*value,
+						 GError		**error);
+
 G_END_DECLS
 
 #endif /* __AS_SCREENSHOT_PRIVATE_H */
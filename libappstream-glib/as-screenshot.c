@@ -458,6 +458,86 @@ as_screenshot_node_parse (AsScreenshot *screenshot, GNode *node, GError **error)
 	return TRUE;
 }
 
+/**
+ * as_screenshot_to_variant: (skip)
+ * @screenshot: a #AsScreenshot instance.
+ *
+ * Converts the screenshot to a binary form used in caches.
+ *
+ * Returns: a floating #GVariant of type %AS_SCREENSHOT_VARIANT_TYPE
+ *
+ * Since: 0.3.3
+ **/
+GVariant *
+as_screenshot_to_variant (AsScreenshot *screenshot)
+{
+	AsImage *image;
+	AsScreenshotPrivate *priv = GET_PRIVATE (screenshot);
+	GVariantBuilder builder;
+	guint i;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a" AS_IMAGE_VARIANT_TYPE));
+	for (i = 0; i < priv->images->len; i++) {
+		image = g_ptr_array_index (priv->images, i);
+		g_variant_builder_add_value (&builder, as_image_to_variant (image));
+	}
+	return g_variant_new ("(ui@a{ss}@a" AS_IMAGE_VARIANT_TYPE ")",
+			      priv->kind,
+			      priv->priority,
+			      as_hash_to_variant (priv->captions),
+			      g_variant_builder_end (&builder));
+}
+
+/**
+ * as_screenshot_variant_parse: (skip)
+ * @screenshot: a #AsScreenshot instance.
+ * @value: a #GVariant of type %AS_SCREENSHOT_VARIANT_TYPE
+ * @error: A #GError or %NULL.
+ *
+ * Populates the object from a value created by as_screenshot_to_variant().
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 0.3.3
+ **/
+gboolean
+as_screenshot_variant_parse (AsScreenshot *screenshot,
+			     GVariant *value,
+			     GError **error)
+{
+	AsScreenshotPrivate *priv = GET_PRIVATE (screenshot);
+	GVariantIter iter;
+	const gchar *locale;
+	const gchar *tmp;
+	gint32 priority;
+	guint32 kind;
+	guint i;
+	_cleanup_variant_unref_ GVariant *captions = NULL;
+	_cleanup_variant_unref_ GVariant *images = NULL;
+
+	g_variant_get (value, "(ui@a{ss}@a" AS_IMAGE_VARIANT_TYPE ")",
+		       &kind, &priority, &captions, &images);
+	priv->kind = kind;
+	priv->priority = priority;
+
+	/* add captions */
+	g_variant_iter_init (&iter, captions);
+	while (g_variant_iter_next (&iter, "{&s&s}", &locale, &tmp))
+		as_screenshot_set_caption (screenshot, locale, tmp, -1);
+
+	/* add images */
+	for (i = 0; i < g_variant_n_children (images); i++) {
+		_cleanup_object_unref_ AsImage *image = NULL;
+		_cleanup_variant_unref_ GVariant *child = NULL;
+		child = g_variant_get_child_value (images, i);
+		image = as_image_new ();
+		if (!as_image_variant_parse (image, child, error))
+			return FALSE;
+		g_ptr_array_add (priv->images, g_object_ref (image));
+	}
+	return TRUE;
+}
+
 /**
  * as_screenshot_node_parse_dep11:
  * @screenshot: a #AsScreenshot instance.
@@ -22,7 +22,9 @@
 #include "config.h"
 
 #include <glib.h>
+#include <glib/gstdio.h>
 #include <stdlib.h>
+#include <utime.h>
 
 #include "as-app-private.h"
 #include "as-cleanup.h"
@@ -35,6 +37,7 @@
 #include "as-release-private.h"
 #include "as-screenshot-private.h"
 #include "as-store.h"
+#include "as-store-private.h"
 #include "as-tag.h"
 #include "as-utils-private.h"
 #include "as-yaml.h"
@@ -280,6 +283,47 @@ as_test_image_resize_filename (AsTestResize rz, const gchar *in, const gchar *ou
 	g_assert (ret);
 }
 
+static void
+as_test_image_sharpen_func (void)
+{
+	guchar *pixels;
+	gint rowstride;
+	gint x, y, c;
+	const guchar expected[4][18] = {
+		{   0,   0,   0,  11,  24,  39,  58,  71,  89,
+		  106, 119, 141, 156, 169, 195, 210, 223, 250 },
+		{  94, 107, 120, 146, 159, 173, 195, 208, 225,
+		  244, 255, 255, 255, 255,   0,   0,   0,   2 },
+		{ 227, 240, 253, 255, 255, 255,   0,   0,   0,
+		    0,  11,  30,  48,  61,  82, 100, 113, 136 },
+		{   0,   0,   5,  34,  47,  61,  86,  99, 114,
+		  136, 149, 166, 184, 197, 216, 236, 249, 255 } };
+	_cleanup_object_unref_ GdkPixbuf *pb = NULL;
+	_cleanup_object_unref_ GdkPixbuf *pb_other = NULL;
+
+	/* a gradient that wraps, so the edges get clamped */
+	pb = gdk_pixbuf_new (GDK_COLORSPACE_RGB, FALSE, 8, 6, 4);
+	pixels = gdk_pixbuf_get_pixels (pb);
+	rowstride = gdk_pixbuf_get_rowstride (pb);
+	for (y = 0; y < 4; y++) {
+		for (x = 0; x < 6; x++) {
+			for (c = 0; c < 3; c++)
+				pixels[y * rowstride + x * 3 + c] = (x * 37 + y * 91 + c * 13) & 0xff;
+		}
+	}
+
+	/* use a different amount first so the cached table is replaced */
+	pb_other = gdk_pixbuf_copy (pb);
+	as_pixbuf_sharpen (pb_other, 1, -0.2);
+
+	/* the output must not change when the implementation is optimized */
+	as_pixbuf_sharpen (pb, 1, -0.5);
+	for (y = 0; y < 4; y++) {
+		for (x = 0; x < 18; x++)
+			g_assert_cmpint (pixels[y * rowstride + x], ==, expected[y][x]);
+	}
+}
+
 static void
 as_test_image_alpha_func (void)
 {
@@ -1465,6 +1509,198 @@ as_test_node_func (void)
 	g_assert (n2 == NULL);
 }
 
+static gboolean
+as_test_node_split_cb (GNode *node, gpointer user_data, GError **error)
+{
+	GPtrArray *ids = (GPtrArray *) user_data;
+	GNode *n;
+
+	/* the parent is still available */
+	g_assert_cmpstr (as_node_get_name (node->parent), ==, "components");
+	n = as_node_find (node, "id");
+	g_assert (n != NULL);
+	g_ptr_array_add (ids, g_strdup (as_node_get_data (n)));
+	return TRUE;
+}
+
+static gboolean
+as_test_node_split_fail_cb (GNode *node, gpointer user_data, GError **error)
+{
+	guint *cnt = (guint *) user_data;
+	(*cnt)++;
+	g_set_error_literal (error, AS_NODE_ERROR, AS_NODE_ERROR_FAILED, "failed");
+	return FALSE;
+}
+
+static void
+as_test_node_arena_func (void)
+{
+	GError *error = NULL;
+	GNode *n;
+	GNode *root;
+	const gchar *xml = "<components version=\"0.6\" origin=\"test\">"
+			   "<component type=\"desktop\">"
+			   "<id>test.desktop</id>"
+			   "<name xml:lang=\"en_GB\">Colour &amp; Sound</name>"
+			   "<custom>unknown tag</custom>"
+			   "</component>"
+			   "</components>";
+	_cleanup_free_ gchar *taken = NULL;
+	_cleanup_node_unref_ GNode *root_heap = NULL;
+	_cleanup_string_free_ GString *str1 = NULL;
+	_cleanup_string_free_ GString *str2 = NULL;
+	_cleanup_string_free_ GString *str3 = NULL;
+
+	/* the arena tree is identical to one allocated normally */
+	root_heap = as_node_from_xml (xml, -1, AS_NODE_FROM_XML_FLAG_NONE, &error);
+	g_assert_no_error (error);
+	g_assert (root_heap != NULL);
+	root = as_node_from_xml (xml, -1, AS_NODE_FROM_XML_FLAG_ARENA, &error);
+	g_assert_no_error (error);
+	g_assert (root != NULL);
+	str1 = as_node_to_xml (root_heap, AS_NODE_TO_XML_FLAG_NONE);
+	str2 = as_node_to_xml (root, AS_NODE_TO_XML_FLAG_NONE);
+	g_assert_cmpstr (str1->str, ==, str2->str);
+	n = as_node_find (root, "components/component/custom");
+	g_assert (n != NULL);
+	g_assert_cmpstr (as_node_get_data (n), ==, "unknown tag");
+
+	/* taking data leaves the arena alone */
+	n = as_node_find (root, "components/component/id");
+	taken = as_node_take_data (n);
+	g_assert_cmpstr (taken, ==, "test.desktop");
+	g_assert (as_node_get_data (n) == NULL);
+
+	/* modify the tree after parsing */
+	n = as_node_find (root, "components/component");
+	as_node_add_attribute (n, "priority", "-1", -1);
+	as_node_remove_attribute (n, "type");
+	as_node_insert (n, "pkgname", "test", 0, NULL);
+	n = as_node_find (root, "components/component/name");
+	as_node_set_data (n, "Color", -1, 0);
+	str3 = as_node_to_xml (root, AS_NODE_TO_XML_FLAG_NONE);
+	g_assert_cmpstr (str3->str, ==,
+			 "<components origin=\"test\" version=\"0.6\">"
+			 "<component priority=\"-1\">"
+			 "<id/>"
+			 "<name xml:lang=\"en_GB\">Color</name>"
+			 "<custom>unknown tag</custom>"
+			 "<pkgname>test</pkgname>"
+			 "</component>"
+			 "</components>");
+	as_node_unref (root);
+}
+
+static void
+as_test_node_speed_func (void)
+{
+	GError *error = NULL;
+	GNode *apps;
+	GNode *id;
+	guint i;
+	guint loops = 10;
+	_cleanup_free_ gchar *filename = NULL;
+	_cleanup_object_unref_ GFile *file = NULL;
+	_cleanup_timer_destroy_ GTimer *timer = NULL;
+
+	/* parse and free a large catalog */
+	filename = as_test_get_filename ("example-v04.xml.gz");
+	file = g_file_new_for_path (filename);
+	timer = g_timer_new ();
+	for (i = 0; i < loops; i++) {
+		GNode *root;
+		root = as_node_from_file (file,
+					  AS_NODE_FROM_XML_FLAG_LITERAL_TEXT,
+					  NULL, &error);
+		g_assert_no_error (error);
+		g_assert (root != NULL);
+		apps = as_node_find (root, "applications");
+		g_assert (apps != NULL);
+		g_assert_cmpint (g_node_n_children (apps), ==, 1746);
+		id = as_node_find (root, "applications/application/id");
+		g_assert (id != NULL);
+		g_assert_cmpstr (as_node_get_attribute (id, "type"), ==, "webapp");
+		as_node_unref (root);
+	}
+	g_print ("%.0f ms: ", g_timer_elapsed (timer, NULL) * 1000 / loops);
+}
+
+static void
+as_test_node_attr_func (void)
+{
+	GError *error = NULL;
+	GNode *n;
+	_cleanup_free_ gchar *key = NULL;
+	_cleanup_node_unref_ GNode *root = NULL;
+
+	root = as_node_from_xml ("<id type=\"desktop\" kind=\"app\">x</id>", -1,
+				 AS_NODE_FROM_XML_FLAG_NONE, &error);
+	g_assert_no_error (error);
+	g_assert (root != NULL);
+	n = as_node_find (root, "id");
+	g_assert (n != NULL);
+
+	/* keys do not have to be interned by the caller */
+	key = g_strdup ("kind");
+	g_assert_cmpstr (as_node_get_attribute (n, key), ==, "app");
+	g_assert_cmpstr (as_node_get_attribute (n, "type"), ==, "desktop");
+	g_assert_cmpstr (as_node_get_attribute (n, "missing"), ==, NULL);
+
+	/* adding more attributes keeps the existing ones */
+	as_node_add_attribute (n, "a", "1", -1);
+	as_node_add_attribute (n, "b", "2", -1);
+	as_node_add_attribute_as_int (n, "c", 3);
+	g_assert_cmpstr (as_node_get_attribute (n, "type"), ==, "desktop");
+	g_assert_cmpstr (as_node_get_attribute (n, "b"), ==, "2");
+	g_assert_cmpint (as_node_get_attribute_as_int (n, "c"), ==, 3);
+
+	/* removing one does not disturb the others */
+	as_node_remove_attribute (n, key);
+	g_assert_cmpstr (as_node_get_attribute (n, "kind"), ==, NULL);
+	g_assert_cmpstr (as_node_get_attribute (n, "type"), ==, "desktop");
+	g_assert_cmpstr (as_node_get_attribute (n, "a"), ==, "1");
+	g_assert_cmpstr (as_node_get_attribute (n, "c"), ==, "3");
+}
+
+static void
+as_test_node_split_func (void)
+{
+	GError *error = NULL;
+	GNode *n;
+	const gchar *xml =
+		"<components origin=\"test\">"
+		"<component><id>one.desktop</id></component>"
+		"<component><id>two.desktop</id></component>"
+		"</components>";
+	guint cnt = 0;
+	_cleanup_node_unref_ GNode *root = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *ids = NULL;
+
+	/* a failure stops the parse straight away */
+	root = as_node_from_xml_full (xml, -1, AS_NODE_FROM_XML_FLAG_NONE,
+				      3, as_test_node_split_fail_cb, &cnt, &error);
+	g_assert_error (error, AS_NODE_ERROR, AS_NODE_ERROR_FAILED);
+	g_assert (root == NULL);
+	g_assert_cmpint (cnt, ==, 1);
+	g_clear_error (&error);
+
+	/* each component is handed off and then freed */
+	ids = g_ptr_array_new_with_free_func (g_free);
+	root = as_node_from_xml_full (xml, -1, AS_NODE_FROM_XML_FLAG_NONE,
+				      3, as_test_node_split_cb, ids, &error);
+	g_assert_no_error (error);
+	g_assert (root != NULL);
+	g_assert_cmpint (ids->len, ==, 2);
+	g_assert_cmpstr (g_ptr_array_index (ids, 0), ==, "one.desktop");
+	g_assert_cmpstr (g_ptr_array_index (ids, 1), ==, "two.desktop");
+
+	/* only the root node remains */
+	n = as_node_find (root, "components");
+	g_assert (n != NULL);
+	g_assert_cmpstr (as_node_get_attribute (n, "origin"), ==, "test");
+	g_assert (n->children == NULL);
+}
+
 static void
 as_test_node_xml_func (void)
 {
@@ -1537,6 +1773,20 @@ as_test_node_xml_func (void)
 	g_string_free (xml, TRUE);
 	as_node_unref (root);
 
+	/* escaped on output, unescaped only once */
+	root = as_node_new ();
+	n2 = as_node_insert (root, "a", "1 < 2 & 3 > 2", 0, NULL);
+	xml = as_node_to_xml (root, AS_NODE_TO_XML_FLAG_NONE);
+	g_assert_cmpstr (xml->str, ==, "<a>1 &lt; 2 &amp; 3 &gt; 2</a>");
+	g_string_free (xml, TRUE);
+	g_assert_cmpstr (as_node_get_data (n2), ==, "1 < 2 & 3 > 2");
+	n2 = as_node_insert (root, "b", "&amp;lt;", AS_NODE_INSERT_FLAG_PRE_ESCAPED, NULL);
+	xml = as_node_to_xml (n2, AS_NODE_TO_XML_FLAG_NONE);
+	g_assert_cmpstr (xml->str, ==, "<b>&amp;lt;</b>");
+	g_string_free (xml, TRUE);
+	g_assert_cmpstr (as_node_get_data (n2), ==, "&lt;");
+	as_node_unref (root);
+
 	/* keep comments */
 	root = as_node_from_xml (valid, -1,
 				 AS_NODE_FROM_XML_FLAG_KEEP_COMMENTS,
@@ -1768,6 +2018,100 @@ as_test_node_localized_wrap2_func (void)
 	g_assert_cmpstr (as_node_get_data (n1), ==, "Czesc");
 }
 
+static void
+as_test_app_intern_func (void)
+{
+	GList *keys1;
+	GList *keys2;
+	_cleanup_object_unref_ AsApp *app1 = NULL;
+	_cleanup_object_unref_ AsApp *app2 = NULL;
+	_cleanup_free_ gchar *category = NULL;
+
+	/* the same strings are shared between applications */
+	category = g_strdup ("AudioVideo");
+	app1 = as_app_new ();
+	as_app_add_category (app1, category, -1);
+	as_app_add_mimetype (app1, "text/plain", -1);
+	as_app_set_name (app1, "en-GB", "Colour", -1);
+	app2 = as_app_new ();
+	as_app_add_category (app2, "AudioVideoFoo", 10);
+	as_app_add_mimetype (app2, "text/plain", -1);
+	as_app_set_name (app2, "en_GB", "Color", -1);
+	g_assert (g_ptr_array_index (as_app_get_categories (app1), 0) !=
+		  (gpointer) category);
+	g_assert (g_ptr_array_index (as_app_get_categories (app1), 0) ==
+		  g_ptr_array_index (as_app_get_categories (app2), 0));
+	g_assert (g_ptr_array_index (as_app_get_mimetypes (app1), 0) ==
+		  g_ptr_array_index (as_app_get_mimetypes (app2), 0));
+	keys1 = g_hash_table_get_keys (as_app_get_names (app1));
+	keys2 = g_hash_table_get_keys (as_app_get_names (app2));
+	g_assert_cmpstr (keys1->data, ==, "en_GB");
+	g_assert (keys1->data == keys2->data);
+	g_list_free (keys1);
+	g_list_free (keys2);
+	g_assert_cmpstr (as_app_get_name (app2, "en_GB"), ==, "Color");
+
+	/* strings added by the caller are still freed with g_free() */
+	g_ptr_array_add (as_app_get_kudos (app1), g_strdup ("ModernToolkit"));
+	g_assert_cmpint (as_app_get_kudos (app1)->len, ==, 1);
+	g_ptr_array_set_size (as_app_get_categories (app2), 0);
+	g_assert_cmpstr (g_ptr_array_index (as_app_get_categories (app1), 0),
+			 ==, "AudioVideo");
+}
+
+static void
+as_test_app_intern_pool_func (void)
+{
+	GError *error = NULL;
+	gboolean ret;
+	guint refs;
+	guint refs_start;
+	guint strings;
+	guint strings_start;
+	AsApp *app1;
+	AsApp *app2;
+	AsStore *store;
+	_cleanup_free_ gchar *filename = NULL;
+	_cleanup_object_unref_ GFile *file = NULL;
+
+	as_app_intern_get_stats (&strings_start, &refs_start);
+
+	/* two apps share one copy of a string */
+	app1 = as_app_new ();
+	as_app_add_category (app1, "AsSelfTestCategory", -1);
+	app2 = as_app_new ();
+	as_app_add_category (app2, "AsSelfTestCategory", -1);
+	as_app_intern_get_stats (&strings, &refs);
+	g_assert_cmpint (strings, ==, strings_start + 1);
+	g_assert_cmpint (refs, ==, refs_start + 2);
+
+	/* and it is freed with the last of them */
+	g_object_unref (app1);
+	as_app_intern_get_stats (&strings, &refs);
+	g_assert_cmpint (strings, ==, strings_start + 1);
+	g_assert_cmpint (refs, ==, refs_start + 1);
+	g_object_unref (app2);
+	as_app_intern_get_stats (&strings, &refs);
+	g_assert_cmpint (strings, ==, strings_start);
+	g_assert_cmpint (refs, ==, refs_start);
+
+	/* a large catalog uses far fewer strings than references */
+	filename = as_test_get_filename ("example-v04.xml.gz");
+	file = g_file_new_for_path (filename);
+	store = as_store_new ();
+	ret = as_store_from_file (store, file, NULL, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	as_app_intern_get_stats (&strings, &refs);
+	g_assert_cmpint (refs - refs_start, >, 10 * (strings - strings_start));
+	g_print ("%u strings for %u refs: ",
+		 strings - strings_start, refs - refs_start);
+	g_object_unref (store);
+	as_app_intern_get_stats (&strings, &refs);
+	g_assert_cmpint (strings, ==, strings_start);
+	g_assert_cmpint (refs, ==, refs_start);
+}
+
 static void
 as_test_app_subsume_func (void)
 {
@@ -2409,104 +2753,786 @@ as_test_store_origin_func (void)
 }
 
 static void
-as_test_store_speed_appstream_func (void)
+as_test_store_truncated_func (void)
 {
 	GError *error = NULL;
 	gboolean ret;
-	guint i;
-	guint loops = 10;
-	_cleanup_free_ gchar *filename = NULL;
-	_cleanup_object_unref_ GFile *file = NULL;
-	_cleanup_timer_destroy_ GTimer *timer = NULL;
+	const gchar *xml =
+		"<components origin=\"test\" builder_id=\"test:1\" version=\"0.6\">"
+		"<component type=\"desktop\">"
+		"<id>one.desktop</id>"
+		"</component>"
+		"<component type=\"desktop\">"
+		"<id>two.des";
+	_cleanup_object_unref_ AsStore *store = NULL;
 
-	filename = as_test_get_filename ("example-v04.xml.gz");
-	file = g_file_new_for_path (filename);
-	timer = g_timer_new ();
-	for (i = 0; i < loops; i++) {
-		_cleanup_object_unref_ AsStore *store = NULL;
-		store = as_store_new ();
-		ret = as_store_from_file (store, file, NULL, NULL, &error);
-		g_assert_no_error (error);
-		g_assert (ret);
-		g_assert_cmpint (as_store_get_apps (store)->len, >=, 1415);
-		g_assert (as_store_get_app_by_id (store, "org.gnome.Software.desktop") != NULL);
-		g_assert (as_store_get_app_by_pkgname (store, "gnome-software") != NULL);
-	}
-	g_print ("%.0f ms: ", g_timer_elapsed (timer, NULL) * 1000 / loops);
+	/* nothing is added from a truncated document */
+	store = as_store_new ();
+	as_store_set_api_version (store, 0.8);
+	ret = as_store_from_xml (store, xml, -1, NULL, &error);
+	g_assert_error (error, AS_STORE_ERROR, AS_STORE_ERROR_FAILED);
+	g_assert (!ret);
+	g_clear_error (&error);
+	g_assert_cmpint (as_store_get_size (store), ==, 0);
+
+	/* and the root attributes are not used either */
+	g_assert_cmpstr (as_store_get_origin (store), ==, NULL);
+	g_assert_cmpstr (as_store_get_builder_id (store), ==, NULL);
+	g_assert_cmpfloat (as_store_get_api_version (store), >, 0.7);
+
+	/* an empty document still sets the root attributes once */
+	ret = as_store_from_xml (store, "<applications origin=\"legacy\"/>",
+				 -1, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpstr (as_store_get_origin (store), ==, "legacy");
+	g_assert_cmpint (as_store_get_size (store), ==, 0);
 }
 
 static void
-as_test_store_speed_appdata_func (void)
+as_test_store_to_file_func (void)
 {
+	AsNodeToXmlFlags flags = AS_NODE_TO_XML_FLAG_ADD_HEADER |
+				 AS_NODE_TO_XML_FLAG_FORMAT_INDENT |
+				 AS_NODE_TO_XML_FLAG_FORMAT_MULTILINE;
 	GError *error = NULL;
 	gboolean ret;
-	guint i;
-	guint loops = 10;
+	gsize len;
+	const gchar *fn_xml = "/tmp/as-self-test-to-file.xml";
+	const gchar *fn_gz = "/tmp/as-self-test-to-file.xml.gz";
+	_cleanup_free_ gchar *data = NULL;
 	_cleanup_free_ gchar *filename = NULL;
-	_cleanup_timer_destroy_ GTimer *timer = NULL;
+	_cleanup_object_unref_ AsStore *store = NULL;
+	_cleanup_object_unref_ AsStore *store_gz = NULL;
+	_cleanup_object_unref_ GFile *file = NULL;
+	_cleanup_object_unref_ GFile *file_gz = NULL;
+	_cleanup_object_unref_ GFile *file_xml = NULL;
+	_cleanup_string_free_ GString *xml = NULL;
+	_cleanup_string_free_ GString *xml_gz = NULL;
 
-	filename = as_test_get_filename (".");
-	timer = g_timer_new ();
-	for (i = 0; i < loops; i++) {
-		_cleanup_object_unref_ AsStore *store = NULL;
-		store = as_store_new ();
-		as_store_set_destdir (store, filename);
-		g_test_expect_message (G_LOG_DOMAIN,
-				       G_LOG_LEVEL_WARNING,
-				       "ignoring description '*' from */broken.appdata.xml: Unknown tag '_p'");
-		ret = as_store_load (store, AS_STORE_LOAD_FLAG_APPDATA, NULL, &error);
-		g_assert_no_error (error);
-		g_assert (ret);
-		g_assert_cmpint (as_store_get_apps (store)->len, >, 0);
-	}
-	g_print ("%.0f ms: ", g_timer_elapsed (timer, NULL) * 1000 / loops);
+	/* load a file to the store */
+	store = as_store_new ();
+	filename = as_test_get_filename ("example-v04.xml.gz");
+	file = g_file_new_for_path (filename);
+	ret = as_store_from_file (store, file, NULL, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* the streamed file is identical to the in-memory XML */
+	file_xml = g_file_new_for_path (fn_xml);
+	ret = as_store_to_file (store, file_xml, flags, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	ret = g_file_get_contents (fn_xml, &data, &len, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	xml = as_store_to_xml (store, flags);
+	g_assert_cmpint (len, ==, xml->len);
+	g_assert_cmpstr (data, ==, xml->str);
+
+	/* and the compressed file loads back the same */
+	file_gz = g_file_new_for_path (fn_gz);
+	ret = as_store_to_file (store, file_gz, flags, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	store_gz = as_store_new ();
+	ret = as_store_from_file (store_gz, file_gz, NULL, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	xml_gz = as_store_to_xml (store_gz, flags);
+	g_assert_cmpstr (xml_gz->str, ==, xml->str);
+
+	g_unlink (fn_xml);
+	g_unlink (fn_gz);
 }
 
 static void
-as_test_store_speed_desktop_func (void)
+as_test_store_to_xml_parallel_func (void)
 {
+	AsNodeToXmlFlags flags = AS_NODE_TO_XML_FLAG_ADD_HEADER |
+				 AS_NODE_TO_XML_FLAG_FORMAT_INDENT |
+				 AS_NODE_TO_XML_FLAG_FORMAT_MULTILINE;
 	GError *error = NULL;
 	gboolean ret;
 	guint i;
-	guint loops = 10;
+	gdouble versions[] = { 0.1, 0.6, 0.8, 0.0 };
+	const gchar *fn_parallel = "/tmp/as-self-test-parallel.xml";
+	const gchar *fn_serial = "/tmp/as-self-test-serial.xml";
+	_cleanup_free_ gchar *data_parallel = NULL;
+	_cleanup_free_ gchar *data_serial = NULL;
 	_cleanup_free_ gchar *filename = NULL;
-	_cleanup_timer_destroy_ GTimer *timer = NULL;
+	_cleanup_object_unref_ AsStore *store = NULL;
+	_cleanup_object_unref_ GFile *file = NULL;
+	_cleanup_object_unref_ GFile *file_parallel = NULL;
+	_cleanup_object_unref_ GFile *file_serial = NULL;
 
-	filename = as_test_get_filename (".");
-	timer = g_timer_new ();
-	for (i = 0; i < loops; i++) {
-		_cleanup_object_unref_ AsStore *store = NULL;
-		store = as_store_new ();
-		as_store_set_destdir (store, filename);
-		ret = as_store_load (store, AS_STORE_LOAD_FLAG_DESKTOP, NULL, &error);
-		g_assert_no_error (error);
-		g_assert (ret);
-		g_assert_cmpint (as_store_get_apps (store)->len, >, 0);
+	/* load a catalog large enough to need several batches */
+	store = as_store_new ();
+	filename = as_test_get_filename ("example-v04.xml.gz");
+	file = g_file_new_for_path (filename);
+	ret = as_store_from_file (store, file, NULL, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (as_store_get_size (store), >, 256 * 2);
+
+	/* the output is identical to the serial output */
+	for (i = 0; versions[i] > 0.f; i++) {
+		_cleanup_string_free_ GString *xml = NULL;
+		_cleanup_string_free_ GString *xml_parallel = NULL;
+		as_store_set_api_version (store, versions[i]);
+		xml = as_store_to_xml (store, flags);
+		xml_parallel = as_store_to_xml (store, flags | AS_NODE_TO_XML_FLAG_PARALLEL);
+		g_assert_cmpstr (xml_parallel->str, ==, xml->str);
 	}
-	g_print ("%.0f ms: ", g_timer_elapsed (timer, NULL) * 1000 / loops);
+
+	/* and also when streamed to a file one batch at a time */
+	file_serial = g_file_new_for_path (fn_serial);
+	ret = as_store_to_file (store, file_serial, flags, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	file_parallel = g_file_new_for_path (fn_parallel);
+	ret = as_store_to_file (store, file_parallel,
+				flags | AS_NODE_TO_XML_FLAG_PARALLEL,
+				NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	ret = g_file_get_contents (fn_serial, &data_serial, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	ret = g_file_get_contents (fn_parallel, &data_parallel, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpstr (data_parallel, ==, data_serial);
+
+	g_unlink (fn_serial);
+	g_unlink (fn_parallel);
 }
 
 static void
-as_test_utils_overlap_func (void)
+as_test_store_parallel_func (void)
 {
-	gchar *tmp;
+	GError *error = NULL;
+	gboolean ret;
+	const gchar *destdir = "/tmp/as-self-test-parallel";
+	const gchar *xml1 =
+		"<components origin=\"aaa\" version=\"0.7\" builder_id=\"test\">"
+		"<component type=\"desktop\">"
+		"<id>shared.desktop</id>"
+		"<pkgname>shared-aaa</pkgname>"
+		"</component>"
+		"<component type=\"desktop\">"
+		"<id>one.desktop</id>"
+		"</component>"
+		"</components>";
+	const gchar *xml2 =
+		"<components origin=\"bbb\" version=\"0.7\">"
+		"<component type=\"desktop\" priority=\"5\">"
+		"<id>shared.desktop</id>"
+		"<pkgname>shared-bbb</pkgname>"
+		"</component>"
+		"<component type=\"desktop\">"
+		"<id>two.desktop</id>"
+		"</component>"
+		"</components>";
+	_cleanup_free_ gchar *fn1 = NULL;
+	_cleanup_free_ gchar *fn2 = NULL;
+	_cleanup_free_ gchar *path = NULL;
+	_cleanup_object_unref_ AsStore *store1 = NULL;
+	_cleanup_object_unref_ AsStore *store2 = NULL;
+	_cleanup_string_free_ GString *str1 = NULL;
+	_cleanup_string_free_ GString *str2 = NULL;
+
+	/* create a fake per-user app-info directory with two files */
+	path = g_build_filename (destdir, g_get_user_data_dir (),
+				 "app-info", "xmls", NULL);
+	g_assert_cmpint (g_mkdir_with_parents (path, 0700), ==, 0);
+	fn1 = g_build_filename (path, "aaa.xml", NULL);
+	ret = g_file_set_contents (fn1, xml1, -1, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	fn2 = g_build_filename (path, "bbb.xml", NULL);
+	ret = g_file_set_contents (fn2, xml2, -1, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
 
-	/* same */
-	tmp = as_utils_get_string_overlap ("dave.ttf", "dave.ttf");
-	g_assert_cmpstr (tmp, ==, "dave.ttf");
-	g_free (tmp);
+	/* load one after the other */
+	store1 = as_store_new ();
+	as_store_set_destdir (store1, destdir);
+	ret = as_store_load (store1, AS_STORE_LOAD_FLAG_APP_INFO_USER, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (as_store_get_size (store1), ==, 3);
+
+	/* load using threads */
+	store2 = as_store_new ();
+	as_store_set_destdir (store2, destdir);
+	ret = as_store_load (store2,
+			     AS_STORE_LOAD_FLAG_APP_INFO_USER |
+			     AS_STORE_LOAD_FLAG_PARALLEL,
+			     NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (as_store_get_size (store2), ==, 3);
+	g_assert_cmpstr (as_store_get_origin (store2), ==, as_store_get_origin (store1));
+	g_assert_cmpstr (as_store_get_builder_id (store2), ==, "test");
+	g_assert_cmpstr (as_store_get_builder_id (store2), ==, as_store_get_builder_id (store1));
+	g_assert_cmpfloat (as_store_get_api_version (store2), ==, as_store_get_api_version (store1));
+
+	/* the higher priority application always wins */
+	g_assert (as_store_get_app_by_pkgname (store2, "shared-bbb") != NULL);
+
+	/* both ways give exactly the same result */
+	str1 = as_store_to_xml (store1, AS_NODE_TO_XML_FLAG_NONE);
+	str2 = as_store_to_xml (store2, AS_NODE_TO_XML_FLAG_NONE);
+	g_assert_cmpstr (str1->str, ==, str2->str);
+
+	/* loading again reuses the same thread pool */
+	ret = as_store_load (store2,
+			     AS_STORE_LOAD_FLAG_APP_INFO_USER |
+			     AS_STORE_LOAD_FLAG_PARALLEL,
+			     NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (as_store_get_size (store2), ==, 3);
 
-	/* only prefix */
-	tmp = as_utils_get_string_overlap ("dave.ttf", "daniel.doc");
-	g_assert_cmpstr (tmp, ==, "da");
-	g_free (tmp);
+	g_unlink (fn1);
+	g_unlink (fn2);
+}
 
-	/* only suffix */
-	tmp = as_utils_get_string_overlap ("dave.ttf", "sara.ttf");
-	g_assert_cmpstr (tmp, ==, ".ttf");
-	g_free (tmp);
+static void
+as_test_store_reload_app_cb (AsStore *store, AsApp *app, guint *cnt)
+{
+	(*cnt)++;
+}
 
-	/* different */
+static void
+as_test_store_reload_func (void)
+{
+	AsApp *app;
+	GError *error = NULL;
+	gboolean ret;
+	guint cnt_added = 0;
+	guint cnt_changed = 0;
+	guint cnt_removed = 0;
+	const gchar *fn = "/tmp/as-self-test-reload.xml";
+	const gchar *xml1 =
+		"<components origin=\"test\" version=\"0.7\">"
+		"<component type=\"desktop\">"
+		"<id>keep.desktop</id>"
+		"<pkgname>keep</pkgname>"
+		"</component>"
+		"<component type=\"desktop\">"
+		"<id>change.desktop</id>"
+		"<name>Old</name>"
+		"</component>"
+		"<component type=\"desktop\">"
+		"<id>remove.desktop</id>"
+		"<pkgname>remove</pkgname>"
+		"</component>"
+		"</components>";
+	const gchar *xml2 =
+		"<components origin=\"test\" version=\"0.7\">"
+		"<component type=\"desktop\">"
+		"<id>keep.desktop</id>"
+		"<pkgname>keep</pkgname>"
+		"</component>"
+		"<component type=\"desktop\">"
+		"<id>change.desktop</id>"
+		"<name>New</name>"
+		"</component>"
+		"<component type=\"desktop\">"
+		"<id>add.desktop</id>"
+		"</component>"
+		"</components>";
+	_cleanup_object_unref_ AsApp *app_keep = NULL;
+	_cleanup_object_unref_ AsStore *store = NULL;
+	_cleanup_object_unref_ GFile *file = NULL;
+
+	/* load the original file */
+	ret = g_file_set_contents (fn, xml1, -1, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	store = as_store_new ();
+	g_signal_connect (store, "app-added",
+			  G_CALLBACK (as_test_store_reload_app_cb), &cnt_added);
+	g_signal_connect (store, "app-changed",
+			  G_CALLBACK (as_test_store_reload_app_cb), &cnt_changed);
+	g_signal_connect (store, "app-removed",
+			  G_CALLBACK (as_test_store_reload_app_cb), &cnt_removed);
+	file = g_file_new_for_path (fn);
+	ret = as_store_from_file (store, file, NULL, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (as_store_get_size (store), ==, 3);
+	app_keep = g_object_ref (as_store_get_app_by_id (store, "keep.desktop"));
+	g_assert_cmpstr (as_app_get_source_file (app_keep), ==, fn);
+
+	/* reload just this file */
+	ret = g_file_set_contents (fn, xml2, -1, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	ret = as_store_reload_file (store, fn, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (cnt_added, ==, 1);
+	g_assert_cmpint (cnt_changed, ==, 1);
+	g_assert_cmpint (cnt_removed, ==, 1);
+	g_assert_cmpint (as_store_get_size (store), ==, 3);
+	g_assert (as_store_get_app_by_id (store, "keep.desktop") == app_keep);
+	g_assert (as_store_get_app_by_id (store, "remove.desktop") == NULL);
+	g_assert (as_store_get_app_by_pkgname (store, "remove") == NULL);
+	app = as_store_get_app_by_id (store, "change.desktop");
+	g_assert (app != NULL);
+	g_assert_cmpstr (as_app_get_name (app, NULL), ==, "New");
+
+	/* deleting the file removes everything it provided */
+	g_unlink (fn);
+	ret = as_store_reload_file (store, fn, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (cnt_removed, ==, 4);
+	g_assert_cmpint (as_store_get_size (store), ==, 0);
+}
+
+static void
+as_test_store_reload_shadowed_func (void)
+{
+	AsApp *app;
+	GError *error = NULL;
+	gboolean ret;
+	guint cnt_changed = 0;
+	guint cnt_removed = 0;
+	const gchar *xml_low =
+		"<components origin=\"test\" version=\"0.7\">"
+		"<component type=\"desktop\">"
+		"<id>shared.desktop</id>"
+		"<name>Low</name>"
+		"</component>"
+		"</components>";
+	const gchar *xml_high =
+		"<components origin=\"test\" version=\"0.7\">"
+		"<component type=\"desktop\" priority=\"5\">"
+		"<id>shared.desktop</id>"
+		"<name>High</name>"
+		"</component>"
+		"</components>";
+	const gchar *xml_empty =
+		"<components origin=\"test\" version=\"0.7\"/>";
+	const gchar *xml_other =
+		"<components origin=\"test\" version=\"0.7\">"
+		"<component type=\"desktop\">"
+		"<id>other.desktop</id>"
+		"</component>"
+		"</components>";
+	_cleanup_free_ gchar *fn_high = NULL;
+	_cleanup_free_ gchar *fn_low = NULL;
+	_cleanup_free_ gchar *fn_other = NULL;
+	_cleanup_free_ gchar *tmpdir = NULL;
+	_cleanup_object_unref_ AsStore *store = NULL;
+	_cleanup_object_unref_ GFile *file_high = NULL;
+	_cleanup_object_unref_ GFile *file_low = NULL;
+	_cleanup_object_unref_ GFile *file_other = NULL;
+
+	/* two files provide the same ID */
+	tmpdir = g_dir_make_tmp ("as-self-test-XXXXXX", &error);
+	g_assert_no_error (error);
+	g_assert (tmpdir != NULL);
+	fn_low = g_build_filename (tmpdir, "low.xml", NULL);
+	fn_high = g_build_filename (tmpdir, "high.xml", NULL);
+	fn_other = g_build_filename (tmpdir, "other.xml", NULL);
+	ret = g_file_set_contents (fn_low, xml_low, -1, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	ret = g_file_set_contents (fn_high, xml_high, -1, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	ret = g_file_set_contents (fn_other, xml_other, -1, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	store = as_store_new ();
+	g_signal_connect (store, "app-changed",
+			  G_CALLBACK (as_test_store_reload_app_cb), &cnt_changed);
+	g_signal_connect (store, "app-removed",
+			  G_CALLBACK (as_test_store_reload_app_cb), &cnt_removed);
+	file_low = g_file_new_for_path (fn_low);
+	ret = as_store_from_file (store, file_low, NULL, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	file_high = g_file_new_for_path (fn_high);
+	ret = as_store_from_file (store, file_high, NULL, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	file_other = g_file_new_for_path (fn_other);
+	ret = as_store_from_file (store, file_other, NULL, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	app = as_store_get_app_by_id (store, "shared.desktop");
+	g_assert (app != NULL);
+	g_assert_cmpstr (as_app_get_name (app, NULL), ==, "High");
+
+	/* a file that never provided the ID is not parsed again */
+	ret = g_file_set_contents (fn_other, "<components>", -1, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* removing the preferred version restores the other one */
+	ret = g_file_set_contents (fn_high, xml_empty, -1, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	ret = as_store_reload_file (store, fn_high, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (cnt_changed, ==, 1);
+	g_assert_cmpint (cnt_removed, ==, 0);
+	app = as_store_get_app_by_id (store, "shared.desktop");
+	g_assert (app != NULL);
+	g_assert_cmpstr (as_app_get_name (app, NULL), ==, "Low");
+	g_assert_cmpstr (as_app_get_source_file (app), ==, fn_low);
+
+	g_assert_cmpint (g_unlink (fn_low), ==, 0);
+	g_assert_cmpint (g_unlink (fn_high), ==, 0);
+	g_assert_cmpint (g_unlink (fn_other), ==, 0);
+	g_assert_cmpint (g_rmdir (tmpdir), ==, 0);
+}
+
+static void
+as_test_store_cache_func (void)
+{
+	AsApp *app;
+	GError *error = NULL;
+	gboolean ret;
+	guint i;
+	struct utimbuf buf = { 1000000000, 1000000000 };
+	const gchar *categories[] = { "Network", "Science", "NotGoingToExist", NULL };
+	const gchar *mimetypes[] = { "application/atom+xml", "text/plain", NULL };
+	const gchar *xml =
+		"<components origin=\"test\" version=\"0.7\">"
+		"<component type=\"desktop\">"
+		"<id>test.desktop</id>"
+		"</component>"
+		"</components>";
+	const gchar *xml_changed =
+		"<components origin=\"test\" version=\"0.7\">"
+		"<component type=\"desktop\">"
+		"<id>changed.desktop</id>"
+		"</component>"
+		"</components>";
+	_cleanup_free_ gchar *filename = NULL;
+	_cleanup_free_ gchar *fn_cache = NULL;
+	_cleanup_free_ gchar *fn_xml = NULL;
+	_cleanup_free_ gchar *tmpdir = NULL;
+	_cleanup_object_unref_ AsStore *store = NULL;
+	_cleanup_object_unref_ AsStore *store_lookup = NULL;
+	_cleanup_object_unref_ AsStore *store_cache = NULL;
+	_cleanup_object_unref_ AsStore *store_stale = NULL;
+	_cleanup_object_unref_ GFile *file = NULL;
+	_cleanup_object_unref_ GFile *file_cache = NULL;
+	_cleanup_object_unref_ GFile *file_xml = NULL;
+	_cleanup_string_free_ GString *str1 = NULL;
+	_cleanup_string_free_ GString *str2 = NULL;
+
+	tmpdir = g_dir_make_tmp ("as-self-test-XXXXXX", &error);
+	g_assert_no_error (error);
+	g_assert (tmpdir != NULL);
+	fn_cache = g_build_filename (tmpdir, "as-self-test.cache", NULL);
+	fn_xml = g_build_filename (tmpdir, "as-self-test-cache.xml", NULL);
+
+	/* load the test catalog and save a cache */
+	store = as_store_new ();
+	filename = as_test_get_filename ("example-v04.xml.gz");
+	file = g_file_new_for_path (filename);
+	ret = as_store_from_file (store, file, NULL, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	file_cache = g_file_new_for_path (fn_cache);
+	ret = as_store_to_cache (store, file_cache, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* load it back, creating applications on demand */
+	store_cache = as_store_new ();
+	ret = as_store_from_cache (store_cache, file_cache, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (as_store_get_size (store_cache), ==, as_store_get_size (store));
+	g_assert_cmpstr (as_store_get_origin (store_cache), ==, as_store_get_origin (store));
+	app = as_store_get_app_by_id (store_cache, "org.gnome.Software.desktop");
+	g_assert (app != NULL);
+	g_assert_cmpstr (as_app_get_pkgname_default (app), ==, "gnome-software");
+	g_assert_cmpint (as_app_get_source_kind (app), ==, AS_APP_SOURCE_KIND_APPSTREAM);
+	g_assert (as_store_get_app_by_id (store_cache, "not-going-to-exist.desktop") == NULL);
+	g_assert_cmpint (as_store_get_apps (store_cache)->len, ==, as_store_get_size (store));
+
+	/* the lookups use the saved indexes without creating everything */
+	store_lookup = as_store_new ();
+	ret = as_store_from_cache (store_lookup, file_cache, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	app = as_store_get_app_by_pkgname (store_lookup, "gnome-software");
+	g_assert (app != NULL);
+	g_assert_cmpstr (as_app_get_id (app), ==, "org.gnome.Software.desktop");
+	g_assert (as_store_get_app_by_pkgname (store_lookup, "not-going-to-exist") == NULL);
+	for (i = 0; categories[i] != NULL; i++) {
+		_cleanup_ptrarray_unref_ GPtrArray *apps1 = NULL;
+		_cleanup_ptrarray_unref_ GPtrArray *apps2 = NULL;
+		apps1 = as_store_get_apps_by_category (store, categories[i]);
+		apps2 = as_store_get_apps_by_category (store_lookup, categories[i]);
+		g_assert_cmpint (apps1->len, ==, apps2->len);
+	}
+	for (i = 0; mimetypes[i] != NULL; i++) {
+		_cleanup_ptrarray_unref_ GPtrArray *apps1 = NULL;
+		_cleanup_ptrarray_unref_ GPtrArray *apps2 = NULL;
+		apps1 = as_store_get_apps_by_mimetype (store, mimetypes[i]);
+		apps2 = as_store_get_apps_by_mimetype (store_lookup, mimetypes[i]);
+		g_assert_cmpint (apps1->len, ==, apps2->len);
+	}
+	g_assert_cmpint (as_store_get_size (store_lookup), ==, as_store_get_size (store));
+
+	/* check it marshals back to the same XML */
+	str1 = as_store_to_xml (store, AS_NODE_TO_XML_FLAG_NONE);
+	str2 = as_store_to_xml (store_cache, AS_NODE_TO_XML_FLAG_NONE);
+	g_assert_cmpstr (str1->str, ==, str2->str);
+
+	/* a cache is invalid when the source file changes, even if the
+	 * modification time is the same to the second */
+	ret = g_file_set_contents (fn_xml, xml, -1, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (g_utime (fn_xml, &buf), ==, 0);
+	file_xml = g_file_new_for_path (fn_xml);
+	as_store_remove_all (store);
+	ret = as_store_from_file (store, file_xml, NULL, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	ret = as_store_to_cache (store, file_cache, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	ret = g_file_set_contents (fn_xml, xml_changed, -1, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (g_utime (fn_xml, &buf), ==, 0);
+	store_stale = as_store_new ();
+	ret = as_store_from_cache (store_stale, file_cache, NULL, &error);
+	g_assert_error (error, AS_STORE_ERROR, AS_STORE_ERROR_FAILED);
+	g_assert (!ret);
+	g_clear_error (&error);
+
+	/* clean up */
+	g_assert_cmpint (g_unlink (fn_xml), ==, 0);
+	g_assert_cmpint (g_unlink (fn_cache), ==, 0);
+	g_assert_cmpint (g_rmdir (tmpdir), ==, 0);
+}
+
+static void
+as_test_store_search_func (void)
+{
+	AsApp *app;
+	GError *error = NULL;
+	GPtrArray *apps;
+	gboolean ret;
+	guint i;
+	guint j;
+	const gchar *searches[] = { "gnome", "soft", "xml", "gnome package",
+				    "nomatchesever", NULL };
+	const gchar *search_removed[] = { "software", NULL };
+	_cleanup_free_ gchar *filename = NULL;
+	_cleanup_object_unref_ AsStore *store = NULL;
+	_cleanup_object_unref_ GFile *file = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *results_removed = NULL;
+
+	/* load the test catalog */
+	store = as_store_new ();
+	filename = as_test_get_filename ("example-v04.xml.gz");
+	file = g_file_new_for_path (filename);
+	ret = as_store_from_file (store, file, NULL, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* the index must agree with the slow path */
+	apps = as_store_get_apps (store);
+	for (i = 0; searches[i] != NULL; i++) {
+		guint last_score = G_MAXUINT;
+		guint matches = 0;
+		_cleanup_ptrarray_unref_ GPtrArray *results = NULL;
+		_cleanup_strv_free_ gchar **terms = NULL;
+
+		terms = g_strsplit (searches[i], " ", -1);
+		results = as_store_search (store, terms);
+		for (j = 0; j < apps->len; j++) {
+			app = g_ptr_array_index (apps, j);
+			if (as_app_search_matches_all (app, terms) > 0)
+				matches++;
+		}
+		g_assert_cmpint (results->len, ==, matches);
+
+		/* best results first */
+		for (j = 0; j < results->len; j++) {
+			guint score;
+			app = g_ptr_array_index (results, j);
+			score = as_app_search_matches_all (app, terms);
+			g_assert_cmpint (score, >, 0);
+			g_assert_cmpint (score, <=, last_score);
+			last_score = score;
+		}
+	}
+
+	/* the index is rebuilt when the store changes */
+	app = as_store_get_app_by_id (store, "org.gnome.Software.desktop");
+	g_assert (app != NULL);
+	g_object_ref (app);
+	as_store_remove_app (store, app);
+	results_removed = as_store_search (store, (gchar **) search_removed);
+	for (j = 0; j < results_removed->len; j++)
+		g_assert (g_ptr_array_index (results_removed, j) != app);
+	g_object_unref (app);
+}
+
+static void
+as_test_store_speed_appstream_func (void)
+{
+	GError *error = NULL;
+	gboolean ret;
+	guint i;
+	guint loops = 10;
+	_cleanup_free_ gchar *filename = NULL;
+	_cleanup_object_unref_ GFile *file = NULL;
+	_cleanup_timer_destroy_ GTimer *timer = NULL;
+
+	filename = as_test_get_filename ("example-v04.xml.gz");
+	file = g_file_new_for_path (filename);
+	timer = g_timer_new ();
+	for (i = 0; i < loops; i++) {
+		_cleanup_object_unref_ AsStore *store = NULL;
+		store = as_store_new ();
+		ret = as_store_from_file (store, file, NULL, NULL, &error);
+		g_assert_no_error (error);
+		g_assert (ret);
+		g_assert_cmpint (as_store_get_apps (store)->len, >=, 1415);
+		g_assert (as_store_get_app_by_id (store, "org.gnome.Software.desktop") != NULL);
+		g_assert (as_store_get_app_by_pkgname (store, "gnome-software") != NULL);
+	}
+	g_print ("%.0f ms: ", g_timer_elapsed (timer, NULL) * 1000 / loops);
+}
+
+static void
+as_test_store_speed_appdata_func (void)
+{
+	GError *error = NULL;
+	gboolean ret;
+	guint i;
+	guint loops = 10;
+	_cleanup_free_ gchar *filename = NULL;
+	_cleanup_timer_destroy_ GTimer *timer = NULL;
+
+	filename = as_test_get_filename (".");
+	timer = g_timer_new ();
+	for (i = 0; i < loops; i++) {
+		_cleanup_object_unref_ AsStore *store = NULL;
+		store = as_store_new ();
+		as_store_set_destdir (store, filename);
+		g_test_expect_message (G_LOG_DOMAIN,
+				       G_LOG_LEVEL_WARNING,
+				       "ignoring description '*' from */broken.appdata.xml: Unknown tag '_p'");
+		ret = as_store_load (store, AS_STORE_LOAD_FLAG_APPDATA, NULL, &error);
+		g_assert_no_error (error);
+		g_assert (ret);
+		g_assert_cmpint (as_store_get_apps (store)->len, >, 0);
+	}
+	g_print ("%.0f ms: ", g_timer_elapsed (timer, NULL) * 1000 / loops);
+}
+
+static void
+as_test_store_speed_desktop_func (void)
+{
+	GError *error = NULL;
+	gboolean ret;
+	guint i;
+	guint loops = 10;
+	_cleanup_free_ gchar *filename = NULL;
+	_cleanup_timer_destroy_ GTimer *timer = NULL;
+
+	filename = as_test_get_filename (".");
+	timer = g_timer_new ();
+	for (i = 0; i < loops; i++) {
+		_cleanup_object_unref_ AsStore *store = NULL;
+		store = as_store_new ();
+		as_store_set_destdir (store, filename);
+		ret = as_store_load (store, AS_STORE_LOAD_FLAG_DESKTOP, NULL, &error);
+		g_assert_no_error (error);
+		g_assert (ret);
+		g_assert_cmpint (as_store_get_apps (store)->len, >, 0);
+	}
+	g_print ("%.0f ms: ", g_timer_elapsed (timer, NULL) * 1000 / loops);
+}
+
+static void
+as_test_store_speed_to_xml_func (void)
+{
+	AsNodeToXmlFlags flags = AS_NODE_TO_XML_FLAG_ADD_HEADER |
+				 AS_NODE_TO_XML_FLAG_FORMAT_INDENT |
+				 AS_NODE_TO_XML_FLAG_FORMAT_MULTILINE;
+	GError *error = NULL;
+	gboolean ret;
+	gdouble elapsed_parallel;
+	gdouble elapsed_serial;
+	gsize len = 0;
+	guint i;
+	guint loops = 10;
+	_cleanup_free_ gchar *filename = NULL;
+	_cleanup_object_unref_ AsStore *store = NULL;
+	_cleanup_object_unref_ GFile *file = NULL;
+	_cleanup_timer_destroy_ GTimer *timer = NULL;
+
+	filename = as_test_get_filename ("example-v04.xml.gz");
+	file = g_file_new_for_path (filename);
+	store = as_store_new ();
+	ret = as_store_from_file (store, file, NULL, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* serial */
+	timer = g_timer_new ();
+	for (i = 0; i < loops; i++) {
+		_cleanup_string_free_ GString *xml = NULL;
+		xml = as_store_to_xml (store, flags);
+		g_assert_cmpint (xml->len, >, 0);
+		len = xml->len;
+	}
+	elapsed_serial = g_timer_elapsed (timer, NULL) * 1000 / loops;
+
+	/* parallel, which has to produce exactly the same amount of XML */
+	g_timer_reset (timer);
+	for (i = 0; i < loops; i++) {
+		_cleanup_string_free_ GString *xml = NULL;
+		xml = as_store_to_xml (store, flags | AS_NODE_TO_XML_FLAG_PARALLEL);
+		g_assert_cmpint (xml->len, ==, len);
+	}
+	elapsed_parallel = g_timer_elapsed (timer, NULL) * 1000 / loops;
+	g_print ("%.0f ms serial, %.0f ms parallel on %u CPUs: ",
+		 elapsed_serial, elapsed_parallel, g_get_num_processors ());
+}
+
+static void
+as_test_utils_overlap_func (void)
+{
+	gchar *tmp;
+
+	/* same */
+	tmp = as_utils_get_string_overlap ("dave.ttf", "dave.ttf");
+	g_assert_cmpstr (tmp, ==, "dave.ttf");
+	g_free (tmp);
+
+	/* only prefix */
+	tmp = as_utils_get_string_overlap ("dave.ttf", "daniel.doc");
+	g_assert_cmpstr (tmp, ==, "da");
+	g_free (tmp);
+
+	/* only suffix */
+	tmp = as_utils_get_string_overlap ("dave.ttf", "sara.ttf");
+	g_assert_cmpstr (tmp, ==, ".ttf");
+	g_free (tmp);
+
+	/* different */
 	tmp = as_utils_get_string_overlap ("dave.ttf", "bob.doc");
 	g_assert_cmpstr (tmp, ==, NULL);
 	g_free (tmp);
@@ -2584,6 +3610,59 @@ as_test_utils_icons_func (void)
 	g_clear_error (&error);
 }
 
+static void
+as_test_utils_icon_index_func (void)
+{
+	AsUtilsIconIndex *idx;
+	GError *error = NULL;
+	guint i;
+	const gchar *names[] = { "test.png", "test", "test2.png", "test2",
+				 "test3", "/usr/share/pixmaps/test.png", NULL };
+	_cleanup_free_ gchar *destdir = NULL;
+	_cleanup_free_ gchar *tmp = NULL;
+
+	destdir = as_test_get_filename (".");
+	idx = as_utils_icon_index_new (destdir);
+
+	/* the same results as searching the filesystem directly */
+	for (i = 0; names[i] != NULL; i++) {
+		_cleanup_free_ gchar *fn = NULL;
+		_cleanup_free_ gchar *fn_hidpi = NULL;
+		_cleanup_free_ gchar *fn_idx = NULL;
+		_cleanup_free_ gchar *fn_idx_hidpi = NULL;
+		fn = as_utils_find_icon_filename_full (destdir, names[i],
+						       AS_UTILS_FIND_ICON_NONE,
+						       NULL);
+		fn_idx = as_utils_find_icon_filename_index (idx, names[i],
+							    AS_UTILS_FIND_ICON_NONE,
+							    NULL);
+		g_assert_cmpstr (fn_idx, ==, fn);
+		fn_hidpi = as_utils_find_icon_filename_full (destdir, names[i],
+							     AS_UTILS_FIND_ICON_HI_DPI,
+							     NULL);
+		fn_idx_hidpi = as_utils_find_icon_filename_index (idx, names[i],
+								  AS_UTILS_FIND_ICON_HI_DPI,
+								  NULL);
+		g_assert_cmpstr (fn_idx_hidpi, ==, fn_hidpi);
+	}
+
+	/* theme icon */
+	tmp = as_utils_find_icon_filename_index (idx, "test2",
+						 AS_UTILS_FIND_ICON_NONE,
+						 &error);
+	g_assert_no_error (error);
+	g_assert (g_str_has_suffix (tmp, "/hicolor/64x64/apps/test2.png"));
+
+	/* all invalid */
+	g_assert (as_utils_find_icon_filename_index (idx, "not-going-to-exist.png",
+						     AS_UTILS_FIND_ICON_NONE,
+						     &error) == NULL);
+	g_assert_error (error, AS_APP_ERROR, AS_APP_ERROR_FAILED);
+	g_clear_error (&error);
+
+	as_utils_icon_index_free (idx);
+}
+
 static void
 as_test_utils_spdx_token_func (void)
 {
@@ -2711,7 +3790,11 @@ as_test_utils_func (void)
 	/* blacklist */
 	g_assert (as_utils_is_blacklisted_id ("gnome-system-monitor-kde.desktop"));
 	g_assert (as_utils_is_blacklisted_id ("doom-*-demo.desktop"));
+	g_assert (as_utils_is_blacklisted_id ("system-config-printer.desktop"));
+	g_assert (as_utils_is_blacklisted_id ("exo-web-browser"));
+	g_assert (!as_utils_is_blacklisted_id ("exo-web-browser.desktop"));
 	g_assert (!as_utils_is_blacklisted_id ("gimp.desktop"));
+	g_assert (!as_utils_is_blacklisted_id (NULL));
 
 	/* valid description markup */
 	tmp = as_markup_convert_simple ("<p>Hello world!</p>", -1, &error);
@@ -2806,6 +3889,7 @@ as_test_store_metadata_func (void)
 static void
 as_test_store_metadata_index_func (void)
 {
+	AsApp *app_tmp;
 	GPtrArray *apps;
 	const guint repeats = 10000;
 	guint i;
@@ -2836,6 +3920,246 @@ as_test_store_metadata_index_func (void)
 	}
 	g_assert_cmpfloat (g_timer_elapsed (timer, NULL), <, 0.5);
 	g_print ("%.0fms: ", g_timer_elapsed (timer, NULL) * 1000);
+
+	/* the index is updated in place when apps are removed or changed */
+	as_store_remove_app_by_id (store, "app-00000");
+	app_tmp = as_store_get_app_by_id (store, "app-00001");
+	g_assert (app_tmp != NULL);
+	as_app_add_metadata (app_tmp, "X-CacheID", "dave.x86_64", -1);
+	apps = as_store_get_apps_by_metadata (store, "X-CacheID", "dave.i386");
+	g_assert_cmpint (apps->len, ==, repeats - 2);
+	g_ptr_array_unref (apps);
+	apps = as_store_get_apps_by_metadata (store, "X-CacheID", "dave.x86_64");
+	g_assert_cmpint (apps->len, ==, 1);
+	g_ptr_array_unref (apps);
+	as_app_remove_metadata (app_tmp, "X-CacheID");
+	apps = as_store_get_apps_by_metadata (store, "X-CacheID", "dave.x86_64");
+	g_assert_cmpint (apps->len, ==, 0);
+	g_ptr_array_unref (apps);
+}
+
+static void
+as_test_store_locale_filter_func (void)
+{
+	AsApp *app;
+	GError *error = NULL;
+	gboolean ret;
+	const gchar *locales[] = { "de_DE.UTF-8", NULL };
+	const gchar *xml =
+		"<components version=\"0.6\">"
+		"<component type=\"desktop\">"
+		"<id>test.desktop</id>"
+		"<name>Test</name>"
+		"<name xml:lang=\"de\">Pruefung</name>"
+		"<name xml:lang=\"de_DE\">Pruefung</name>"
+		"<name xml:lang=\"fr\">Essai</name>"
+		"<description><p>Text</p></description>"
+		"<description xml:lang=\"fr\"><p>Texte</p></description>"
+		"<keywords>"
+		"<keyword>test</keyword>"
+		"<keyword xml:lang=\"fr\">essai</keyword>"
+		"</keywords>"
+		"</component>"
+		"</components>";
+	_cleanup_object_unref_ AsStore *store = NULL;
+
+	store = as_store_new ();
+	as_store_set_locale_filter (store, locales);
+	ret = as_store_from_xml (store, xml, -1, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* only the requested locale and the fallbacks are kept */
+	app = as_store_get_app_by_id (store, "test.desktop");
+	g_assert (app != NULL);
+	g_assert_cmpint (g_hash_table_size (as_app_get_names (app)), ==, 3);
+	g_assert_cmpstr (as_app_get_name (app, "de"), ==, "Pruefung");
+	g_assert_cmpstr (as_app_get_name (app, "fr"), ==, NULL);
+	g_assert_cmpint (g_hash_table_size (as_app_get_descriptions (app)), ==, 1);
+	g_assert (as_app_get_keywords (app, "fr") == NULL);
+
+	/* the filter only applies when parsing */
+	as_app_set_name (app, "fr", "Essai", -1);
+	g_assert_cmpstr (as_app_get_name (app, "fr"), ==, "Essai");
+}
+
+static void
+as_test_store_locale_filter_parallel_func (void)
+{
+	AsApp *app;
+	GError *error = NULL;
+	gboolean ret;
+	guint i;
+	const gchar *destdir = "/tmp/as-self-test-locale-parallel";
+	const gchar *locales[] = { "de_DE.UTF-8", NULL };
+	const gchar *xml1 =
+		"<components origin=\"aaa\" version=\"0.7\">"
+		"<component type=\"desktop\">"
+		"<id>one.desktop</id>"
+		"<name>One</name>"
+		"<name xml:lang=\"de\">Eins</name>"
+		"<name xml:lang=\"fr\">Un</name>"
+		"</component>"
+		"</components>";
+	const gchar *xml2 =
+		"<components origin=\"bbb\" version=\"0.7\">"
+		"<component type=\"desktop\">"
+		"<id>two.desktop</id>"
+		"<name>Two</name>"
+		"<name xml:lang=\"de_DE\">Zwei</name>"
+		"<name xml:lang=\"fr\">Deux</name>"
+		"</component>"
+		"</components>";
+	_cleanup_free_ gchar *fn1 = NULL;
+	_cleanup_free_ gchar *fn2 = NULL;
+	_cleanup_free_ gchar *path = NULL;
+	_cleanup_object_unref_ AsStore *store1 = NULL;
+	_cleanup_object_unref_ AsStore *store2 = NULL;
+	_cleanup_string_free_ GString *str1 = NULL;
+	_cleanup_string_free_ GString *str2 = NULL;
+
+	/* create a fake per-user app-info directory with two files */
+	path = g_build_filename (destdir, g_get_user_data_dir (),
+				 "app-info", "xmls", NULL);
+	g_assert_cmpint (g_mkdir_with_parents (path, 0700), ==, 0);
+	fn1 = g_build_filename (path, "aaa.xml", NULL);
+	ret = g_file_set_contents (fn1, xml1, -1, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	fn2 = g_build_filename (path, "bbb.xml", NULL);
+	ret = g_file_set_contents (fn2, xml2, -1, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* load one after the other */
+	store1 = as_store_new ();
+	as_store_set_destdir (store1, destdir);
+	as_store_set_locale_filter (store1, locales);
+	ret = as_store_load (store1, AS_STORE_LOAD_FLAG_APP_INFO_USER, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* load using threads, where each file is parsed into its own store */
+	store2 = as_store_new ();
+	as_store_set_destdir (store2, destdir);
+	as_store_set_locale_filter (store2, locales);
+	ret = as_store_load (store2,
+			     AS_STORE_LOAD_FLAG_APP_INFO_USER |
+			     AS_STORE_LOAD_FLAG_PARALLEL,
+			     NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (as_store_get_size (store2), ==, 2);
+
+	/* the filter was used for every file */
+	for (i = 0; i < 2; i++) {
+		const gchar *id = i == 0 ? "one.desktop" : "two.desktop";
+		app = as_store_get_app_by_id (store2, id);
+		g_assert (app != NULL);
+		g_assert_cmpint (g_hash_table_size (as_app_get_names (app)), ==, 2);
+		g_assert_cmpstr (as_app_get_name (app, "fr"), ==, NULL);
+	}
+	app = as_store_get_app_by_id (store2, "one.desktop");
+	g_assert_cmpstr (as_app_get_name (app, "de"), ==, "Eins");
+	app = as_store_get_app_by_id (store2, "two.desktop");
+	g_assert_cmpstr (as_app_get_name (app, "de_DE"), ==, "Zwei");
+
+	/* both ways give exactly the same result */
+	str1 = as_store_to_xml (store1, AS_NODE_TO_XML_FLAG_NONE);
+	str2 = as_store_to_xml (store2, AS_NODE_TO_XML_FLAG_NONE);
+	g_assert_cmpstr (str1->str, ==, str2->str);
+
+	g_unlink (fn1);
+	g_unlink (fn2);
+}
+
+static void
+as_test_store_reverse_index_func (void)
+{
+	AsApp *app;
+	GError *error = NULL;
+	GPtrArray *apps;
+	gboolean ret;
+	const gchar *xml =
+		"<components version=\"0.6\">"
+		"<component type=\"desktop\">"
+		"<id>eog.desktop</id>"
+		"<categories><category>Graphics</category></categories>"
+		"<mimetypes><mimetype>image/png</mimetype></mimetypes>"
+		"<provides><binary>eog</binary><binary>eog</binary></provides>"
+		"</component>"
+		"<component type=\"desktop\">"
+		"<id>gimp.desktop</id>"
+		"<categories><category>Graphics</category></categories>"
+		"<mimetypes><mimetype>image/png</mimetype></mimetypes>"
+		"</component>"
+		"<component type=\"desktop\">"
+		"<id>eog-compat.desktop</id>"
+		"<provides><binary>eog</binary></provides>"
+		"</component>"
+		"</components>";
+	_cleanup_object_unref_ AsStore *store = NULL;
+	_cleanup_object_unref_ AsApp *app_new = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *apps_old = NULL;
+
+	store = as_store_new ();
+	ret = as_store_from_xml (store, xml, -1, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* build the indexes */
+	apps = as_store_get_apps_by_mimetype (store, "image/png");
+	g_assert_cmpint (apps->len, ==, 2);
+	g_ptr_array_unref (apps);
+	apps = as_store_get_apps_by_category (store, "Graphics");
+	g_assert_cmpint (apps->len, ==, 2);
+	g_ptr_array_unref (apps);
+	apps = as_store_get_apps_by_provide (store, AS_PROVIDE_KIND_BINARY, "eog");
+	g_assert_cmpint (apps->len, ==, 2);
+	app = g_ptr_array_index (apps, 0);
+	g_assert_cmpstr (as_app_get_id (app), ==, "eog.desktop");
+	g_ptr_array_unref (apps);
+	apps = as_store_get_apps_by_provide (store, AS_PROVIDE_KIND_LIBRARY, "eog");
+	g_assert_cmpint (apps->len, ==, 0);
+	g_ptr_array_unref (apps);
+
+	/* removing an app updates the indexes but not the returned arrays */
+	apps_old = as_store_get_apps_by_mimetype (store, "image/png");
+	as_store_remove_app_by_id (store, "gimp.desktop");
+	apps = as_store_get_apps_by_mimetype (store, "image/png");
+	g_assert_cmpint (apps->len, ==, 1);
+	g_assert_cmpint (apps_old->len, ==, 2);
+	g_ptr_array_unref (apps);
+
+	/* adding and merging apps updates the indexes */
+	app_new = as_app_new ();
+	as_app_set_id (app_new, "eog.desktop", -1);
+	as_app_add_mimetype (app_new, "image/jpeg", -1);
+	as_store_add_app (store, app_new);
+	apps = as_store_get_apps_by_mimetype (store, "image/jpeg");
+	g_assert_cmpint (apps->len, ==, 1);
+	g_ptr_array_unref (apps);
+	apps = as_store_get_apps_by_category (store, "Graphics");
+	g_assert_cmpint (apps->len, ==, 1);
+	g_ptr_array_unref (apps);
+
+	/* merging again does not add the app twice */
+	as_store_add_app (store, app_new);
+	apps = as_store_get_apps_by_mimetype (store, "image/jpeg");
+	g_assert_cmpint (apps->len, ==, 1);
+	g_ptr_array_unref (apps);
+
+	/* removing the app takes it out of every index it was in, once
+	 * for the repeated provide that another app shares */
+	as_store_remove_app_by_id (store, "eog.desktop");
+	apps = as_store_get_apps_by_mimetype (store, "image/jpeg");
+	g_assert_cmpint (apps->len, ==, 0);
+	g_ptr_array_unref (apps);
+	apps = as_store_get_apps_by_provide (store, AS_PROVIDE_KIND_BINARY, "eog");
+	g_assert_cmpint (apps->len, ==, 1);
+	app = g_ptr_array_index (apps, 0);
+	g_assert_cmpstr (as_app_get_id (app), ==, "eog-compat.desktop");
+	g_ptr_array_unref (apps);
 }
 
 static void
@@ -3063,6 +4387,7 @@ main (int argc, char **argv)
 	g_test_add_func ("/AppStream/icon{embedded}", as_test_icon_embedded_func);
 	g_test_add_func ("/AppStream/image", as_test_image_func);
 	g_test_add_func ("/AppStream/image{resize}", as_test_image_resize_func);
+	g_test_add_func ("/AppStream/image{sharpen}", as_test_image_sharpen_func);
 	g_test_add_func ("/AppStream/image{alpha}", as_test_image_alpha_func);
 	g_test_add_func ("/AppStream/screenshot", as_test_screenshot_func);
 	g_test_add_func ("/AppStream/app", as_test_app_func);
@@ -3076,10 +4401,16 @@ main (int argc, char **argv)
 	g_test_add_func ("/AppStream/app{parse-file}", as_test_app_parse_file_func);
 	g_test_add_func ("/AppStream/app{no-markup}", as_test_app_no_markup_func);
 	g_test_add_func ("/AppStream/app{subsume}", as_test_app_subsume_func);
+	g_test_add_func ("/AppStream/app{intern}", as_test_app_intern_func);
+	g_test_add_func ("/AppStream/app{intern-pool}", as_test_app_intern_pool_func);
 	g_test_add_func ("/AppStream/app{search}", as_test_app_search_func);
 	g_test_add_func ("/AppStream/node", as_test_node_func);
 	g_test_add_func ("/AppStream/node{reflow}", as_test_node_reflow_text_func);
 	g_test_add_func ("/AppStream/node{xml}", as_test_node_xml_func);
+	g_test_add_func ("/AppStream/node{split}", as_test_node_split_func);
+	g_test_add_func ("/AppStream/node{arena}", as_test_node_arena_func);
+	g_test_add_func ("/AppStream/node{attr}", as_test_node_attr_func);
+	g_test_add_func ("/AppStream/node{speed}", as_test_node_speed_func);
 	g_test_add_func ("/AppStream/node{hash}", as_test_node_hash_func);
 	g_test_add_func ("/AppStream/node{no-dup-c}", as_test_node_no_dup_c_func);
 	g_test_add_func ("/AppStream/node{localized}", as_test_node_localized_func);
@@ -3090,6 +4421,7 @@ main (int argc, char **argv)
 	g_test_add_func ("/AppStream/utils", as_test_utils_func);
 	g_test_add_func ("/AppStream/utils{overlap}", as_test_utils_overlap_func);
 	g_test_add_func ("/AppStream/utils{icons}", as_test_utils_icons_func);
+	g_test_add_func ("/AppStream/utils{icon-index}", as_test_utils_icon_index_func);
 	g_test_add_func ("/AppStream/utils{spdx-token}", as_test_utils_spdx_token_func);
 	g_test_add_func ("/AppStream/yaml", as_test_yaml_func);
 	g_test_add_func ("/AppStream/store", as_test_store_func);
@@ -3099,10 +4431,21 @@ main (int argc, char **argv)
 	g_test_add_func ("/AppStream/store{addons}", as_test_store_addons_func);
 	g_test_add_func ("/AppStream/store{versions}", as_test_store_versions_func);
 	g_test_add_func ("/AppStream/store{origin}", as_test_store_origin_func);
+	g_test_add_func ("/AppStream/store{truncated}", as_test_store_truncated_func);
+	g_test_add_func ("/AppStream/store{to-file}", as_test_store_to_file_func);
+	g_test_add_func ("/AppStream/store{to-xml-parallel}", as_test_store_to_xml_parallel_func);
 	g_test_add_func ("/AppStream/store{app-install}", as_test_store_app_install_func);
 	g_test_add_func ("/AppStream/store{yaml}", as_test_store_yaml_func);
 	g_test_add_func ("/AppStream/store{metadata}", as_test_store_metadata_func);
 	g_test_add_func ("/AppStream/store{metadata-index}", as_test_store_metadata_index_func);
+	g_test_add_func ("/AppStream/store{reverse-index}", as_test_store_reverse_index_func);
+	g_test_add_func ("/AppStream/store{locale-filter}", as_test_store_locale_filter_func);
+	g_test_add_func ("/AppStream/store{locale-filter-parallel}", as_test_store_locale_filter_parallel_func);
+	g_test_add_func ("/AppStream/store{cache}", as_test_store_cache_func);
+	g_test_add_func ("/AppStream/store{parallel}", as_test_store_parallel_func);
+	g_test_add_func ("/AppStream/store{reload}", as_test_store_reload_func);
+	g_test_add_func ("/AppStream/store{reload-shadowed}", as_test_store_reload_shadowed_func);
+	g_test_add_func ("/AppStream/store{search}", as_test_store_search_func);
 	g_test_add_func ("/AppStream/store{validate}", as_test_store_validate_func);
 	g_test_add_func ("/AppStream/store{embedded}", as_test_store_embedded_func);
 	g_test_add_func ("/AppStream/store{local-app-install}", as_test_store_local_app_install_func);
@@ -3111,6 +4454,7 @@ main (int argc, char **argv)
 	g_test_add_func ("/AppStream/store{speed-appdata}", as_test_store_speed_appdata_func);
 	g_test_add_func ("/AppStream/store{speed-desktop}", as_test_store_speed_desktop_func);
 	g_test_add_func ("/AppStream/store{speed-yaml}", as_test_store_speed_yaml_func);
+	g_test_add_func ("/AppStream/store{speed-to-xml}", as_test_store_speed_to_xml_func);
 
 	return g_test_run ();
 }
@@ -36,22 +36,42 @@
 
 #include "config.h"
 
+#include <glib/gstdio.h>
+
 #include "as-app-private.h"
 #include "as-cleanup.h"
 #include "as-node-private.h"
 #include "as-problem.h"
 #include "as-store.h"
+#include "as-store-private.h"
 #include "as-utils-private.h"
 #include "as-yaml.h"
 
 #define AS_API_VERSION_NEWEST	0.6
 
+#define AS_STORE_CACHE_MAGIC	"AsStoreCache"
+#define AS_STORE_CACHE_VERSION	2
+#define AS_STORE_CACHE_FORMAT	"(sudssa(stt)asa(au" AS_APP_VARIANT_TYPE ")" \
+				"a(su)a(sau)a(sau)a(sau))"
+
 typedef enum {
 	AS_STORE_PROBLEM_NONE			= 0,
 	AS_STORE_PROBLEM_LEGACY_ROOT		= 1 << 0,
 	AS_STORE_PROBLEM_LAST
 } AsStoreProblems;
 
+typedef enum {
+	AS_STORE_INDEX_PROVIDE,
+	AS_STORE_INDEX_MIMETYPE,
+	AS_STORE_INDEX_CATEGORY,
+	AS_STORE_INDEX_LAST
+} AsStoreIndex;
+
+typedef struct {
+	guint64			 mtime;		/* in ns */
+	guint64			 size;
+} AsStoreCacheSource;
+
 typedef struct _AsStorePrivate	AsStorePrivate;
 struct _AsStorePrivate
 {
@@ -62,16 +82,35 @@ struct _AsStorePrivate
 	GPtrArray		*array;		/* of AsApp */
 	GHashTable		*hash_id;	/* of AsApp{id} */
 	GHashTable		*hash_pkgname;	/* of AsApp{pkgname} */
+	GHashTable		*hash_shadowed;	/* of GHashTable{filename}{id} */
 	GPtrArray		*file_monitors;	/* of GFileMonitor */
 	GHashTable		*metadata_indexes;	/* GHashTable{key} */
+	GHashTable		*indexes[AS_STORE_INDEX_LAST]; /* of GPtrArray{value} */
 	AsStoreAddFlags		 add_flags;
 	AsStoreProblems		 problems;
+	GHashTable		*locale_filter;	/* of interned locale */
+	GHashTable		*cache_sources;	/* of AsStoreCacheSource{filename} */
+	GVariant		*cache_apps;	/* of (au<AsApp>) */
+	GVariant		*cache_ids;	/* of sorted app IDs */
+	GVariant		*cache_pkgnames; /* of sorted (su) */
+	GVariant		*cache_indexes[AS_STORE_INDEX_LAST]; /* of sorted (sau) */
+	gboolean		*cache_loaded;
+	guint			 cache_pending;
+	GPtrArray		*search_apps;	/* of AsApp */
+	GPtrArray		*search_tokens;	/* of AsStoreSearchToken */
+	GThreadPool		*load_pool;
+	GMutex			 load_mutex;
+	GCond			 load_cond;
+	guint			 load_pending;
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE (AsStore, as_store, G_TYPE_OBJECT)
 
 enum {
 	SIGNAL_CHANGED,
+	SIGNAL_APP_ADDED,
+	SIGNAL_APP_REMOVED,
+	SIGNAL_APP_CHANGED,
 	SIGNAL_LAST
 };
 
@@ -95,6 +134,363 @@ as_store_error_quark (void)
 	return quark;
 }
 
+typedef struct {
+	gchar		*token;
+	GArray		*postings;	/* of AsStoreSearchPosting */
+} AsStoreSearchToken;
+
+typedef struct {
+	guint		 app_idx;
+	guint		 order;
+	guint		 score;
+} AsStoreSearchPosting;
+
+/**
+ * as_store_search_token_free:
+ **/
+static void
+as_store_search_token_free (AsStoreSearchToken *token)
+{
+	g_free (token->token);
+	g_array_unref (token->postings);
+	g_slice_free (AsStoreSearchToken, token);
+}
+
+/**
+ * as_store_search_invalidate:
+ **/
+static void
+as_store_search_invalidate (AsStore *store)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	if (priv->search_tokens != NULL) {
+		g_ptr_array_unref (priv->search_tokens);
+		priv->search_tokens = NULL;
+	}
+	if (priv->search_apps != NULL) {
+		g_ptr_array_unref (priv->search_apps);
+		priv->search_apps = NULL;
+	}
+}
+
+/**
+ * as_store_index_invalidate:
+ **/
+static void
+as_store_index_invalidate (AsStore *store)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	guint i;
+	for (i = 0; i < AS_STORE_INDEX_LAST; i++) {
+		if (priv->indexes[i] == NULL)
+			continue;
+		g_hash_table_unref (priv->indexes[i]);
+		priv->indexes[i] = NULL;
+	}
+}
+
+/**
+ * as_store_index_provide_key:
+ **/
+static gchar *
+as_store_index_provide_key (AsProvideKind kind, const gchar *value)
+{
+	return g_strdup_printf ("%u:%s", kind, value);
+}
+
+typedef struct {
+	GPtrArray	*apps;		/* of AsApp */
+} AsStoreIndexEntry;
+
+/**
+ * as_store_index_entry_free:
+ **/
+static void
+as_store_index_entry_free (AsStoreIndexEntry *entry)
+{
+	g_ptr_array_unref (entry->apps);
+	g_slice_free (AsStoreIndexEntry, entry);
+}
+
+/**
+ * as_store_index_new:
+ **/
+static GHashTable *
+as_store_index_new (void)
+{
+	return g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+				      (GDestroyNotify) as_store_index_entry_free);
+}
+
+/**
+ * as_store_index_get_apps:
+ *
+ * Returns a copy of the applications in an index entry, so that the entry
+ * can be modified in place whatever the caller does with the array.
+ * GPtrArray does not expose its reference count, so sharing the entry
+ * would mean copying it on every later change instead.
+ **/
+static GPtrArray *
+as_store_index_get_apps (GHashTable *index, const gchar *value)
+{
+	AsStoreIndexEntry *entry;
+	GPtrArray *apps;
+	guint i;
+
+	entry = g_hash_table_lookup (index, value);
+	if (entry == NULL)
+		return g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	apps = g_ptr_array_new_full (entry->apps->len,
+				     (GDestroyNotify) g_object_unref);
+	for (i = 0; i < entry->apps->len; i++)
+		g_ptr_array_add (apps, g_object_ref (g_ptr_array_index (entry->apps, i)));
+	return apps;
+}
+
+/**
+ * as_store_index_update_value:
+ **/
+static void
+as_store_index_update_value (GHashTable *index,
+			     const gchar *value,
+			     AsApp *app,
+			     gboolean add)
+{
+	AsStoreIndexEntry *entry;
+	gboolean ret;
+
+	if (value == NULL)
+		return;
+	entry = g_hash_table_lookup (index, value);
+	if (entry == NULL) {
+		if (!add)
+			return;
+		entry = g_slice_new0 (AsStoreIndexEntry);
+		entry->apps = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+		g_hash_table_insert (index, g_strdup (value), entry);
+	}
+
+	/* an application is only ever added to the indexes when it is not
+	 * already in them: when it is inserted, after it has been removed
+	 * for a merge, or after a metadata value has been removed -- so
+	 * the only possible duplicate is a repeated value of the app that
+	 * was just added, which is at the end of the array */
+	if (add && entry->apps->len > 0 &&
+	    g_ptr_array_index (entry->apps, entry->apps->len - 1) == app)
+		return;
+	if (add) {
+		g_ptr_array_add (entry->apps, g_object_ref (app));
+		return;
+	}
+
+	/* drop the key entirely when the last application goes; repeated
+	 * values are skipped by the caller, so the application is in the
+	 * entry exactly once */
+	ret = g_ptr_array_remove (entry->apps, app);
+	g_warn_if_fail (ret);
+	if (entry->apps->len == 0)
+		g_hash_table_remove (index, value);
+}
+
+/**
+ * as_store_index_provide_repeated:
+ **/
+static gboolean
+as_store_index_provide_repeated (GPtrArray *provides, guint idx)
+{
+	AsProvide *provide = g_ptr_array_index (provides, idx);
+	AsProvide *tmp;
+	guint i;
+
+	for (i = 0; i < idx; i++) {
+		tmp = g_ptr_array_index (provides, i);
+		if (as_provide_get_kind (tmp) == as_provide_get_kind (provide) &&
+		    g_strcmp0 (as_provide_get_value (tmp),
+			       as_provide_get_value (provide)) == 0)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+/**
+ * as_store_index_value_repeated:
+ *
+ * Returns %TRUE if the value at @idx is also earlier in @values; the
+ * application was only added to the index once for both.
+ **/
+static gboolean
+as_store_index_value_repeated (GPtrArray *values, guint idx)
+{
+	guint i;
+
+	for (i = 0; i < idx; i++) {
+		if (g_strcmp0 (g_ptr_array_index (values, i),
+			       g_ptr_array_index (values, idx)) == 0)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+/**
+ * as_store_index_update_app_idx:
+ **/
+static void
+as_store_index_update_app_idx (AsStore *store,
+			       AsStoreIndex idx,
+			       AsApp *app,
+			       gboolean add)
+{
+	AsProvide *provide;
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	GHashTable *index = priv->indexes[idx];
+	GPtrArray *values = NULL;
+	guint i;
+
+	switch (idx) {
+	case AS_STORE_INDEX_PROVIDE:
+		values = as_app_get_provides (app);
+		for (i = 0; i < values->len; i++) {
+			_cleanup_free_ gchar *key = NULL;
+			provide = g_ptr_array_index (values, i);
+			if (as_provide_get_value (provide) == NULL)
+				continue;
+			if (!add && as_store_index_provide_repeated (values, i))
+				continue;
+			key = as_store_index_provide_key (as_provide_get_kind (provide),
+							  as_provide_get_value (provide));
+			as_store_index_update_value (index, key, app, add);
+		}
+		return;
+	case AS_STORE_INDEX_MIMETYPE:
+		values = as_app_get_mimetypes (app);
+		break;
+	case AS_STORE_INDEX_CATEGORY:
+		values = as_app_get_categories (app);
+		break;
+	default:
+		return;
+	}
+	for (i = 0; i < values->len; i++) {
+		if (!add && as_store_index_value_repeated (values, i))
+			continue;
+		as_store_index_update_value (index, g_ptr_array_index (values, i), app, add);
+	}
+}
+
+/**
+ * as_store_metadata_changed_cb:
+ **/
+static void
+as_store_metadata_changed_cb (AsApp *app,
+			      const gchar *key,
+			      const gchar *old_value,
+			      const gchar *new_value,
+			      gpointer user_data)
+{
+	AsStore *store = AS_STORE (user_data);
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	GHashTable *md;
+
+	md = g_hash_table_lookup (priv->metadata_indexes, key);
+	if (md == NULL)
+		return;
+	as_store_index_update_value (md, old_value, app, FALSE);
+	as_store_index_update_value (md, new_value, app, TRUE);
+}
+
+/**
+ * as_store_index_update_app:
+ *
+ * Adds or removes the application from each of the reverse indexes that
+ * have already been built, and from every registered metadata index.
+ **/
+static void
+as_store_index_update_app (AsStore *store, AsApp *app, gboolean add)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	GHashTableIter iter;
+	gpointer key;
+	gpointer value;
+	guint i;
+
+	for (i = 0; i < AS_STORE_INDEX_LAST; i++) {
+		if (priv->indexes[i] == NULL)
+			continue;
+		as_store_index_update_app_idx (store, i, app, add);
+	}
+
+	/* metadata can be changed after the app has been added */
+	if (g_hash_table_size (priv->metadata_indexes) == 0)
+		return;
+	g_hash_table_iter_init (&iter, priv->metadata_indexes);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		as_store_index_update_value (value,
+					     as_app_get_metadata_item (app, key),
+					     app, add);
+	}
+	if (add)
+		as_app_add_metadata_watch (app, as_store_metadata_changed_cb, store);
+	else
+		as_app_remove_metadata_watch (app, as_store_metadata_changed_cb, store);
+}
+
+/**
+ * as_store_metadata_unwatch_all:
+ **/
+static void
+as_store_metadata_unwatch_all (AsStore *store)
+{
+	AsApp *app;
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	GHashTableIter iter;
+	gpointer value;
+	guint i;
+
+	if (g_hash_table_size (priv->metadata_indexes) == 0)
+		return;
+
+	/* keep the registered keys, but drop the applications */
+	g_hash_table_iter_init (&iter, priv->metadata_indexes);
+	while (g_hash_table_iter_next (&iter, NULL, &value))
+		g_hash_table_remove_all (value);
+	for (i = 0; i < priv->array->len; i++) {
+		app = g_ptr_array_index (priv->array, i);
+		as_app_remove_metadata_watch (app, as_store_metadata_changed_cb, store);
+	}
+}
+
+/**
+ * as_store_cache_free:
+ **/
+static void
+as_store_cache_free (AsStore *store)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	guint i;
+
+	if (priv->cache_apps != NULL) {
+		g_variant_unref (priv->cache_apps);
+		priv->cache_apps = NULL;
+	}
+	if (priv->cache_ids != NULL) {
+		g_variant_unref (priv->cache_ids);
+		priv->cache_ids = NULL;
+	}
+	if (priv->cache_pkgnames != NULL) {
+		g_variant_unref (priv->cache_pkgnames);
+		priv->cache_pkgnames = NULL;
+	}
+	for (i = 0; i < AS_STORE_INDEX_LAST; i++) {
+		if (priv->cache_indexes[i] == NULL)
+			continue;
+		g_variant_unref (priv->cache_indexes[i]);
+		priv->cache_indexes[i] = NULL;
+	}
+	g_free (priv->cache_loaded);
+	priv->cache_loaded = NULL;
+	priv->cache_pending = 0;
+}
+
 /**
  * as_store_finalize:
  **/
@@ -104,6 +500,10 @@ as_store_finalize (GObject *object)
 	AsStore *store = AS_STORE (object);
 	AsStorePrivate *priv = GET_PRIVATE (store);
 
+	as_store_cache_free (store);
+	as_store_search_invalidate (store);
+	as_store_index_invalidate (store);
+	as_store_metadata_unwatch_all (store);
 	g_free (priv->destdir);
 	g_free (priv->origin);
 	g_free (priv->builder_id);
@@ -111,7 +511,15 @@ as_store_finalize (GObject *object)
 	g_ptr_array_unref (priv->file_monitors);
 	g_hash_table_unref (priv->hash_id);
 	g_hash_table_unref (priv->hash_pkgname);
+	g_hash_table_unref (priv->hash_shadowed);
 	g_hash_table_unref (priv->metadata_indexes);
+	g_hash_table_unref (priv->cache_sources);
+	if (priv->locale_filter != NULL)
+		g_hash_table_unref (priv->locale_filter);
+	if (priv->load_pool != NULL)
+		g_thread_pool_free (priv->load_pool, TRUE, TRUE);
+	g_mutex_clear (&priv->load_mutex);
+	g_cond_clear (&priv->load_cond);
 
 	G_OBJECT_CLASS (as_store_parent_class)->finalize (object);
 }
@@ -124,6 +532,8 @@ as_store_init (AsStore *store)
 {
 	AsStorePrivate *priv = GET_PRIVATE (store);
 	priv->api_version = AS_API_VERSION_NEWEST;
+	g_mutex_init (&priv->load_mutex);
+	g_cond_init (&priv->load_cond);
 	priv->array = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
 	priv->hash_id = g_hash_table_new_full (g_str_hash,
 					       g_str_equal,
@@ -133,11 +543,19 @@ as_store_init (AsStore *store)
 						    g_str_equal,
 						    g_free,
 						    (GDestroyNotify) g_object_unref);
+	priv->hash_shadowed = g_hash_table_new_full (g_str_hash,
+						     g_str_equal,
+						     g_free,
+						     (GDestroyNotify) g_hash_table_unref);
 	priv->file_monitors = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
 	priv->metadata_indexes = g_hash_table_new_full (g_str_hash,
 							  g_str_equal,
 							  g_free,
 							  (GDestroyNotify) g_hash_table_unref);
+	priv->cache_sources = g_hash_table_new_full (g_str_hash,
+						     g_str_equal,
+						     g_free,
+						     g_free);
 }
 
 /**
@@ -164,7 +582,601 @@ as_store_class_init (AsStoreClass *klass)
 			      NULL, NULL, g_cclosure_marshal_VOID__VOID,
 			      G_TYPE_NONE, 0);
 
-	object_class->finalize = as_store_finalize;
+	/**
+	 * AsStore::app-added:
+	 * @store: the #AsStore instance that emitted the signal
+	 * @app: the #AsApp that was added
+	 *
+	 * The ::app-added signal is emitted when a file backing the store
+	 * has been reloaded and contains a new application.
+	 *
+	 * Since: 0.3.3
+	 **/
+	signals [SIGNAL_APP_ADDED] =
+		g_signal_new ("app-added",
+			      G_TYPE_FROM_CLASS (object_class), G_SIGNAL_RUN_LAST,
+			      0, NULL, NULL, g_cclosure_marshal_VOID__OBJECT,
+			      G_TYPE_NONE, 1, AS_TYPE_APP);
+
+	/**
+	 * AsStore::app-removed:
+	 * @store: the #AsStore instance that emitted the signal
+	 * @app: the #AsApp that was removed
+	 *
+	 * The ::app-removed signal is emitted when a file backing the store
+	 * has been reloaded and no longer contains the application.
+	 *
+	 * Since: 0.3.3
+	 **/
+	signals [SIGNAL_APP_REMOVED] =
+		g_signal_new ("app-removed",
+			      G_TYPE_FROM_CLASS (object_class), G_SIGNAL_RUN_LAST,
+			      0, NULL, NULL, g_cclosure_marshal_VOID__OBJECT,
+			      G_TYPE_NONE, 1, AS_TYPE_APP);
+
+	/**
+	 * AsStore::app-changed:
+	 * @store: the #AsStore instance that emitted the signal
+	 * @app: the new #AsApp
+	 *
+	 * The ::app-changed signal is emitted when a file backing the store
+	 * has been reloaded and the application data is different.
+	 *
+	 * Since: 0.3.3
+	 **/
+	signals [SIGNAL_APP_CHANGED] =
+		g_signal_new ("app-changed",
+			      G_TYPE_FROM_CLASS (object_class), G_SIGNAL_RUN_LAST,
+			      0, NULL, NULL, g_cclosure_marshal_VOID__OBJECT,
+			      G_TYPE_NONE, 1, AS_TYPE_APP);
+
+	object_class->finalize = as_store_finalize;
+}
+
+/**
+ * as_store_insert_app:
+ **/
+static void
+as_store_insert_app (AsStore *store, AsApp *app)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	GPtrArray *pkgnames;
+	const gchar *pkgname;
+	guint i;
+
+	as_store_search_invalidate (store);
+	g_ptr_array_add (priv->array, g_object_ref (app));
+	g_hash_table_insert (priv->hash_id,
+			     (gpointer) as_app_get_id (app),
+			     app);
+	pkgnames = as_app_get_pkgnames (app);
+	for (i = 0; i < pkgnames->len; i++) {
+		pkgname = g_ptr_array_index (pkgnames, i);
+		g_hash_table_insert (priv->hash_pkgname,
+				     g_strdup (pkgname),
+				     g_object_ref (app));
+	}
+	as_store_index_update_app (store, app, TRUE);
+}
+
+/**
+ * as_store_cache_source_stat:
+ *
+ * Gets the modification time and size of a file, which together are used
+ * to decide if a cache is out of date. The modification time has nanosecond
+ * resolution where the platform supports it, so that a file rewritten in
+ * the same second is still noticed.
+ **/
+static gboolean
+as_store_cache_source_stat (const gchar *filename, AsStoreCacheSource *source)
+{
+	GStatBuf st;
+
+	if (g_stat (filename, &st) != 0)
+		return FALSE;
+	source->mtime = (guint64) st.st_mtime * G_GUINT64_CONSTANT (1000000000);
+#ifdef HAVE_STRUCT_STAT_ST_MTIM_TV_NSEC
+	source->mtime += (guint64) st.st_mtim.tv_nsec;
+#endif
+	source->size = (guint64) st.st_size;
+	return TRUE;
+}
+
+/**
+ * as_store_add_cache_source:
+ **/
+static void
+as_store_add_cache_source (AsStore *store, const gchar *filename)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	AsStoreCacheSource source;
+
+	if (filename == NULL)
+		return;
+	if (!as_store_cache_source_stat (filename, &source))
+		return;
+	g_hash_table_insert (priv->cache_sources,
+			     g_strdup (filename),
+			     g_memdup (&source, sizeof (AsStoreCacheSource)));
+}
+
+/**
+ * as_store_cache_parse_app:
+ **/
+static AsApp *
+as_store_cache_parse_app (GVariant *apps,
+			  guint idx,
+			  GHashTable *locale_filter,
+			  GError **error)
+{
+	AsApp *app;
+	_cleanup_variant_unref_ GVariant *value = NULL;
+	_cleanup_variant_unref_ GVariant *value_app = NULL;
+
+	/* the application is stored field by field */
+	value = g_variant_get_child_value (apps, idx);
+	value_app = g_variant_get_child_value (value, 1);
+	app = as_app_new ();
+	as_app_set_locale_filter (app, locale_filter);
+	if (!as_app_variant_parse (app, value_app, error)) {
+		g_object_unref (app);
+		return NULL;
+	}
+	as_app_set_locale_filter (app, NULL);
+	return app;
+}
+
+/**
+ * as_store_cache_load_app:
+ **/
+static AsApp *
+as_store_cache_load_app (AsStore *store, guint idx)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	AsApp *addon;
+	GVariantIter iter;
+	guint32 addon_idx;
+	_cleanup_error_free_ GError *error_local = NULL;
+	_cleanup_object_unref_ AsApp *app = NULL;
+	_cleanup_variant_unref_ GVariant *addons = NULL;
+	_cleanup_variant_unref_ GVariant *value = NULL;
+
+	/* already done */
+	if (priv->cache_loaded[idx]) {
+		const gchar *id;
+		g_variant_get_child (priv->cache_ids, idx, "&s", &id);
+		return g_hash_table_lookup (priv->hash_id, id);
+	}
+	priv->cache_loaded[idx] = TRUE;
+	priv->cache_pending--;
+
+	app = as_store_cache_parse_app (priv->cache_apps, idx,
+					priv->locale_filter, &error_local);
+	if (app == NULL) {
+		g_warning ("Failed to load cached application: %s",
+			   error_local->message);
+		return NULL;
+	}
+
+	/* the cache only ever contains unique IDs, so no merging is required */
+	as_store_insert_app (store, app);
+
+	/* the addons are materialized at the same time as the parent */
+	value = g_variant_get_child_value (priv->cache_apps, idx);
+	addons = g_variant_get_child_value (value, 0);
+	g_variant_iter_init (&iter, addons);
+	while (g_variant_iter_next (&iter, "u", &addon_idx)) {
+		if (addon_idx >= g_variant_n_children (priv->cache_apps))
+			continue;
+		addon = as_store_cache_load_app (store, addon_idx);
+		if (addon != NULL)
+			as_app_add_addon (app, addon);
+	}
+	return app;
+}
+
+/**
+ * as_store_cache_ensure:
+ *
+ * Materializes every application still pending in a loaded cache.
+ **/
+static void
+as_store_cache_ensure (AsStore *store)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	guint i;
+	guint len;
+
+	if (priv->cache_apps == NULL)
+		return;
+	len = g_variant_n_children (priv->cache_apps);
+	for (i = 0; i < len && priv->cache_pending > 0; i++)
+		as_store_cache_load_app (store, i);
+	as_store_cache_free (store);
+}
+
+/**
+ * as_store_cache_lookup_id:
+ **/
+static AsApp *
+as_store_cache_lookup_id (AsStore *store, const gchar *id)
+{
+	AsApp *app = NULL;
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	const gchar *tmp;
+	gint rc;
+	guint hi;
+	guint lo = 0;
+	guint mid;
+
+	/* the IDs are sorted, so we can do a binary search */
+	hi = g_variant_n_children (priv->cache_ids);
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		g_variant_get_child (priv->cache_ids, mid, "&s", &tmp);
+		rc = g_strcmp0 (id, tmp);
+		if (rc == 0) {
+			app = as_store_cache_load_app (store, mid);
+			break;
+		}
+		if (rc < 0)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+
+	/* everything has been loaded */
+	if (priv->cache_pending == 0)
+		as_store_cache_free (store);
+	return app;
+}
+
+/**
+ * as_store_cache_find_key:
+ *
+ * Finds @key in a sorted array of tuples where the first member is the
+ * string key.
+ *
+ * Returns: the tuple, or %NULL if not found
+ **/
+static GVariant *
+as_store_cache_find_key (GVariant *array, const gchar *key)
+{
+	const gchar *tmp;
+	gint rc;
+	guint hi;
+	guint lo = 0;
+	guint mid;
+
+	hi = g_variant_n_children (array);
+	while (lo < hi) {
+		GVariant *item;
+		mid = (lo + hi) / 2;
+		item = g_variant_get_child_value (array, mid);
+		g_variant_get_child (item, 0, "&s", &tmp);
+		rc = g_strcmp0 (key, tmp);
+		if (rc == 0)
+			return item;
+		g_variant_unref (item);
+		if (rc < 0)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+	return NULL;
+}
+
+/**
+ * as_store_cache_lookup_pkgname:
+ **/
+static AsApp *
+as_store_cache_lookup_pkgname (AsStore *store, const gchar *pkgname)
+{
+	AsApp *app;
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	guint32 idx;
+	_cleanup_variant_unref_ GVariant *item = NULL;
+
+	item = as_store_cache_find_key (priv->cache_pkgnames, pkgname);
+	if (item == NULL)
+		return NULL;
+	g_variant_get_child (item, 1, "u", &idx);
+	app = as_store_cache_load_app (store, idx);
+	if (priv->cache_pending == 0)
+		as_store_cache_free (store);
+	return app;
+}
+
+/**
+ * as_store_cache_lookup_index:
+ *
+ * Only creates the applications that match the value using the reverse
+ * index saved with the cache.
+ **/
+static GPtrArray *
+as_store_cache_lookup_index (AsStore *store,
+			     AsStoreIndex idx,
+			     const gchar *value)
+{
+	AsApp *app;
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	GPtrArray *apps;
+	GVariantIter iter;
+	guint32 app_idx;
+	_cleanup_variant_unref_ GVariant *indexes = NULL;
+	_cleanup_variant_unref_ GVariant *item = NULL;
+
+	apps = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	item = as_store_cache_find_key (priv->cache_indexes[idx], value);
+	if (item == NULL)
+		return apps;
+	indexes = g_variant_get_child_value (item, 1);
+	g_variant_iter_init (&iter, indexes);
+	while (g_variant_iter_next (&iter, "u", &app_idx)) {
+		app = as_store_cache_load_app (store, app_idx);
+		if (app != NULL)
+			g_ptr_array_add (apps, g_object_ref (app));
+	}
+	if (priv->cache_pending == 0)
+		as_store_cache_free (store);
+	return apps;
+}
+
+/**
+ * as_store_search_add_tokens:
+ **/
+static void
+as_store_search_add_tokens (GHashTable *hash,
+			    gchar **values,
+			    guint app_idx,
+			    guint order,
+			    guint score)
+{
+	AsStoreSearchPosting posting;
+	AsStoreSearchPosting *last;
+	AsStoreSearchToken *token;
+	guint i;
+
+	if (values == NULL)
+		return;
+	for (i = 0; values[i] != NULL; i++) {
+		token = g_hash_table_lookup (hash, values[i]);
+		if (token == NULL) {
+			token = g_slice_new0 (AsStoreSearchToken);
+			token->token = g_strdup (values[i]);
+			token->postings = g_array_new (FALSE, FALSE,
+						       sizeof (AsStoreSearchPosting));
+			g_hash_table_insert (hash, token->token, token);
+		}
+
+		/* the apps are added in order and the first item that
+		 * matches is the one that as_app_search_matches() uses */
+		if (token->postings->len > 0) {
+			last = &g_array_index (token->postings,
+					       AsStoreSearchPosting,
+					       token->postings->len - 1);
+			if (last->app_idx == app_idx)
+				continue;
+		}
+		posting.app_idx = app_idx;
+		posting.order = order;
+		posting.score = score;
+		g_array_append_val (token->postings, posting);
+	}
+}
+
+/**
+ * as_store_search_token_sort_cb:
+ **/
+static gint
+as_store_search_token_sort_cb (gconstpointer a, gconstpointer b)
+{
+	AsStoreSearchToken *t1 = *((AsStoreSearchToken **) a);
+	AsStoreSearchToken *t2 = *((AsStoreSearchToken **) b);
+	return g_strcmp0 (t1->token, t2->token);
+}
+
+/**
+ * as_store_search_ensure:
+ *
+ * Builds a sorted dictionary of every folded search token in the store, where
+ * each token has a list of the applications that contain it.
+ **/
+static void
+as_store_search_ensure (AsStore *store)
+{
+	AsApp *app;
+	AsAppTokenItem *item;
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	GHashTableIter iter;
+	GPtrArray *items;
+	gpointer value;
+	guint i;
+	guint j;
+	_cleanup_hashtable_unref_ GHashTable *hash = NULL;
+
+	/* already valid */
+	if (priv->search_tokens != NULL)
+		return;
+
+	/* take a copy as the array may be reordered */
+	as_store_cache_ensure (store);
+	priv->search_apps = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	for (i = 0; i < priv->array->len; i++) {
+		app = g_ptr_array_index (priv->array, i);
+		g_ptr_array_add (priv->search_apps, g_object_ref (app));
+	}
+
+	/* add all the tokens from each application */
+	hash = g_hash_table_new (g_str_hash, g_str_equal);
+	for (i = 0; i < priv->search_apps->len; i++) {
+		app = g_ptr_array_index (priv->search_apps, i);
+		items = as_app_get_search_tokens (app);
+		for (j = 0; j < items->len; j++) {
+			item = g_ptr_array_index (items, j);
+			as_store_search_add_tokens (hash, item->values_utf8,
+						    i, j * 2, item->score);
+			as_store_search_add_tokens (hash, item->values_ascii,
+						    i, j * 2 + 1, item->score / 2);
+		}
+	}
+
+	/* sort the dictionary so we can do prefix searches */
+	priv->search_tokens = g_ptr_array_new_with_free_func ((GDestroyNotify) as_store_search_token_free);
+	g_hash_table_iter_init (&iter, hash);
+	while (g_hash_table_iter_next (&iter, NULL, &value))
+		g_ptr_array_add (priv->search_tokens, value);
+	g_ptr_array_sort (priv->search_tokens, as_store_search_token_sort_cb);
+}
+
+/**
+ * as_store_search_lower_bound:
+ **/
+static guint
+as_store_search_lower_bound (GPtrArray *tokens, const gchar *search)
+{
+	AsStoreSearchToken *token;
+	guint hi = tokens->len;
+	guint lo = 0;
+	guint mid;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		token = g_ptr_array_index (tokens, mid);
+		if (g_strcmp0 (token->token, search) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+typedef struct {
+	AsApp		*app;
+	guint		 score;
+} AsStoreSearchResult;
+
+/**
+ * as_store_search_result_sort_cb:
+ **/
+static gint
+as_store_search_result_sort_cb (gconstpointer a, gconstpointer b)
+{
+	const AsStoreSearchResult *r1 = a;
+	const AsStoreSearchResult *r2 = b;
+	if (r1->score > r2->score)
+		return -1;
+	if (r1->score < r2->score)
+		return 1;
+	return g_strcmp0 (as_app_get_id (r1->app), as_app_get_id (r2->app));
+}
+
+/**
+ * as_store_search:
+ * @store: a #AsStore instance.
+ * @search: the search terms, already tokenized and folded.
+ *
+ * Finds all the applications that match all of the search terms, using the
+ * same prefix matching and scoring as as_app_search_matches_all().
+ *
+ * The first call builds an index of all the search tokens in the store, and
+ * the index is rebuilt if any applications are added or removed.
+ *
+ * Returns: (element-type AsApp) (transfer container): an array of
+ * applications, with the best match first
+ *
+ * Since: 0.3.3
+ **/
+GPtrArray *
+as_store_search (AsStore *store, gchar **search)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	AsStoreSearchPosting *posting;
+	AsStoreSearchResult result;
+	AsStoreSearchToken *token;
+	GPtrArray *apps;
+	guint i;
+	guint j;
+	guint k;
+	guint n_terms;
+	_cleanup_array_unref_ GArray *results = NULL;
+	_cleanup_array_unref_ GArray *touched = NULL;
+	_cleanup_free_ guint *best_order = NULL;
+	_cleanup_free_ guint *best_score = NULL;
+	_cleanup_free_ guint *matched = NULL;
+	_cleanup_free_ guint *total = NULL;
+
+	g_return_val_if_fail (AS_IS_STORE (store), NULL);
+
+	apps = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	if (search == NULL)
+		return apps;
+	n_terms = g_strv_length (search);
+	if (n_terms == 0)
+		return apps;
+
+	as_store_search_ensure (store);
+	best_order = g_new (guint, priv->search_apps->len);
+	best_score = g_new0 (guint, priv->search_apps->len);
+	matched = g_new0 (guint, priv->search_apps->len);
+	total = g_new0 (guint, priv->search_apps->len);
+	for (i = 0; i < priv->search_apps->len; i++)
+		best_order[i] = G_MAXUINT;
+	touched = g_array_new (FALSE, FALSE, sizeof (guint));
+
+	for (k = 0; k < n_terms; k++) {
+
+		/* find the best match for each app from any token with this prefix */
+		g_array_set_size (touched, 0);
+		for (i = as_store_search_lower_bound (priv->search_tokens, search[k]);
+		     i < priv->search_tokens->len; i++) {
+			token = g_ptr_array_index (priv->search_tokens, i);
+			if (!g_str_has_prefix (token->token, search[k]))
+				break;
+			for (j = 0; j < token->postings->len; j++) {
+				posting = &g_array_index (token->postings,
+							  AsStoreSearchPosting, j);
+
+				/* did not match all the previous terms */
+				if (matched[posting->app_idx] != k)
+					continue;
+				if (best_order[posting->app_idx] == G_MAXUINT)
+					g_array_append_val (touched, posting->app_idx);
+				if (posting->order >= best_order[posting->app_idx])
+					continue;
+				best_order[posting->app_idx] = posting->order;
+				best_score[posting->app_idx] = posting->score;
+			}
+		}
+
+		/* only apps with every term so far get to the next round */
+		for (i = 0; i < touched->len; i++) {
+			guint app_idx = g_array_index (touched, guint, i);
+			best_order[app_idx] = G_MAXUINT;
+			if (best_score[app_idx] == 0)
+				continue;
+			total[app_idx] += best_score[app_idx];
+			matched[app_idx]++;
+		}
+		if (touched->len == 0)
+			return apps;
+	}
+
+	/* sort by score */
+	results = g_array_new (FALSE, FALSE, sizeof (AsStoreSearchResult));
+	for (i = 0; i < priv->search_apps->len; i++) {
+		if (matched[i] != n_terms)
+			continue;
+		result.app = g_ptr_array_index (priv->search_apps, i);
+		result.score = total[i];
+		g_array_append_val (results, result);
+	}
+	g_array_sort (results, as_store_search_result_sort_cb);
+	for (i = 0; i < results->len; i++) {
+		result = g_array_index (results, AsStoreSearchResult, i);
+		g_ptr_array_add (apps, g_object_ref (result.app));
+	}
+	return apps;
 }
 
 /**
@@ -183,7 +1195,7 @@ as_store_get_size (AsStore *store)
 {
 	AsStorePrivate *priv = GET_PRIVATE (store);
 	g_return_val_if_fail (AS_IS_STORE (store), 0);
-	return priv->array->len;
+	return priv->array->len + priv->cache_pending;
 }
 
 /**
@@ -192,6 +1204,11 @@ as_store_get_size (AsStore *store)
  *
  * Gets an array of all the valid applications in the store.
  *
+ * If the store was loaded using as_store_from_cache() then this creates
+ * every application that has not yet been used, so callers only wanting
+ * a few applications should use as_store_get_app_by_id() or one of the
+ * as_store_get_apps_by_*() functions instead.
+ *
  * Returns: (element-type AsApp) (transfer none): an array
  *
  * Since: 0.1.0
@@ -201,6 +1218,7 @@ as_store_get_apps (AsStore *store)
 {
 	AsStorePrivate *priv = GET_PRIVATE (store);
 	g_return_val_if_fail (AS_IS_STORE (store), NULL);
+	as_store_cache_ensure (store);
 	return priv->array;
 }
 
@@ -217,9 +1235,15 @@ as_store_remove_all (AsStore *store)
 {
 	AsStorePrivate *priv = GET_PRIVATE (store);
 	g_return_if_fail (AS_IS_STORE (store));
+	as_store_cache_free (store);
+	as_store_search_invalidate (store);
+	as_store_index_invalidate (store);
+	as_store_metadata_unwatch_all (store);
+	g_hash_table_remove_all (priv->cache_sources);
 	g_ptr_array_set_size (priv->array, 0);
 	g_hash_table_remove_all (priv->hash_id);
 	g_hash_table_remove_all (priv->hash_pkgname);
+	g_hash_table_remove_all (priv->hash_shadowed);
 }
 
 /**
@@ -231,35 +1255,21 @@ as_store_regen_metadata_index_key (AsStore *store, const gchar *key)
 	AsApp *app;
 	AsStorePrivate *priv = GET_PRIVATE (store);
 	GHashTable *md;
-	GPtrArray *apps;
-	const gchar *tmp;
 	guint i;
 
 	/* regenerate cache */
-	md = g_hash_table_new_full (g_str_hash, g_str_equal,
-				    g_free, (GDestroyNotify) g_ptr_array_unref);
+	as_store_cache_ensure (store);
+	md = as_store_index_new ();
+	g_hash_table_insert (priv->metadata_indexes, g_strdup (key), md);
 	for (i = 0; i < priv->array->len; i++) {
 		app = g_ptr_array_index (priv->array, i);
+		as_store_index_update_value (md,
+					     as_app_get_metadata_item (app, key),
+					     app, TRUE);
 
-		/* no data */
-		tmp = as_app_get_metadata_item (app, key);
-		if (tmp == NULL)
-			continue;
-
-		/* seen before */
-		apps = g_hash_table_lookup (md, tmp);
-		if (apps != NULL) {
-			g_ptr_array_add (apps, g_object_ref (app));
-			continue;
-		}
-
-		/* never seen before */
-		apps = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
-		g_ptr_array_add (apps, g_object_ref (app));
-		g_hash_table_insert (md, g_strdup (tmp), apps);
-
+		/* keep the index up to date if the value changes */
+		as_app_add_metadata_watch (app, as_store_metadata_changed_cb, store);
 	}
-	g_hash_table_insert (priv->metadata_indexes, g_strdup (key), md);
 }
 
 /**
@@ -288,17 +1298,10 @@ as_store_get_apps_by_metadata (AsStore *store,
 	g_return_val_if_fail (AS_IS_STORE (store), NULL);
 
 	/* do we have this indexed? */
+	as_store_cache_ensure (store);
 	index = g_hash_table_lookup (priv->metadata_indexes, key);
-	if (index != NULL) {
-		if (g_hash_table_size (index) == 0) {
-			as_store_regen_metadata_index_key (store, key);
-			index = g_hash_table_lookup (priv->metadata_indexes, key);
-		}
-		apps = g_hash_table_lookup (index, value);
-		if (apps != NULL)
-			return g_ptr_array_ref (apps);
-		return g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
-	}
+	if (index != NULL)
+		return as_store_index_get_apps (index, value);
 
 	/* find all the apps with this specific metadata key */
 	apps = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
@@ -318,17 +1321,125 @@ as_store_get_apps_by_metadata (AsStore *store,
  *
  * Adds a metadata index key.
  *
- * NOTE: if applications are removed *all* the indexes will be invalid and
- * will have to be re-added.
+ * The index is kept up to date when applications are added to or removed
+ * from the store, and when the metadata of an application in the store is
+ * changed using as_app_add_metadata() or as_app_remove_metadata().
  *
  * Since: 0.3.0
  **/
 void
 as_store_add_metadata_index (AsStore *store, const gchar *key)
 {
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	g_return_if_fail (AS_IS_STORE (store));
+	if (g_hash_table_lookup (priv->metadata_indexes, key) != NULL)
+		return;
 	as_store_regen_metadata_index_key (store, key);
 }
 
+/**
+ * as_store_index_ensure:
+ **/
+static void
+as_store_index_ensure (AsStore *store, AsStoreIndex idx)
+{
+	AsApp *app;
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	guint i;
+
+	as_store_cache_ensure (store);
+	if (priv->indexes[idx] != NULL)
+		return;
+	priv->indexes[idx] = as_store_index_new ();
+	for (i = 0; i < priv->array->len; i++) {
+		app = g_ptr_array_index (priv->array, i);
+		as_store_index_update_app_idx (store, idx, app, TRUE);
+	}
+}
+
+/**
+ * as_store_index_lookup:
+ *
+ * Builds the reverse index the first time it is used, after which it is
+ * kept up to date as applications are added and removed.
+ **/
+static GPtrArray *
+as_store_index_lookup (AsStore *store, AsStoreIndex idx, const gchar *value)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+
+	/* a pending cache was saved with its own reverse index */
+	if (priv->cache_apps != NULL)
+		return as_store_cache_lookup_index (store, idx, value);
+	as_store_index_ensure (store, idx);
+	return as_store_index_get_apps (priv->indexes[idx], value);
+}
+
+/**
+ * as_store_get_apps_by_provide:
+ * @store: a #AsStore instance.
+ * @kind: the #AsProvideKind, e.g. %AS_PROVIDE_KIND_LIBRARY
+ * @value: the provide value, e.g. "libfoo.so.1"
+ *
+ * Gets an array of all the applications that provide a specific item.
+ *
+ * The index is built the first time this is called and is then kept up to
+ * date as applications are added or removed from the store.
+ *
+ * Returns: (element-type AsApp) (transfer container): an array
+ *
+ * Since: 0.3.3
+ **/
+GPtrArray *
+as_store_get_apps_by_provide (AsStore *store,
+			      AsProvideKind kind,
+			      const gchar *value)
+{
+	_cleanup_free_ gchar *key = NULL;
+	g_return_val_if_fail (AS_IS_STORE (store), NULL);
+	g_return_val_if_fail (value != NULL, NULL);
+	key = as_store_index_provide_key (kind, value);
+	return as_store_index_lookup (store, AS_STORE_INDEX_PROVIDE, key);
+}
+
+/**
+ * as_store_get_apps_by_mimetype:
+ * @store: a #AsStore instance.
+ * @mimetype: the mimetype, e.g. "image/png"
+ *
+ * Gets an array of all the applications that can handle a mimetype.
+ *
+ * Returns: (element-type AsApp) (transfer container): an array
+ *
+ * Since: 0.3.3
+ **/
+GPtrArray *
+as_store_get_apps_by_mimetype (AsStore *store, const gchar *mimetype)
+{
+	g_return_val_if_fail (AS_IS_STORE (store), NULL);
+	g_return_val_if_fail (mimetype != NULL, NULL);
+	return as_store_index_lookup (store, AS_STORE_INDEX_MIMETYPE, mimetype);
+}
+
+/**
+ * as_store_get_apps_by_category:
+ * @store: a #AsStore instance.
+ * @category: the category, e.g. "Game"
+ *
+ * Gets an array of all the applications in a category.
+ *
+ * Returns: (element-type AsApp) (transfer container): an array
+ *
+ * Since: 0.3.3
+ **/
+GPtrArray *
+as_store_get_apps_by_category (AsStore *store, const gchar *category)
+{
+	g_return_val_if_fail (AS_IS_STORE (store), NULL);
+	g_return_val_if_fail (category != NULL, NULL);
+	return as_store_index_lookup (store, AS_STORE_INDEX_CATEGORY, category);
+}
+
 /**
  * as_store_get_app_by_id:
  * @store: a #AsStore instance.
@@ -343,9 +1454,13 @@ as_store_add_metadata_index (AsStore *store, const gchar *key)
 AsApp *
 as_store_get_app_by_id (AsStore *store, const gchar *id)
 {
+	AsApp *app;
 	AsStorePrivate *priv = GET_PRIVATE (store);
 	g_return_val_if_fail (AS_IS_STORE (store), NULL);
-	return g_hash_table_lookup (priv->hash_id, id);
+	app = g_hash_table_lookup (priv->hash_id, id);
+	if (app == NULL && priv->cache_apps != NULL)
+		app = as_store_cache_lookup_id (store, id);
+	return app;
 }
 
 /**
@@ -364,6 +1479,8 @@ as_store_get_app_by_pkgname (AsStore *store, const gchar *pkgname)
 {
 	AsStorePrivate *priv = GET_PRIVATE (store);
 	g_return_val_if_fail (AS_IS_STORE (store), NULL);
+	if (priv->cache_apps != NULL)
+		return as_store_cache_lookup_pkgname (store, pkgname);
 	return g_hash_table_lookup (priv->hash_pkgname, pkgname);
 }
 
@@ -380,9 +1497,21 @@ void
 as_store_remove_app (AsStore *store, AsApp *app)
 {
 	AsStorePrivate *priv = GET_PRIVATE (store);
+	GPtrArray *pkgnames;
+	const gchar *pkgname;
+	guint i;
+
+	as_store_cache_ensure (store);
+	as_store_search_invalidate (store);
+	pkgnames = as_app_get_pkgnames (app);
+	for (i = 0; i < pkgnames->len; i++) {
+		pkgname = g_ptr_array_index (pkgnames, i);
+		if (g_hash_table_lookup (priv->hash_pkgname, pkgname) == app)
+			g_hash_table_remove (priv->hash_pkgname, pkgname);
+	}
+	as_store_index_update_app (store, app, FALSE);
 	g_hash_table_remove (priv->hash_id, as_app_get_id (app));
 	g_ptr_array_remove (priv->array, app);
-	g_hash_table_remove_all (priv->metadata_indexes);
 }
 
 /**
@@ -399,17 +1528,52 @@ as_store_remove_app_by_id (AsStore *store, const gchar *id)
 {
 	AsApp *app;
 	AsStorePrivate *priv = GET_PRIVATE (store);
-	guint i;
 
-	if (!g_hash_table_remove (priv->hash_id, id))
+	as_store_cache_ensure (store);
+	app = g_hash_table_lookup (priv->hash_id, id);
+	if (app == NULL)
 		return;
-	for (i = 0; i < priv->array->len; i++) {
-		app = g_ptr_array_index (priv->array, i);
-		if (g_strcmp0 (id, as_app_get_id (app)) != 0)
-			continue;
-		g_ptr_array_remove (priv->array, app);
+	as_store_remove_app (store, app);
+}
+
+/**
+ * as_store_subsume_app:
+ *
+ * Merges a duplicate application into the one already in the store, keeping
+ * the reverse indexes in sync with any data the stored application gains.
+ **/
+static void
+as_store_subsume_app (AsStore *store, AsApp *app, AsApp *item)
+{
+	as_store_index_update_app (store, item, FALSE);
+	as_app_subsume_full (app, item, AS_APP_SUBSUME_FLAG_BOTH_WAYS);
+	as_store_index_update_app (store, item, TRUE);
+}
+
+/**
+ * as_store_add_shadowed:
+ *
+ * Records the file that provided an application whose ID was also
+ * provided by another file, so only these files are parsed again when
+ * the version that was kept goes away.
+ **/
+static void
+as_store_add_shadowed (AsStore *store, const gchar *id, AsApp *app)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	GHashTable *files;
+	const gchar *source_file;
+
+	source_file = as_app_get_source_file (app);
+	if (source_file == NULL)
+		return;
+	files = g_hash_table_lookup (priv->hash_shadowed, id);
+	if (files == NULL) {
+		files = g_hash_table_new_full (g_str_hash, g_str_equal,
+					       g_free, NULL);
+		g_hash_table_insert (priv->hash_shadowed, g_strdup (id), files);
 	}
-	g_hash_table_remove_all (priv->metadata_indexes);
+	g_hash_table_add (files, g_strdup (source_file));
 }
 
 /**
@@ -429,10 +1593,7 @@ as_store_add_app (AsStore *store, AsApp *app)
 {
 	AsApp *item;
 	AsStorePrivate *priv = GET_PRIVATE (store);
-	GPtrArray *pkgnames;
 	const gchar *id;
-	const gchar *pkgname;
-	guint i;
 
 	/* have we recorded this before? */
 	id = as_app_get_id (app);
@@ -440,9 +1601,14 @@ as_store_add_app (AsStore *store, AsApp *app)
 		g_warning ("application has no ID set");
 		return;
 	}
+	as_store_cache_ensure (store);
 	item = g_hash_table_lookup (priv->hash_id, id);
 	if (item != NULL) {
 
+		/* one of these may need to be restored on reload */
+		as_store_add_shadowed (store, id, item);
+		as_store_add_shadowed (store, id, app);
+
 		/* the previously stored app is what we actually want */
 		if ((priv->add_flags & AS_STORE_ADD_FLAG_PREFER_LOCAL) > 0) {
 
@@ -459,7 +1625,7 @@ as_store_add_app (AsStore *store, AsApp *app)
 			if (as_app_get_source_kind (app) == AS_APP_SOURCE_KIND_APPDATA &&
 			    as_app_get_source_kind (item) == AS_APP_SOURCE_KIND_DESKTOP) {
 				g_debug ("merging duplicate AppData:desktop entries: %s", id);
-				as_app_subsume_full (app, item, AS_APP_SUBSUME_FLAG_BOTH_WAYS);
+				as_store_subsume_app (store, app, item);
 				/* promote the desktop source to AppData */
 				as_app_set_source_kind (item, AS_APP_SOURCE_KIND_APPDATA);
 				return;
@@ -467,7 +1633,7 @@ as_store_add_app (AsStore *store, AsApp *app)
 			if (as_app_get_source_kind (app) == AS_APP_SOURCE_KIND_DESKTOP &&
 			    as_app_get_source_kind (item) == AS_APP_SOURCE_KIND_APPDATA) {
 				g_debug ("merging duplicate desktop:AppData entries: %s", id);
-				as_app_subsume_full (app, item, AS_APP_SUBSUME_FLAG_BOTH_WAYS);
+				as_store_subsume_app (store, app, item);
 				return;
 			}
 
@@ -502,8 +1668,7 @@ as_store_add_app (AsStore *store, AsApp *app)
 					 as_app_source_kind_to_string (as_app_get_source_kind (app)),
 					 as_app_source_kind_to_string (as_app_get_source_kind (item)),
 					 id);
-				as_app_subsume_full (app, item,
-						     AS_APP_SUBSUME_FLAG_BOTH_WAYS);
+				as_store_subsume_app (store, app, item);
 
 				/* promote the desktop source to AppData */
 				if (as_app_get_source_kind (item) == AS_APP_SOURCE_KIND_DESKTOP &&
@@ -518,22 +1683,14 @@ as_store_add_app (AsStore *store, AsApp *app)
 		g_debug ("removing %s entry: %s",
 			 as_app_source_kind_to_string (as_app_get_source_kind (item)),
 			 id);
+		as_store_index_update_app (store, item, FALSE);
 		g_hash_table_remove (priv->hash_id, id);
 		g_ptr_array_remove (priv->array, item);
+		as_store_search_invalidate (store);
 	}
 
 	/* success, add to array */
-	g_ptr_array_add (priv->array, g_object_ref (app));
-	g_hash_table_insert (priv->hash_id,
-			     (gpointer) as_app_get_id (app),
-			     app);
-	pkgnames = as_app_get_pkgnames (app);
-	for (i = 0; i < pkgnames->len; i++) {
-		pkgname = g_ptr_array_index (pkgnames, i);
-		g_hash_table_insert (priv->hash_pkgname,
-				     g_strdup (pkgname),
-				     g_object_ref (app));
-	}
+	as_store_insert_app (store, app);
 }
 
 /**
@@ -570,84 +1727,243 @@ as_store_match_addons (AsStore *store)
 	}
 }
 
+typedef struct {
+	AsStore		*store;
+	GNode		*apps;
+	GPtrArray	*apps_parsed;	/* of AsApp */
+	const gchar	*icon_root;
+	gchar		*icon_path;
+	const gchar	*filename;
+	gchar		*origin;
+	gchar		*builder_id;
+	gchar		*api_version;
+	gboolean	 legacy_root;
+} AsStoreParseHelper;
+
+/**
+ * as_store_parse_helper_get_origin:
+ **/
+static const gchar *
+as_store_parse_helper_get_origin (AsStoreParseHelper *helper)
+{
+	AsStorePrivate *priv = GET_PRIVATE (helper->store);
+	if (helper->origin != NULL)
+		return helper->origin;
+	return priv->origin;
+}
+
+/**
+ * as_store_parse_root_attrs:
+ *
+ * Reads the attributes of the root node into @helper. They are only set
+ * on the store once the whole document has been parsed successfully.
+ **/
+static void
+as_store_parse_root_attrs (AsStoreParseHelper *helper, GNode *apps)
+{
+	const gchar *icon_root = helper->icon_root;
+	const gchar *origin;
+
+	helper->legacy_root = as_node_get_tag (apps) == AS_TAG_APPLICATIONS;
+
+	/* set in the XML file */
+	g_free (helper->api_version);
+	helper->api_version = g_strdup (as_node_get_attribute (apps, "version"));
+	g_free (helper->origin);
+	helper->origin = g_strdup (as_node_get_attribute (apps, "origin"));
+	g_free (helper->builder_id);
+	helper->builder_id = g_strdup (as_node_get_attribute (apps, "builder_id"));
+
+	/* if we have an origin either from the XML or _set_origin() */
+	g_free (helper->icon_path);
+	helper->icon_path = NULL;
+	origin = as_store_parse_helper_get_origin (helper);
+	if (origin == NULL)
+		return;
+	if (icon_root == NULL)
+		icon_root = "/usr/share/app-info/icons/";
+	helper->icon_path = g_build_filename (icon_root, origin, NULL);
+}
+
 /**
- * as_store_from_root:
+ * as_store_parse_app:
+ *
+ * Parses a component, and either adds it to the store or to @apps if the
+ * caller wants to add all the applications in one go.
  **/
 static gboolean
-as_store_from_root (AsStore *store,
-		    GNode *root,
-		    const gchar *icon_root,
+as_store_parse_app (AsStore *store,
+		    GNode *n,
+		    const gchar *icon_path,
+		    const gchar *origin,
+		    const gchar *source_file,
+		    GPtrArray *apps,
 		    GError **error)
 {
 	AsStorePrivate *priv = GET_PRIVATE (store);
-	GNode *apps;
-	GNode *n;
-	const gchar *tmp;
-	_cleanup_free_ gchar *icon_path = NULL;
+	_cleanup_error_free_ GError *error_local = NULL;
+	_cleanup_object_unref_ AsApp *app = NULL;
 
-	g_return_val_if_fail (AS_IS_STORE (store), FALSE);
+	if (as_node_get_tag (n) != AS_TAG_APPLICATION)
+		return TRUE;
+	app = as_app_new ();
+	if (icon_path != NULL)
+		as_app_set_icon_path (app, icon_path, -1);
+	as_app_set_source_kind (app, AS_APP_SOURCE_KIND_APPSTREAM);
+	as_app_set_locale_filter (app, priv->locale_filter);
+	if (!as_app_node_parse (app, n, &error_local)) {
+		g_set_error (error,
+			     AS_STORE_ERROR,
+			     AS_STORE_ERROR_FAILED,
+			     "Failed to parse root: %s",
+			     error_local->message);
+		return FALSE;
+	}
+	as_app_set_locale_filter (app, NULL);
+	as_app_set_origin (app, origin);
+	if (source_file != NULL)
+		as_app_set_source_file (app, source_file);
+	if (apps != NULL) {
+		g_ptr_array_add (apps, g_object_ref (app));
+		return TRUE;
+	}
+	as_store_add_app (store, app);
+	return TRUE;
+}
+
+/**
+ * as_store_find_root:
+ **/
+static GNode *
+as_store_find_root (GNode *root, GError **error)
+{
+	GNode *apps;
 
 	apps = as_node_find (root, "components");
-	if (apps == NULL) {
-		apps = as_node_find (root, "applications");
-		if (apps == NULL) {
-			g_set_error_literal (error,
-					     AS_STORE_ERROR,
-					     AS_STORE_ERROR_FAILED,
-					     "No valid root node specified");
-			return FALSE;
-		}
-		priv->problems |= AS_STORE_PROBLEM_LEGACY_ROOT;
-	}
+	if (apps != NULL)
+		return apps;
+	apps = as_node_find (root, "applications");
+	if (apps != NULL)
+		return apps;
+	g_set_error_literal (error,
+			     AS_STORE_ERROR,
+			     AS_STORE_ERROR_FAILED,
+			     "No valid root node specified");
+	return NULL;
+}
 
-	/* get version */
-	tmp = as_node_get_attribute (apps, "version");
-	if (tmp != NULL)
-		priv->api_version = g_ascii_strtod (tmp, NULL);
+/**
+ * as_store_parse_helper_init:
+ **/
+static void
+as_store_parse_helper_init (AsStoreParseHelper *helper,
+			    AsStore *store,
+			    const gchar *icon_root,
+			    const gchar *filename)
+{
+	helper->store = store;
+	helper->apps = NULL;
+	helper->apps_parsed = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	helper->icon_root = icon_root;
+	helper->icon_path = NULL;
+	helper->filename = filename;
+	helper->origin = NULL;
+	helper->builder_id = NULL;
+	helper->api_version = NULL;
+	helper->legacy_root = FALSE;
+}
 
-	/* set in the XML file */
-	tmp = as_node_get_attribute (apps, "origin");
-	if (tmp != NULL)
-		as_store_set_origin (store, tmp);
+/**
+ * as_store_parse_helper_finish:
+ *
+ * Adds the applications from a streamed parse to the store. Nothing is
+ * added until the whole document has been parsed, so a truncated or
+ * invalid file never leaves a partial catalog in the store.
+ **/
+static gboolean
+as_store_parse_helper_finish (AsStoreParseHelper *helper,
+			      GNode *root,
+			      GError **error)
+{
+	AsApp *app;
+	AsStorePrivate *priv = GET_PRIVATE (helper->store);
+	GNode *apps;
+	guint i;
 
-	/* set in the XML file */
-	tmp = as_node_get_attribute (apps, "builder_id");
-	if (tmp != NULL)
-		as_store_set_builder_id (store, tmp);
+	/* the parse failed */
+	if (root == NULL)
+		return FALSE;
 
-	/* if we have an origin either from the XML or _set_origin() */
-	if (priv->origin != NULL) {
-		if (icon_root == NULL)
-			icon_root = "/usr/share/app-info/icons/";
-		icon_path = g_build_filename (icon_root,
-					      priv->origin,
-					      NULL);
-	}
-	for (n = apps->children; n != NULL; n = n->next) {
-		_cleanup_error_free_ GError *error_local = NULL;
-		_cleanup_object_unref_ AsApp *app = NULL;
-		if (as_node_get_tag (n) != AS_TAG_APPLICATION)
-			continue;
-		app = as_app_new ();
-		if (icon_path != NULL)
-			as_app_set_icon_path (app, icon_path, -1);
-		as_app_set_source_kind (app, AS_APP_SOURCE_KIND_APPSTREAM);
-		if (!as_app_node_parse (app, n, &error_local)) {
-			g_set_error (error,
-				     AS_STORE_ERROR,
-				     AS_STORE_ERROR_FAILED,
-				     "Failed to parse root: %s",
-				     error_local->message);
-			return FALSE;
-		}
-		as_app_set_origin (app, priv->origin);
-		as_store_add_app (store, app);
+	/* the root attributes still need parsing if there were no
+	 * components in the document */
+	apps = as_store_find_root (root, error);
+	if (apps == NULL)
+		return FALSE;
+	if (helper->apps == NULL)
+		as_store_parse_root_attrs (helper, apps);
+
+	/* the document is valid, so the root attributes can be used */
+	if (helper->legacy_root)
+		priv->problems |= AS_STORE_PROBLEM_LEGACY_ROOT;
+	if (helper->api_version != NULL)
+		priv->api_version = g_ascii_strtod (helper->api_version, NULL);
+	if (helper->origin != NULL)
+		as_store_set_origin (helper->store, helper->origin);
+	if (helper->builder_id != NULL)
+		as_store_set_builder_id (helper->store, helper->builder_id);
+	for (i = 0; i < helper->apps_parsed->len; i++) {
+		app = g_ptr_array_index (helper->apps_parsed, i);
+		as_store_add_app (helper->store, app);
 	}
 
-	/* add addon kinds to their parent AsApp */
-	as_store_match_addons (store);
+	/* add addon kinds to their parent AsApp */
+	as_store_match_addons (helper->store);
+	return TRUE;
+}
+
+/**
+ * as_store_parse_helper_clear:
+ **/
+static void
+as_store_parse_helper_clear (AsStoreParseHelper *helper)
+{
+	g_ptr_array_unref (helper->apps_parsed);
+	g_free (helper->icon_path);
+	g_free (helper->origin);
+	g_free (helper->builder_id);
+	g_free (helper->api_version);
+}
+
+/**
+ * as_store_parse_split_cb:
+ *
+ * Called for each complete <component> as soon as it has been parsed, before
+ * the subtree is freed.
+ **/
+static gboolean
+as_store_parse_split_cb (GNode *n, gpointer user_data, GError **error)
+{
+	AsStoreParseHelper *helper = (AsStoreParseHelper *) user_data;
+	GNode *apps = n->parent;
+	const gchar *tmp;
+
+	/* not in a valid root node */
+	tmp = as_node_get_name (apps);
+	if (g_strcmp0 (tmp, "components") != 0 &&
+	    g_strcmp0 (tmp, "applications") != 0)
+		return TRUE;
 
-	return TRUE;
+	/* the root attributes are always parsed before the first child */
+	if (helper->apps != apps) {
+		helper->apps = apps;
+		as_store_parse_root_attrs (helper, apps);
+	}
+	return as_store_parse_app (helper->store, n,
+				   helper->icon_path,
+				   as_store_parse_helper_get_origin (helper),
+				   helper->filename,
+				   helper->apps_parsed,
+				   error);
 }
 
 /**
@@ -664,6 +1980,7 @@ as_store_load_yaml_file (AsStore *store,
 	GNode *app_n;
 	GNode *n;
 	const gchar *tmp;
+	_cleanup_free_ gchar *filename = NULL;
 	_cleanup_free_ gchar *icon_path = NULL;
 	_cleanup_yaml_unref_ GNode *root = NULL;
 
@@ -696,6 +2013,7 @@ as_store_load_yaml_file (AsStore *store,
 	}
 
 	/* parse applications */
+	filename = g_file_get_path (file);
 	for (app_n = root->children->next; app_n != NULL; app_n = app_n->next) {
 		_cleanup_object_unref_ AsApp *app = NULL;
 		if (app_n->children == NULL)
@@ -704,9 +2022,12 @@ as_store_load_yaml_file (AsStore *store,
 		if (icon_path != NULL)
 			as_app_set_icon_path (app, icon_path, -1);
 		as_app_set_source_kind (app, AS_APP_SOURCE_KIND_APPSTREAM);
+		as_app_set_locale_filter (app, priv->locale_filter);
 		if (!as_app_node_parse_dep11 (app, app_n, error))
 			return FALSE;
+		as_app_set_locale_filter (app, NULL);
 		as_app_set_origin (app, priv->origin);
+		as_app_set_source_file (app, filename);
 		if (as_app_get_id (app) != NULL)
 			as_store_add_app (store, app);
 	}
@@ -722,7 +2043,8 @@ as_store_load_yaml_file (AsStore *store,
  * @error: A #GError or %NULL.
  *
  * Parses an AppStream XML or DEP-11 YAML file and adds any valid applications
- * to the store.
+ * to the store. If an AppStream XML file cannot be parsed then no applications
+ * from it are added.
  *
  * If the root node does not have a 'origin' attribute, then the method
  * as_store_set_origin() should be called *before* this function if cached
@@ -739,6 +2061,8 @@ as_store_from_file (AsStore *store,
 		    GCancellable *cancellable,
 		    GError **error)
 {
+	AsStoreParseHelper helper;
+	gboolean ret;
 	_cleanup_free_ gchar *filename = NULL;
 	_cleanup_error_free_ GError *error_local = NULL;
 	_cleanup_node_unref_ GNode *root = NULL;
@@ -747,16 +2071,20 @@ as_store_from_file (AsStore *store,
 
 	/* a DEP-11 file */
 	filename = g_file_get_path (file);
+	as_store_add_cache_source (store, filename);
 	if (g_strstr_len (filename, -1, ".yml") != NULL)
 		return as_store_load_yaml_file (store, file, icon_root,
 						cancellable, error);
 
-	/* an AppStream XML file */
-	root = as_node_from_file (file,
-				  AS_NODE_FROM_XML_FLAG_LITERAL_TEXT,
-				  cancellable,
-				  &error_local);
+	/* an AppStream XML file, parsed one component at a time */
+	as_store_parse_helper_init (&helper, store, icon_root, filename);
+	root = as_node_from_file_full (file,
+				       AS_NODE_FROM_XML_FLAG_LITERAL_TEXT,
+				       3, as_store_parse_split_cb, &helper,
+				       cancellable,
+				       &error_local);
 	if (root == NULL) {
+		as_store_parse_helper_clear (&helper);
 		g_set_error (error,
 			     AS_STORE_ERROR,
 			     AS_STORE_ERROR_FAILED,
@@ -764,7 +2092,9 @@ as_store_from_file (AsStore *store,
 			     filename, error_local->message);
 		return FALSE;
 	}
-	return as_store_from_root (store, root, icon_root, error);
+	ret = as_store_parse_helper_finish (&helper, root, error);
+	as_store_parse_helper_clear (&helper);
+	return ret;
 }
 
 /**
@@ -776,6 +2106,7 @@ as_store_from_file (AsStore *store,
  * @error: A #GError or %NULL.
  *
  * Parses AppStream XML file and adds any valid applications to the store.
+ * If the data cannot be parsed then no applications are added.
  *
  * If the root node does not have a 'origin' attribute, then the method
  * as_store_set_origin() should be called *before* this function if cached
@@ -792,23 +2123,30 @@ as_store_from_xml (AsStore *store,
 		   const gchar *icon_root,
 		   GError **error)
 {
+	AsStoreParseHelper helper;
+	gboolean ret;
 	_cleanup_error_free_ GError *error_local = NULL;
 	_cleanup_node_unref_ GNode *root = NULL;
 
 	g_return_val_if_fail (AS_IS_STORE (store), FALSE);
 
-	root = as_node_from_xml (data, data_len,
-				 AS_NODE_FROM_XML_FLAG_LITERAL_TEXT,
-				 &error_local);
+	as_store_parse_helper_init (&helper, store, icon_root, NULL);
+	root = as_node_from_xml_full (data, data_len,
+				      AS_NODE_FROM_XML_FLAG_LITERAL_TEXT,
+				      3, as_store_parse_split_cb, &helper,
+				      &error_local);
 	if (root == NULL) {
+		as_store_parse_helper_clear (&helper);
 		g_set_error (error,
 			     AS_STORE_ERROR,
 			     AS_STORE_ERROR_FAILED,
 			     "Failed to parse XML: %s",
 			     error_local->message);
-		return TRUE;
+		return FALSE;
 	}
-	return as_store_from_root (store, root, icon_root, error);
+	ret = as_store_parse_helper_finish (&helper, root, error);
+	as_store_parse_helper_clear (&helper);
+	return ret;
 }
 
 /**
@@ -822,50 +2160,277 @@ as_store_apps_sort_cb (gconstpointer a, gconstpointer b)
 }
 
 /**
- * as_store_to_xml:
- * @store: a #AsStore instance.
- * @flags: the AsNodeToXmlFlags, e.g. %AS_NODE_INSERT_FLAG_NONE.
- *
- * Outputs an XML representation of all the applications in the store.
+ * as_store_to_node_root:
  *
- * Returns: A #GString
- *
- * Since: 0.1.0
+ * Creates the root node with the store-wide attributes, but no applications.
  **/
-GString *
-as_store_to_xml (AsStore *store, AsNodeToXmlFlags flags)
+static GNode *
+as_store_to_node_root (AsStore *store, GNode **node_apps)
 {
-	AsApp *app;
 	AsStorePrivate *priv = GET_PRIVATE (store);
-	GNode *node_apps;
 	GNode *node_root;
-	GString *xml;
-	guint i;
 	gchar version[6];
 
-	/* get XML text */
 	node_root = as_node_new ();
 	if (priv->api_version >= 0.6) {
-		node_apps = as_node_insert (node_root, "components", NULL, 0, NULL);
+		*node_apps = as_node_insert (node_root, "components", NULL, 0, NULL);
 	} else {
-		node_apps = as_node_insert (node_root, "applications", NULL, 0, NULL);
+		*node_apps = as_node_insert (node_root, "applications", NULL, 0, NULL);
 	}
 
 	/* set origin attribute */
 	if (priv->origin != NULL)
-		as_node_add_attribute (node_apps, "origin", priv->origin, -1);
+		as_node_add_attribute (*node_apps, "origin", priv->origin, -1);
 
 	/* set origin attribute */
 	if (priv->builder_id != NULL)
-		as_node_add_attribute (node_apps, "builder_id", priv->builder_id, -1);
+		as_node_add_attribute (*node_apps, "builder_id", priv->builder_id, -1);
 
 	/* set version attribute */
 	if (priv->api_version > 0.1f) {
 		g_ascii_formatd (version, sizeof (version),
 				 "%.1f", priv->api_version);
-		as_node_add_attribute (node_apps, "version", version, -1);
+		as_node_add_attribute (*node_apps, "version", version, -1);
+	}
+	return node_root;
+}
+
+#define AS_STORE_XML_BATCH_SIZE		256
+
+typedef struct {
+	AsApp			*app;
+	GString			*xml;
+	gdouble			 api_version;
+	AsNodeToXmlFlags	 flags;
+} AsStoreXmlItem;
+
+typedef struct {
+	GMutex			 mutex;
+	GCond			 cond;
+	guint			 pending;
+} AsStoreXmlBatch;
+
+/**
+ * as_store_xml_item_func:
+ *
+ * Renders one application into its own buffer using a private tree, so this
+ * can be run from any thread. The tree has the same depth as the complete
+ * document and so the indentation is identical.
+ **/
+static void
+as_store_xml_item_func (gpointer data, gpointer user_data)
+{
+	AsStoreXmlItem *item = (AsStoreXmlItem *) data;
+	GNode *node_app;
+	GNode *node_apps;
+	_cleanup_node_unref_ GNode *node_root = NULL;
+
+	node_root = as_node_new ();
+	node_apps = as_node_insert (node_root, "components", NULL, 0, NULL);
+	node_app = as_app_node_insert (item->app, node_apps, item->api_version);
+	if (node_app == NULL)
+		return;
+	item->xml = g_string_new ("");
+	as_node_to_xml_child (item->xml, node_app, item->flags);
+}
+
+/**
+ * as_store_xml_item_thread_func:
+ **/
+static void
+as_store_xml_item_thread_func (gpointer data, gpointer user_data)
+{
+	AsStoreXmlBatch *batch = (AsStoreXmlBatch *) user_data;
+
+	as_store_xml_item_func (data, NULL);
+	g_mutex_lock (&batch->mutex);
+	if (--batch->pending == 0)
+		g_cond_signal (&batch->cond);
+	g_mutex_unlock (&batch->mutex);
+}
+
+/**
+ * as_store_to_xml_can_stream:
+ **/
+static gboolean
+as_store_to_xml_can_stream (AsStore *store, AsNodeToXmlFlags flags)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+
+	/* sorting needs all the children at once */
+	if (flags & AS_NODE_TO_XML_FLAG_SORT_CHILDREN)
+		return FALSE;
+
+	/* priority is written between the applications in these versions */
+	if (priv->api_version > 0.3 && priv->api_version <= 0.5)
+		return FALSE;
+	return TRUE;
+}
+
+/**
+ * as_store_to_xml_flush:
+ **/
+static gboolean
+as_store_to_xml_flush (GOutputStream *out,
+		       GString *xml,
+		       GCancellable *cancellable,
+		       GError **error)
+{
+	if (out == NULL)
+		return TRUE;
+	if (!g_output_stream_write_all (out, xml->str, xml->len,
+					NULL, cancellable, error))
+		return FALSE;
+	g_string_truncate (xml, 0);
+	return TRUE;
+}
+
+/**
+ * as_store_to_xml_stream:
+ *
+ * Writes the same XML as building the complete tree would, but only builds
+ * the nodes for a batch of applications at a time. If %AS_NODE_TO_XML_FLAG_PARALLEL
+ * is set the applications in each batch are rendered using a thread pool,
+ * which is shared by all the batches, and then concatenated in the sorted
+ * order.
+ *
+ * If @out is %NULL the output is appended to @xml, otherwise it is written
+ * to @out after each batch.
+ **/
+static gboolean
+as_store_to_xml_stream (AsStore *store,
+			GString *xml,
+			GOutputStream *out,
+			AsNodeToXmlFlags flags,
+			GCancellable *cancellable,
+			GError **error)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	AsStoreXmlBatch helper;
+	GNode *node_apps;
+	GThreadPool *pool = NULL;
+	gboolean ret = FALSE;
+	gboolean xml_started = FALSE;
+	guint batch;
+	guint i;
+	guint j;
+	_cleanup_free_ AsStoreXmlItem *items = NULL;
+	_cleanup_node_unref_ GNode *node_root = NULL;
+
+	as_store_cache_ensure (store);
+	node_root = as_store_to_node_root (store, &node_apps);
+	g_ptr_array_sort (priv->array, as_store_apps_sort_cb);
+
+	/* the workers are reused for every batch */
+	g_mutex_init (&helper.mutex);
+	g_cond_init (&helper.cond);
+	helper.pending = 0;
+	if (flags & AS_NODE_TO_XML_FLAG_PARALLEL) {
+		pool = g_thread_pool_new (as_store_xml_item_thread_func,
+					  &helper,
+					  (gint) g_get_num_processors (),
+					  FALSE,
+					  NULL);
+	}
+
+	items = g_new0 (AsStoreXmlItem, AS_STORE_XML_BATCH_SIZE);
+	for (i = 0; i < priv->array->len; i += batch) {
+
+		/* render each application */
+		batch = MIN (AS_STORE_XML_BATCH_SIZE, priv->array->len - i);
+		for (j = 0; j < batch; j++) {
+			items[j].app = g_ptr_array_index (priv->array, i + j);
+			items[j].xml = NULL;
+			items[j].api_version = priv->api_version;
+			items[j].flags = flags;
+		}
+		if (pool != NULL) {
+			g_mutex_lock (&helper.mutex);
+			helper.pending = batch;
+			g_mutex_unlock (&helper.mutex);
+			for (j = 0; j < batch; j++) {
+				if (!g_thread_pool_push (pool, &items[j], NULL)) {
+					/* render it here instead */
+					as_store_xml_item_thread_func (&items[j],
+								       &helper);
+				}
+			}
+			g_mutex_lock (&helper.mutex);
+			while (helper.pending > 0)
+				g_cond_wait (&helper.cond, &helper.mutex);
+			g_mutex_unlock (&helper.mutex);
+		} else {
+			for (j = 0; j < batch; j++)
+				as_store_xml_item_func (&items[j], NULL);
+		}
+
+		/* join them in order */
+		for (j = 0; j < batch; j++) {
+			if (items[j].xml == NULL)
+				continue;
+			if (!xml_started) {
+				if (flags & AS_NODE_TO_XML_FLAG_ADD_HEADER)
+					g_string_append (xml, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+				as_node_to_xml_start (xml, node_apps, flags);
+				xml_started = TRUE;
+			}
+			g_string_append_len (xml, items[j].xml->str, items[j].xml->len);
+			g_string_free (items[j].xml, TRUE);
+		}
+		if (!as_store_to_xml_flush (out, xml, cancellable, error))
+			goto out;
+	}
+
+	/* nothing was added, so this is written as a single empty tag */
+	if (!xml_started) {
+		_cleanup_string_free_ GString *xml_root = NULL;
+		xml_root = as_node_to_xml (node_root, flags);
+		g_string_append_len (xml, xml_root->str, xml_root->len);
+	} else {
+		as_node_to_xml_end (xml, node_apps, flags);
+	}
+	ret = as_store_to_xml_flush (out, xml, cancellable, error);
+out:
+	if (pool != NULL)
+		g_thread_pool_free (pool, FALSE, TRUE);
+	g_mutex_clear (&helper.mutex);
+	g_cond_clear (&helper.cond);
+	return ret;
+}
+
+/**
+ * as_store_to_xml:
+ * @store: a #AsStore instance.
+ * @flags: the AsNodeToXmlFlags, e.g. %AS_NODE_INSERT_FLAG_NONE.
+ *
+ * Outputs an XML representation of all the applications in the store.
+ *
+ * Returns: A #GString
+ *
+ * Since: 0.1.0
+ **/
+GString *
+as_store_to_xml (AsStore *store, AsNodeToXmlFlags flags)
+{
+	AsApp *app;
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	GNode *node_apps;
+	GNode *node_root;
+	GString *xml;
+	guint i;
+
+	/* build the output without a complete tree */
+	if ((flags & AS_NODE_TO_XML_FLAG_PARALLEL) > 0 &&
+	    as_store_to_xml_can_stream (store, flags)) {
+		xml = g_string_new ("");
+		as_store_to_xml_stream (store, xml, NULL, flags, NULL, NULL);
+		return xml;
 	}
 
+	/* get XML text */
+	as_store_cache_ensure (store);
+	node_root = as_store_to_node_root (store, &node_apps);
+
 	/* sort by ID */
 	g_ptr_array_sort (priv->array, as_store_apps_sort_cb);
 
@@ -899,6 +2464,7 @@ as_store_convert_icons (AsStore *store, AsIconKind kind, GError **error)
 	guint i;
 
 	/* convert application icons */
+	as_store_cache_ensure (store);
 	for (i = 0; i < priv->array->len; i++) {
 		app = g_ptr_array_index (priv->array, i);
 		if (!as_app_convert_icons (app, kind, error))
@@ -919,83 +2485,418 @@ as_store_convert_icons (AsStore *store, AsIconKind kind, GError **error)
  *
  * Returns: A #GString
  *
- * Since: 0.1.0
+ * Since: 0.1.0
+ **/
+gboolean
+as_store_to_file (AsStore *store,
+		  GFile *file,
+		  AsNodeToXmlFlags flags,
+		  GCancellable *cancellable,
+		  GError **error)
+{
+	gboolean ret;
+	_cleanup_error_free_ GError *error_local = NULL;
+	_cleanup_object_unref_ GFileOutputStream *out = NULL;
+	_cleanup_object_unref_ GOutputStream *out2 = NULL;
+	_cleanup_object_unref_ GZlibCompressor *compressor = NULL;
+	_cleanup_free_ gchar *basename = NULL;
+	_cleanup_string_free_ GString *xml = NULL;
+
+	/* write to a temporary file which replaces the original on close */
+	out = g_file_replace (file, NULL, FALSE, G_FILE_CREATE_NONE,
+			      cancellable, &error_local);
+	if (out == NULL) {
+		g_set_error (error,
+			     AS_STORE_ERROR,
+			     AS_STORE_ERROR_FAILED,
+			     "Failed to write file: %s",
+			     error_local->message);
+		return FALSE;
+	}
+
+	/* check if compressed */
+	basename = g_file_get_basename (file);
+	if (g_strstr_len (basename, -1, ".gz") != NULL) {
+		compressor = g_zlib_compressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP, -1);
+		out2 = g_converter_output_stream_new (G_OUTPUT_STREAM (out),
+						      G_CONVERTER (compressor));
+	} else {
+		out2 = g_object_ref (out);
+	}
+
+	/* write each component as it is generated */
+	if (as_store_to_xml_can_stream (store, flags)) {
+		xml = g_string_new ("");
+		ret = as_store_to_xml_stream (store, xml, out2, flags,
+					      cancellable, &error_local);
+	} else {
+		xml = as_store_to_xml (store, flags);
+		ret = g_output_stream_write_all (out2, xml->str, xml->len,
+						 NULL, cancellable, &error_local);
+	}
+	if (!ret) {
+		_cleanup_object_unref_ GCancellable *cancellable_abort = NULL;
+
+		/* leave the original file untouched */
+		cancellable_abort = g_cancellable_new ();
+		g_cancellable_cancel (cancellable_abort);
+		g_output_stream_close (G_OUTPUT_STREAM (out), cancellable_abort, NULL);
+		g_set_error (error,
+			     AS_STORE_ERROR,
+			     AS_STORE_ERROR_FAILED,
+			     "Failed to write stream: %s",
+			     error_local->message);
+		return FALSE;
+	}
+	if (!g_output_stream_close (out2, cancellable, &error_local)) {
+		g_set_error (error,
+			     AS_STORE_ERROR,
+			     AS_STORE_ERROR_FAILED,
+			     "Failed to close stream: %s",
+			     error_local->message);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * as_store_cache_index_to_variant:
+ *
+ * Saves a reverse index as a sorted array of the value and the positions
+ * of the applications in the cache.
+ **/
+static GVariant *
+as_store_cache_index_to_variant (AsStore *store,
+				 AsStoreIndex idx,
+				 GHashTable *indexes)
+{
+	AsApp *app;
+	AsStoreIndexEntry *entry;
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	GList *keys;
+	GList *l;
+	GVariantBuilder builder;
+	gpointer value;
+	guint i;
+
+	as_store_index_ensure (store, idx);
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(sau)"));
+	keys = g_hash_table_get_keys (priv->indexes[idx]);
+	keys = g_list_sort (keys, (GCompareFunc) g_strcmp0);
+	for (l = keys; l != NULL; l = l->next) {
+		GVariantBuilder builder_apps;
+		entry = g_hash_table_lookup (priv->indexes[idx], l->data);
+		g_variant_builder_init (&builder_apps, G_VARIANT_TYPE ("au"));
+		for (i = 0; i < entry->apps->len; i++) {
+			app = g_ptr_array_index (entry->apps, i);
+			if (!g_hash_table_lookup_extended (indexes,
+							   as_app_get_id (app),
+							   NULL, &value))
+				continue;
+			g_variant_builder_add (&builder_apps, "u",
+					       GPOINTER_TO_UINT (value));
+		}
+		g_variant_builder_add (&builder, "(sau)",
+				       (const gchar *) l->data,
+				       &builder_apps);
+	}
+	g_list_free (keys);
+	return g_variant_builder_end (&builder);
+}
+
+/**
+ * as_store_to_cache:
+ * @store: a #AsStore instance.
+ * @file: file
+ * @cancellable: A #GCancellable, or %NULL
+ * @error: A #GError or %NULL
+ *
+ * Writes a binary cache of all the applications in the store which can be
+ * loaded much faster than the original metadata using as_store_from_cache().
+ *
+ * The cache records the modification times of all the files and directories
+ * the store was loaded from, and will be treated as invalid if any of them
+ * have changed.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 0.3.3
+ **/
+gboolean
+as_store_to_cache (AsStore *store,
+		   GFile *file,
+		   GCancellable *cancellable,
+		   GError **error)
+{
+	AsApp *addon;
+	AsApp *app;
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	GHashTableIter iter;
+	GPtrArray *addons;
+	GList *keys;
+	GList *l;
+	GVariantBuilder builder_apps;
+	GVariantBuilder builder_ids;
+	GVariantBuilder builder_pkgnames;
+	GVariantBuilder builder_sources;
+	gpointer key;
+	gpointer value;
+	guint i;
+	guint j;
+	_cleanup_error_free_ GError *error_local = NULL;
+	_cleanup_hashtable_unref_ GHashTable *indexes = NULL;
+	_cleanup_variant_unref_ GVariant *cache = NULL;
+
+	g_return_val_if_fail (AS_IS_STORE (store), FALSE);
+
+	/* the index is just the position in the sorted array */
+	as_store_cache_ensure (store);
+	g_ptr_array_sort (priv->array, as_store_apps_sort_cb);
+	indexes = g_hash_table_new (g_str_hash, g_str_equal);
+	for (i = 0; i < priv->array->len; i++) {
+		app = g_ptr_array_index (priv->array, i);
+		g_hash_table_insert (indexes,
+				     (gpointer) as_app_get_id (app),
+				     GUINT_TO_POINTER (i));
+	}
+
+	/* the files used to create the store */
+	g_variant_builder_init (&builder_sources, G_VARIANT_TYPE ("a(stt)"));
+	g_hash_table_iter_init (&iter, priv->cache_sources);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		AsStoreCacheSource *source = value;
+		g_variant_builder_add (&builder_sources, "(stt)",
+				       (const gchar *) key,
+				       source->mtime,
+				       source->size);
+	}
+
+	/* add each application */
+	g_variant_builder_init (&builder_ids, G_VARIANT_TYPE ("as"));
+	g_variant_builder_init (&builder_apps,
+				G_VARIANT_TYPE ("a(au" AS_APP_VARIANT_TYPE ")"));
+	for (i = 0; i < priv->array->len; i++) {
+		GVariantBuilder builder_addons;
+
+		app = g_ptr_array_index (priv->array, i);
+		g_variant_builder_add (&builder_ids, "s", as_app_get_id (app));
+
+		/* save the addons as indexes into the array */
+		g_variant_builder_init (&builder_addons, G_VARIANT_TYPE ("au"));
+		addons = as_app_get_addons (app);
+		for (j = 0; j < addons->len; j++) {
+			addon = g_ptr_array_index (addons, j);
+			if (!g_hash_table_lookup_extended (indexes,
+							   as_app_get_id (addon),
+							   NULL, &value))
+				continue;
+			g_variant_builder_add (&builder_addons, "u",
+					       GPOINTER_TO_UINT (value));
+		}
+
+		/* the application itself is stored in binary form */
+		g_variant_builder_add (&builder_apps, "(au@" AS_APP_VARIANT_TYPE ")",
+				       &builder_addons,
+				       as_app_to_variant (app));
+	}
+
+	/* the package name lookup, sorted for a binary search */
+	g_variant_builder_init (&builder_pkgnames, G_VARIANT_TYPE ("a(su)"));
+	keys = g_hash_table_get_keys (priv->hash_pkgname);
+	keys = g_list_sort (keys, (GCompareFunc) g_strcmp0);
+	for (l = keys; l != NULL; l = l->next) {
+		app = g_hash_table_lookup (priv->hash_pkgname, l->data);
+		if (!g_hash_table_lookup_extended (indexes,
+						   as_app_get_id (app),
+						   NULL, &value))
+			continue;
+		g_variant_builder_add (&builder_pkgnames, "(su)",
+				       (const gchar *) l->data,
+				       GPOINTER_TO_UINT (value));
+	}
+	g_list_free (keys);
+
+	cache = g_variant_new ("(sudssa(stt)asa(au" AS_APP_VARIANT_TYPE ")"
+			       "a(su)@a(sau)@a(sau)@a(sau))",
+			       AS_STORE_CACHE_MAGIC,
+			       AS_STORE_CACHE_VERSION,
+			       priv->api_version,
+			       priv->origin ? priv->origin : "",
+			       priv->builder_id ? priv->builder_id : "",
+			       &builder_sources,
+			       &builder_ids,
+			       &builder_apps,
+			       &builder_pkgnames,
+			       as_store_cache_index_to_variant (store, AS_STORE_INDEX_PROVIDE, indexes),
+			       as_store_cache_index_to_variant (store, AS_STORE_INDEX_MIMETYPE, indexes),
+			       as_store_cache_index_to_variant (store, AS_STORE_INDEX_CATEGORY, indexes));
+	g_variant_ref_sink (cache);
+
+	/* write file */
+	if (!g_file_replace_contents (file,
+				      g_variant_get_data (cache),
+				      g_variant_get_size (cache),
+				      NULL,
+				      FALSE,
+				      G_FILE_CREATE_NONE,
+				      NULL,
+				      cancellable,
+				      &error_local)) {
+		g_set_error (error,
+			     AS_STORE_ERROR,
+			     AS_STORE_ERROR_FAILED,
+			     "Failed to write file: %s",
+			     error_local->message);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * as_store_from_cache:
+ * @store: a #AsStore instance.
+ * @file: file
+ * @cancellable: A #GCancellable, or %NULL
+ * @error: A #GError or %NULL
+ *
+ * Loads a binary cache created with as_store_to_cache().
+ *
+ * The cache file is memory mapped and when loaded into an empty store the
+ * applications are only created when they are first required. If any of the
+ * files used to create the cache have been changed since it was written then
+ * an error is returned and the caller should fall back to as_store_load().
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 0.3.3
  **/
 gboolean
-as_store_to_file (AsStore *store,
-		  GFile *file,
-		  AsNodeToXmlFlags flags,
-		  GCancellable *cancellable,
-		  GError **error)
+as_store_from_cache (AsStore *store,
+		     GFile *file,
+		     GCancellable *cancellable,
+		     GError **error)
 {
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	AsStoreCacheSource source;
+	AsStoreCacheSource source_tmp;
+	GVariantIter iter;
+	const gchar *builder_id;
+	const gchar *magic;
+	const gchar *origin;
+	const gchar *tmp;
+	gdouble api_version;
+	guint32 version;
+	guint i;
+	guint len;
+	_cleanup_bytes_unref_ GBytes *bytes = NULL;
 	_cleanup_error_free_ GError *error_local = NULL;
-	_cleanup_object_unref_ GOutputStream *out2 = NULL;
-	_cleanup_object_unref_ GOutputStream *out = NULL;
-	_cleanup_object_unref_ GZlibCompressor *compressor = NULL;
-	_cleanup_string_free_ GString *xml = NULL;
-	_cleanup_free_ gchar *basename = NULL;
+	_cleanup_free_ gchar *filename = NULL;
+	_cleanup_mapped_file_unref_ GMappedFile *mapped_file = NULL;
+	_cleanup_variant_unref_ GVariant *apps = NULL;
+	_cleanup_variant_unref_ GVariant *cache = NULL;
+	_cleanup_variant_unref_ GVariant *ids = NULL;
+	_cleanup_variant_unref_ GVariant *sources = NULL;
 
-	/* check if compressed */
-	basename = g_file_get_basename (file);
-	if (g_strstr_len (basename, -1, ".gz") == NULL) {
-		xml = as_store_to_xml (store, flags);
-		if (!g_file_replace_contents (file, xml->str, xml->len,
-					      NULL,
-					      FALSE,
-					      G_FILE_CREATE_NONE,
-					      NULL,
-					      cancellable,
-					      &error_local)) {
-			g_set_error (error,
-				     AS_STORE_ERROR,
-				     AS_STORE_ERROR_FAILED,
-				     "Failed to write file: %s",
-				     error_local->message);
-			return FALSE;
-		}
-		return TRUE;
-	}
+	g_return_val_if_fail (AS_IS_STORE (store), FALSE);
 
-	/* compress as a gzip file */
-	compressor = g_zlib_compressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP, -1);
-	out = g_memory_output_stream_new_resizable ();
-	out2 = g_converter_output_stream_new (out, G_CONVERTER (compressor));
-	xml = as_store_to_xml (store, flags);
-	if (!g_output_stream_write_all (out2, xml->str, xml->len,
-					NULL, NULL, &error_local)) {
+	/* map the file */
+	filename = g_file_get_path (file);
+	mapped_file = g_mapped_file_new (filename, FALSE, &error_local);
+	if (mapped_file == NULL) {
 		g_set_error (error,
 			     AS_STORE_ERROR,
 			     AS_STORE_ERROR_FAILED,
-			     "Failed to write stream: %s",
-			     error_local->message);
+			     "Failed to map %s: %s",
+			     filename, error_local->message);
 		return FALSE;
 	}
-	if (!g_output_stream_close (out2, NULL, &error_local)) {
+	bytes = g_mapped_file_get_bytes (mapped_file);
+	cache = g_variant_new_from_bytes (G_VARIANT_TYPE (AS_STORE_CACHE_FORMAT),
+					  bytes, FALSE);
+	g_variant_ref_sink (cache);
+
+	/* check the header, which also catches a different byte order */
+	g_variant_get_child (cache, 0, "&s", &magic);
+	g_variant_get_child (cache, 1, "u", &version);
+	if (g_strcmp0 (magic, AS_STORE_CACHE_MAGIC) != 0 ||
+	    version != AS_STORE_CACHE_VERSION) {
 		g_set_error (error,
 			     AS_STORE_ERROR,
 			     AS_STORE_ERROR_FAILED,
-			     "Failed to close stream: %s",
-			     error_local->message);
+			     "%s is not a valid cache file",
+			     filename);
 		return FALSE;
 	}
 
-	/* write file */
-	if (!g_file_replace_contents (file,
-		g_memory_output_stream_get_data (G_MEMORY_OUTPUT_STREAM (out)),
-		g_memory_output_stream_get_data_size (G_MEMORY_OUTPUT_STREAM (out)),
-				      NULL,
-				      FALSE,
-				      G_FILE_CREATE_NONE,
-				      NULL,
-				      cancellable,
-				      &error_local)) {
-		g_set_error (error,
-			     AS_STORE_ERROR,
-			     AS_STORE_ERROR_FAILED,
-			     "Failed to write file: %s",
-			     error_local->message);
-		return FALSE;
+	/* check none of the source files have changed */
+	sources = g_variant_get_child_value (cache, 5);
+	g_variant_iter_init (&iter, sources);
+	while (g_variant_iter_next (&iter, "(&stt)", &tmp,
+				    &source.mtime, &source.size)) {
+		if (!as_store_cache_source_stat (tmp, &source_tmp) ||
+		    source_tmp.mtime != source.mtime ||
+		    source_tmp.size != source.size) {
+			g_set_error (error,
+				     AS_STORE_ERROR,
+				     AS_STORE_ERROR_FAILED,
+				     "%s is out of date as %s has changed",
+				     filename, tmp);
+			return FALSE;
+		}
+	}
+	g_variant_iter_init (&iter, sources);
+	while (g_variant_iter_next (&iter, "(&stt)", &tmp,
+				    &source.mtime, &source.size)) {
+		g_hash_table_insert (priv->cache_sources,
+				     g_strdup (tmp),
+				     g_memdup (&source, sizeof (AsStoreCacheSource)));
+	}
+
+	/* the store metadata */
+	g_variant_get_child (cache, 2, "d", &api_version);
+	g_variant_get_child (cache, 3, "&s", &origin);
+	g_variant_get_child (cache, 4, "&s", &builder_id);
+	priv->api_version = api_version;
+	if (origin[0] != '\0')
+		as_store_set_origin (store, origin);
+	if (builder_id[0] != '\0')
+		as_store_set_builder_id (store, builder_id);
+
+	/* the store already has applications, so use the merge rules */
+	ids = g_variant_get_child_value (cache, 6);
+	apps = g_variant_get_child_value (cache, 7);
+	len = g_variant_n_children (apps);
+	as_store_cache_ensure (store);
+	if (priv->array->len > 0) {
+		for (i = 0; i < len; i++) {
+			_cleanup_object_unref_ AsApp *app = NULL;
+			app = as_store_cache_parse_app (apps, i,
+							priv->locale_filter,
+							&error_local);
+			if (app == NULL) {
+				g_set_error (error,
+					     AS_STORE_ERROR,
+					     AS_STORE_ERROR_FAILED,
+					     "Failed to parse %s: %s",
+					     filename, error_local->message);
+				return FALSE;
+			}
+			as_store_add_app (store, app);
+		}
+		as_store_match_addons (store);
+		return TRUE;
 	}
+
+	/* create the applications on demand */
+	if (len == 0)
+		return TRUE;
+	priv->cache_apps = g_variant_ref (apps);
+	priv->cache_ids = g_variant_ref (ids);
+	priv->cache_pkgnames = g_variant_get_child_value (cache, 8);
+	for (i = 0; i < AS_STORE_INDEX_LAST; i++)
+		priv->cache_indexes[i] = g_variant_get_child_value (cache, 9 + i);
+	priv->cache_loaded = g_new0 (gboolean, len);
+	priv->cache_pending = len;
 	return TRUE;
 }
 
@@ -1172,6 +3073,52 @@ as_store_set_add_flags (AsStore *store, AsStoreAddFlags add_flags)
 	priv->add_flags = add_flags;
 }
 
+/**
+ * as_store_set_locale_filter:
+ * @store: a #AsStore instance.
+ * @locales: (allow-none) (array zero-terminated=1): locales, or %NULL
+ *
+ * Sets the locales to keep translations for when loading applications.
+ * The "C" locale and any fallback locales, e.g. "de" for "de_DE", are
+ * always kept. Any other translation is dropped when the file is parsed,
+ * which reduces the time taken to load the store and the memory used.
+ *
+ * Applications that are loaded with a locale filter are incomplete, and
+ * so the store should not be written back to disk.
+ *
+ * Use %NULL to keep all the translations, which is the default.
+ *
+ * Since: 0.3.3
+ **/
+void
+as_store_set_locale_filter (AsStore *store, const gchar * const *locales)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	guint i;
+	guint j;
+
+	g_return_if_fail (AS_IS_STORE (store));
+
+	if (priv->locale_filter != NULL) {
+		g_hash_table_unref (priv->locale_filter);
+		priv->locale_filter = NULL;
+	}
+	if (locales == NULL)
+		return;
+
+	priv->locale_filter = g_hash_table_new_full (g_str_hash, g_str_equal,
+						     g_free, NULL);
+	g_hash_table_add (priv->locale_filter, g_strdup ("C"));
+	for (i = 0; locales[i] != NULL; i++) {
+		_cleanup_strv_free_ gchar **variants = NULL;
+		variants = g_get_locale_variants (locales[i]);
+		for (j = 0; variants[j] != NULL; j++) {
+			g_hash_table_add (priv->locale_filter,
+					  g_strdup (variants[j]));
+		}
+	}
+}
+
 /**
  * as_store_guess_origin_fallback:
  */
@@ -1233,6 +3180,303 @@ as_store_load_app_info_file (AsStore *store,
 				   error);
 }
 
+/**
+ * as_store_new_for_load:
+ *
+ * Creates a private store used to parse a file, with the same state as
+ * @store so that it gives the same results as loading into @store itself.
+ **/
+static AsStore *
+as_store_new_for_load (AsStore *store)
+{
+	AsStore *store_new;
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	AsStorePrivate *priv_new;
+
+	store_new = as_store_new ();
+	priv_new = GET_PRIVATE (store_new);
+	priv_new->destdir = g_strdup (priv->destdir);
+	priv_new->origin = g_strdup (priv->origin);
+	priv_new->builder_id = g_strdup (priv->builder_id);
+	priv_new->api_version = priv->api_version;
+	priv_new->add_flags = priv->add_flags;
+	if (priv->locale_filter != NULL)
+		priv_new->locale_filter = g_hash_table_ref (priv->locale_filter);
+	return store_new;
+}
+
+/**
+ * as_store_app_equal:
+ *
+ * Compares two applications as they would be written by @store, so only
+ * the data that could be exported makes them different.
+ **/
+static gboolean
+as_store_app_equal (AsStore *store, AsApp *app1, AsApp *app2)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	_cleanup_node_unref_ GNode *root1 = NULL;
+	_cleanup_node_unref_ GNode *root2 = NULL;
+	_cleanup_string_free_ GString *xml1 = NULL;
+	_cleanup_string_free_ GString *xml2 = NULL;
+
+	if (g_strcmp0 (as_app_get_origin (app1), as_app_get_origin (app2)) != 0)
+		return FALSE;
+	if (as_app_get_priority (app1) != as_app_get_priority (app2))
+		return FALSE;
+	root1 = as_node_new ();
+	root2 = as_node_new ();
+	as_app_node_insert (app1, root1, priv->api_version);
+	as_app_node_insert (app2, root2, priv->api_version);
+	xml1 = as_node_to_xml (root1, AS_NODE_TO_XML_FLAG_NONE);
+	xml2 = as_node_to_xml (root2, AS_NODE_TO_XML_FLAG_NONE);
+	return g_strcmp0 (xml1->str, xml2->str) == 0;
+}
+
+/**
+ * as_store_reload_load_file:
+ **/
+static gboolean
+as_store_reload_load_file (AsStore *store,
+			   const gchar *filename,
+			   GCancellable *cancellable,
+			   GError **error)
+{
+	_cleanup_free_ gchar *icon_root = NULL;
+	_cleanup_free_ gchar *path = NULL;
+	_cleanup_free_ gchar *path_md = NULL;
+
+	/* the icons are stored in ../icons relative to the format */
+	path_md = g_path_get_dirname (filename);
+	path = g_path_get_dirname (path_md);
+	icon_root = g_build_filename (path, "icons", NULL);
+	return as_store_load_app_info_file (store, filename, icon_root,
+					    cancellable, error);
+}
+
+/**
+ * as_store_is_app_info_file:
+ **/
+static gboolean
+as_store_is_app_info_file (const gchar *filename)
+{
+	return g_str_has_suffix (filename, ".xml") ||
+	       g_str_has_suffix (filename, ".xml.gz") ||
+	       g_str_has_suffix (filename, ".yml") ||
+	       g_str_has_suffix (filename, ".yml.gz");
+}
+
+/**
+ * as_store_reload_shadowed:
+ *
+ * When an application with the same ID was loaded from more than one file
+ * only one version is kept. If the version from the reloaded file has been
+ * removed or changed then the version from the other files is needed
+ * again, so the files that also provided that ID are parsed again and any
+ * matching application is added back using the usual priority rules.
+ **/
+static gboolean
+as_store_reload_shadowed (AsStore *store,
+			  const gchar *filename,
+			  GPtrArray *removed,
+			  GPtrArray *changed,
+			  GCancellable *cancellable,
+			  GError **error)
+{
+	AsApp *app;
+	AsApp *app_other;
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	GHashTable *shadowed;
+	GList *l;
+	const gchar *id;
+	guint i;
+	_cleanup_hashtable_unref_ GHashTable *files = NULL;
+	_cleanup_list_free_ GList *sources = NULL;
+	_cleanup_object_unref_ AsStore *store_other = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *ids = NULL;
+
+	/* nothing was ever dropped with these IDs */
+	ids = g_ptr_array_new ();
+	files = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	for (i = 0; i < removed->len + changed->len; i++) {
+		if (i < removed->len)
+			app = g_ptr_array_index (removed, i);
+		else
+			app = g_ptr_array_index (changed, i - removed->len);
+		id = as_app_get_id (app);
+		shadowed = g_hash_table_lookup (priv->hash_shadowed, id);
+		if (shadowed == NULL)
+			continue;
+		g_ptr_array_add (ids, (gpointer) id);
+		sources = g_hash_table_get_keys (shadowed);
+		for (l = sources; l != NULL; l = l->next)
+			g_hash_table_add (files, g_strdup (l->data));
+		g_list_free (sources);
+		sources = NULL;
+	}
+	if (ids->len == 0)
+		return TRUE;
+
+	/* parse only the other files that provided these IDs */
+	store_other = as_store_new_for_load (store);
+	sources = g_hash_table_get_keys (files);
+	for (l = sources; l != NULL; l = l->next) {
+		const gchar *tmp = l->data;
+		if (g_strcmp0 (tmp, filename) == 0)
+			continue;
+		if (!as_store_is_app_info_file (tmp))
+			continue;
+		if (!g_file_test (tmp, G_FILE_TEST_IS_REGULAR))
+			continue;
+		if (!as_store_reload_load_file (store_other, tmp,
+						cancellable, error))
+			return FALSE;
+	}
+
+	/* add back the other versions */
+	for (i = 0; i < ids->len; i++) {
+		id = g_ptr_array_index (ids, i);
+		app_other = as_store_get_app_by_id (store_other, id);
+		if (app_other == NULL)
+			continue;
+		g_debug ("restoring %s from %s", id,
+			 as_app_get_source_file (app_other));
+		as_store_add_app (store, app_other);
+	}
+
+	/* a removed application that was restored has just changed */
+	for (i = 0; i < removed->len; ) {
+		app = g_ptr_array_index (removed, i);
+		app_other = g_hash_table_lookup (priv->hash_id, as_app_get_id (app));
+		if (app_other == NULL) {
+			i++;
+			continue;
+		}
+		g_ptr_array_add (changed, g_object_ref (app_other));
+		g_ptr_array_remove_index (removed, i);
+	}
+	return TRUE;
+}
+
+/**
+ * as_store_reload_file: (skip)
+ * @store: a #AsStore instance.
+ * @filename: the AppStream file that changed
+ * @cancellable: a #GCancellable.
+ * @error: A #GError or %NULL.
+ *
+ * Re-parses just one app-info file, and updates the applications that were
+ * previously added from it. The ::app-added, ::app-removed and ::app-changed
+ * signals are emitted for each application that is different.
+ *
+ * If @filename no longer exists then all the applications from it are
+ * removed. If another file provided an application with the same ID that
+ * was dropped in favour of the old version, then it is added back.
+ *
+ * Returns: %TRUE for success
+ **/
+gboolean
+as_store_reload_file (AsStore *store,
+		      const gchar *filename,
+		      GCancellable *cancellable,
+		      GError **error)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	AsApp *app;
+	AsApp *app_old;
+	GHashTableIter iter;
+	GPtrArray *apps;
+	const gchar *id;
+	gpointer value;
+	guint i;
+	_cleanup_hashtable_unref_ GHashTable *old = NULL;
+	_cleanup_object_unref_ AsStore *store_new = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *added = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *changed = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *removed = NULL;
+
+	g_return_val_if_fail (AS_IS_STORE (store), FALSE);
+
+	/* parse the new version of the file into a private store */
+	store_new = as_store_new_for_load (store);
+	if (g_file_test (filename, G_FILE_TEST_EXISTS)) {
+		if (!as_store_reload_load_file (store_new, filename,
+						cancellable, error))
+			return FALSE;
+		as_store_add_cache_source (store, filename);
+	} else {
+		g_hash_table_remove (priv->cache_sources, filename);
+	}
+
+	/* find all the applications this file previously provided */
+	as_store_cache_ensure (store);
+	old = g_hash_table_new_full (g_str_hash, g_str_equal,
+				     NULL, (GDestroyNotify) g_object_unref);
+	for (i = 0; i < priv->array->len; i++) {
+		app = g_ptr_array_index (priv->array, i);
+		if (g_strcmp0 (as_app_get_source_file (app), filename) != 0)
+			continue;
+		g_hash_table_insert (old,
+				     (gpointer) as_app_get_id (app),
+				     g_object_ref (app));
+	}
+
+	/* add or replace anything that is new or different */
+	added = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	changed = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	removed = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	apps = as_store_get_apps (store_new);
+	for (i = 0; i < apps->len; i++) {
+		app = g_ptr_array_index (apps, i);
+		id = as_app_get_id (app);
+		app_old = g_hash_table_lookup (old, id);
+		if (app_old == NULL) {
+			as_store_add_app (store, app);
+			if (g_hash_table_lookup (priv->hash_id, id) == app)
+				g_ptr_array_add (added, g_object_ref (app));
+			continue;
+		}
+		if (!as_store_app_equal (store, app_old, app)) {
+			as_store_remove_app (store, app_old);
+			as_store_add_app (store, app);
+			g_ptr_array_add (changed, g_object_ref (app));
+		}
+		g_hash_table_remove (old, id);
+	}
+
+	/* anything left over is no longer in the file */
+	g_hash_table_iter_init (&iter, old);
+	while (g_hash_table_iter_next (&iter, NULL, &value)) {
+		app = AS_APP (value);
+		as_store_remove_app (store, app);
+		g_ptr_array_add (removed, g_object_ref (app));
+	}
+
+	/* add back anything another file provided with the same ID */
+	if (!as_store_reload_shadowed (store, filename, removed, changed,
+				       cancellable, error))
+		return FALSE;
+	as_store_match_addons (store);
+
+	/* only tell the caller when the store is consistent */
+	for (i = 0; i < removed->len; i++) {
+		app = g_ptr_array_index (removed, i);
+		g_debug ("Emitting ::app-removed(%s)", as_app_get_id (app));
+		g_signal_emit (store, signals[SIGNAL_APP_REMOVED], 0, app);
+	}
+	for (i = 0; i < added->len; i++) {
+		app = g_ptr_array_index (added, i);
+		g_debug ("Emitting ::app-added(%s)", as_app_get_id (app));
+		g_signal_emit (store, signals[SIGNAL_APP_ADDED], 0, app);
+	}
+	for (i = 0; i < changed->len; i++) {
+		app = g_ptr_array_index (changed, i);
+		g_debug ("Emitting ::app-changed(%s)", as_app_get_id (app));
+		g_signal_emit (store, signals[SIGNAL_APP_CHANGED], 0, app);
+	}
+	return TRUE;
+}
+
 /**
  * as_store_cache_changed_cb:
  */
@@ -1242,6 +3486,20 @@ as_store_cache_changed_cb (GFileMonitor *monitor,
 			   GFileMonitorEvent event_type,
 			   AsStore *store)
 {
+	_cleanup_error_free_ GError *error = NULL;
+	_cleanup_free_ gchar *filename = NULL;
+
+	/* only reload the AppStream file that changed, ignoring icons */
+	if (event_type == G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT ||
+	    event_type == G_FILE_MONITOR_EVENT_DELETED) {
+		filename = g_file_get_path (file);
+		if (as_store_is_app_info_file (filename)) {
+			if (!as_store_reload_file (store, filename, NULL, &error))
+				g_warning ("failed to reload %s: %s",
+					   filename, error->message);
+		}
+	}
+
 	g_debug ("Emitting ::changed()");
 	g_signal_emit (store, signals[SIGNAL_CHANGED], 0);
 }
@@ -1280,13 +3538,170 @@ as_store_monitor_directory (AsStore *store,
 	return TRUE;
 }
 
+typedef struct {
+	gchar		*filename;
+	gchar		*icon_root;
+	AsStore		*store;
+	AsStore		*store_parent;
+	GCancellable	*cancellable;
+	GError		*error;
+} AsStoreLoadItem;
+
+/**
+ * as_store_load_item_free:
+ **/
+static void
+as_store_load_item_free (AsStoreLoadItem *item)
+{
+	if (item->store != NULL)
+		g_object_unref (item->store);
+	if (item->error != NULL)
+		g_error_free (item->error);
+	g_free (item->filename);
+	g_free (item->icon_root);
+	g_free (item);
+}
+
+/**
+ * as_store_load_item_func:
+ **/
+static void
+as_store_load_item_func (gpointer data, gpointer user_data)
+{
+	AsStoreLoadItem *item = (AsStoreLoadItem *) data;
+	AsStorePrivate *priv = GET_PRIVATE (item->store_parent);
+
+	as_store_load_app_info_file (item->store,
+				     item->filename,
+				     item->icon_root,
+				     item->cancellable,
+				     &item->error);
+
+	/* wake up the loader when the last file is done */
+	g_mutex_lock (&priv->load_mutex);
+	if (--priv->load_pending == 0)
+		g_cond_signal (&priv->load_cond);
+	g_mutex_unlock (&priv->load_mutex);
+}
+
+/**
+ * as_store_load_items:
+ *
+ * Parses each file into its own private store using a thread pool, and
+ * then merges the results back in the order the files were found so that
+ * the priority and PREFER_LOCAL rules resolve exactly as they would if
+ * the files had been loaded one after the other.
+ *
+ * The private stores all start with the state the store had before the
+ * load, so a file without an origin uses the origin the store already had
+ * rather than one set by an earlier file in the same directory.
+ **/
+static gboolean
+as_store_load_items (AsStore *store,
+		     GPtrArray *items,
+		     GCancellable *cancellable,
+		     GError **error)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	AsStoreLoadItem *item;
+	AsApp *app;
+	GHashTableIter iter;
+	GPtrArray *apps;
+	gdouble api_version;
+	gpointer key;
+	gpointer value;
+	guint i;
+	guint j;
+	_cleanup_free_ gchar *builder_id = NULL;
+	_cleanup_free_ gchar *origin = NULL;
+
+	if (items->len == 0)
+		return TRUE;
+
+	/* the pool is kept for the lifetime of the store */
+	if (priv->load_pool == NULL) {
+		priv->load_pool = g_thread_pool_new (as_store_load_item_func,
+						     NULL,
+						     (gint) g_get_num_processors (),
+						     FALSE,
+						     error);
+		if (priv->load_pool == NULL)
+			return FALSE;
+	}
+
+	/* each file gets a private store with the same settings */
+	origin = g_strdup (priv->origin);
+	builder_id = g_strdup (priv->builder_id);
+	api_version = priv->api_version;
+	for (i = 0; i < items->len; i++) {
+		item = g_ptr_array_index (items, i);
+		item->store = as_store_new_for_load (store);
+		item->store_parent = store;
+		item->cancellable = cancellable;
+	}
+
+	/* parse them all */
+	g_mutex_lock (&priv->load_mutex);
+	for (i = 0; i < items->len; i++) {
+		item = g_ptr_array_index (items, i);
+		priv->load_pending++;
+		if (!g_thread_pool_push (priv->load_pool, item, error)) {
+			priv->load_pending--;
+			break;
+		}
+	}
+	while (priv->load_pending > 0)
+		g_cond_wait (&priv->load_cond, &priv->load_mutex);
+	g_mutex_unlock (&priv->load_mutex);
+	if (i < items->len)
+		return FALSE;
+
+	/* merge in the original order */
+	for (i = 0; i < items->len; i++) {
+		AsStorePrivate *priv_item;
+		item = g_ptr_array_index (items, i);
+		if (item->error != NULL) {
+			g_propagate_error (error, item->error);
+			item->error = NULL;
+			return FALSE;
+		}
+		priv_item = GET_PRIVATE (item->store);
+		apps = as_store_get_apps (item->store);
+		for (j = 0; j < apps->len; j++) {
+			app = g_ptr_array_index (apps, j);
+			as_store_add_app (store, app);
+		}
+
+		/* only copy what the file set itself, as when loading
+		 * the files one after the other */
+		if (g_strcmp0 (priv_item->origin, origin) != 0)
+			as_store_set_origin (store, priv_item->origin);
+		if (g_strcmp0 (priv_item->builder_id, builder_id) != 0)
+			as_store_set_builder_id (store, priv_item->builder_id);
+		if (priv_item->api_version != api_version)
+			priv->api_version = priv_item->api_version;
+		priv->problems |= priv_item->problems;
+		g_hash_table_iter_init (&iter, priv_item->cache_sources);
+		while (g_hash_table_iter_next (&iter, &key, &value)) {
+			g_hash_table_insert (priv->cache_sources,
+					     g_strdup (key),
+					     g_memdup (value, sizeof (AsStoreCacheSource)));
+		}
+	}
+	return TRUE;
+}
+
 /**
  * as_store_load_app_info:
+ *
+ * If @items is not %NULL then the files are only queued, and have to be
+ * loaded later using as_store_load_items().
  **/
 static gboolean
 as_store_load_app_info (AsStore *store,
 			const gchar *path,
 			const gchar *format,
+			GPtrArray *items,
 			GCancellable *cancellable,
 			GError **error)
 {
@@ -1309,10 +3724,18 @@ as_store_load_app_info (AsStore *store,
 			     path_md, error_local->message);
 		return FALSE;
 	}
+	as_store_add_cache_source (store, path_md);
 	icon_root = g_build_filename (path, "icons", NULL);
 	while ((tmp = g_dir_read_name (dir)) != NULL) {
 		_cleanup_free_ gchar *filename_md = NULL;
 		filename_md = g_build_filename (path_md, tmp, NULL);
+		if (items != NULL) {
+			AsStoreLoadItem *item = g_new0 (AsStoreLoadItem, 1);
+			item->filename = g_strdup (filename_md);
+			item->icon_root = g_strdup (icon_root);
+			g_ptr_array_add (items, item);
+			continue;
+		}
 		if (!as_store_load_app_info_file (store,
 						  filename_md,
 						  icon_root,
@@ -1371,6 +3794,7 @@ as_store_load_app_install_file (AsStore *store,
 				const gchar *path_icons,
 				GError **error)
 {
+	AsStorePrivate *priv = GET_PRIVATE (store);
 	AsIcon *icon;
 	GPtrArray *icons;
 	guint i;
@@ -1379,6 +3803,7 @@ as_store_load_app_install_file (AsStore *store,
 
 	app = as_app_new ();
 	as_app_set_icon_path (app, path_icons, -1);
+	as_app_set_locale_filter (app, priv->locale_filter);
 	if (!as_app_parse_file (app,
 				filename,
 				AS_APP_PARSE_FLAG_USE_HEURISTICS,
@@ -1397,6 +3822,7 @@ as_store_load_app_install_file (AsStore *store,
 			     error_local->message);
 		return FALSE;
 	}
+	as_app_set_locale_filter (app, NULL);
 
 	/* convert all the icons */
 	icons = as_app_get_icons (app);
@@ -1443,6 +3869,7 @@ as_store_load_app_install (AsStore *store,
 			     error_local->message);
 		return FALSE;
 	}
+	as_store_add_cache_source (store, path_desktop);
 
 	path_icons = g_build_filename (path, "icons", NULL);
 	while ((tmp = g_dir_read_name (dir)) != NULL) {
@@ -1478,6 +3905,7 @@ as_store_load_installed (AsStore *store,
 	dir = g_dir_open (path, 0, error);
 	if (dir == NULL)
 		return FALSE;
+	as_store_add_cache_source (store, path);
 
 	/* relax the checks when parsing */
 	if (flags & AS_STORE_LOAD_FLAG_ALLOW_VETO)
@@ -1500,7 +3928,9 @@ as_store_load_installed (AsStore *store,
 				continue;
 			}
 		}
+		as_store_add_cache_source (store, filename);
 		app = as_app_new ();
+		as_app_set_locale_filter (app, priv->locale_filter);
 		if (!as_app_parse_file (app, filename, parse_flags, &error_local)) {
 			if (g_error_matches (error_local,
 					     AS_APP_ERROR,
@@ -1513,6 +3943,7 @@ as_store_load_installed (AsStore *store,
 			g_propagate_error (error, error_local);
 			return FALSE;
 		}
+		as_app_set_locale_filter (app, NULL);
 
 		/* do not load applications with vetos */
 		if ((flags & AS_STORE_LOAD_FLAG_ALLOW_VETO) == 0 &&
@@ -1574,6 +4005,16 @@ as_store_load (AsStore *store,
 	guint i;
 	_cleanup_ptrarray_unref_ GPtrArray *app_info = NULL;
 	_cleanup_ptrarray_unref_ GPtrArray *installed = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *items = NULL;
+
+	/* only keep the translations the session can use */
+	if ((flags & AS_STORE_LOAD_FLAG_ONLY_SESSION_LOCALES) > 0 &&
+	    priv->locale_filter == NULL)
+		as_store_set_locale_filter (store, g_get_language_names ());
+
+	/* parse the app-info files using multiple threads */
+	if ((flags & AS_STORE_LOAD_FLAG_PARALLEL) > 0)
+		items = g_ptr_array_new_with_free_func ((GDestroyNotify) as_store_load_item_free);
 
 	/* system locations */
 	app_info = g_ptr_array_new_with_free_func (g_free);
@@ -1619,9 +4060,15 @@ as_store_load (AsStore *store,
 		dest = g_build_filename (priv->destdir ? priv->destdir : "/", tmp, NULL);
 		if (!g_file_test (dest, G_FILE_TEST_EXISTS))
 			continue;
-		if (!as_store_load_app_info (store, dest, "xmls", cancellable, error))
+		if (!as_store_load_app_info (store, dest, "xmls", items,
+					     cancellable, error))
 			return FALSE;
-		if (!as_store_load_app_info (store, dest, "yaml", cancellable, error))
+		if (!as_store_load_app_info (store, dest, "yaml", items,
+					     cancellable, error))
+			return FALSE;
+	}
+	if (items != NULL) {
+		if (!as_store_load_items (store, items, cancellable, error))
 			return FALSE;
 	}
 
@@ -1703,6 +4150,7 @@ as_store_validate (AsStore *store, AsAppValidateFlags flags, GError **error)
 
 	g_return_val_if_fail (AS_IS_STORE (store), NULL);
 
+	as_store_cache_ensure (store);
 	probs = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
 
 	/* check the root node */
@@ -72,6 +72,8 @@ struct _AsStoreClass
  * @AS_STORE_LOAD_FLAG_APPDATA:			The installed AppData files
  * @AS_STORE_LOAD_FLAG_DESKTOP:			The installed desktop files
  * @AS_STORE_LOAD_FLAG_ALLOW_VETO:		Add vetoed applications
+ * @AS_STORE_LOAD_FLAG_PARALLEL:		Parse the app-info files using threads
+ * @AS_STORE_LOAD_FLAG_ONLY_SESSION_LOCALES:	Only keep translations for g_get_language_names()
  *
  * The flags to use when loading the store.
  **/
@@ -83,6 +85,8 @@ typedef enum {
 	AS_STORE_LOAD_FLAG_APPDATA		= 8,	/* Since: 0.2.2 */
 	AS_STORE_LOAD_FLAG_DESKTOP		= 16,	/* Since: 0.2.2 */
 	AS_STORE_LOAD_FLAG_ALLOW_VETO		= 32,	/* Since: 0.2.5 */
+	AS_STORE_LOAD_FLAG_PARALLEL		= 64,	/* Since: 0.3.3 */
+	AS_STORE_LOAD_FLAG_ONLY_SESSION_LOCALES	= 128,	/* Since: 0.3.3 */
 	/*< private >*/
 	AS_STORE_LOAD_FLAG_LAST
 } AsStoreLoadFlags;
@@ -146,10 +150,19 @@ GPtrArray	*as_store_get_apps		(AsStore	*store);
 GPtrArray	*as_store_get_apps_by_metadata	(AsStore	*store,
 						 const gchar	*key,
 						 const gchar	*value);
+GPtrArray	*as_store_get_apps_by_provide	(AsStore	*store,
+						 AsProvideKind	 kind,
+						 const gchar	*value);
+GPtrArray	*as_store_get_apps_by_mimetype	(AsStore	*store,
+						 const gchar	*mimetype);
+GPtrArray	*as_store_get_apps_by_category	(AsStore	*store,
+						 const gchar	*category);
 AsApp		*as_store_get_app_by_id		(AsStore	*store,
 						 const gchar	*id);
 AsApp		*as_store_get_app_by_pkgname	(AsStore	*store,
 						 const gchar	*pkgname);
+GPtrArray	*as_store_search		(AsStore	*store,
+						 gchar		**search);
 void		 as_store_add_app		(AsStore	*store,
 						 AsApp		*app);
 void		 as_store_remove_app		(AsStore	*store,
@@ -163,6 +176,14 @@ gboolean	 as_store_to_file		(AsStore	*store,
 						 AsNodeToXmlFlags flags,
 						 GCancellable	*cancellable,
 						 GError		**error);
+gboolean	 as_store_to_cache		(AsStore	*store,
+						 GFile		*file,
+						 GCancellable	*cancellable,
+						 GError		**error);
+gboolean	 as_store_from_cache		(AsStore	*store,
+						 GFile		*file,
+						 GCancellable	*cancellable,
+						 GError		**error);
 gboolean	 as_store_convert_icons		(AsStore	*store,
 						 AsIconKind	 kind,
 						 GError		**error);
@@ -181,6 +202,8 @@ void		 as_store_set_api_version	(AsStore	*store,
 AsStoreAddFlags	 as_store_get_add_flags		(AsStore	*store);
 void		 as_store_set_add_flags		(AsStore	*store,
 						 AsStoreAddFlags add_flags);
+void		 as_store_set_locale_filter	(AsStore	*store,
+						 const gchar * const *locales);
 GPtrArray	*as_store_validate		(AsStore	*store,
 						 AsAppValidateFlags flags,
 						 GError		**error);
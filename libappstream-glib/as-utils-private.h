@@ -36,6 +36,7 @@ gchar		*as_strndup			(const gchar	*text,
 						 gssize		 text_len);
 const gchar	*as_hash_lookup_by_locale	(GHashTable	*hash,
 						 const gchar	*locale);
+GVariant	*as_hash_to_variant		(GHashTable	*hash);
 void		 as_pixbuf_sharpen		(GdkPixbuf	*src,
 						 gint		 radius,
 						 gdouble	 amount);
@@ -39,8 +39,8 @@
 #include "as-app.h"
 #include "as-cleanup.h"
 #include "as-enums.h"
+#include "as-ids-private.h"
 #include "as-node.h"
-#include "as-resources.h"
 #include "as-utils.h"
 #include "as-utils-private.h"
 
@@ -94,7 +94,7 @@ as_markup_convert_simple (const gchar *markup,
 	/* load */
 	root = as_node_from_xml (markup,
 				 markup_len,
-				 AS_NODE_FROM_XML_FLAG_NONE,
+				 AS_NODE_FROM_XML_FLAG_ARENA,
 				 error);
 	if (root == NULL)
 		return NULL;
@@ -182,6 +182,53 @@ as_hash_lookup_by_locale (GHashTable *hash, const gchar *locale)
 	return NULL;
 }
 
+/**
+ * as_hash_to_variant:
+ * @hash: (allow-none): a #GHashTable of string:string, or %NULL
+ *
+ * Converts a hash of strings, typically a locale:translation hash, to a
+ * floating #GVariant of type a{ss}.
+ **/
+GVariant *
+as_hash_to_variant (GHashTable *hash)
+{
+	GHashTableIter iter;
+	GVariantBuilder builder;
+	gpointer key;
+	gpointer value;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{ss}"));
+	if (hash == NULL)
+		return g_variant_builder_end (&builder);
+	g_hash_table_iter_init (&iter, hash);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		g_variant_builder_add (&builder, "{ss}",
+				       (const gchar *) key,
+				       (const gchar *) value);
+	}
+	return g_variant_builder_end (&builder);
+}
+
+/**
+ * as_utils_ids_cmp:
+ **/
+static gint
+as_utils_ids_cmp (gconstpointer a, gconstpointer b)
+{
+	return strcmp ((const gchar *) a, *((const gchar **) b));
+}
+
+/**
+ * as_utils_ids_contains:
+ **/
+static gboolean
+as_utils_ids_contains (const gchar **ids, gsize ids_len, const gchar *id)
+{
+	if (id == NULL)
+		return FALSE;
+	return bsearch (id, ids, ids_len, sizeof (gchar *), as_utils_ids_cmp) != NULL;
+}
+
 /**
  * as_utils_is_stock_icon_name:
  * @name: an icon name
@@ -196,18 +243,9 @@ as_hash_lookup_by_locale (GHashTable *hash, const gchar *locale)
 gboolean
 as_utils_is_stock_icon_name (const gchar *name)
 {
-	_cleanup_bytes_unref_ GBytes *data = NULL;
-	_cleanup_free_ gchar *key = NULL;
-
-	/* load the readonly data section and look for the icon name */
-	data = g_resource_lookup_data (as_get_resource (),
-				       "/org/freedesktop/appstream-glib/as-stock-icons.txt",
-				       G_RESOURCE_LOOKUP_FLAGS_NONE,
-				       NULL);
-	if (data == NULL)
-		return FALSE;
-	key = g_strdup_printf ("\n%s\n", name);
-	return g_strstr_len (g_bytes_get_data (data, NULL), -1, key) != NULL;
+	return as_utils_ids_contains (as_ids_stock_icons,
+				      G_N_ELEMENTS (as_ids_stock_icons),
+				      name);
 }
 
 /**
@@ -223,18 +261,9 @@ as_utils_is_stock_icon_name (const gchar *name)
 gboolean
 as_utils_is_spdx_license_id (const gchar *license_id)
 {
-	_cleanup_bytes_unref_ GBytes *data = NULL;
-	_cleanup_free_ gchar *key = NULL;
-
-	/* load the readonly data section and look for the icon name */
-	data = g_resource_lookup_data (as_get_resource (),
-				       "/org/freedesktop/appstream-glib/as-license-ids.txt",
-				       G_RESOURCE_LOOKUP_FLAGS_NONE,
-				       NULL);
-	if (data == NULL)
-		return FALSE;
-	key = g_strdup_printf ("\n%s\n", license_id);
-	return g_strstr_len (g_bytes_get_data (data, NULL), -1, key) != NULL;
+	return as_utils_ids_contains (as_ids_licenses,
+				      G_N_ELEMENTS (as_ids_licenses),
+				      license_id);
 }
 
 /**
@@ -251,20 +280,17 @@ gboolean
 as_utils_is_blacklisted_id (const gchar *desktop_id)
 {
 	guint i;
-	_cleanup_bytes_unref_ GBytes *data = NULL;
-	_cleanup_free_ gchar *key = NULL;
-	_cleanup_strv_free_ gchar **split = NULL;
-
-	/* load the readonly data section and look for the icon name */
-	data = g_resource_lookup_data (as_get_resource (),
-				       "/org/freedesktop/appstream-glib/as-blacklist-ids.txt",
-				       G_RESOURCE_LOOKUP_FLAGS_NONE,
-				       NULL);
-	if (data == NULL)
+
+	if (desktop_id == NULL)
 		return FALSE;
-	split = g_strsplit (g_bytes_get_data (data, NULL), "\n", -1);
-	for (i = 0; split[i] != NULL; i++) {
-		if (fnmatch (split[i], desktop_id, 0) == 0)
+
+	/* most entries are not globs */
+	if (as_utils_ids_contains (as_ids_blacklist,
+				   G_N_ELEMENTS (as_ids_blacklist),
+				   desktop_id))
+		return TRUE;
+	for (i = 0; i < G_N_ELEMENTS (as_ids_blacklist_globs); i++) {
+		if (fnmatch (as_ids_blacklist_globs[i], desktop_id, 0) == 0)
 			return TRUE;
 	}
 	return FALSE;
@@ -283,18 +309,9 @@ as_utils_is_blacklisted_id (const gchar *desktop_id)
 gboolean
 as_utils_is_environment_id (const gchar *environment_id)
 {
-	_cleanup_bytes_unref_ GBytes *data = NULL;
-	_cleanup_free_ gchar *key = NULL;
-
-	/* load the readonly data section and look for the icon name */
-	data = g_resource_lookup_data (as_get_resource (),
-				       "/org/freedesktop/appstream-glib/as-environment-ids.txt",
-				       G_RESOURCE_LOOKUP_FLAGS_NONE,
-				       NULL);
-	if (data == NULL)
-		return FALSE;
-	key = g_strdup_printf ("\n%s\n", environment_id);
-	return g_strstr_len (g_bytes_get_data (data, NULL), -1, key) != NULL;
+	return as_utils_ids_contains (as_ids_environments,
+				      G_N_ELEMENTS (as_ids_environments),
+				      environment_id);
 }
 
 /**
@@ -310,18 +327,9 @@ as_utils_is_environment_id (const gchar *environment_id)
 gboolean
 as_utils_is_category_id (const gchar *category_id)
 {
-	_cleanup_bytes_unref_ GBytes *data = NULL;
-	_cleanup_free_ gchar *key = NULL;
-
-	/* load the readonly data section and look for the icon name */
-	data = g_resource_lookup_data (as_get_resource (),
-				       "/org/freedesktop/appstream-glib/as-category-ids.txt",
-				       G_RESOURCE_LOOKUP_FLAGS_NONE,
-				       NULL);
-	if (data == NULL)
-		return FALSE;
-	key = g_strdup_printf ("\n%s\n", category_id);
-	return g_strstr_len (g_bytes_get_data (data, NULL), -1, key) != NULL;
+	return as_utils_ids_contains (as_ids_categories,
+				      G_N_ELEMENTS (as_ids_categories),
+				      category_id);
 }
 
 typedef struct {
@@ -596,6 +604,12 @@ as_utils_check_url_exists (const gchar *url, guint timeout, GError **error)
 
 /**
  * as_pixbuf_blur_private:
+ *
+ * Runs one iteration of a box blur, using @dest as scratch space.
+ *
+ * Both passes walk the image row by row so that memory is read in order;
+ * the vertical pass keeps a running sum for every column instead of walking
+ * down each column in turn.
  **/
 static void
 as_pixbuf_blur_private (GdkPixbuf *src, GdkPixbuf *dest, gint radius, guchar *div_kernel_size)
@@ -603,8 +617,11 @@ as_pixbuf_blur_private (GdkPixbuf *src, GdkPixbuf *dest, gint radius, guchar *di
 	gint width, height, src_rowstride, dest_rowstride, n_channels;
 	guchar *p_src, *p_dest, *c1, *c2;
 	gint x, y, i, i1, i2, width_minus_1, height_minus_1, radius_plus_1;
-	gint r, g, b, a;
-	guchar *p_dest_row, *p_dest_col;
+	gint x_mid_end;
+	gint r, g, b;
+	gint *sum;
+	guchar *p_dest_row;
+	_cleanup_free_ gint *sums = NULL;
 
 	width = gdk_pixbuf_get_width (src);
 	height = gdk_pixbuf_get_height (src);
@@ -617,10 +634,11 @@ as_pixbuf_blur_private (GdkPixbuf *src, GdkPixbuf *dest, gint radius, guchar *di
 	src_rowstride = gdk_pixbuf_get_rowstride (src);
 	dest_rowstride = gdk_pixbuf_get_rowstride (dest);
 	width_minus_1 = width - 1;
+	x_mid_end = width_minus_1 - radius_plus_1;
 	for (y = 0; y < height; y++) {
 
 		/* calc the initial sums of the kernel */
-		r = g = b = a = 0;
+		r = g = b = 0;
 		for (i = -radius; i <= radius; i++) {
 			c1 = p_src + (CLAMP (i, 0, width_minus_1) * n_channels);
 			r += c1[0];
@@ -629,7 +647,28 @@ as_pixbuf_blur_private (GdkPixbuf *src, GdkPixbuf *dest, gint radius, guchar *di
 		}
 
 		p_dest_row = p_dest;
-		for (x = 0; x < width; x++) {
+		x = 0;
+		while (x < width) {
+
+			/* away from the edges nothing needs clamping, so just
+			 * step the pixels to add and remove along the row */
+			if (x == radius && x <= x_mid_end) {
+				c1 = p_src + ((x + radius_plus_1) * n_channels);
+				c2 = p_src + ((x - radius) * n_channels);
+				for (; x <= x_mid_end; x++) {
+					p_dest_row[0] = div_kernel_size[r];
+					p_dest_row[1] = div_kernel_size[g];
+					p_dest_row[2] = div_kernel_size[b];
+					p_dest_row += n_channels;
+					r += c1[0] - c2[0];
+					g += c1[1] - c2[1];
+					b += c1[2] - c2[2];
+					c1 += n_channels;
+					c2 += n_channels;
+				}
+				continue;
+			}
+
 			/* set as the mean of the kernel */
 			p_dest_row[0] = div_kernel_size[r];
 			p_dest_row[1] = div_kernel_size[g];
@@ -652,6 +691,7 @@ as_pixbuf_blur_private (GdkPixbuf *src, GdkPixbuf *dest, gint radius, guchar *di
 			r += c1[0] - c2[0];
 			g += c1[1] - c2[1];
 			b += c1[2] - c2[2];
+			x++;
 		}
 
 		p_src += src_rowstride;
@@ -664,46 +704,52 @@ as_pixbuf_blur_private (GdkPixbuf *src, GdkPixbuf *dest, gint radius, guchar *di
 	src_rowstride = gdk_pixbuf_get_rowstride (dest);
 	dest_rowstride = gdk_pixbuf_get_rowstride (src);
 	height_minus_1 = height - 1;
-	for (x = 0; x < width; x++) {
 
-		/* calc the initial sums of the kernel */
-		r = g = b = a = 0;
-		for (i = -radius; i <= radius; i++) {
-			c1 = p_src + (CLAMP (i, 0, height_minus_1) * src_rowstride);
-			r += c1[0];
-			g += c1[1];
-			b += c1[2];
+	/* calc the initial sums of the kernel for every column */
+	sums = g_new0 (gint, width * 3);
+	for (i = -radius; i <= radius; i++) {
+		c1 = p_src + (CLAMP (i, 0, height_minus_1) * src_rowstride);
+		sum = sums;
+		for (x = 0; x < width; x++) {
+			sum[0] += c1[0];
+			sum[1] += c1[1];
+			sum[2] += c1[2];
+			sum += 3;
+			c1 += n_channels;
 		}
+	}
 
-		p_dest_col = p_dest;
-		for (y = 0; y < height; y++) {
-			/* set as the mean of the kernel */
-
-			p_dest_col[0] = div_kernel_size[r];
-			p_dest_col[1] = div_kernel_size[g];
-			p_dest_col[2] = div_kernel_size[b];
-			p_dest_col += dest_rowstride;
+	for (y = 0; y < height; y++) {
 
-			/* the pixel to add to the kernel */
-			i1 = y + radius_plus_1;
-			if (i1 > height_minus_1)
-				i1 = height_minus_1;
-			c1 = p_src + (i1 * src_rowstride);
+		/* the rows to add to and remove from the kernel */
+		i1 = y + radius_plus_1;
+		if (i1 > height_minus_1)
+			i1 = height_minus_1;
+		c1 = p_src + (i1 * src_rowstride);
+		i2 = y - radius;
+		if (i2 < 0)
+			i2 = 0;
+		c2 = p_src + (i2 * src_rowstride);
 
-			/* the pixel to remove from the kernel */
-			i2 = y - radius;
-			if (i2 < 0)
-				i2 = 0;
-			c2 = p_src + (i2 * src_rowstride);
+		p_dest_row = p_dest;
+		sum = sums;
+		for (x = 0; x < width; x++) {
+			/* set as the mean of the kernel */
+			p_dest_row[0] = div_kernel_size[sum[0]];
+			p_dest_row[1] = div_kernel_size[sum[1]];
+			p_dest_row[2] = div_kernel_size[sum[2]];
+			p_dest_row += n_channels;
 
 			/* calc the new sums of the kernel */
-			r += c1[0] - c2[0];
-			g += c1[1] - c2[1];
-			b += c1[2] - c2[2];
+			sum[0] += c1[0] - c2[0];
+			sum[1] += c1[1] - c2[1];
+			sum[2] += c1[2] - c2[2];
+			sum += 3;
+			c1 += n_channels;
+			c2 += n_channels;
 		}
 
-		p_src += n_channels;
-		p_dest += n_channels;
+		p_dest += dest_rowstride;
 	}
 }
 
@@ -713,7 +759,7 @@ as_pixbuf_blur_private (GdkPixbuf *src, GdkPixbuf *dest, gint radius, guchar *di
  * @radius: the pixel radius for the gaussian blur, typical values are 1..3
  * @iterations: Amount to blur the image, typical values are 1..5
  *
- * Blurs an image. Warning, this method is s..l..o..w... for large images.
+ * Blurs an image.
  *
  * Since: 0.3.2
  **/
@@ -743,13 +789,55 @@ as_pixbuf_blur (GdkPixbuf *src, gint radius, gint iterations)
 	(CLAMP (((distance) * (reference)) +				\
 		((1.0 - (distance)) * (original)), 0, 255))
 
+static GBytes	*as_pixbuf_sharpen_lut = NULL;
+static gdouble	 as_pixbuf_sharpen_lut_amount = 0.f;
+G_LOCK_DEFINE_STATIC (as_pixbuf_sharpen_lut);
+
+/**
+ * as_pixbuf_sharpen_get_lut:
+ *
+ * Gets the lookup table for an amount. There are only 256*256 possible
+ * results, so they are worked out once rather than doing the floating
+ * point maths for every pixel. Callers nearly always use the same amount,
+ * so the last table is kept for the next call.
+ **/
+static GBytes *
+as_pixbuf_sharpen_get_lut (gdouble amount)
+{
+	GBytes *bytes;
+	guchar *lut;
+	guint i;
+
+	G_LOCK (as_pixbuf_sharpen_lut);
+	if (as_pixbuf_sharpen_lut != NULL &&
+	    as_pixbuf_sharpen_lut_amount == amount) {
+		bytes = g_bytes_ref (as_pixbuf_sharpen_lut);
+		G_UNLOCK (as_pixbuf_sharpen_lut);
+		return bytes;
+	}
+	G_UNLOCK (as_pixbuf_sharpen_lut);
+
+	lut = g_new (guchar, 256 * 256);
+	for (i = 0; i < 256 * 256; i++)
+		lut[i] = interpolate_value (i >> 8, i & 0xff, amount);
+	bytes = g_bytes_new_take (lut, 256 * 256);
+
+	G_LOCK (as_pixbuf_sharpen_lut);
+	if (as_pixbuf_sharpen_lut != NULL)
+		g_bytes_unref (as_pixbuf_sharpen_lut);
+	as_pixbuf_sharpen_lut = g_bytes_ref (bytes);
+	as_pixbuf_sharpen_lut_amount = amount;
+	G_UNLOCK (as_pixbuf_sharpen_lut);
+	return bytes;
+}
+
 /**
  * as_pixbuf_sharpen: (skip)
  * @src: the GdkPixbuf.
  * @radius: the pixel radius for the unsharp mask, typical values are 1..3
  * @amount: Amount to sharpen the image, typical values are -0.1 to -0.9
  *
- * Sharpens an image. Warning, this method is s..l..o..w... for large images.
+ * Sharpens an image.
  *
  * Since: 0.2.2
  **/
@@ -758,14 +846,19 @@ as_pixbuf_sharpen (GdkPixbuf *src, gint radius, gdouble amount)
 {
 	gint width, height, rowstride, n_channels;
 	gint x, y;
+	const guchar *lut;
+	const guchar *lut_row;
 	guchar *p_blurred;
 	guchar *p_blurred_row;
 	guchar *p_src;
 	guchar *p_src_row;
+	_cleanup_bytes_unref_ GBytes *lut_bytes = NULL;
 	_cleanup_object_unref_ GdkPixbuf *blurred = NULL;
 
 	blurred = gdk_pixbuf_copy (src);
 	as_pixbuf_blur (blurred, radius, 3);
+	lut_bytes = as_pixbuf_sharpen_get_lut (amount);
+	lut = g_bytes_get_data (lut_bytes, NULL);
 
 	width = gdk_pixbuf_get_width (src);
 	height = gdk_pixbuf_get_height (src);
@@ -779,15 +872,12 @@ as_pixbuf_sharpen (GdkPixbuf *src, gint radius, gdouble amount)
 		p_src_row = p_src;
 		p_blurred_row = p_blurred;
 		for (x = 0; x < width; x++) {
-			p_src_row[0] = interpolate_value (p_src_row[0],
-							  p_blurred_row[0],
-							  amount);
-			p_src_row[1] = interpolate_value (p_src_row[1],
-							  p_blurred_row[1],
-							  amount);
-			p_src_row[2] = interpolate_value (p_src_row[2],
-							  p_blurred_row[2],
-							  amount);
+			lut_row = lut + (p_src_row[0] << 8);
+			p_src_row[0] = lut_row[p_blurred_row[0]];
+			lut_row = lut + (p_src_row[1] << 8);
+			p_src_row[1] = lut_row[p_blurred_row[1]];
+			lut_row = lut + (p_src_row[2] << 8);
+			p_src_row[2] = lut_row[p_blurred_row[2]];
 			p_src_row += n_channels;
 			p_blurred_row += n_channels;
 		}
@@ -796,23 +886,70 @@ as_pixbuf_sharpen (GdkPixbuf *src, gint radius, gdouble amount)
 	}
 }
 
+/* these are in order of preference */
+static const gchar *as_utils_icon_pixmap_dirs[] = { "pixmaps", "icons", NULL };
+static const gchar *as_utils_icon_theme_dirs[] = { "hicolor", "oxygen", NULL };
+static const gchar *as_utils_icon_exts[] = { ".png",
+					     ".gif",
+					     ".svg",
+					     ".xpm",
+					     "",
+					     NULL };
+static const gchar *as_utils_icon_sizes_lo_dpi[] = { "64x64",
+						     "128x128",
+						     "96x96",
+						     "256x256",
+						     "scalable",
+						     "48x48",
+						     "32x32",
+						     "24x24",
+						     "16x16",
+						     NULL };
+static const gchar *as_utils_icon_sizes_hi_dpi[] = { "128x128",
+						     "256x256",
+						     "scalable",
+						     NULL };
+static const gchar *as_utils_icon_types[] = { "actions",
+					      "animations",
+					      "apps",
+					      "categories",
+					      "devices",
+					      "emblems",
+					      "emotes",
+					      "filesystems",
+					      "intl",
+					      "mimetypes",
+					      "places",
+					      "status",
+					      "stock",
+					      NULL };
+
 /**
- * as_utils_find_icon_filename_full:
- * @destdir: the destdir.
- * @search: the icon search name, e.g. "microphone.svg"
- * @flags: A #AsUtilsFindIconFlag bitfield
- * @error: A #GError or %NULL
- *
- * Finds an icon filename from a filesystem root.
- *
- * Returns: (transfer full): a newly allocated %NULL terminated string
+ * as_utils_find_icon_exists:
  *
- * Since: 0.3.1
+ * Checks if @filename exists, using @exists_func for the part after @destdir
+ * if the filesystem root is not a real directory.
  **/
-gchar *
-as_utils_find_icon_filename_full (const gchar *destdir,
+static gboolean
+as_utils_find_icon_exists (const gchar *destdir,
+			   const gchar *filename,
+			   AsUtilsIconIndexExistsFunc exists_func,
+			   gpointer user_data)
+{
+	if (exists_func != NULL)
+		return exists_func (filename + strlen (destdir), user_data);
+	return g_file_test (filename, G_FILE_TEST_EXISTS);
+}
+
+/**
+ * as_utils_find_icon_filename_real:
+ **/
+static gchar *
+as_utils_find_icon_filename_real (const gchar *destdir,
 				  const gchar *search,
 				  AsUtilsFindIconFlag flags,
+				  AsUtilsIconIndexExistsFunc exists_func,
+				  gpointer user_data,
 				  GError **error)
 {
 	guint i;
@@ -820,42 +957,6 @@ as_utils_find_icon_filename_full (const gchar *destdir,
 	guint k;
 	guint m;
 	const gchar **sizes;
-	const gchar *pixmap_dirs[] = { "pixmaps", "icons", NULL };
-	const gchar *theme_dirs[] = { "hicolor", "oxygen", NULL };
-	const gchar *supported_ext[] = { ".png",
-					 ".gif",
-					 ".svg",
-					 ".xpm",
-					 "",
-					 NULL };
-	const gchar *sizes_lo_dpi[] = { "64x64",
-					"128x128",
-					"96x96",
-					"256x256",
-					"scalable",
-					"48x48",
-					"32x32",
-					"24x24",
-					"16x16",
-					NULL };
-	const gchar *sizes_hi_dpi[] = { "128x128",
-					"256x256",
-					"scalable",
-					NULL };
-	const gchar *types[] = { "actions",
-				 "animations",
-				 "apps",
-				 "categories",
-				 "devices",
-				 "emblems",
-				 "emotes",
-				 "filesystems",
-				 "intl",
-				 "mimetypes",
-				 "places",
-				 "status",
-				 "stock",
-				 NULL };
 
 	/* fallback */
 	if (destdir == NULL)
@@ -865,7 +966,8 @@ as_utils_find_icon_filename_full (const gchar *destdir,
 	if (search[0] == '/') {
 		_cleanup_free_ gchar *tmp = NULL;
 		tmp = g_build_filename (destdir, search, NULL);
-		if (!g_file_test (tmp, G_FILE_TEST_EXISTS)) {
+		if (exists_func != NULL ? !exists_func (search, user_data) :
+		    !g_file_test (tmp, G_FILE_TEST_EXISTS)) {
 			g_set_error (error,
 				     AS_APP_ERROR,
 				     AS_APP_ERROR_FAILED,
@@ -877,21 +979,24 @@ as_utils_find_icon_filename_full (const gchar *destdir,
 	}
 
 	/* icon theme apps */
-	sizes = flags & AS_UTILS_FIND_ICON_HI_DPI ? sizes_hi_dpi : sizes_lo_dpi;
-	for (k = 0; theme_dirs[k] != NULL; k++) {
+	sizes = flags & AS_UTILS_FIND_ICON_HI_DPI ? as_utils_icon_sizes_hi_dpi :
+						    as_utils_icon_sizes_lo_dpi;
+	for (k = 0; as_utils_icon_theme_dirs[k] != NULL; k++) {
 		for (i = 0; sizes[i] != NULL; i++) {
-			for (m = 0; types[m] != NULL; m++) {
-				for (j = 0; supported_ext[j] != NULL; j++) {
+			for (m = 0; as_utils_icon_types[m] != NULL; m++) {
+				for (j = 0; as_utils_icon_exts[j] != NULL; j++) {
 					_cleanup_free_ gchar *tmp = NULL;
 					tmp = g_strdup_printf ("%s/usr/share/icons/"
 							       "%s/%s/%s/%s%s",
 							       destdir,
-							       theme_dirs[k],
+							       as_utils_icon_theme_dirs[k],
 							       sizes[i],
-							       types[m],
+							       as_utils_icon_types[m],
 							       search,
-							       supported_ext[j]);
-					if (g_file_test (tmp, G_FILE_TEST_EXISTS))
+							       as_utils_icon_exts[j]);
+					if (as_utils_find_icon_exists (destdir, tmp,
+								       exists_func,
+								       user_data))
 						return g_strdup (tmp);
 				}
 			}
@@ -899,15 +1004,16 @@ as_utils_find_icon_filename_full (const gchar *destdir,
 	}
 
 	/* pixmap */
-	for (i = 0; pixmap_dirs[i] != NULL; i++) {
-		for (j = 0; supported_ext[j] != NULL; j++) {
+	for (i = 0; as_utils_icon_pixmap_dirs[i] != NULL; i++) {
+		for (j = 0; as_utils_icon_exts[j] != NULL; j++) {
 			_cleanup_free_ gchar *tmp = NULL;
 			tmp = g_strdup_printf ("%s/usr/share/%s/%s%s",
 					       destdir,
-					       pixmap_dirs[i],
+					       as_utils_icon_pixmap_dirs[i],
 					       search,
-					       supported_ext[j]);
-			if (g_file_test (tmp, G_FILE_TEST_EXISTS))
+					       as_utils_icon_exts[j]);
+			if (as_utils_find_icon_exists (destdir, tmp,
+						       exists_func, user_data))
 				return g_strdup (tmp);
 		}
 	}
@@ -920,6 +1026,375 @@ as_utils_find_icon_filename_full (const gchar *destdir,
 	return NULL;
 }
 
+/**
+ * as_utils_find_icon_filename_full:
+ * @destdir: the destdir.
+ * @search: the icon search name, e.g. "microphone.svg"
+ * @flags: A #AsUtilsFindIconFlag bitfield
+ * @error: A #GError or %NULL
+ *
+ * Finds an icon filename from a filesystem root.
+ *
+ * Returns: (transfer full): a newly allocated %NULL terminated string
+ *
+ * Since: 0.3.1
+ **/
+gchar *
+as_utils_find_icon_filename_full (const gchar *destdir,
+				  const gchar *search,
+				  AsUtilsFindIconFlag flags,
+				  GError **error)
+{
+	return as_utils_find_icon_filename_real (destdir, search, flags,
+						 NULL, NULL, error);
+}
+
+struct _AsUtilsIconIndex {
+	gchar		*destdir;
+	GHashTable	*hash;		/* basename : GPtrArray of AsUtilsIconIndexItem */
+	AsUtilsIconIndexListFunc list_func;
+	AsUtilsIconIndexExistsFunc exists_func;
+	gpointer	 user_data;
+};
+
+typedef struct {
+	gchar		*filename;
+	gint		 theme;		/* or -1 for a pixmap */
+	gint		 size_lo_dpi;
+	gint		 size_hi_dpi;
+	gint		 type;
+	gint		 pixmap_dir;
+	guint		 rank;		/* only valid during a search */
+} AsUtilsIconIndexItem;
+
+/**
+ * as_utils_icon_index_item_free:
+ **/
+static void
+as_utils_icon_index_item_free (AsUtilsIconIndexItem *item)
+{
+	g_free (item->filename);
+	g_slice_free (AsUtilsIconIndexItem, item);
+}
+
+/**
+ * as_utils_icon_index_find_str:
+ **/
+static gint
+as_utils_icon_index_find_str (const gchar **array, const gchar *value)
+{
+	guint i;
+	for (i = 0; array[i] != NULL; i++) {
+		if (g_strcmp0 (array[i], value) == 0)
+			return (gint) i;
+	}
+	return -1;
+}
+
+/**
+ * as_utils_icon_index_list_dir:
+ *
+ * Returns the names in @path, which is relative to the destdir, or %NULL if
+ * it is not a directory.
+ **/
+static GPtrArray *
+as_utils_icon_index_list_dir (AsUtilsIconIndex *idx, const gchar *path)
+{
+	GPtrArray *names;
+	const gchar *name;
+	_cleanup_dir_close_ GDir *dir = NULL;
+	_cleanup_free_ gchar *filename = NULL;
+
+	if (idx->list_func != NULL)
+		return idx->list_func (path, idx->user_data);
+	filename = g_strconcat (idx->destdir, path, NULL);
+	dir = g_dir_open (filename, 0, NULL);
+	if (dir == NULL)
+		return NULL;
+	names = g_ptr_array_new_with_free_func (g_free);
+	while ((name = g_dir_read_name (dir)) != NULL)
+		g_ptr_array_add (names, g_strdup (name));
+	return names;
+}
+
+/**
+ * as_utils_icon_index_add_dir:
+ **/
+static void
+as_utils_icon_index_add_dir (AsUtilsIconIndex *idx,
+			     const gchar *path,
+			     const AsUtilsIconIndexItem *tmpl)
+{
+	const gchar *name;
+	guint i;
+	_cleanup_ptrarray_unref_ GPtrArray *names = NULL;
+
+	names = as_utils_icon_index_list_dir (idx, path);
+	if (names == NULL)
+		return;
+	for (i = 0; i < names->len; i++) {
+		AsUtilsIconIndexItem *item;
+		GPtrArray *items;
+
+		name = g_ptr_array_index (names, i);
+		items = g_hash_table_lookup (idx->hash, name);
+		if (items == NULL) {
+			items = g_ptr_array_new_with_free_func ((GDestroyNotify) as_utils_icon_index_item_free);
+			g_hash_table_insert (idx->hash, g_strdup (name), items);
+		}
+		item = g_slice_dup (AsUtilsIconIndexItem, tmpl);
+		item->filename = g_strdup_printf ("%s%s/%s",
+						  idx->destdir, path, name);
+		g_ptr_array_add (items, item);
+	}
+}
+
+/**
+ * as_utils_icon_index_load:
+ *
+ * Scans the icon theme and pixmap directories of the destdir once, only
+ * descending into the sizes and contexts that can ever be returned.
+ **/
+static void
+as_utils_icon_index_load (AsUtilsIconIndex *idx)
+{
+	AsUtilsIconIndexItem tmpl;
+	const gchar *size;
+	const gchar *type;
+	guint i;
+	guint j;
+	guint k;
+
+	/* pixmaps */
+	memset (&tmpl, 0, sizeof (tmpl));
+	tmpl.theme = -1;
+	for (i = 0; as_utils_icon_pixmap_dirs[i] != NULL; i++) {
+		_cleanup_free_ gchar *path = NULL;
+		path = g_strdup_printf ("/usr/share/%s",
+					as_utils_icon_pixmap_dirs[i]);
+		tmpl.pixmap_dir = (gint) i;
+		as_utils_icon_index_add_dir (idx, path, &tmpl);
+	}
+
+	/* icon themes */
+	for (i = 0; as_utils_icon_theme_dirs[i] != NULL; i++) {
+		_cleanup_free_ gchar *path_theme = NULL;
+		_cleanup_ptrarray_unref_ GPtrArray *sizes = NULL;
+		path_theme = g_strdup_printf ("/usr/share/icons/%s",
+					      as_utils_icon_theme_dirs[i]);
+		sizes = as_utils_icon_index_list_dir (idx, path_theme);
+		if (sizes == NULL)
+			continue;
+		tmpl.theme = (gint) i;
+		for (j = 0; j < sizes->len; j++) {
+			_cleanup_free_ gchar *path_size = NULL;
+			_cleanup_ptrarray_unref_ GPtrArray *types = NULL;
+			size = g_ptr_array_index (sizes, j);
+			tmpl.size_lo_dpi = as_utils_icon_index_find_str (as_utils_icon_sizes_lo_dpi, size);
+			tmpl.size_hi_dpi = as_utils_icon_index_find_str (as_utils_icon_sizes_hi_dpi, size);
+			if (tmpl.size_lo_dpi < 0 && tmpl.size_hi_dpi < 0)
+				continue;
+			path_size = g_strdup_printf ("%s/%s", path_theme, size);
+			types = as_utils_icon_index_list_dir (idx, path_size);
+			if (types == NULL)
+				continue;
+			for (k = 0; k < types->len; k++) {
+				_cleanup_free_ gchar *path_type = NULL;
+				type = g_ptr_array_index (types, k);
+				tmpl.type = as_utils_icon_index_find_str (as_utils_icon_types, type);
+				if (tmpl.type < 0)
+					continue;
+				path_type = g_strdup_printf ("%s/%s", path_size, type);
+				as_utils_icon_index_add_dir (idx, path_type, &tmpl);
+			}
+		}
+	}
+}
+
+/**
+ * as_utils_icon_index_new:
+ * @destdir: the destdir, or %NULL
+ *
+ * Creates a new icon index for a filesystem root. The directories are only
+ * scanned when the index is first searched, and the index should be freed
+ * if the contents of @destdir changes.
+ *
+ * The index is not threadsafe.
+ *
+ * Returns: (transfer full): a new #AsUtilsIconIndex
+ *
+ * Since: 0.3.3
+ **/
+AsUtilsIconIndex *
+as_utils_icon_index_new (const gchar *destdir)
+{
+	return as_utils_icon_index_new_full (destdir, NULL, NULL, NULL);
+}
+
+/**
+ * as_utils_icon_index_new_full:
+ * @destdir: the destdir, or %NULL
+ * @list_func: a #AsUtilsIconIndexListFunc, or %NULL
+ * @exists_func: a #AsUtilsIconIndexExistsFunc, or %NULL
+ * @user_data: user data to pass to @list_func and @exists_func
+ *
+ * Creates a new icon index for a filesystem root that may not be present on
+ * disk, for instance the contents of a package. Paths passed to the
+ * callbacks are relative to @destdir, e.g. "/usr/share/pixmaps", but the
+ * returned filenames still have @destdir prepended.
+ *
+ * If a callback is %NULL then the filesystem is used instead.
+ *
+ * Returns: (transfer full): a new #AsUtilsIconIndex
+ *
+ * Since: 0.3.3
+ **/
+AsUtilsIconIndex *
+as_utils_icon_index_new_full (const gchar *destdir,
+			      AsUtilsIconIndexListFunc list_func,
+			      AsUtilsIconIndexExistsFunc exists_func,
+			      gpointer user_data)
+{
+	AsUtilsIconIndex *idx;
+	idx = g_slice_new0 (AsUtilsIconIndex);
+	idx->destdir = g_strdup (destdir != NULL ? destdir : "");
+	idx->list_func = list_func;
+	idx->exists_func = exists_func;
+	idx->user_data = user_data;
+	return idx;
+}
+
+/**
+ * as_utils_icon_index_free:
+ * @idx: a #AsUtilsIconIndex
+ *
+ * Frees an icon index.
+ *
+ * Since: 0.3.3
+ **/
+void
+as_utils_icon_index_free (AsUtilsIconIndex *idx)
+{
+	if (idx == NULL)
+		return;
+	if (idx->hash != NULL)
+		g_hash_table_unref (idx->hash);
+	g_free (idx->destdir);
+	g_slice_free (AsUtilsIconIndex, idx);
+}
+
+/**
+ * as_utils_icon_index_sort_cb:
+ **/
+static gint
+as_utils_icon_index_sort_cb (gconstpointer a, gconstpointer b)
+{
+	AsUtilsIconIndexItem *item_a = *((AsUtilsIconIndexItem **) a);
+	AsUtilsIconIndexItem *item_b = *((AsUtilsIconIndexItem **) b);
+	if (item_a->rank < item_b->rank)
+		return -1;
+	if (item_a->rank > item_b->rank)
+		return 1;
+	return 0;
+}
+
+/**
+ * as_utils_find_icon_filename_index:
+ * @idx: a #AsUtilsIconIndex
+ * @search: the icon search name, e.g. "microphone.svg"
+ * @flags: A #AsUtilsFindIconFlag bitfield
+ * @error: A #GError or %NULL
+ *
+ * Finds an icon filename using an icon index. This returns the same results
+ * as as_utils_find_icon_filename_full() but is much faster when looking up
+ * several icons in the same filesystem root.
+ *
+ * Returns: (transfer full): a newly allocated %NULL terminated string
+ *
+ * Since: 0.3.3
+ **/
+gchar *
+as_utils_find_icon_filename_index (AsUtilsIconIndex *idx,
+				   const gchar *search,
+				   AsUtilsFindIconFlag flags,
+				   GError **error)
+{
+	AsUtilsIconIndexItem *item;
+	gint size;
+	guint i;
+	guint j;
+	guint n_sizes = G_N_ELEMENTS (as_utils_icon_sizes_lo_dpi);
+	guint n_types = G_N_ELEMENTS (as_utils_icon_types);
+	guint n_exts = G_N_ELEMENTS (as_utils_icon_exts);
+	guint rank_pixmap;
+	_cleanup_ptrarray_unref_ GPtrArray *candidates = NULL;
+
+	/* absolute paths and subdirectories are not indexed */
+	if (search[0] == '/' || strchr (search, '/') != NULL) {
+		return as_utils_find_icon_filename_real (idx->destdir,
+							 search,
+							 flags,
+							 idx->exists_func,
+							 idx->user_data,
+							 error);
+	}
+
+	/* only scan the tree on first use */
+	if (idx->hash == NULL) {
+		idx->hash = g_hash_table_new_full (g_str_hash, g_str_equal,
+						   g_free, (GDestroyNotify) g_ptr_array_unref);
+		as_utils_icon_index_load (idx);
+	}
+
+	/* rank every file using the same order as the directory search */
+	rank_pixmap = G_N_ELEMENTS (as_utils_icon_theme_dirs) * n_sizes * n_types * n_exts;
+	candidates = g_ptr_array_new ();
+	for (j = 0; as_utils_icon_exts[j] != NULL; j++) {
+		GPtrArray *items;
+		_cleanup_free_ gchar *key = NULL;
+		key = g_strconcat (search, as_utils_icon_exts[j], NULL);
+		items = g_hash_table_lookup (idx->hash, key);
+		if (items == NULL)
+			continue;
+		for (i = 0; i < items->len; i++) {
+			item = g_ptr_array_index (items, i);
+			if (item->theme < 0) {
+				item->rank = rank_pixmap +
+					     (guint) item->pixmap_dir * n_exts + j;
+			} else {
+				if (flags & AS_UTILS_FIND_ICON_HI_DPI)
+					size = item->size_hi_dpi;
+				else
+					size = item->size_lo_dpi;
+				if (size < 0)
+					continue;
+				item->rank = (((guint) item->theme * n_sizes +
+					       (guint) size) * n_types +
+					      (guint) item->type) * n_exts + j;
+			}
+			g_ptr_array_add (candidates, item);
+		}
+	}
+
+	/* dangling symlinks do not count */
+	g_ptr_array_sort (candidates, as_utils_icon_index_sort_cb);
+	for (i = 0; i < candidates->len; i++) {
+		item = g_ptr_array_index (candidates, i);
+		if (as_utils_find_icon_exists (idx->destdir,
+					       item->filename,
+					       idx->exists_func,
+					       idx->user_data))
+			return g_strdup (item->filename);
+	}
+
+	/* failed */
+	g_set_error (error,
+		     AS_APP_ERROR,
+		     AS_APP_ERROR_FAILED,
+		     "Failed to find icon %s", search);
+	return NULL;
+}
+
 /**
  * as_utils_find_icon_filename:
  * @destdir: the destdir.
@@ -44,6 +44,32 @@ typedef enum {
 	AS_UTILS_FIND_ICON_LAST
 } AsUtilsFindIconFlag;
 
+typedef struct _AsUtilsIconIndex	AsUtilsIconIndex;
+
+/**
+ * AsUtilsIconIndexListFunc:
+ * @path: the directory relative to the destdir, e.g. "/usr/share/pixmaps"
+ * @user_data: user data
+ *
+ * Lists the names in a directory for an icon index.
+ *
+ * Returns: (transfer container) (element-type utf8): names, or %NULL
+ **/
+typedef GPtrArray	*(*AsUtilsIconIndexListFunc)	(const gchar	*path,
+							 gpointer	 user_data);
+
+/**
+ * AsUtilsIconIndexExistsFunc:
+ * @path: the filename relative to the destdir
+ * @user_data: user data
+ *
+ * Checks if a file exists for an icon index.
+ *
+ * Returns: %TRUE if the file exists
+ **/
+typedef gboolean	 (*AsUtilsIconIndexExistsFunc)	(const gchar	*path,
+							 gpointer	 user_data);
+
 gchar		*as_markup_convert_simple	(const gchar	*markup,
 						 gssize		 markup_len,
 						 GError		**error);
@@ -65,6 +91,16 @@ gchar		*as_utils_find_icon_filename_full (const gchar	*destdir,
 						 const gchar	*search,
 						 AsUtilsFindIconFlag flags,
 						 GError		**error);
+AsUtilsIconIndex *as_utils_icon_index_new	(const gchar	*destdir);
+AsUtilsIconIndex *as_utils_icon_index_new_full	(const gchar	*destdir,
+						 AsUtilsIconIndexListFunc list_func,
+						 AsUtilsIconIndexExistsFunc exists_func,
+						 gpointer	 user_data);
+void		 as_utils_icon_index_free	(AsUtilsIconIndex *idx);
+gchar		*as_utils_find_icon_filename_index (AsUtilsIconIndex *idx,
+						 const gchar	*search,
+						 AsUtilsFindIconFlag flags,
+						 GError		**error);
 gchar		*as_utils_get_string_overlap	(const gchar	*s1,
 						 const gchar	*s2);
 